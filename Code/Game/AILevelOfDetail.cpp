@@ -0,0 +1,250 @@
+#include "Game/AILevelOfDetail.hpp"
+#include "Game/GameCommon.h"
+#include "Game/Actor.hpp"
+#include "Game/BenchHelpers.hpp"
+#include "Game/Game.h"
+#include "Game/Map.hpp"
+#include "Game/Player.hpp"
+#include "Engine/Core/DevConsole.hpp"
+#include "Engine/Core/EngineCommon.h"
+#include "Engine/Core/Time.hpp"
+#include "Engine/Math/MathUtils.h"
+#include <cfloat>
+#include <cmath>
+
+AILodSettings AILodSettings::LoadFromConfig()
+{
+	AILodSettings settings;
+	settings.m_isEnabled      = g_gameConfigBlackboard.GetValue("aiLod", settings.m_isEnabled);
+	settings.m_midDistance    = g_gameConfigBlackboard.GetValue("aiLodMidDistance", settings.m_midDistance);
+	settings.m_farDistance    = g_gameConfigBlackboard.GetValue("aiLodFarDistance", settings.m_farDistance);
+	settings.m_midInterval    = g_gameConfigBlackboard.GetValue("aiLodMidInterval", settings.m_midInterval);
+	settings.m_farInterval    = g_gameConfigBlackboard.GetValue("aiLodFarInterval", settings.m_farInterval);
+	settings.m_hiddenInterval = g_gameConfigBlackboard.GetValue("aiLodHiddenInterval", settings.m_hiddenInterval);
+	return settings;
+}
+
+// Player positions are gathered once here rather than per agent
+void AILevelOfDetail::BeginTick(Map const& map)
+{
+	m_map = &map;
+	m_lastTickStats = m_tickStats;
+	m_tickStats = AILodTickStats();
+	++m_tickIndex;
+
+	m_playerPositions.clear();
+	std::vector<Player*> const& players = map.m_game->m_players;
+	for (int playerIndex = 0; playerIndex < static_cast<int>(players.size()); ++playerIndex)
+	{
+		Actor const* playerActor = map.GetActorByHandle(players[playerIndex]->m_currentHandle);
+		if (playerActor != nullptr && !playerActor->IsDead())
+		{
+			m_playerPositions.push_back(playerActor->m_position.GetXY());
+		}
+	}
+}
+
+// Replays start from a reset session, so the stagger has to start over with it
+void AILevelOfDetail::Reset()
+{
+	m_tickIndex = 0;
+	m_tickStats = AILodTickStats();
+	m_lastTickStats = AILodTickStats();
+}
+
+unsigned int AILevelOfDetail::GetTickIndex() const
+{
+	return m_tickIndex;
+}
+
+// Saves bring the stagger back so the same agents think on the same ticks
+void AILevelOfDetail::SetTickIndex(unsigned int tickIndex)
+{
+	m_tickIndex = tickIndex;
+}
+
+AILodTier AILevelOfDetail::GetTier(Actor const& actor) const
+{
+	if (!m_settings.m_isEnabled || m_map == nullptr)
+	{
+		return AILodTier::CLOSE;
+	}
+
+	Vec2 actorPosXY = actor.m_position.GetXY();
+	float nearestDistanceSquared = FLT_MAX;
+	for (int playerIndex = 0; playerIndex < static_cast<int>(m_playerPositions.size()); ++playerIndex)
+	{
+		float distanceSquared = GetDistanceSquared2D(actorPosXY, m_playerPositions[playerIndex]);
+		nearestDistanceSquared = (distanceSquared < nearestDistanceSquared) ? distanceSquared : nearestDistanceSquared;
+	}
+	if (nearestDistanceSquared < m_settings.m_midDistance * m_settings.m_midDistance)
+	{
+		return AILodTier::CLOSE;
+	}
+
+	IntVec2 tileCoords(RoundDownToInt(actorPosXY.x), RoundDownToInt(actorPosXY.y));
+	for (int fieldIndex = 0; fieldIndex < static_cast<int>(m_map->m_visibilityFields.size()); ++fieldIndex)
+	{
+		VisibilityField const& field = m_map->m_visibilityFields[fieldIndex];
+		if (field.Covers(actorPosXY) && field.IsTileVisible(tileCoords))
+		{
+			return (nearestDistanceSquared < m_settings.m_farDistance * m_settings.m_farDistance) ? AILodTier::MID : AILodTier::DISTANT;
+		}
+	}
+	return AILodTier::HIDDEN;
+}
+
+bool AILevelOfDetail::IsUpdateTick(AILodTier tier, ActorHandle const& handle) const
+{
+	unsigned int interval = static_cast<unsigned int>(GetInterval(tier));
+	return ((m_tickIndex + handle.GetIndex()) % interval) == 0;
+}
+
+void AILevelOfDetail::CountAgent(AILodTier tier)
+{
+	m_tickStats.m_numAgents[static_cast<int>(tier)] += 1;
+}
+
+void AILevelOfDetail::RecordUpdate(AILodTier tier, double seconds)
+{
+	m_tickStats.m_numUpdates[static_cast<int>(tier)] += 1;
+	m_tickStats.m_updateSeconds[static_cast<int>(tier)] += seconds;
+}
+
+AILodTickStats const& AILevelOfDetail::GetLastTickStats() const
+{
+	return m_lastTickStats;
+}
+
+char const* AILevelOfDetail::GetTierName(AILodTier tier)
+{
+	switch (tier)
+	{
+	case AILodTier::CLOSE:   return "close";
+	case AILodTier::MID:     return "mid";
+	case AILodTier::DISTANT: return "distant";
+	case AILodTier::HIDDEN:  return "hidden";
+	default:                 return "unknown";
+	}
+}
+
+int AILevelOfDetail::GetInterval(AILodTier tier) const
+{
+	int interval = 1;
+	switch (tier)
+	{
+	case AILodTier::MID:     interval = m_settings.m_midInterval;    break;
+	case AILodTier::DISTANT: interval = m_settings.m_farInterval;    break;
+	case AILodTier::HIDDEN:  interval = m_settings.m_hiddenInterval; break;
+	default:                 break;
+	}
+	return (interval < 1) ? 1 : interval;
+}
+
+// -----------------------------------------------------------------------------
+// Dev console: AILod
+// Prints how many agents were in each tier last tick, how many of them
+// thought and the time their thinking took.
+// -----------------------------------------------------------------------------
+bool AILevelOfDetail::Command_AILod(EventArgs& args)
+{
+	UNUSED(args);
+	Map* map = g_theGame->m_defaultMap;
+	if (g_theGame->m_currentState != GameState::PLAYING || map == nullptr)
+	{
+		g_theDevConsole->AddLine(Rgba8::RED, "AILod needs a game in progress");
+		return false;
+	}
+
+	AILodTickStats const& stats = map->m_aiLod.GetLastTickStats();
+	g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, Stringf("AI level of detail is %s", map->m_aiLod.m_settings.m_isEnabled ? "on" : "off"));
+	for (int tierIndex = 0; tierIndex < static_cast<int>(AILodTier::COUNT); ++tierIndex)
+	{
+		g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, Stringf("  %-8s %5d agents, %5d thought, %.3f ms", GetTierName(static_cast<AILodTier>(tierIndex)),
+			stats.m_numAgents[tierIndex], stats.m_numUpdates[tierIndex], stats.m_updateSeconds[tierIndex] * 1000.0));
+	}
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Runs headless map ticks with a growing crowd of demons, with level of detail
+// off and then on, and prints the mean, spread and worst tick time for each.
+// The map and player lives are restored afterwards.
+// -----------------------------------------------------------------------------
+static void RunLodBenchTicks(Map& map, int numTicks, double& outMeanSeconds, double& outDeviationSeconds, double& outWorstSeconds)
+{
+	float deltaSeconds = 1.f / 60.f;
+	double sumSeconds = 0.0;
+	double sumSquaredSeconds = 0.0;
+	outWorstSeconds = 0.0;
+	for (int tickIndex = 0; tickIndex < numTicks; ++tickIndex)
+	{
+		double tickStart = GetCurrentTimeSeconds();
+		map.Update(deltaSeconds);
+		double tickSeconds = GetCurrentTimeSeconds() - tickStart;
+		sumSeconds += tickSeconds;
+		sumSquaredSeconds += tickSeconds * tickSeconds;
+		outWorstSeconds = (tickSeconds > outWorstSeconds) ? tickSeconds : outWorstSeconds;
+	}
+	outMeanSeconds = sumSeconds / static_cast<double>(numTicks);
+	double variance = (sumSquaredSeconds / static_cast<double>(numTicks)) - (outMeanSeconds * outMeanSeconds);
+	outDeviationSeconds = sqrt((variance > 0.0) ? variance : 0.0);
+}
+
+// -----------------------------------------------------------------------------
+// Dev console: AILodBench agents=<count> ticks=<count>
+// Steps the crowd through an eighth, a quarter, half and all of the agent count.
+// -----------------------------------------------------------------------------
+bool AILevelOfDetail::Command_AILodBench(EventArgs& args)
+{
+	Map* map = g_theGame->m_defaultMap;
+	if (g_theGame->m_currentState != GameState::PLAYING || map == nullptr)
+	{
+		g_theDevConsole->AddLine(Rgba8::RED, "AILodBench needs a game in progress");
+		return false;
+	}
+
+	int maxAgents = args.GetValue("agents", 8000);
+	int numTicks = args.GetValue("ticks", 240);
+	numTicks = (numTicks < 1) ? 1 : numTicks;
+	int maxActors = static_cast<int>(ActorHandle::MAX_ACTOR_INDEX) - static_cast<int>(map->m_allActors.size());
+	maxAgents = (maxAgents < 1) ? 1 : ((maxAgents > maxActors) ? maxActors : maxAgents);
+
+	std::vector<IntVec2> openTiles;
+	if (!GatherOpenTiles(*map, "AILodBench", openTiles))
+	{
+		return false;
+	}
+
+	BenchMapScope benchScope(*map);
+	bool wasEnabled = map->m_aiLod.m_settings.m_isEnabled;
+
+	for (int step = 3; step >= 0; --step)
+	{
+		int numAgents = maxAgents >> step;
+		for (int lodIndex = 0; lodIndex < 2; ++lodIndex)
+		{
+			benchScope.Restore();
+			map->m_aiLod.m_settings.m_isEnabled = lodIndex == 1;
+			for (int spawnIndex = 0; spawnIndex < numAgents; ++spawnIndex)
+			{
+				IntVec2 tileCoords = RollOpenTile(openTiles);
+
+				SpawnInfo spawnInfo;
+				spawnInfo.m_actorDef = ActorDefinition::GetByActorName("Demon");
+				spawnInfo.m_position = Vec3(static_cast<float>(tileCoords.x) + 0.5f, static_cast<float>(tileCoords.y) + 0.5f, 0.f);
+				map->SpawnActor(spawnInfo);
+			}
+
+			double meanSeconds = 0.0;
+			double deviationSeconds = 0.0;
+			double worstSeconds = 0.0;
+			RunLodBenchTicks(*map, numTicks, meanSeconds, deviationSeconds, worstSeconds);
+			g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, Stringf("%6d agents, level of detail %-3s: %.3f ms/tick, deviation %.3f ms, worst %.3f ms",
+				numAgents, (lodIndex == 1) ? "on" : "off", meanSeconds * 1000.0, deviationSeconds * 1000.0, worstSeconds * 1000.0));
+		}
+	}
+
+	map->m_aiLod.m_settings.m_isEnabled = wasEnabled;
+	return true;
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include "Game/ActorHandle.hpp"
+#include "Engine/Core/EventSystem.hpp"
+#include "Engine/Math/Vec2.hpp"
+#include <vector>
+// -----------------------------------------------------------------------------
+class Actor;
+class Map;
+// -----------------------------------------------------------------------------
+enum class AILodTier
+{
+	CLOSE,		// Within the mid distance of a player, thinks every tick
+	MID,
+	DISTANT,	// Past the far distance
+	HIDDEN,		// Past the mid distance and out of every player's sight
+	COUNT
+};
+// -----------------------------------------------------------------------------
+// Read from GameConfig.xml, distances in tiles and intervals in ticks
+struct AILodSettings
+{
+	bool  m_isEnabled = true;
+	float m_midDistance = 16.f;
+	float m_farDistance = 40.f;
+	int   m_midInterval = 2;
+	int   m_farInterval = 4;
+	int   m_hiddenInterval = 8;
+
+	static AILodSettings LoadFromConfig();
+};
+// -----------------------------------------------------------------------------
+struct AILodTickStats
+{
+	int    m_numAgents[static_cast<int>(AILodTier::COUNT)] = {};
+	int    m_numUpdates[static_cast<int>(AILodTier::COUNT)] = {};
+	double m_updateSeconds[static_cast<int>(AILodTier::COUNT)] = {};
+};
+// -----------------------------------------------------------------------------
+// Decides how often each AI thinks from its distance to the nearest player
+// and whether any player can see it. An agent thinking every Nth tick gets the
+// time it skipped, and the tick it thinks on is offset by its handle so each
+// tier's work is spread evenly over its interval.
+// -----------------------------------------------------------------------------
+class AILevelOfDetail
+{
+public:
+	AILevelOfDetail() = default;
+
+	void BeginTick(Map const& map);
+	void Reset();
+	unsigned int GetTickIndex() const;
+	void SetTickIndex(unsigned int tickIndex);
+	AILodTier GetTier(Actor const& actor) const;
+	bool IsUpdateTick(AILodTier tier, ActorHandle const& handle) const;
+	void CountAgent(AILodTier tier);
+	void RecordUpdate(AILodTier tier, double seconds);
+	AILodTickStats const& GetLastTickStats() const;
+
+	AILodSettings m_settings;
+
+	static char const* GetTierName(AILodTier tier);
+	static bool Command_AILod(EventArgs& args);
+	static bool Command_AILodBench(EventArgs& args);
+// -----------------------------------------------------------------------------
+private:
+	int GetInterval(AILodTier tier) const;
+// -----------------------------------------------------------------------------
+	Map const* m_map = nullptr;
+	std::vector<Vec2> m_playerPositions;
+	unsigned int m_tickIndex = 0;
+	AILodTickStats m_tickStats;
+	AILodTickStats m_lastTickStats;
+};
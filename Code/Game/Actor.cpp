@@ -3,8 +3,11 @@
 #include "Game/Game.h"
 #include "Game/Controller.hpp"
 #include "Game/Ai.h"
+#include "Game/FactionDefinition.hpp"
 #include "Game/Player.hpp"
 #include "Game/SpriteAnimationGroup.hpp"
+#include "Game/FrameArena.hpp"
+#include "Game/FrameStats.hpp"
 #include "Engine/Math/Mat44.hpp"
 #include "Engine/Math/MathUtils.h"
 #include "Engine/Renderer/Renderer.h"
@@ -12,30 +15,93 @@
 #include "Engine/Core/VertexUtils.h"
 #include "Engine/Core/DebugRender.hpp"
 
+// -----------------------------------------------------------------------------
+// Freed actors go on a free list and slabs are only returned when the game
+// shuts down, so spawning and deleting thousands in a tick stays off the heap.
+// -----------------------------------------------------------------------------
+static int const ACTOR_SLAB_SIZE = 256;
+static std::vector<unsigned char*> s_actorSlabs;
+static std::vector<void*> s_freeActorBlocks;
+
+void* Actor::operator new(size_t size)
+{
+	if (size != sizeof(Actor))
+	{
+		return ::operator new(size);
+	}
+	if (s_freeActorBlocks.empty())
+	{
+		unsigned char* slab = static_cast<unsigned char*>(::operator new(sizeof(Actor) * ACTOR_SLAB_SIZE));
+		s_actorSlabs.push_back(slab);
+		for (int blockIndex = ACTOR_SLAB_SIZE - 1; blockIndex >= 0; --blockIndex)
+		{
+			s_freeActorBlocks.push_back(slab + (sizeof(Actor) * blockIndex));
+		}
+	}
+	void* block = s_freeActorBlocks.back();
+	s_freeActorBlocks.pop_back();
+	return block;
+}
+
+void Actor::operator delete(void* block, size_t size)
+{
+	if (block == nullptr)
+	{
+		return;
+	}
+	if (size != sizeof(Actor))
+	{
+		::operator delete(block);
+		return;
+	}
+	s_freeActorBlocks.push_back(block);
+}
+
+// Only once no actor is left
+void Actor::ReleaseSlabs()
+{
+	for (int slabIndex = 0; slabIndex < static_cast<int>(s_actorSlabs.size()); ++slabIndex)
+	{
+		::operator delete(s_actorSlabs[slabIndex]);
+	}
+	s_actorSlabs.clear();
+	s_freeActorBlocks.clear();
+}
+
+int Actor::GetNumSlabs()
+{
+	return static_cast<int>(s_actorSlabs.size());
+}
+
 Actor::Actor(Map* owner, SpawnInfo spawnInfo, ActorHandle actorHandle)
 	:m_theMap(owner),
-	 m_actorDef(ActorDefinition::GetByActorName(spawnInfo.m_actorName)),
+	 m_actorDef(spawnInfo.m_actorDef),
 	 m_position(spawnInfo.m_position),
 	 m_orientation(spawnInfo.m_orientation),
 	 m_velocity(spawnInfo.m_velocity),
-	 m_actorHandle(actorHandle),
-	 m_animationClock(new Clock(*g_theGame->m_gameClock))
+	 m_actorHandle(actorHandle)
 {
+	m_animationPlayback.Restart(m_theMap->m_simulationSeconds);
 	m_health = m_actorDef->m_health;
 	m_physicsHeight = m_actorDef->m_physicsHeight;
 	m_physicsRadius = m_actorDef->m_physicsRadius;
 	m_isMovable = m_actorDef->m_isSimulated;
 	m_enemySpawnInterval = m_actorDef->m_spawnInterval;
 
+	// Spawners and short-lived effects are woken by the map's timer wheel, see Map::ScheduleActorTimers
+	if (m_actorDef->m_actorName == "EnemySpawner")
+	{
+		m_nextSpawnSeconds = m_theMap->m_simulationSeconds + static_cast<double>(m_enemySpawnInterval);
+	}
+	if (m_actorDef->m_dieOnSpawn)
+	{
+		m_removeSeconds = m_theMap->m_simulationSeconds + static_cast<double>(m_actorDef->m_corpseLifetime);
+	}
+
 	// Load weapons
-	for (int weaponIndex = 0; weaponIndex < static_cast<int>(m_actorDef->m_weaponNames.size()); ++weaponIndex)
+	for (int weaponIndex = 0; weaponIndex < static_cast<int>(m_actorDef->m_weaponDefs.size()); ++weaponIndex)
 	{
-		std::string const& items = m_actorDef->m_weaponNames[weaponIndex];
-		WeaponDefinition* weaponName = WeaponDefinition::GetByWeaponName(items);
-		if (weaponName != nullptr)
-		{
-			m_weapons.push_back(new Weapon(this, weaponName));
-		}
+		m_weapons.push_back(new Weapon(this, m_actorDef->m_weaponDefs[weaponIndex]));
 	}
 	if (!m_weapons.empty() && m_weapons[0] != nullptr)
 	{
@@ -44,21 +110,43 @@ Actor::Actor(Map* owner, SpawnInfo spawnInfo, ActorHandle actorHandle)
 
 	InitializeActorColor();
 
-	// Create geometry if we are visible
+	// Create geometry if we are visible, white so the pulse can tint it when drawn
 	if (m_actorDef->m_isVisible && m_actorDef->m_actorName == "EnemySpawner")
 	{
-		AddVertsForCylinderZ3D(m_actorVerts, Vec3::ZERO, m_physicsRadius, m_physicsHeight, m_color);
+		AddVertsForCylinderZ3D(m_actorVerts, Vec3::ZERO, m_physicsRadius, m_physicsHeight, Rgba8::WHITE);
 	}
 
 	if (m_actorDef->m_isVisible && !m_actorDef->m_animationGroups.empty())
 	{
 		m_animGroup = m_actorDef->m_animationGroups[0];
 	}
+	if (m_actorDef->m_dieOnSpawn)
+	{
+		PlayAnimation("Death");
+	}
 
 	m_hurtSound = g_theAudio->CreateOrGetSound(m_actorDef->GetSoundByName("Hurt"));
 	m_deathSound = g_theAudio->CreateOrGetSound(m_actorDef->GetSoundByName("Death"));
 }
 
+// Possessing players only hold a handle, the AI controller and weapons belong to the actor
+Actor::~Actor()
+{
+	for (int weaponIndex = 0; weaponIndex < static_cast<int>(m_weapons.size()); ++weaponIndex)
+	{
+		delete m_weapons[weaponIndex];
+	}
+	m_weapons.clear();
+	m_equippedWeapon = nullptr;
+
+	if (m_controller == m_aiController)
+	{
+		m_controller = nullptr;
+	}
+	delete m_aiController;
+	m_aiController = nullptr;
+}
+
 void Actor::InitializeActorColor()
 {
 	if (m_actorDef->m_actorName == "Marine")
@@ -79,140 +167,96 @@ void Actor::InitializeActorColor()
 	}
 }
 
+// Only called for actors with tick work, see HasTickWork
 void Actor::Update(float deltaSeconds)
 {
-	if (m_isDead == true || m_actorDef->m_dieOnSpawn == true)
-	{
-		m_lifetime += deltaSeconds;
-
-		// Play death animation
-		PlayAnimation("Death");
-	}
-
-
-	if (m_lifetime > m_actorDef->m_corpseLifetime)
-	{
-		m_isDestroyed = true;
-	}
-
-	SpawnEnemy(deltaSeconds);
-	EnemySpawnerPulse(deltaSeconds);
-
 	if (m_animGroup == nullptr)
 	{
 		return;
 	}
 
+	double simulationSeconds = m_theMap->m_simulationSeconds;
 	float animDuration = m_animGroup->m_anims[0].GetDuration();
-	if (m_animationClock->GetTotalSeconds() > animDuration && m_animGroup->m_playbackMode == SpriteAnimPlaybackType::ONCE)
+	if (m_animationPlayback.GetElapsedSeconds(simulationSeconds) > animDuration && m_animGroup->m_playbackMode == SpriteAnimPlaybackType::ONCE)
 	{
 		if (m_animGroup != m_actorDef->m_animationGroups[0])
 		{
 			m_animGroup = m_actorDef->m_animationGroups[0];
-			m_animationClock->Reset();
+			m_animationPlayback.Restart(simulationSeconds);
 		}
 	}
 	if (m_animGroup->m_scaleBySpeed)
 	{
-		m_animationClock->SetTimeScale(m_velocity.GetLength() / m_actorDef->m_runSpeed);
+		m_animationPlayback.SetTimeScale(m_velocity.GetLength() / m_actorDef->m_runSpeed, simulationSeconds);
 	}
 	else
 	{
-		m_animationClock->SetTimeScale(1.f);
+		m_animationPlayback.SetTimeScale(1.f, simulationSeconds);
 	}
 
 
-	if (m_actorDef->m_isSimulated)
-	{
-		UpdatePhysics(deltaSeconds);
-		if (m_aiController)
-		{
-			m_aiController->Update(deltaSeconds);
-		}
-	}
-}
-
-void Actor::EnemySpawnerPulse(float deltaSeconds)
-{
-	if (m_actorDef->m_actorName == "EnemySpawner")
+	// Physics for the tick already ran in the map's batch
+	if (m_actorDef->m_isSimulated && m_aiController)
 	{
-		m_colorPulseTime += deltaSeconds;
-		float pulsePeriod = 2.f;
-		float fraction = 0.5f * (1.f + sinf((2.f * 3.14f / pulsePeriod) * m_colorPulseTime));
-		m_color = m_color.Rgba8Interpolate(Rgba8::BLACK, Rgba8::RED, fraction);
-
-		m_actorVerts.clear();
-		AddVertsForCylinderZ3D(m_actorVerts, Vec3::ZERO, m_physicsRadius, m_physicsHeight, m_color);
+		m_aiController->Update(deltaSeconds);
 	}
 }
 
-void Actor::SpawnEnemy(float deltaSeconds)
+// -----------------------------------------------------------------------------
+// Timers are never cancelled, so one only counts if its due time is still the
+// one this actor is waiting for; a slow that was extended or a corpse time set
+// again leaves the earlier timer stale.
+// -----------------------------------------------------------------------------
+void Actor::OnTimer(TimerEvent event, double dueSeconds)
 {
-	if (m_actorDef->m_actorName == "EnemySpawner")
+	switch (event)
 	{
-		m_timeSinceSpawn += deltaSeconds;
-		if (m_timeSinceSpawn >= m_enemySpawnInterval)
+	case TimerEvent::REMOVE_CORPSE:
+		if (dueSeconds == m_removeSeconds)
 		{
-			m_timeSinceSpawn -= m_enemySpawnInterval;
-			SpawnInfo spawningInfo;
-			spawningInfo.m_actorName = m_actorDef->m_enemyType;
-			spawningInfo.m_position = m_position;
-			m_theMap->SpawnActor(spawningInfo);
+			Destroy();
 		}
-	}
-}
-
-void Actor::UpdatePhysics(float deltaSeconds)
-{
-	if (!m_actorDef->m_isSimulated || m_isDestroyed || m_isDead)
-	{
-		return;
-	}
-
-	// Set non-flying actors to 0 z component
-	if (m_actorDef->m_isFlying && m_actorDef->m_actorName == "LostSoul")
-	{
-		m_position.z = 0.35f;
-	}
-	else if (m_actorDef->m_isFlying == false)
-	{
-		m_position.z = 0.0f;
-	}
-
-	// Add a drag force equal to our drag times our negative current velocity
-	Vec3 dragForce = -m_actorDef->m_drag * m_velocity;
-
-	// Integrate acceleration, velocity, and position
-	m_acceleration += dragForce;
-	m_velocity += m_acceleration * deltaSeconds;
-	m_position += m_velocity * deltaSeconds;
-
-	// Clear out acceleration for next frame
-	m_acceleration = Vec3::ZERO;
-
-	// Apply slow effect to velocity if active
-	if (m_isSlowed)
-	{
-		m_velocity *= m_slowAmount;
-		m_slowTimer -= deltaSeconds;
-		if (m_slowTimer <= 0.f)
+		break;
+	case TimerEvent::SPAWN_ENEMY:
+		if (dueSeconds == m_nextSpawnSeconds)
+		{
+			SpawnEnemy();
+			m_nextSpawnSeconds += static_cast<double>(m_enemySpawnInterval);
+			m_theMap->m_timerWheel.Schedule(m_nextSpawnSeconds, m_actorHandle, TimerEvent::SPAWN_ENEMY);
+		}
+		break;
+	case TimerEvent::END_SLOW:
+		if (m_isSlowed && dueSeconds == m_slowEndSeconds)
 		{
 			m_isSlowed = false;
 			m_slowAmount = 1.f;
+			m_slowEndSeconds = -1.0;
 		}
+		break;
+	default:
+		break;
 	}
 }
 
+void Actor::SpawnEnemy()
+{
+	SpawnInfo spawningInfo;
+	spawningInfo.m_actorDef = m_actorDef->m_enemyTypeDef;
+	spawningInfo.m_position = m_position;
+	m_theMap->SpawnActor(spawningInfo);
+}
+
 void Actor::Render(Player const* facingPlayer) const
 {
 	// Draw untextured first
-	g_theRenderer->SetModelConstants(GetModelToWorldTransform());
+	g_theRenderer->SetModelConstants(GetModelToWorldTransform(), GetColor());
 	g_theRenderer->SetBlendMode(BlendMode::OPAQUE);
 	g_theRenderer->SetRasterizerMode(RasterizerMode::SOLID_CULL_BACK);
 	g_theRenderer->SetDepthMode(DepthMode::READ_WRITE_LESS_EQUAL);
 	g_theRenderer->BindShader(nullptr);
 	g_theRenderer->BindTexture(nullptr);
 	g_theRenderer->DrawVertexArray(m_actorVerts);
+	FrameStats::AddDrawCall();
 
 	if (m_actorDef->m_actorName == "SpawnPoint" || m_actorDef->m_actorName == "EnemySpawner")
 	{
@@ -256,7 +300,7 @@ void Actor::Render(Player const* facingPlayer) const
 	Vec3 viewingDirection = GetModelToWorldTransform().GetOrthonormalInverse().TransformVectorQuantity3D(playerToActorDirection);
 
 	SpriteAnimDefinition anim = m_animGroup->GetAnimDirection(viewingDirection);
-	SpriteDefinition spriteDef = anim.GetSpriteDefAtTime(static_cast<float>(m_animationClock->GetTotalSeconds()));
+	SpriteDefinition spriteDef = anim.GetSpriteDefAtTime(static_cast<float>(m_animationPlayback.GetElapsedSeconds(m_theMap->m_simulationSeconds)));
 	AABB2 spriteUVs = spriteDef.GetUVs();
 	
 	Vec3 spriteOffsetSize = -Vec3(0.f, m_actorDef->m_spriteSize.x, m_actorDef->m_spriteSize.y);
@@ -269,20 +313,16 @@ void Actor::Render(Player const* facingPlayer) const
 	Vec3 tL = (Vec3::ZAXE * m_actorDef->m_spriteSize.y);
 
 	bool isSpriteLit = m_actorDef->m_renderLit;
-	std::vector<Vertex_PCU> unlitVerts;
-	std::vector<Vertex_PCUTBN> litVertexes;
-
 	if (isSpriteLit)
 	{
+		std::vector<Vertex_PCUTBN>& litVertexes = g_frameArena->AllocateVertsTBN();
 		if (m_actorDef->m_renderRounded)
 		{
-			litVertexes.reserve(10000);
 			AddVertsForRoundedQuad3D(litVertexes, bL, bR, tR, tL, Rgba8::WHITE, spriteUVs);
 			TransformVertexArrayTBN3D(litVertexes, Mat44::MakeTranslation3D(spriteOffset));
 		}
 		else
 		{
-			litVertexes.reserve(10000);
 			AddVertsForQuad3D(litVertexes, bL, bR, tR, tL, Rgba8::WHITE, spriteUVs);
 			TransformVertexArrayTBN3D(litVertexes, Mat44::MakeTranslation3D(spriteOffset));
 		}
@@ -294,11 +334,12 @@ void Actor::Render(Player const* facingPlayer) const
 		g_theRenderer->BindShader(m_actorDef->m_shader);
 		g_theRenderer->BindTexture(&spriteDef.GetTexture());
 		g_theRenderer->DrawVertexArray(litVertexes);
+		FrameStats::AddDrawCall();
 		return;
 	}
 	if (!isSpriteLit)
 	{
-		unlitVerts.reserve(10000);
+		std::vector<Vertex_PCU>& unlitVerts = g_frameArena->AllocateVerts();
 		AddVertsForQuad3D(unlitVerts, bL, bR, tR, tL, Rgba8::WHITE, spriteUVs);
 		TransformVertexArray3D(unlitVerts, Mat44::MakeTranslation3D(spriteOffset));
 
@@ -309,6 +350,7 @@ void Actor::Render(Player const* facingPlayer) const
 		g_theRenderer->BindShader(m_actorDef->m_shader);
 		g_theRenderer->BindTexture(&spriteDef.GetTexture());
 		g_theRenderer->DrawVertexArray(unlitVerts);
+		FrameStats::AddDrawCall();
 		return;
 	}
 }
@@ -350,7 +392,7 @@ void Actor::OnCollide(Actor* actor)
 	bool isOverlapping = DoDiscsOverlap(positionXY, m_physicsRadius, actorPosXY, actor->m_physicsRadius);
 
 	// Lost soul damage
-	if (actor != nullptr && m_actorDef->m_damageOnCollide.m_max > 0.f && isOverlapping && actor->m_actorDef->m_faction != m_actorDef->m_faction)
+	if (actor != nullptr && m_actorDef->m_damageOnCollide.m_max > 0.f && isOverlapping && !FactionDefinition::IsFriendly(m_actorDef->m_factionId, actor->m_actorDef->m_factionId))
 	{
 		float damage = g_rng->RollRandomFloatInRange(m_actorDef->m_damageOnCollide.m_min, m_actorDef->m_damageOnCollide.m_max);
 		actor->Damage(damage, m_actorHandle);
@@ -361,7 +403,7 @@ void Actor::OnCollide(Actor* actor)
 	{
 		if (actor->m_actorDef->m_actorName == "Marine")
 		{
-			m_isDead = true;
+			Die();
 
 			// Play death sound
 			g_theAudio->StartSoundAt(m_deathSound, m_position, false, 0.5f);
@@ -387,7 +429,7 @@ void Actor::OnCollide(Actor* actor)
 	// Projectile Death
 	if (actor != nullptr && m_actorDef->m_dieOnCollide && m_actorDef->m_actorName == "PlasmaProjectile")
 	{
-		m_isDead = true;
+		Die();
 	}
 }
 
@@ -418,7 +460,7 @@ void Actor::Damage(float damage, Actor* attackingActor)
 	// Check if dead
 	if (m_health <= 0)
 	{
-		m_isDead = true;
+		Die();
 	}
 }
 
@@ -448,7 +490,7 @@ void Actor::Damage(float damage, ActorHandle& attackingActor)
 	// Check if dead
 	if (m_health <= 0)
 	{
-		m_isDead = true;
+		Die();
 
 		// Play death sound
 		g_theAudio->StartSoundAt(m_deathSound, m_position, false, 0.5f);
@@ -520,8 +562,16 @@ float Actor::GetPhysicsHeight() const
 	return m_physicsHeight;
 }
 
+// Spawners pulse on map time instead of rebuilding their geometry every tick
 Rgba8 Actor::GetColor() const
 {
+	if (m_actorDef->m_actorName == "EnemySpawner")
+	{
+		float pulsePeriod = 2.f;
+		float fraction = 0.5f * (1.f + sinf((2.f * 3.14f / pulsePeriod) * static_cast<float>(m_theMap->m_simulationSeconds)));
+		Rgba8 pulseColor = m_color;
+		return pulseColor.Rgba8Interpolate(Rgba8::BLACK, Rgba8::RED, fraction);
+	}
 	return m_color;
 }
 
@@ -540,9 +590,51 @@ bool Actor::IsDestroyed() const
 	return m_isDestroyed;
 }
 
+// Corpses, effects and anything without animation only change when a timer fires
+bool Actor::HasTickWork() const
+{
+	return !m_isDead && !m_isDestroyed && !m_actorDef->m_dieOnSpawn && m_animGroup != nullptr;
+}
+
+// Every death goes through here so the map's faction counts stay current
+void Actor::Die()
+{
+	if (m_isDead)
+	{
+		return;
+	}
+	m_isDead = true;
+	m_theMap->m_factionRoster.OnActorDied(*this);
+
+	// Corpses have no tick work, so the death animation starts here and the wheel removes them
+	PlayAnimation("Death");
+	m_animationPlayback.SetTimeScale(1.f, m_theMap->m_simulationSeconds);
+	m_removeSeconds = m_theMap->m_simulationSeconds + static_cast<double>(m_actorDef->m_corpseLifetime);
+	m_theMap->m_timerWheel.Schedule(m_removeSeconds, m_actorHandle, TimerEvent::REMOVE_CORPSE);
+}
+
+// The map deletes it at its next sync point
+void Actor::Destroy()
+{
+	if (m_isDestroyed)
+	{
+		return;
+	}
+	m_isDestroyed = true;
+	m_theMap->QueueDestroy(m_actorHandle);
+}
+
+void Actor::ApplySlow(float slowAmount, float durationSeconds)
+{
+	m_isSlowed = true;
+	m_slowAmount = slowAmount;
+	m_slowEndSeconds = m_theMap->m_simulationSeconds + static_cast<double>(durationSeconds);
+	m_theMap->m_timerWheel.Schedule(m_slowEndSeconds, m_actorHandle, TimerEvent::END_SLOW);
+}
+
 bool Actor::IsEnemy() const
 {
-	return m_actorDef->m_faction == "Demon";
+	return FactionDefinition::IsHostile(FactionDefinition::GetPlayerFactionId(), m_actorDef->m_factionId);
 }
 
 void Actor::PlayAnimation(std::string const& animName)
@@ -554,7 +646,7 @@ void Actor::PlayAnimation(std::string const& animName)
 			if (m_animGroup != m_actorDef->m_animationGroups[animIndex])
 			{
 				m_animGroup = m_actorDef->m_animationGroups[animIndex];
-				m_animationClock->Reset();
+				m_animationPlayback.Restart(m_theMap->m_simulationSeconds);
 			}
 			break;
 		}
@@ -3,28 +3,34 @@
 #include "Game/ActorHandle.hpp"
 #include "Game/ActorDefinition.hpp"
 #include "Game/Weapon.hpp"
+#include "Game/TimerWheel.hpp"
+#include "Game/AnimationPlayback.hpp"
 #include "Engine/Core/Vertex_PCU.h"
 #include "Engine/Audio/AudioSystem.hpp"
 // -----------------------------------------------------------------------------
 struct ActorHandle;
 class Controller;
 class Mat44;
-class Clock;
 // -----------------------------------------------------------------------------
 class Actor
 {
 public:
 	Actor(Map* owner, SpawnInfo spawnInfo, ActorHandle actorHandle);
+	~Actor();
+
+	// Actors are carved from slabs so a burst of spawns rarely reaches the heap
+	static void* operator new(size_t size);
+	static void  operator delete(void* block, size_t size);
+	static void  ReleaseSlabs();
+	static int   GetNumSlabs();
 
 	void InitializeActorColor();
 
 	void Update(float deltaSeconds);
+	void OnTimer(TimerEvent event, double dueSeconds);
 
-	void EnemySpawnerPulse(float deltaSeconds);
-
-	void SpawnEnemy(float deltaSeconds);
+	void SpawnEnemy();
 
-	void UpdatePhysics(float deltaSeconds);
 	void Render(Player const* facingPlayer) const;
 	Mat44 GetModelToWorldTransform() const;
 
@@ -36,6 +42,9 @@ public:
 
 	void Damage(float damage, Actor* attackingActor);
 	void Damage(float damage, ActorHandle& attackingActor);
+	void Die();
+	void Destroy();
+	void ApplySlow(float slowAmount, float durationSeconds);
 	void MoveInDirection(Vec3 direction, float speed);
 	void TurnInDirection(Vec2 const& targetPosition, float maxTurnDegrees);
 	void TurnInDirection(Vec3 dir, float maxDegrees);
@@ -53,9 +62,10 @@ public:
 	bool  IsDead() const;
 	bool  IsDestroyed() const;
 	bool  IsEnemy() const;
+	bool  HasTickWork() const;
 	void  PlayAnimation(std::string const& name);
 
-	Clock* m_animationClock = nullptr;
+	AnimationPlayback m_animationPlayback;
 	SpriteAnimationGroup* m_animGroup = nullptr;
 // -----------------------------------------------------------------------------
 public:
@@ -72,17 +82,19 @@ public:
 	bool  m_isDead = false;
 	bool  m_isDestroyed = false;
 	int	  m_health = 1;
-	float m_lifetime = 0.f;
 	float m_enemySpawnInterval = 0.f;
-	float m_timeSinceSpawn = 0.f;
-	float m_colorPulseTime = 0.f;
 	bool   m_isSlowed = false;
-	float  m_slowTimer = 0.f;
 	float  m_slowAmount = 1.f;
 
+	// Map simulation times the timer wheel was asked to wake this actor at, -1 when none is pending
+	double m_removeSeconds = -1.0;
+	double m_nextSpawnSeconds = -1.0;
+	double m_slowEndSeconds = -1.0;
+
 	Map* m_theMap = nullptr;
 	Actor* m_actorFiringProjectile = nullptr;
 	ActorHandle m_actorHandle = ActorHandle::INVALID;
+	int m_factionSlot = -1;	// Where the map's faction roster lists this actor, -1 when not listed
 
 	Controller* m_controller = nullptr;
 	Controller* m_aiController = nullptr;
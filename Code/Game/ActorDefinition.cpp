@@ -1,6 +1,10 @@
 #include "Game/ActorDefinition.hpp"
 #include "Game/GameCommon.h"
+#include "Game/AssetLoader.hpp"
+#include "Game/FactionDefinition.hpp"
+#include "Game/ShaderRegistry.hpp"
 #include "Game/SpriteAnimationGroup.hpp"
+#include "Game/WeaponDefinition.hpp"
 #include "Engine/Audio/AudioSystem.hpp"
 #include "Engine/Renderer/Renderer.h"
 #include "Engine/Core/ErrorWarningAssert.hpp"
@@ -12,6 +16,24 @@ ActorDefinition::ActorDefinition()
 }
 
 ActorDefinition::ActorDefinition(XmlElement const& actorDefElement)
+{
+	ParseXmlElement(actorDefElement);
+	Initialize();
+}
+
+ActorDefinition::~ActorDefinition()
+{
+	for (int animGroupIndex = 0; animGroupIndex < static_cast<int>(m_animationGroups.size()); ++animGroupIndex)
+	{
+		delete m_animationGroups[animGroupIndex];
+	}
+	m_animationGroups.clear();
+
+	delete m_spriteSheet;
+	m_spriteSheet = nullptr;
+}
+
+void ActorDefinition::ParseXmlElement(XmlElement const& actorDefElement)
 {
 	// Base
 	m_actorName		 = ParseXmlAttribute(actorDefElement, "name", m_actorName);
@@ -37,6 +59,9 @@ ActorDefinition::ActorDefinition(XmlElement const& actorDefElement)
 	// Visuals
 	ParseVisuals(actorDefElement);
 
+	// Light
+	ParseLight(actorDefElement);
+
 	// Sounds
 	ParseSounds(actorDefElement);
 
@@ -47,6 +72,40 @@ ActorDefinition::ActorDefinition(XmlElement const& actorDefElement)
 	ParseInventory(actorDefElement);
 }
 
+void ActorDefinition::Initialize()
+{
+	m_factionId = FactionDefinition::GetIdByName(m_faction);
+	GUARANTEE_OR_DIE(m_factionId >= 0, Stringf("Actor definition \"%s\" has faction \"%s\", which FactionDefinitions.xml does not declare", m_actorName.c_str(), m_faction.c_str()));
+	ResolvePinnedHeight();
+
+	if (!m_spriteSheetPath.empty())
+	{
+		if (m_shaderName != "Default")
+		{
+			m_shader = g_shaderRegistry->CreateOrGetShader(m_shaderName, VertexType::VERTEX_PCUTBN);
+		}
+		Texture* spriteSheetTexture = g_assetLoader->CreateOrGetTexture(m_spriteSheetPath);
+		m_spriteSheet = new SpriteSheet(*spriteSheetTexture, m_cellCount);
+
+		for (int animGroupIndex = 0; animGroupIndex < static_cast<int>(m_animationGroupInfos.size()); ++animGroupIndex)
+		{
+			AnimationGroupInfo const& animGroupInfo = m_animationGroupInfos[animGroupIndex];
+			SpriteAnimationGroup* animGroup = new SpriteAnimationGroup(animGroupInfo.m_name, m_spriteSheet, animGroupInfo.m_secondsPerFrame, animGroupInfo.m_playbackMode, animGroupInfo.m_scaleBySpeed);
+			for (int directionIndex = 0; directionIndex < static_cast<int>(animGroupInfo.m_directions.size()); ++directionIndex)
+			{
+				AnimationDirectionInfo const& direction = animGroupInfo.m_directions[directionIndex];
+				animGroup->AddDirection(direction.m_direction, direction.m_startFrame, direction.m_endFrame);
+			}
+			m_animationGroups.push_back(animGroup);
+		}
+	}
+
+	for (int soundIndex = 0; soundIndex < static_cast<int>(m_sounds.size()); ++soundIndex)
+	{
+		g_theAudio->CreateOrGetSound(m_sounds[soundIndex].m_soundFilePath);
+	}
+}
+
 void ActorDefinition::ParseCollision(XmlElement const& actorDefElement)
 {
 	XmlElement const* collisionElement = actorDefElement.FirstChildElement("Collision");
@@ -77,6 +136,7 @@ void ActorDefinition::ParsePhysics(XmlElement const& actorDefElement)
 
 	m_isSimulated = ParseXmlAttribute(*physicsElement, "simulated", m_isSimulated);
 	m_isFlying	  = ParseXmlAttribute(*physicsElement, "flying", m_isFlying);
+	m_flyHeight   = ParseXmlAttribute(*physicsElement, "flyHeight", m_flyHeight);
 	m_walkSpeed   = ParseXmlAttribute(*physicsElement, "walkSpeed", m_walkSpeed);
 	m_runSpeed    = ParseXmlAttribute(*physicsElement, "runSpeed", m_runSpeed);
 	m_drag        = ParseXmlAttribute(*physicsElement, "drag", m_drag);
@@ -137,29 +197,49 @@ void ActorDefinition::ParseVisuals(XmlElement const& actorDefElement)
 	m_renderLit = ParseXmlAttribute(*visualElement, "renderLit", m_renderLit);
 	m_renderRounded = ParseXmlAttribute(*visualElement, "renderRounded", m_renderRounded);
 
-	// Shader parsing
-	std::string shader = ParseXmlAttribute(*visualElement, "shader", shader);
-	if (shader == "Default")
-	{
-		m_shader = nullptr;
-	}
-	else
-	{
-		m_shader = g_theRenderer->CreateShader(shader.c_str(), VertexType::VERTEX_PCUTBN);
-	}
-
-	// SpriteSheet parsing
-	std::string spritesheet = ParseXmlAttribute(*visualElement, "spriteSheet", spritesheet);
+	// Shader and SpriteSheet parsing
+	m_shaderName = ParseXmlAttribute(*visualElement, "shader", m_shaderName);
+	m_spriteSheetPath = ParseXmlAttribute(*visualElement, "spriteSheet", m_spriteSheetPath);
 	m_cellCount = ParseXmlAttribute(*visualElement, "cellCount", m_cellCount);
-	Texture* spriteSheetTextureImg = g_theRenderer->CreateOrGetTextureFromFile(spritesheet.c_str());
-	m_spriteSheet = new SpriteSheet(*spriteSheetTextureImg, m_cellCount);
 
 	// AnimationGroup parsing
 	for (XmlElement const* animGroupElement = visualElement->FirstChildElement("AnimationGroup"); animGroupElement != nullptr; animGroupElement = animGroupElement->NextSiblingElement("AnimationGroup"))
 	{
-		SpriteAnimationGroup* animGroup = new SpriteAnimationGroup(*animGroupElement, m_spriteSheet);
-		m_animationGroups.push_back(animGroup);
+		AnimationGroupInfo animGroupInfo;
+		animGroupInfo.m_name            = ParseXmlAttribute(*animGroupElement, "name", animGroupInfo.m_name);
+		animGroupInfo.m_secondsPerFrame = ParseXmlAttribute(*animGroupElement, "secondsPerFrame", animGroupInfo.m_secondsPerFrame);
+		animGroupInfo.m_scaleBySpeed    = ParseXmlAttribute(*animGroupElement, "scaleBySpeed", animGroupInfo.m_scaleBySpeed);
+		if (ParseXmlAttribute(*animGroupElement, "playbackMode", "") == "Loop")
+		{
+			animGroupInfo.m_playbackMode = SpriteAnimPlaybackType::LOOP;
+		}
+
+		for (XmlElement const* directionElement = animGroupElement->FirstChildElement("Direction"); directionElement != nullptr; directionElement = directionElement->NextSiblingElement("Direction"))
+		{
+			XmlElement const* animElement = directionElement->FirstChildElement("Animation");
+			GUARANTEE_OR_DIE(animElement != nullptr, Stringf("Actor definition \"%s\" has a direction without an animation element", m_actorName.c_str()));
+
+			AnimationDirectionInfo direction;
+			direction.m_direction  = ParseXmlAttribute(*directionElement, "vector", direction.m_direction).GetNormalized();
+			direction.m_startFrame = ParseXmlAttribute(*animElement, "startFrame", direction.m_startFrame);
+			direction.m_endFrame   = ParseXmlAttribute(*animElement, "endFrame", direction.m_endFrame);
+			animGroupInfo.m_directions.push_back(direction);
+		}
+		m_animationGroupInfos.push_back(animGroupInfo);
+	}
+}
+
+void ActorDefinition::ParseLight(XmlElement const& actorDefElement)
+{
+	XmlElement const* lightElement = actorDefElement.FirstChildElement("Light");
+	if (!lightElement)
+	{
+		return;
 	}
+
+	m_emitsLight  = true;
+	m_lightColor  = ParseXmlAttribute(*lightElement, "color", m_lightColor);
+	m_lightRadius = ParseXmlAttribute(*lightElement, "radius", m_lightRadius);
 }
 
 void ActorDefinition::ParseSounds(XmlElement const& actorDefElement)
@@ -177,7 +257,6 @@ void ActorDefinition::ParseSounds(XmlElement const& actorDefElement)
 		sounds.m_soundName = ParseXmlAttribute(*soundElement, "sound", sounds.m_soundName);
 		sounds.m_soundFilePath = ParseXmlAttribute(*soundElement, "name", sounds.m_soundFilePath);
 		m_sounds.push_back(sounds);
-		g_theAudio->CreateOrGetSound(sounds.m_soundFilePath);
 
 		soundElement = soundElement->NextSiblingElement("Sound");
 	}
@@ -257,6 +336,25 @@ void ActorDefinition::InitializeProjectileActorDefs()
 	}
 }
 
+// Enemy types and weapons are named in XML, any of which may load after this definition
+void ActorDefinition::ResolveReferences()
+{
+	for (int actorDefIndex = 0; actorDefIndex < static_cast<int>(s_actorDefinitions.size()); ++actorDefIndex)
+	{
+		ActorDefinition* actorDef = s_actorDefinitions[actorDefIndex];
+		actorDef->m_enemyTypeDef = GetByActorName(actorDef->m_enemyType);
+		GUARANTEE_OR_DIE(actorDef->m_enemyTypeDef != nullptr, Stringf("Actor definition \"%s\" spawns unknown actor \"%s\"", actorDef->m_actorName.c_str(), actorDef->m_enemyType.c_str()));
+
+		actorDef->m_weaponDefs.clear();
+		for (int weaponIndex = 0; weaponIndex < static_cast<int>(actorDef->m_weaponNames.size()); ++weaponIndex)
+		{
+			WeaponDefinition* weaponDef = WeaponDefinition::GetByWeaponName(actorDef->m_weaponNames[weaponIndex]);
+			GUARANTEE_OR_DIE(weaponDef != nullptr, Stringf("Actor definition \"%s\" carries unknown weapon \"%s\"", actorDef->m_actorName.c_str(), actorDef->m_weaponNames[weaponIndex].c_str()));
+			actorDef->m_weaponDefs.push_back(weaponDef);
+		}
+	}
+}
+
 ActorDefinition* ActorDefinition::GetByActorName(std::string const& name)
 {
 	for (int actorDefIndex = 0; actorDefIndex < static_cast<int>(s_actorDefinitions.size()); ++actorDefIndex)
@@ -292,3 +390,30 @@ std::string ActorDefinition::GetSoundByName(std::string const& soundName)
 	}
 	return "default";
 }
+
+bool ActorDefinition::HasStaticLight() const
+{
+	// Lights that never move are baked into the lightmap instead of the light grid
+	return m_emitsLight && !m_isSimulated;
+}
+
+// Walkers stay on the floor and flyers with a flyHeight hover at it, decided
+// once here so the physics pass blends instead of branching per actor
+void ActorDefinition::ResolvePinnedHeight()
+{
+	if (!m_isFlying)
+	{
+		m_heightPinWeight = 1.0f;
+		m_pinnedHeight = 0.0f;
+	}
+	else if (m_flyHeight > 0.0f)
+	{
+		m_heightPinWeight = 1.0f;
+		m_pinnedHeight = m_flyHeight;
+	}
+	else
+	{
+		m_heightPinWeight = 0.0f;
+		m_pinnedHeight = 0.0f;
+	}
+}
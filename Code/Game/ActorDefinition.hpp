@@ -1,5 +1,6 @@
 #pragma once
 #include "Engine/Core/XmlUtils.hpp"
+#include "Engine/Core/Rgba8.h"
 #include "Engine/Renderer/SpriteAnimDefinition.hpp"
 #include "Engine/Math/MathUtils.h"
 #include <map>
@@ -7,38 +8,72 @@
 // -----------------------------------------------------------------------------
 class Shader;
 class SpriteAnimationGroup;
+struct WeaponDefinition;
 // -----------------------------------------------------------------------------
 struct Sounds
 {
 	std::string   m_soundName;
 	std::string   m_soundFilePath;
 };
+// -----------------------------------------------------------------------------
+// An animation group as parsed, turned into a SpriteAnimationGroup once the
+// definition's sprite sheet exists
+// -----------------------------------------------------------------------------
+struct AnimationDirectionInfo
+{
+	Vec3 m_direction = Vec3::ZERO;
+	int  m_startFrame = -1;
+	int  m_endFrame = -1;
+};
+struct AnimationGroupInfo
+{
+	std::string            m_name;
+	float                  m_secondsPerFrame = 0.f;
+	SpriteAnimPlaybackType m_playbackMode = SpriteAnimPlaybackType::ONCE;
+	bool                   m_scaleBySpeed = false;
+	std::vector<AnimationDirectionInfo> m_directions;
+};
+// -----------------------------------------------------------------------------
+// Parsing only fills in fields, Initialize then looks up the faction and
+// creates the shader, sprite sheet, animations and sounds. A definition built
+// from a cooked bundle sets the same fields and runs the same Initialize.
+// Names of other definitions are kept as parsed and resolved into pointers
+// by ResolveReferences once every definition is loaded.
+// -----------------------------------------------------------------------------
 struct ActorDefinition
 {
 	ActorDefinition();
 	ActorDefinition(XmlElement const& actorDefElement);
+	~ActorDefinition();
 	static std::vector<ActorDefinition*> s_actorDefinitions;
 // -----------------------------------------------------------------------------
+	void ParseXmlElement(XmlElement const& actorDefElement);
+	void Initialize();
 	void ParseCollision(XmlElement const& actorDefElement);
 	void ParsePhysics(XmlElement const& actorDefElement);
 	void ParseCamera(XmlElement const& actorDefElement);
 	void ParseAI(XmlElement const& actorDefElement);
 	void ParseVisuals(XmlElement const& actorDefElement);
+	void ParseLight(XmlElement const& actorDefElement);
 	void ParseSounds(XmlElement const& actorDefElement);
 	void ParseSpawning(XmlElement const& actorDefElement);
 	void ParseInventory(XmlElement const& actorDefElement);
 // -----------------------------------------------------------------------------
 	static void InitializeActorDefs();
 	static void InitializeProjectileActorDefs();
+	static void ResolveReferences();
 	static ActorDefinition* GetByActorName(std::string const& name);
 	SpriteAnimationGroup* GetAnimationByName(std::string const& animationName);
 	std::string GetSoundByName(std::string const& soundName);
+	bool HasStaticLight() const;
+	void ResolvePinnedHeight();
 // -----------------------------------------------------------------------------
 	std::string m_actorName;
 	bool		m_isVisible = false;
 	int			m_health = 1;
 	float		m_corpseLifetime = 0.0f;
 	std::string m_faction = "NEUTRAL";
+	int			m_factionId = -1;
 	bool		m_canBePossessed = false;
 	float		m_physicsRadius = 0.0f;
 	float		m_physicsHeight = 0.0f;
@@ -52,16 +87,20 @@ struct ActorDefinition
 	float		m_impulseOnCollide = 0.0f;
 	bool		m_isSimulated = false;
 	bool		m_isFlying = false;
+	float		m_flyHeight = 0.0f;		// Flying actors above zero hover at this height instead of moving freely in z
 	float		m_walkSpeed = 0.0f;
 	float		m_runSpeed = 0.0f;
 	float		m_drag = 0.0f;
 	float		m_turnSpeed = 0.0f;
+	float		m_heightPinWeight = 1.0f;	// 1 when physics holds the actor at m_pinnedHeight, 0 when it moves freely in z
+	float		m_pinnedHeight = 0.0f;
 	float		m_eyeHeight = 0.0f;
 	float		m_cameraFOVDeg = 60.0f;
 	bool		m_isAIEnabled = false;
 	float		m_sightRadius = 0.0f;
 	float		m_sightAngle = 0.0f;
-	std::vector<std::string> m_weaponNames;
+	std::vector<std::string> m_weaponNames;		// As parsed, see m_weaponDefs
+	std::vector<WeaponDefinition*> m_weaponDefs;
 // -----------------------------------------------------------------------------
 	bool          m_dieOnSpawn = false;
 	Vec2		  m_spriteSize = Vec2::ONE;
@@ -69,15 +108,22 @@ struct ActorDefinition
 	BillboardType m_billboardType = BillboardType::NONE;
 	bool          m_renderLit = false;
 	bool		  m_renderRounded = false;
+	std::string   m_shaderName;
+	std::string   m_spriteSheetPath;
 	Shader*		  m_shader = nullptr;
 	SpriteSheet*  m_spriteSheet = nullptr;
 	IntVec2       m_cellCount = IntVec2::ONE;
 	Vec3		  m_direction = Vec3::XAXE;
 	int			  m_startFrame = 0;
 	int			  m_endFrame = 0;
+	std::vector<AnimationGroupInfo> m_animationGroupInfos;
 	std::vector<SpriteAnimationGroup*> m_animationGroups;
+	bool		  m_emitsLight = false;
+	Rgba8		  m_lightColor = Rgba8::WHITE;
+	float		  m_lightRadius = 0.0f;
 	std::vector<Sounds> m_sounds;
-	std::string   m_enemyType = "Imp";
+	std::string   m_enemyType = "Imp";		// As parsed, see m_enemyTypeDef
+	ActorDefinition* m_enemyTypeDef = nullptr;
 	float         m_spawnInterval = 0.0f;
 // -----------------------------------------------------------------------------
 };
\ No newline at end of file
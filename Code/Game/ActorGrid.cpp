@@ -0,0 +1,499 @@
+#include "Game/ActorGrid.hpp"
+#include "Game/GameCommon.h"
+#include "Game/Actor.hpp"
+#include "Game/ActorHandle.hpp"
+#include "Game/BenchHelpers.hpp"
+#include "Game/FactionDefinition.hpp"
+#include "Game/FactionRoster.hpp"
+#include "Game/Game.h"
+#include "Game/Map.hpp"
+#include "Engine/Core/DevConsole.hpp"
+#include "Engine/Core/EngineCommon.h"
+#include "Engine/Core/Time.hpp"
+#include "Engine/Math/MathUtils.h"
+#include <algorithm>
+#include <cmath>
+
+// Actors are assumed to move at most this many times their last speed before the next build
+static constexpr float ACTOR_GRID_SPEED_MARGIN = 2.f;
+
+bool ActorQueryFilter::Accepts(Actor const& actor) const
+{
+	if (&actor == m_ignoreActor)
+	{
+		return false;
+	}
+	if (m_aliveOnly && actor.m_isDead)
+	{
+		return false;
+	}
+	if (m_collidersOnly && !actor.m_actorDef->m_collidesWithActors)
+	{
+		return false;
+	}
+	if (m_hostileTo != nullptr)
+	{
+		if (!FactionDefinition::IsHostile(m_hostileTo->m_actorDef->m_factionId, actor.m_actorDef->m_factionId))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+void ActorGrid::Initialize(ActorList const& actors, FactionRoster const& factionRoster, IntVec2 const& mapDimensions, int tilesPerCell)
+{
+	m_actors = &actors;
+	m_factionRoster = &factionRoster;
+	m_tilesPerCell = tilesPerCell;
+	m_cellCounts.x = (mapDimensions.x + tilesPerCell - 1) / tilesPerCell;
+	m_cellCounts.y = (mapDimensions.y + tilesPerCell - 1) / tilesPerCell;
+	m_cellCounts.x = (m_cellCounts.x < 1) ? 1 : m_cellCounts.x;
+	m_cellCounts.y = (m_cellCounts.y < 1) ? 1 : m_cellCounts.y;
+	Clear();
+}
+
+// Until the next build every actor is checked one by one
+void ActorGrid::Clear()
+{
+	m_cellActorStarts.assign(GetNumCells() + 1, 0);
+	m_cellActorIndexes.clear();
+	m_numIndexedSlots = 0;
+	m_slack = 0.f;
+}
+
+// -----------------------------------------------------------------------------
+// Counting sort of every live actor into the cell under its position. The slack
+// covers how far actors may move before the next build: their fastest speed for
+// movementSeconds, plus one physics radius for collision pushes.
+// -----------------------------------------------------------------------------
+void ActorGrid::Build(float movementSeconds)
+{
+	ActorList const& actors = *m_actors;
+	int numSlots = static_cast<int>(actors.size());
+	int numCells = GetNumCells();
+	m_cellActorStarts.assign(numCells + 1, 0);
+	m_actorCells.assign(numSlots, -1);
+
+	float maxSpeedSquared = 0.f;
+	m_maxPhysicsRadius = 0.f;
+	for (int actorIndex = 0; actorIndex < numSlots; ++actorIndex)
+	{
+		Actor const* actor = actors[actorIndex];
+		if (actor == nullptr)
+		{
+			continue;
+		}
+		IntVec2 cellCoords = GetCellCoords(actor->m_position.GetXY());
+		int cellIndex = GetCellIndex(cellCoords.x, cellCoords.y);
+		m_actorCells[actorIndex] = cellIndex;
+		m_cellActorStarts[cellIndex + 1] += 1;
+
+		maxSpeedSquared = std::max(maxSpeedSquared, actor->m_velocity.GetLengthSquared());
+		m_maxPhysicsRadius = std::max(m_maxPhysicsRadius, actor->m_physicsRadius);
+	}
+
+	for (int cellIndex = 0; cellIndex < numCells; ++cellIndex)
+	{
+		m_cellActorStarts[cellIndex + 1] += m_cellActorStarts[cellIndex];
+	}
+	m_cellActorIndexes.resize(m_cellActorStarts[numCells]);
+
+	// Scatter in index order so each cell lists its actors in ascending index
+	for (int actorIndex = 0; actorIndex < numSlots; ++actorIndex)
+	{
+		if (m_actorCells[actorIndex] >= 0)
+		{
+			m_cellActorIndexes[m_cellActorStarts[m_actorCells[actorIndex]]++] = actorIndex;
+		}
+	}
+	for (int cellIndex = numCells; cellIndex > 0; --cellIndex)
+	{
+		m_cellActorStarts[cellIndex] = m_cellActorStarts[cellIndex - 1];
+	}
+	m_cellActorStarts[0] = 0;
+
+	m_numIndexedSlots = numSlots;
+	m_slack = (ACTOR_GRID_SPEED_MARGIN * sqrtf(maxSpeedSquared) * movementSeconds) + m_maxPhysicsRadius;
+}
+
+void ActorGrid::QueryDisc(Vec2 const& center, float radius, ActorQueryFilter const& filter, ActorList& outActors) const
+{
+	outActors.clear();
+	std::vector<int>& candidates = m_candidateScratch;
+	GatherQueryCandidates(center, radius, filter, candidates);
+
+	float radiusSquared = radius * radius;
+	for (int candidateIndex = 0; candidateIndex < static_cast<int>(candidates.size()); ++candidateIndex)
+	{
+		Actor* actor = (*m_actors)[candidates[candidateIndex]];
+		if (filter.Accepts(*actor) && GetDistanceSquared2D(actor->m_position.GetXY(), center) <= radiusSquared)
+		{
+			outActors.push_back(actor);
+		}
+	}
+}
+
+void ActorGrid::QuerySector(Vec2 const& center, Vec2 const& forward, float apertureDegrees, float radius, ActorQueryFilter const& filter, ActorList& outActors) const
+{
+	outActors.clear();
+	std::vector<int>& candidates = m_candidateScratch;
+	GatherQueryCandidates(center, radius, filter, candidates);
+
+	Vec2 forwardNormal = forward.GetNormalized();
+	for (int candidateIndex = 0; candidateIndex < static_cast<int>(candidates.size()); ++candidateIndex)
+	{
+		Actor* actor = (*m_actors)[candidates[candidateIndex]];
+		if (filter.Accepts(*actor) && IsPointInsideDirectedSector2D(actor->m_position.GetXY(), center, forwardNormal, apertureDegrees, radius))
+		{
+			outActors.push_back(actor);
+		}
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Searches rings of cells outward from the center and stops once the nearest
+// actors found are closer than anything in an unsearched ring could be.
+// Results are sorted nearest first.
+// -----------------------------------------------------------------------------
+void ActorGrid::QueryKNearest(Vec2 const& center, int numNearest, float maxRadius, ActorQueryFilter const& filter, ActorList& outActors) const
+{
+	outActors.clear();
+	if (numNearest <= 0)
+	{
+		return;
+	}
+
+	std::vector<std::pair<float, int>>& nearest = m_nearestScratch;		// Max heap on distance, then index
+	nearest.clear();
+	float maxRadiusSquared = maxRadius * maxRadius;
+	auto considerActor = [&](int actorIndex)
+	{
+		Actor const* actor = (actorIndex < static_cast<int>(m_actors->size())) ? (*m_actors)[actorIndex] : nullptr;
+		if (actor == nullptr || !filter.Accepts(*actor))
+		{
+			return;
+		}
+		float distanceSquared = GetDistanceSquared2D(actor->m_position.GetXY(), center);
+		if (distanceSquared > maxRadiusSquared)
+		{
+			return;
+		}
+		std::pair<float, int> entry(distanceSquared, actorIndex);
+		if (static_cast<int>(nearest.size()) < numNearest)
+		{
+			nearest.push_back(entry);
+			std::push_heap(nearest.begin(), nearest.end());
+		}
+		else if (entry < nearest.front())
+		{
+			std::pop_heap(nearest.begin(), nearest.end());
+			nearest.back() = entry;
+			std::push_heap(nearest.begin(), nearest.end());
+		}
+	};
+
+	// Positions off the grid were clamped into edge cells, so only a center on the grid can stop early
+	float cellSize = static_cast<float>(m_tilesPerCell);
+	bool isCenterOnGrid = center.x >= 0.f && center.y >= 0.f && center.x < cellSize * static_cast<float>(m_cellCounts.x) && center.y < cellSize * static_cast<float>(m_cellCounts.y);
+	IntVec2 centerCell = GetCellCoords(center);
+	int maxRing = std::max(m_cellCounts.x, m_cellCounts.y);
+	for (int ring = 0; ring <= maxRing; ++ring)
+	{
+		for (int cellY = centerCell.y - ring; cellY <= centerCell.y + ring; ++cellY)
+		{
+			if (cellY < 0 || cellY >= m_cellCounts.y)
+			{
+				continue;
+			}
+			bool isEdgeRow = (cellY == centerCell.y - ring) || (cellY == centerCell.y + ring);
+			int cellXStep = isEdgeRow ? 1 : 2 * ring;
+			for (int cellX = centerCell.x - ring; cellX <= centerCell.x + ring; cellX += (cellXStep > 0) ? cellXStep : 1)
+			{
+				if (cellX < 0 || cellX >= m_cellCounts.x)
+				{
+					continue;
+				}
+				int cellIndex = GetCellIndex(cellX, cellY);
+				for (int entryIndex = m_cellActorStarts[cellIndex]; entryIndex < m_cellActorStarts[cellIndex + 1]; ++entryIndex)
+				{
+					considerActor(m_cellActorIndexes[entryIndex]);
+				}
+			}
+		}
+
+		float searchedRadius = (static_cast<float>(ring) * cellSize) - m_slack;
+		if (isCenterOnGrid && searchedRadius > 0.f)
+		{
+			bool isNearestComplete = static_cast<int>(nearest.size()) == numNearest && nearest.front().first <= searchedRadius * searchedRadius;
+			if (isNearestComplete || searchedRadius > maxRadius)
+			{
+				break;
+			}
+		}
+	}
+
+	for (int actorIndex = m_numIndexedSlots; actorIndex < static_cast<int>(m_actors->size()); ++actorIndex)
+	{
+		considerActor(actorIndex);
+	}
+
+	std::sort_heap(nearest.begin(), nearest.end());
+	for (int entryIndex = 0; entryIndex < static_cast<int>(nearest.size()); ++entryIndex)
+	{
+		outActors.push_back((*m_actors)[nearest[entryIndex].second]);
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Every live actor whose position may be within radius of the center, padded by
+// the slack. The caller does the exact test against live positions.
+// -----------------------------------------------------------------------------
+void ActorGrid::GatherCandidateIndexes(Vec2 const& center, float radius, std::vector<int>& outIndexes) const
+{
+	outIndexes.clear();
+	float paddedRadius = radius + m_slack;
+	IntVec2 cellMins = GetCellCoords(center - Vec2(paddedRadius, paddedRadius));
+	IntVec2 cellMaxs = GetCellCoords(center + Vec2(paddedRadius, paddedRadius));
+	for (int cellY = cellMins.y; cellY <= cellMaxs.y; ++cellY)
+	{
+		for (int cellX = cellMins.x; cellX <= cellMaxs.x; ++cellX)
+		{
+			AddCellCandidates(cellX, cellY, outIndexes);
+		}
+	}
+
+	ActorList const& actors = *m_actors;
+	int numSlots = static_cast<int>(actors.size());
+	for (int actorIndex = m_numIndexedSlots; actorIndex < numSlots; ++actorIndex)
+	{
+		if (actors[actorIndex] != nullptr)
+		{
+			outIndexes.push_back(actorIndex);
+		}
+	}
+}
+
+// -----------------------------------------------------------------------------
+// A demon looking for marines only has a handful of actors it could hit, so
+// when the hostile factions are small they are tested directly instead of
+// every nearby cell full of other demons.
+// -----------------------------------------------------------------------------
+void ActorGrid::GatherQueryCandidates(Vec2 const& center, float radius, ActorQueryFilter const& filter, std::vector<int>& outIndexes) const
+{
+	int factionId = (filter.m_hostileTo != nullptr) ? filter.m_hostileTo->m_actorDef->m_factionId : -1;
+	if (factionId < 0 || m_factionRoster->GetNumHostileActors(factionId) > ACTOR_QUERY_MAX_HOSTILE_SCAN)
+	{
+		GatherCandidateIndexes(center, radius, outIndexes);
+		return;
+	}
+
+	outIndexes.clear();
+	for (int otherFactionId = 0; otherFactionId < m_factionRoster->GetNumFactions(); ++otherFactionId)
+	{
+		if (FactionDefinition::IsHostile(factionId, otherFactionId))
+		{
+			std::vector<int> const& actorIndexes = m_factionRoster->GetFaction(otherFactionId).m_actorIndexes;
+			outIndexes.insert(outIndexes.end(), actorIndexes.begin(), actorIndexes.end());
+		}
+	}
+}
+
+float ActorGrid::GetMaxPhysicsRadius() const
+{
+	return m_maxPhysicsRadius;
+}
+
+int ActorGrid::GetNumCells() const
+{
+	return m_cellCounts.x * m_cellCounts.y;
+}
+
+int ActorGrid::GetCellIndex(int cellX, int cellY) const
+{
+	return (cellY * m_cellCounts.x) + cellX;
+}
+
+// Positions off the map clamp to the nearest edge cell
+IntVec2 ActorGrid::GetCellCoords(Vec2 const& position) const
+{
+	float cellSize = static_cast<float>(m_tilesPerCell);
+	int cellX = RoundDownToInt(GetClamped(position.x / cellSize, 0.f, static_cast<float>(m_cellCounts.x - 1)));
+	int cellY = RoundDownToInt(GetClamped(position.y / cellSize, 0.f, static_cast<float>(m_cellCounts.y - 1)));
+	return IntVec2(cellX, cellY);
+}
+
+// Slots emptied since the build are skipped
+void ActorGrid::AddCellCandidates(int cellX, int cellY, std::vector<int>& outIndexes) const
+{
+	ActorList const& actors = *m_actors;
+	int numSlots = static_cast<int>(actors.size());
+	int cellIndex = GetCellIndex(cellX, cellY);
+	for (int entryIndex = m_cellActorStarts[cellIndex]; entryIndex < m_cellActorStarts[cellIndex + 1]; ++entryIndex)
+	{
+		int actorIndex = m_cellActorIndexes[entryIndex];
+		if (actorIndex < numSlots && actors[actorIndex] != nullptr)
+		{
+			outIndexes.push_back(actorIndex);
+		}
+	}
+}
+
+// Brute force references for the bench, the same tests the grid makes
+static void QueryAllActors(ActorList const& actors, Vec2 const& center, Vec2 const& forward, float apertureDegrees, float radius, ActorQueryFilter const& filter, ActorList& outActors)
+{
+	outActors.clear();
+	Vec2 forwardNormal = forward.GetNormalized();
+	for (int actorIndex = 0; actorIndex < static_cast<int>(actors.size()); ++actorIndex)
+	{
+		Actor* actor = actors[actorIndex];
+		if (actor == nullptr || !filter.Accepts(*actor))
+		{
+			continue;
+		}
+		Vec2 actorPosXY = actor->m_position.GetXY();
+		bool isInside = (apertureDegrees >= 360.f) ? GetDistanceSquared2D(actorPosXY, center) <= radius * radius : IsPointInsideDirectedSector2D(actorPosXY, center, forwardNormal, apertureDegrees, radius);
+		if (isInside)
+		{
+			outActors.push_back(actor);
+		}
+	}
+}
+
+static bool AreSameActors(ActorList& actorsA, ActorList& actorsB)
+{
+	std::sort(actorsA.begin(), actorsA.end());
+	std::sort(actorsB.begin(), actorsB.end());
+	return actorsA == actorsB;
+}
+
+// -----------------------------------------------------------------------------
+// Dev console: ActorQueryBench actors=<count> queries=<count>
+// Fills the running map with extra demons, checks sector and k-nearest queries
+// against brute force scans, then prints queries per second for each kind.
+// -----------------------------------------------------------------------------
+bool ActorGrid::Command_ActorQueryBench(EventArgs& args)
+{
+	Map* map = g_theGame->m_defaultMap;
+	if (g_theGame->m_currentState != GameState::PLAYING || map == nullptr)
+	{
+		g_theDevConsole->AddLine(Rgba8::RED, "ActorQueryBench needs a game in progress");
+		return false;
+	}
+
+	int numActors = args.GetValue("actors", 20000);
+	int numQueries = args.GetValue("queries", 20000);
+	numQueries = (numQueries < 1) ? 1 : numQueries;
+	int maxActors = static_cast<int>(ActorHandle::MAX_ACTOR_INDEX) - static_cast<int>(map->m_allActors.size());
+	numActors = (numActors < 0) ? 0 : ((numActors > maxActors) ? maxActors : numActors);
+
+	std::vector<IntVec2> openTiles;
+	if (!GatherOpenTiles(*map, "ActorQueryBench", openTiles))
+	{
+		return false;
+	}
+
+	std::vector<ActorHandle> benchActors;
+	for (int spawnIndex = 0; spawnIndex < numActors; ++spawnIndex)
+	{
+		IntVec2 tileCoords = RollOpenTile(openTiles);
+
+		SpawnInfo spawnInfo;
+		spawnInfo.m_actorDef = ActorDefinition::GetByActorName("Demon");
+		spawnInfo.m_position = Vec3(GetBenchRng().RollRandomFloatInRange(0.f, 1.f) + static_cast<float>(tileCoords.x), GetBenchRng().RollRandomFloatInRange(0.f, 1.f) + static_cast<float>(tileCoords.y), 0.f);
+		spawnInfo.m_orientation = EulerAngles(GetBenchRng().RollRandomFloatInRange(0.f, 360.f), 0.f, 0.f);
+		benchActors.push_back(map->SpawnActor(spawnInfo)->m_actorHandle);
+	}
+
+	double buildStart = GetCurrentTimeSeconds();
+	map->m_actorGrid.Build(0.f);
+	double buildSeconds = GetCurrentTimeSeconds() - buildStart;
+
+	std::vector<Vec2> centers(numQueries);
+	std::vector<Vec2> forwards(numQueries);
+	for (int queryIndex = 0; queryIndex < numQueries; ++queryIndex)
+	{
+		centers[queryIndex] = Vec2(GetBenchRng().RollRandomFloatInRange(0.f, static_cast<float>(map->m_dimensions.x)), GetBenchRng().RollRandomFloatInRange(0.f, static_cast<float>(map->m_dimensions.y)));
+		forwards[queryIndex] = Vec2::MakeFromPolarDegrees(GetBenchRng().RollRandomFloatInRange(0.f, 360.f));
+	}
+
+	ActorQueryFilter filter;
+	filter.m_aliveOnly = true;
+	ActorList results;
+	ActorList expected;
+	int numResults = 0;
+
+	double discStart = GetCurrentTimeSeconds();
+	for (int queryIndex = 0; queryIndex < numQueries; ++queryIndex)
+	{
+		map->QueryActorsInDisc(centers[queryIndex], 2.f, filter, results);
+		numResults += static_cast<int>(results.size());
+	}
+	double discSeconds = GetCurrentTimeSeconds() - discStart;
+
+	double sectorStart = GetCurrentTimeSeconds();
+	for (int queryIndex = 0; queryIndex < numQueries; ++queryIndex)
+	{
+		map->QueryActorsInSector(centers[queryIndex], forwards[queryIndex], 90.f, 4.f, filter, results);
+		numResults += static_cast<int>(results.size());
+	}
+	double sectorSeconds = GetCurrentTimeSeconds() - sectorStart;
+
+	double nearestStart = GetCurrentTimeSeconds();
+	for (int queryIndex = 0; queryIndex < numQueries; ++queryIndex)
+	{
+		map->QueryKNearest(centers[queryIndex], 8, 16.f, filter, results);
+		numResults += static_cast<int>(results.size());
+	}
+	double nearestSeconds = GetCurrentTimeSeconds() - nearestStart;
+
+	// Brute force is slow enough that a few hundred queries make the comparison
+	int numChecked = std::min(numQueries, 200);
+	double bruteStart = GetCurrentTimeSeconds();
+	for (int queryIndex = 0; queryIndex < numChecked; ++queryIndex)
+	{
+		QueryAllActors(map->m_allActors, centers[queryIndex], forwards[queryIndex], 90.f, 4.f, filter, expected);
+	}
+	double bruteSeconds = GetCurrentTimeSeconds() - bruteStart;
+
+	int numMismatches = 0;
+	for (int queryIndex = 0; queryIndex < numChecked; ++queryIndex)
+	{
+		QueryAllActors(map->m_allActors, centers[queryIndex], forwards[queryIndex], 90.f, 4.f, filter, expected);
+		map->QueryActorsInSector(centers[queryIndex], forwards[queryIndex], 90.f, 4.f, filter, results);
+		numMismatches += AreSameActors(results, expected) ? 0 : 1;
+
+		QueryAllActors(map->m_allActors, centers[queryIndex], Vec2(1.f, 0.f), 360.f, 16.f, filter, expected);
+		std::sort(expected.begin(), expected.end(), [&](Actor const* actorA, Actor const* actorB)
+		{
+			float distanceA = GetDistanceSquared2D(actorA->m_position.GetXY(), centers[queryIndex]);
+			float distanceB = GetDistanceSquared2D(actorB->m_position.GetXY(), centers[queryIndex]);
+			return (distanceA != distanceB) ? distanceA < distanceB : actorA->m_actorHandle.GetIndex() < actorB->m_actorHandle.GetIndex();
+		});
+		expected.resize(std::min(static_cast<int>(expected.size()), 8));
+		map->QueryKNearest(centers[queryIndex], 8, 16.f, filter, results);
+		numMismatches += (results == expected) ? 0 : 1;
+	}
+
+	for (int actorIndex = 0; actorIndex < static_cast<int>(benchActors.size()); ++actorIndex)
+	{
+		Actor* actor = map->GetActorByHandle(benchActors[actorIndex]);
+		if (actor != nullptr)
+		{
+			actor->Destroy();
+		}
+	}
+	map->DeleteDestroyedActors();
+	map->m_actorGrid.Build(0.f);
+
+	auto getQueriesPerSecond = [](int count, double seconds)
+	{
+		return (seconds > 0.0) ? static_cast<double>(count) / seconds : 0.0;
+	};
+	g_theDevConsole->AddLine((numMismatches == 0) ? Rgba8::LIGHTYELLOW : Rgba8::RED, Stringf("Actor query bench: %d extra actors, %d cells, build %.3f ms, %d of %d checked queries differ from brute force",
+		numActors, map->m_actorGrid.GetNumCells(), buildSeconds * 1000.0, numMismatches, numChecked * 2));
+	g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, Stringf("Queries per second: disc %.0f, sector %.0f, 8 nearest %.0f, brute force sector %.0f (%d results)",
+		getQueriesPerSecond(numQueries, discSeconds), getQueriesPerSecond(numQueries, sectorSeconds), getQueriesPerSecond(numQueries, nearestSeconds),
+		getQueriesPerSecond(numChecked, bruteSeconds), numResults));
+	return true;
+}
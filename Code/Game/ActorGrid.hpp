@@ -0,0 +1,70 @@
+#pragma once
+#include "Engine/Core/EventSystem.hpp"
+#include "Engine/Math/IntVec2.h"
+#include "Engine/Math/Vec2.hpp"
+#include <utility>
+#include <vector>
+// -----------------------------------------------------------------------------
+class Actor;
+class FactionRoster;
+typedef std::vector<Actor*> ActorList;
+// -----------------------------------------------------------------------------
+constexpr int ACTOR_GRID_TILES_PER_CELL = 2;
+constexpr int ACTOR_QUERY_MAX_HOSTILE_SCAN = 32;	// Hostile queries test the hostile factions directly when they are this small
+// -----------------------------------------------------------------------------
+struct ActorQueryFilter
+{
+	Actor const* m_ignoreActor = nullptr;	// Usually the actor asking
+	Actor const* m_hostileTo = nullptr;		// Only actors this one's faction is hostile toward
+	bool         m_aliveOnly = false;
+	bool         m_collidersOnly = false;	// Only actors that collide with other actors
+
+	bool Accepts(Actor const& actor) const;
+};
+// -----------------------------------------------------------------------------
+// Uniform grid of actor indexes over the map, rebuilt with a counting sort
+// like the light grid. Queries test live positions, so actors that moved since
+// the build are still found as long as they stayed within the slack the build
+// allowed for; actors spawned since the build are checked one by one.
+// -----------------------------------------------------------------------------
+class ActorGrid
+{
+public:
+	ActorGrid() = default;
+
+	void Initialize(ActorList const& actors, FactionRoster const& factionRoster, IntVec2 const& mapDimensions, int tilesPerCell);
+	void Clear();
+	void Build(float movementSeconds);
+
+	void QueryDisc(Vec2 const& center, float radius, ActorQueryFilter const& filter, ActorList& outActors) const;
+	void QuerySector(Vec2 const& center, Vec2 const& forward, float apertureDegrees, float radius, ActorQueryFilter const& filter, ActorList& outActors) const;
+	void QueryKNearest(Vec2 const& center, int numNearest, float maxRadius, ActorQueryFilter const& filter, ActorList& outActors) const;
+	void GatherCandidateIndexes(Vec2 const& center, float radius, std::vector<int>& outIndexes) const;
+
+	float GetMaxPhysicsRadius() const;
+	int   GetNumCells() const;
+
+	static bool Command_ActorQueryBench(EventArgs& args);
+// -----------------------------------------------------------------------------
+private:
+	int  GetCellIndex(int cellX, int cellY) const;
+	IntVec2 GetCellCoords(Vec2 const& position) const;
+	void AddCellCandidates(int cellX, int cellY, std::vector<int>& outIndexes) const;
+	void GatherQueryCandidates(Vec2 const& center, float radius, ActorQueryFilter const& filter, std::vector<int>& outIndexes) const;
+// -----------------------------------------------------------------------------
+	ActorList const* m_actors = nullptr;
+	FactionRoster const* m_factionRoster = nullptr;
+	IntVec2 m_cellCounts = IntVec2::ZERO;
+	int     m_tilesPerCell = ACTOR_GRID_TILES_PER_CELL;
+
+	std::vector<int> m_actorCells;			// By actor index, -1 when not indexed
+	std::vector<int> m_cellActorStarts;
+	std::vector<int> m_cellActorIndexes;
+	int   m_numIndexedSlots = 0;			// Slots past this were added after the build
+	float m_slack = 0.f;
+	float m_maxPhysicsRadius = 0.f;
+
+	// Reused by queries so they don't allocate, main thread only
+	mutable std::vector<int> m_candidateScratch;
+	mutable std::vector<std::pair<float, int>> m_nearestScratch;
+};
@@ -27,6 +27,11 @@ unsigned int ActorHandle::GetIndex() const
 	return m_data & 0xFFFF;
 }
 
+unsigned int ActorHandle::GetData() const
+{
+	return m_data;
+}
+
 bool ActorHandle::operator==(ActorHandle const& other) const
 {
 	return m_data == other.m_data;
@@ -8,6 +8,7 @@ public:
 
 	bool IsValid() const;
 	unsigned int GetIndex() const;
+	unsigned int GetData() const;
 	bool operator==(ActorHandle const& other) const;
 	bool operator!=(ActorHandle const& other) const;
 
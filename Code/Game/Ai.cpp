@@ -5,6 +5,7 @@
 #include "Game/SpriteAnimationGroup.hpp"
 #include "Game/Actor.hpp"
 #include "Engine/Core/EngineCommon.h"
+#include "Engine/Core/Time.hpp"
 
 AI::AI(Map* currentMap)
 	:Controller(currentMap)
@@ -19,10 +20,33 @@ void AI::Update(float deltaseconds)
 		return;
 	}
 
+	AILevelOfDetail& aiLod = m_theMap->m_aiLod;
+	AILodTier tier = aiLod.GetTier(*self);
+	aiLod.CountAgent(tier);
+	m_pendingSeconds += deltaseconds;
+	if (aiLod.IsUpdateTick(tier, m_currentHandle))
+	{
+		double thinkStart = GetCurrentTimeSeconds();
+		Think(*self, m_pendingSeconds);
+		aiLod.RecordUpdate(tier, GetCurrentTimeSeconds() - thinkStart);
+		m_pendingSeconds = 0.f;
+	}
+
+	// Physics clears acceleration every step, so the chosen move is pushed every tick
+	if (m_moveSpeed > 0.f && !self->IsDead())
+	{
+		self->MoveInDirection(m_moveDirection, m_moveSpeed);
+	}
+}
+
+void AI::Think(Actor& self, float deltaSeconds)
+{
+	m_moveSpeed = 0.f;
+
 	//-------------------------------------------------------------------------
 	// Target acquisition
 	//-------------------------------------------------------------------------
-	Actor const* visibleEnemy = m_theMap->GetClosestVisibleEnemy(self);
+	Actor const* visibleEnemy = m_theMap->GetClosestVisibleEnemy(&self);
 	if (visibleEnemy && !visibleEnemy->IsDead() && m_targetActorHandle != visibleEnemy->m_actorHandle)
 	{
 		m_targetActorHandle = visibleEnemy->m_actorHandle;
@@ -38,23 +62,24 @@ void AI::Update(float deltaseconds)
 	//-------------------------------------------------------------------------
 	// Facing/movement
 	//-------------------------------------------------------------------------
-	Vec3 toTarget = target->m_position - self->m_position;
+	Vec3 toTarget = target->m_position - self.m_position;
 
-	float maxTurnDegrees = self->m_actorDef->m_turnSpeed * deltaseconds;
-	self->TurnInDirection(toTarget, maxTurnDegrees);
+	float maxTurnDegrees = self.m_actorDef->m_turnSpeed * deltaSeconds;
+	self.TurnInDirection(toTarget, maxTurnDegrees);
 
 	float distance = toTarget.GetLength();
-	float combinedRadius = self->GetPhysicsRadius() + target->GetPhysicsRadius();
+	float combinedRadius = self.GetPhysicsRadius() + target->GetPhysicsRadius();
 
-	if (self->m_actorDef->m_actorName != "Cacodemon" && distance > combinedRadius)
+	if (self.m_actorDef->m_actorName != "Cacodemon" && distance > combinedRadius)
 	{
-		self->MoveInDirection(toTarget, self->m_actorDef->m_runSpeed);
+		m_moveDirection = toTarget;
+		m_moveSpeed = self.m_actorDef->m_runSpeed;
 	}
 
 	//-------------------------------------------------------------------------
 	// Weapon usage
 	//-------------------------------------------------------------------------
-	Weapon* weapon = self->m_equippedWeapon;
+	Weapon* weapon = self.m_equippedWeapon;
 	if (!weapon)
 	{
 		return;
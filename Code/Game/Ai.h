@@ -1,5 +1,6 @@
 #pragma once
 #include "Game/Controller.hpp"
+#include "Engine/Math/Vec3.h"
 // -----------------------------------------------------------------------------
 // -----------------------------------------------------------------------------
 class AI : public Controller
@@ -9,6 +10,13 @@ public:
 	void Update(float deltaseconds) override;
 	void DamagedBy(ActorHandle& actorUID);
 	void Possess(ActorHandle& actorHandle) override;
+	void Think(Actor& self, float deltaSeconds);
 // -----------------------------------------------------------------------------
 	ActorHandle m_targetActorHandle ;
+
+	// Agents at a coarse level of detail think every few ticks with the time they
+	// skipped, and keep pushing in the last direction they chose in between
+	float m_pendingSeconds = 0.f;
+	Vec3  m_moveDirection;
+	float m_moveSpeed = 0.f;
 };
\ No newline at end of file
@@ -0,0 +1,135 @@
+#include "Game/AnimationPlayback.hpp"
+#include "Game/GameCommon.h"
+#include "Game/Actor.hpp"
+#include "Game/BenchHelpers.hpp"
+#include "Game/Game.h"
+#include "Game/Map.hpp"
+#include "Engine/Core/Clock.hpp"
+#include "Engine/Core/DevConsole.hpp"
+#include "Engine/Core/EngineCommon.h"
+#include "Engine/Core/Time.hpp"
+
+void AnimationPlayback::Restart(double nowSeconds)
+{
+	m_startSeconds = nowSeconds;
+	m_elapsedAtStart = 0.0;
+}
+
+void AnimationPlayback::SetTimeScale(float timeScale, double nowSeconds)
+{
+	if (timeScale == m_timeScale)
+	{
+		return;
+	}
+	m_elapsedAtStart = GetElapsedSeconds(nowSeconds);
+	m_startSeconds = nowSeconds;
+	m_timeScale = timeScale;
+}
+
+double AnimationPlayback::GetElapsedSeconds(double nowSeconds) const
+{
+	double secondsSinceStart = (nowSeconds > m_startSeconds) ? (nowSeconds - m_startSeconds) : 0.0;
+	return m_elapsedAtStart + (secondsSinceStart * static_cast<double>(m_timeScale));
+}
+
+// -----------------------------------------------------------------------------
+// Dev console: AnimationClockBench actors=<count> frames=<count>
+// Ticks the engine clock tree with as many child clocks as the actors and
+// their weapons used to create, against ticking it bare, then spawns the
+// actors and times reading every playback once per frame. Prints both next
+// to the memory each way takes. The map and player lives are restored
+// afterwards; game time keeps running while the clocks are ticked.
+// -----------------------------------------------------------------------------
+bool AnimationPlayback::Command_AnimationClockBench(EventArgs& args)
+{
+	Map* map = g_theGame->m_defaultMap;
+	if (g_theGame->m_currentState != GameState::PLAYING || map == nullptr)
+	{
+		g_theDevConsole->AddLine(Rgba8::RED, "AnimationClockBench needs a game in progress");
+		return false;
+	}
+
+	int numActors = args.GetValue("actors", 10000);
+	int numFrames = args.GetValue("frames", 120);
+	numFrames = (numFrames < 1) ? 1 : numFrames;
+	int maxActors = static_cast<int>(ActorHandle::MAX_ACTOR_INDEX) - static_cast<int>(map->m_allActors.size());
+	numActors = (numActors < 1) ? 1 : ((numActors > maxActors) ? maxActors : numActors);
+	ActorDefinition* demonDef = ActorDefinition::GetByActorName("Demon");
+	int numWeaponsPerActor = static_cast<int>(demonDef->m_weaponDefs.size());
+	int numClocks = numActors * (1 + numWeaponsPerActor);
+
+	std::vector<IntVec2> openTiles;
+	if (!GatherOpenTiles(*map, "AnimationClockBench", openTiles))
+	{
+		return false;
+	}
+
+	// The tree as it is, then with a clock per actor and per weapon hung off the game clock
+	double bareStart = GetCurrentTimeSeconds();
+	for (int frameIndex = 0; frameIndex < numFrames; ++frameIndex)
+	{
+		Clock::TickSystemClock();
+	}
+	double bareSeconds = GetCurrentTimeSeconds() - bareStart;
+
+	std::vector<Clock*> clocks;
+	clocks.reserve(numClocks);
+	for (int clockIndex = 0; clockIndex < numClocks; ++clockIndex)
+	{
+		clocks.push_back(new Clock(*g_theGame->m_gameClock));
+	}
+	double clockStart = GetCurrentTimeSeconds();
+	for (int frameIndex = 0; frameIndex < numFrames; ++frameIndex)
+	{
+		Clock::TickSystemClock();
+	}
+	double clockSeconds = GetCurrentTimeSeconds() - clockStart;
+	for (int clockIndex = 0; clockIndex < numClocks; ++clockIndex)
+	{
+		delete clocks[clockIndex];
+	}
+	clocks.clear();
+
+	// Playbacks cost nothing until read, so time one read per actor and weapon per frame
+	BenchMapScope benchScope(*map);
+	int numPlaybacks = 0;
+	for (int spawnIndex = 0; spawnIndex < numActors; ++spawnIndex)
+	{
+		IntVec2 tileCoords = RollOpenTile(openTiles);
+
+		SpawnInfo spawnInfo;
+		spawnInfo.m_actorDef = demonDef;
+		spawnInfo.m_position = Vec3(static_cast<float>(tileCoords.x) + 0.5f, static_cast<float>(tileCoords.y) + 0.5f, 0.f);
+		Actor* actor = map->SpawnActor(spawnInfo);
+		numPlaybacks += 1 + static_cast<int>(actor->m_weapons.size());
+	}
+
+	double elapsedSum = 0.0;
+	double playbackStart = GetCurrentTimeSeconds();
+	for (int frameIndex = 0; frameIndex < numFrames; ++frameIndex)
+	{
+		double nowSeconds = map->m_simulationSeconds + (static_cast<double>(frameIndex) / 60.0);
+		for (Actor const* actor : map->m_allActors)
+		{
+			if (actor == nullptr)
+			{
+				continue;
+			}
+			elapsedSum += actor->m_animationPlayback.GetElapsedSeconds(nowSeconds);
+			for (Weapon const* weapon : actor->m_weapons)
+			{
+				elapsedSum += weapon->m_animationPlayback.GetElapsedSeconds(nowSeconds);
+			}
+		}
+	}
+	double playbackSeconds = GetCurrentTimeSeconds() - playbackStart;
+
+	double frameCount = static_cast<double>(numFrames);
+	double clockMs = ((clockSeconds - bareSeconds) * 1000.0) / frameCount;
+	double playbackMs = (playbackSeconds * 1000.0) / frameCount;
+	size_t clockBytes = static_cast<size_t>(numClocks) * (sizeof(Clock) + sizeof(Clock*));
+	size_t playbackBytes = static_cast<size_t>(numPlaybacks) * sizeof(AnimationPlayback);
+	g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, Stringf("%d actors: %d child clocks cost %.3f ms/frame to tick and %zu KB, %d playbacks cost %.3f ms/frame to read and %zu KB (check %.0f)",
+		numActors, numClocks, clockMs, clockBytes / 1024, numPlaybacks, playbackMs, playbackBytes / 1024, elapsedSum));
+	return true;
+}
@@ -0,0 +1,20 @@
+#pragma once
+#include "Engine/Core/EventSystem.hpp"
+// -----------------------------------------------------------------------------
+// How far an animation has played, kept as the map simulation time it was
+// last measured at rather than as a clock that has to be ticked every frame.
+// Changing the time scale folds the time played so far into the start, so
+// the animation carries on from where it was.
+// -----------------------------------------------------------------------------
+struct AnimationPlayback
+{
+	void   Restart(double nowSeconds);
+	void   SetTimeScale(float timeScale, double nowSeconds);
+	double GetElapsedSeconds(double nowSeconds) const;
+
+	static bool Command_AnimationClockBench(EventArgs& args);
+
+	double m_startSeconds = 0.0;		// Map simulation time the playback was last measured at
+	double m_elapsedAtStart = 0.0;		// Animation seconds already played by then
+	float  m_timeScale = 1.f;
+};
@@ -1,4 +1,26 @@
 #include "Game/App.h"
+#include "Game/AssetLoader.hpp"
+#include "Game/AssetResidency.hpp"
+#include "Game/DefinitionBundle.hpp"
+#include "Game/FrameArena.hpp"
+#include "Game/FrameStats.hpp"
+#include "Game/LightGrid.hpp"
+#include "Game/MapDefinition.hpp"
+#include "Game/MapSaveState.hpp"
+#include "Game/NetSession.hpp"
+#include "Game/Player.hpp"
+#include "Game/ReplaySystem.hpp"
+#include "Game/ShaderRegistry.hpp"
+#include "Game/ActorGrid.hpp"
+#include "Game/FactionRoster.hpp"
+#include "Game/FactionDefinition.hpp"
+#include "Game/VisibilityField.hpp"
+#include "Game/AILevelOfDetail.hpp"
+#include "Game/TimerWheel.hpp"
+#include "Game/PhysicsBatch.hpp"
+#include "Game/CrowdSolver.hpp"
+#include "Game/AnimationPlayback.hpp"
+#include "Game/Actor.hpp"
 #include "Engine/Core/EventSystem.hpp"
 #include "Engine/Renderer/Renderer.h"
 #include "Engine/Renderer/Camera.h"
@@ -18,6 +40,10 @@ Game* g_theGame = nullptr;
 Renderer* g_theRenderer = nullptr;		// Created and owned by the App
 AudioSystem* g_theAudio = nullptr;		// Created and owned by the App
 Window* g_theWindow = nullptr;			// Created and owned by the App
+FrameArena* g_frameArena = nullptr;		// Created and owned by the App
+AssetLoader* g_assetLoader = nullptr;	// Created and owned by the App
+AssetResidency* g_assetResidency = nullptr; // Created and owned by the App
+ShaderRegistry* g_shaderRegistry = nullptr; // Created and owned by the App
 
 App::App()
 {
@@ -29,6 +55,7 @@ App::~App()
 
 void App::Startup()
 {
+	m_startupSeconds = GetCurrentTimeSeconds();
 	LoadGameConfig("Data/GameConfig.xml");
 	float windowAspect = g_gameConfigBlackboard.GetValue("windowAspect", 0.f);
 
@@ -60,6 +87,9 @@ void App::Startup()
 	AudioSystemConfig audioConfig;
 	g_theAudio = new AudioSystem(audioConfig);
 
+	g_frameArena = new FrameArena();
+	g_rng = new RandomNumberGenerator();
+
 	g_theEventSystem->Startup();
 	g_theDevConsole->Startup();
 	g_theInput->Startup();
@@ -72,6 +102,10 @@ void App::Startup()
 	debugRenderConfig.m_fontName = "Data/Fonts/SquirrelFixedFont";
 	DebugRenderSystemStartup(debugRenderConfig);
 
+	g_assetLoader = new AssetLoader(g_gameConfigBlackboard.GetValue("loadingThreads", 0));
+	g_assetResidency = new AssetResidency();
+	g_shaderRegistry = new ShaderRegistry("Data/Shaders/Cache");
+
 	g_theGame = new Game(this);
 	g_theGame->StartUp();
 
@@ -83,6 +117,18 @@ void App::Shutdown()
 	g_theGame->Shutdown();
 	delete g_theGame;
 	g_theGame = nullptr;
+	Actor::ReleaseSlabs();
+
+	MapDefinition::ClearDefinitions();
+	FactionDefinition::ClearDefinitions();
+	delete g_assetResidency;
+	g_assetResidency = nullptr;
+
+	delete g_shaderRegistry;
+	g_shaderRegistry = nullptr;
+
+	delete g_assetLoader;
+	g_assetLoader = nullptr;
 
 	DebugRenderSystemShutdown();
 
@@ -99,6 +145,8 @@ void App::Shutdown()
 	delete g_theWindow;
 	delete g_theInput;
 	delete g_theDevConsole;
+	delete g_frameArena;
+	delete g_rng;
 
 	g_theAudio = nullptr;
 	g_theRenderer = nullptr;
@@ -106,11 +154,15 @@ void App::Shutdown()
 	g_theWindow = nullptr;
 	g_theInput = nullptr;
 	g_theDevConsole = nullptr;
+	g_frameArena = nullptr;
+	g_rng = nullptr;
 }
 
 void App::BeginFrame()
 {
 	Clock::TickSystemClock();
+	FrameStats::BeginFrame();
+	g_frameArena->BeginFrame();
 
 	g_theRenderer->BeginFrame();
 	g_theEventSystem->BeginFrame();
@@ -124,14 +176,16 @@ void App::BeginFrame()
 
 void App::Render() const
 {
+	FrameStats::BeginRender();
 	g_theRenderer->ClearScreen(Rgba8(70, 70, 70, 255));
 	g_theGame->Render();
+	FrameStats::EndRender();
 	g_theDevConsole->Render(AABB2(Vec2::ZERO, Vec2(SCREEN_SIZE_X, SCREEN_SIZE_Y)));
 }
 
 void App::Update()
 {
-	if (g_theDevConsole->GetMode() == DevConsoleMode::OPEN_FULL || g_theGame->GetCurrentGameState() == GameState::ATTRACT || GetActiveWindow() != Window::s_mainWindow->GetHwnd())
+	if (g_theDevConsole->GetMode() == DevConsoleMode::OPEN_FULL || g_theGame->GetCurrentGameState() == GameState::ATTRACT || g_theGame->GetCurrentGameState() == GameState::LOADING || GetActiveWindow() != Window::s_mainWindow->GetHwnd())
 	{
 		g_theInput->SetCursorMode(CursorMode::POINTER);
 	}
@@ -185,6 +239,37 @@ void App::LoadGameConfig(char const* gameConfigXMLFilePath)
 void App::SubscribeToEvents()
 {
 	SubscribeEventCallbackFunction("Quit", HandleQuitRequested);
+	SubscribeEventCallbackFunction("LightGridTest", LightGrid::Command_LightGridTest);
+	SubscribeEventCallbackFunction("FrameStats", FrameStats::Command_FrameStats);
+	SubscribeEventCallbackFunction("HudCache", Player::Command_HudCache);
+	SubscribeEventCallbackFunction("ReplayRecord", ReplaySystem::Command_ReplayRecord);
+	SubscribeEventCallbackFunction("ReplayStop", ReplaySystem::Command_ReplayStop);
+	SubscribeEventCallbackFunction("ReplayRun", ReplaySystem::Command_ReplayRun);
+	SubscribeEventCallbackFunction("PlayerBots", Player::Command_PlayerBots);
+	SubscribeEventCallbackFunction("BotSoak", Player::Command_BotSoak);
+	SubscribeEventCallbackFunction("NetLoopback", NetSession::Command_NetLoopback);
+	SubscribeEventCallbackFunction("NetSnapshotBench", NetSession::Command_NetSnapshotBench);
+	SubscribeEventCallbackFunction("NetRelevancyBench", NetSession::Command_NetRelevancyBench);
+	SubscribeEventCallbackFunction("MapSave", MapSaveState::Command_MapSave);
+	SubscribeEventCallbackFunction("MapLoad", MapSaveState::Command_MapLoad);
+	SubscribeEventCallbackFunction("MapSaveTest", MapSaveState::Command_MapSaveTest);
+	SubscribeEventCallbackFunction("MapSaveBench", MapSaveState::Command_MapSaveBench);
+	SubscribeEventCallbackFunction("AssetReport", AssetResidency::Command_AssetReport);
+	SubscribeEventCallbackFunction("CookDefinitions", DefinitionBundle::Command_CookDefinitions);
+	SubscribeEventCallbackFunction("DefinitionBench", DefinitionBundle::Command_DefinitionBench);
+	SubscribeEventCallbackFunction("ShaderReport", ShaderRegistry::Command_ShaderReport);
+	SubscribeEventCallbackFunction("ShaderCacheTest", ShaderRegistry::Command_ShaderCacheTest);
+	SubscribeEventCallbackFunction("ActorQueryBench", ActorGrid::Command_ActorQueryBench);
+	SubscribeEventCallbackFunction("FactionCountTest", FactionRoster::Command_FactionCountTest);
+	SubscribeEventCallbackFunction("FactionBench", FactionDefinition::Command_FactionBench);
+	SubscribeEventCallbackFunction("VisibilityBench", VisibilityField::Command_VisibilityBench);
+	SubscribeEventCallbackFunction("AILod", AILevelOfDetail::Command_AILod);
+	SubscribeEventCallbackFunction("AILodBench", AILevelOfDetail::Command_AILodBench);
+	SubscribeEventCallbackFunction("TimerWheelBench", TimerWheel::Command_TimerWheelBench);
+	SubscribeEventCallbackFunction("AnimationClockBench", AnimationPlayback::Command_AnimationClockBench);
+	SubscribeEventCallbackFunction("SpawnStressTest", Map::Command_SpawnStressTest);
+	SubscribeEventCallbackFunction("PhysicsBench", PhysicsBatch::Command_PhysicsBench);
+	SubscribeEventCallbackFunction("CrowdBench", CrowdSolver::Command_CrowdBench);
 }
 
 void App::RunFrame()
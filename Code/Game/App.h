@@ -14,6 +14,7 @@ public:
 
 	void RunMainLoop();
 	bool IsQuitting() const { return m_isQuitting; }
+	double GetStartupSeconds() const { return m_startupSeconds; }
 	static bool HandleQuitRequested(EventArgs& args);
 	
 private:
@@ -28,4 +29,5 @@ private:
 private:
 	Game* m_game = nullptr;
 	bool  m_isQuitting = false;
+	double m_startupSeconds = 0.0;
 };
\ No newline at end of file
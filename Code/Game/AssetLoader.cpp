@@ -0,0 +1,340 @@
+#include "Game/AssetLoader.hpp"
+#include "Game/GameCommon.h"
+#include "Engine/Core/EngineCommon.h"
+#include "Engine/Core/ErrorWarningAssert.hpp"
+#include "Engine/Core/Image.hpp"
+#include "Engine/Core/Time.hpp"
+#include "Engine/Renderer/Renderer.h"
+#include "Engine/Renderer/Texture.hpp"
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+static bool DoesPathEndWith(std::string const& filePath, char const* extension)
+{
+	size_t extensionLength = strlen(extension);
+	if (filePath.size() < extensionLength)
+	{
+		return false;
+	}
+	for (size_t charIndex = 0; charIndex < extensionLength; ++charIndex)
+	{
+		char pathChar = static_cast<char>(tolower(static_cast<unsigned char>(filePath[filePath.size() - extensionLength + charIndex])));
+		if (pathChar != extension[charIndex])
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+static bool IsImagePath(std::string const& filePath)
+{
+	return DoesPathEndWith(filePath, ".png") || DoesPathEndWith(filePath, ".jpg") || DoesPathEndWith(filePath, ".tga");
+}
+
+static bool IsSoundPath(std::string const& filePath)
+{
+	return DoesPathEndWith(filePath, ".wav") || DoesPathEndWith(filePath, ".mp3") || DoesPathEndWith(filePath, ".mp2") || DoesPathEndWith(filePath, ".ogg");
+}
+
+AssetLoader::AssetLoader(int numWorkers)
+	:m_numImageBytesDecoded(0), m_numSoundBytesRead(0), m_numQueuedJobs(0), m_numUnfinishedJobs(0)
+{
+	if (numWorkers <= 0)
+	{
+		numWorkers = static_cast<int>(std::thread::hardware_concurrency()) - 1;
+	}
+	numWorkers = (numWorkers < 1) ? 1 : numWorkers;
+	for (int workerIndex = 0; workerIndex < numWorkers; ++workerIndex)
+	{
+		m_workers.emplace_back(&AssetLoader::RunWorker, this);
+	}
+}
+
+AssetLoader::~AssetLoader()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_isShuttingDown = true;
+	}
+	m_workerJobsChanged.notify_all();
+	for (int workerIndex = 0; workerIndex < static_cast<int>(m_workers.size()); ++workerIndex)
+	{
+		m_workers[workerIndex].join();
+	}
+
+	for (auto& xmlFile : m_xmlFiles)
+	{
+		delete xmlFile.second;
+	}
+	for (auto& image : m_images)
+	{
+		delete image.second;
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Unless told otherwise, every image and sound path the file names is decoded
+// or read once it has been parsed, so a definition file pulls in its own assets.
+// -----------------------------------------------------------------------------
+void AssetLoader::QueueXmlFile(std::string const& filePath, bool queueNamedAssets)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (!m_queuedFiles.insert(filePath).second)
+		{
+			return;
+		}
+	}
+
+	QueueWorkerJob([this, filePath, queueNamedAssets]()
+	{
+		XmlDocument* document = new XmlDocument();
+		XmlError result = document->LoadFile(filePath.c_str());
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_xmlFiles[filePath] = document;
+			m_xmlErrors[filePath] = result;
+		}
+
+		XmlElement const* rootElement = document->RootElement();
+		if (queueNamedAssets && result == tinyxml2::XML_SUCCESS && rootElement != nullptr)
+		{
+			QueueAssetsNamedBy(*rootElement);
+		}
+	});
+}
+
+void AssetLoader::QueueImageFile(std::string const& filePath)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (!m_queuedFiles.insert(filePath).second)
+		{
+			return;
+		}
+	}
+
+	QueueWorkerJob([this, filePath]()
+	{
+		Image* image = new Image(filePath.c_str());
+		IntVec2 dimensions = image->GetDimensions();
+		m_numImageBytesDecoded += static_cast<size_t>(dimensions.x) * static_cast<size_t>(dimensions.y) * 4;
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_images[filePath] = image;
+	});
+}
+
+// -----------------------------------------------------------------------------
+// The audio system only opens sounds by path, so workers read the files
+// through once and the main thread's CreateOrGetSound finds them cached by
+// the OS instead of waiting on the disk.
+// -----------------------------------------------------------------------------
+void AssetLoader::QueueSoundFile(std::string const& filePath)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (!m_queuedFiles.insert(filePath).second)
+		{
+			return;
+		}
+	}
+
+	QueueWorkerJob([this, filePath]()
+	{
+		std::ifstream file(filePath, std::ios::binary);
+		std::vector<char> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+		m_numSoundBytesRead += bytes.size();
+	});
+}
+
+// Queues the path as an image or sound by its extension, anything else is ignored
+void AssetLoader::QueueNamedAsset(std::string const& filePath)
+{
+	if (IsImagePath(filePath))
+	{
+		QueueImageFile(filePath);
+	}
+	else if (IsSoundPath(filePath))
+	{
+		QueueSoundFile(filePath);
+	}
+}
+
+void AssetLoader::QueueMainThreadStep(AssetLoadStep const& step)
+{
+	m_mainThreadSteps.push_back(step);
+	m_numQueuedSteps += 1;
+}
+
+// -----------------------------------------------------------------------------
+// Runs main thread steps until the budget is used up, always at least one so
+// loading moves forward however small the budget. Returns true once all work
+// is finished.
+// -----------------------------------------------------------------------------
+bool AssetLoader::Update(double budgetSeconds)
+{
+	if (m_numUnfinishedJobs > 0)
+	{
+		return false;
+	}
+
+	double updateStart = GetCurrentTimeSeconds();
+	while (!m_mainThreadSteps.empty())
+	{
+		if (m_mainThreadSteps.front()())
+		{
+			m_mainThreadSteps.pop_front();
+			m_numFinishedSteps += 1;
+		}
+		if (GetCurrentTimeSeconds() - updateStart >= budgetSeconds)
+		{
+			break;
+		}
+	}
+	return IsFinished();
+}
+
+bool AssetLoader::IsFinished() const
+{
+	return m_numUnfinishedJobs == 0 && m_mainThreadSteps.empty();
+}
+
+float AssetLoader::GetProgress() const
+{
+	int numQueuedJobs = m_numQueuedJobs;
+	int numFinishedJobs = numQueuedJobs - m_numUnfinishedJobs;
+	int numQueued = numQueuedJobs + m_numQueuedSteps;
+	if (numQueued == 0)
+	{
+		return 1.f;
+	}
+	return static_cast<float>(numFinishedJobs + m_numFinishedSteps) / static_cast<float>(numQueued);
+}
+
+int AssetLoader::GetNumWorkers() const
+{
+	return static_cast<int>(m_workers.size());
+}
+
+int AssetLoader::GetNumTextures() const
+{
+	return static_cast<int>(m_textures.size());
+}
+
+size_t AssetLoader::GetTextureBytes() const
+{
+	size_t numBytes = 0;
+	for (auto const& texture : m_textures)
+	{
+		IntVec2 dimensions = texture.second->GetDimensions();
+		numBytes += static_cast<size_t>(dimensions.x) * static_cast<size_t>(dimensions.y) * 4;
+	}
+	return numBytes;
+}
+
+XmlDocument const& AssetLoader::GetXmlFile(std::string const& filePath) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	auto foundFile = m_xmlFiles.find(filePath);
+	GUARANTEE_OR_DIE(foundFile != m_xmlFiles.end(), Stringf("XML file \"%s\" was never queued for loading", filePath.c_str()));
+	GUARANTEE_OR_DIE(m_xmlErrors.at(filePath) == tinyxml2::XML_SUCCESS, Stringf("Failed to open required definitions file \"%s\"", filePath.c_str()));
+	return *foundFile->second;
+}
+
+// -----------------------------------------------------------------------------
+// Hands over an image decoded by a worker, or decodes it now if it was never
+// queued. The caller owns the image.
+// -----------------------------------------------------------------------------
+Image* AssetLoader::TakeImage(std::string const& filePath)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto foundImage = m_images.find(filePath);
+		if (foundImage != m_images.end())
+		{
+			Image* image = foundImage->second;
+			m_images.erase(foundImage);
+			return image;
+		}
+	}
+	return new Image(filePath.c_str());
+}
+
+Texture* AssetLoader::CreateOrGetTexture(std::string const& filePath)
+{
+	auto foundTexture = m_textures.find(filePath);
+	if (foundTexture != m_textures.end())
+	{
+		return foundTexture->second;
+	}
+
+	// Images nobody queued load the old way, through the renderer's own cache
+	Texture* texture = nullptr;
+	bool wasDecoded = false;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		wasDecoded = m_images.find(filePath) != m_images.end();
+	}
+	if (wasDecoded)
+	{
+		Image* image = TakeImage(filePath);
+		texture = g_theRenderer->CreateTextureFromImage(*image);
+		delete image;
+	}
+	else
+	{
+		texture = g_theRenderer->CreateOrGetTextureFromFile(filePath.c_str());
+	}
+	m_textures[filePath] = texture;
+	return texture;
+}
+
+void AssetLoader::QueueWorkerJob(std::function<void()> const& job)
+{
+	m_numQueuedJobs += 1;
+	m_numUnfinishedJobs += 1;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_workerJobs.push_back(job);
+	}
+	m_workerJobsChanged.notify_one();
+}
+
+void AssetLoader::RunWorker()
+{
+	for (;;)
+	{
+		std::function<void()> job;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_workerJobsChanged.wait(lock, [this]() { return m_isShuttingDown || !m_workerJobs.empty(); });
+			if (m_isShuttingDown)
+			{
+				return;
+			}
+			job = std::move(m_workerJobs.front());
+			m_workerJobs.pop_front();
+		}
+
+		// Jobs a job queues are counted before it finishes, so the count never drops to zero early
+		job();
+		m_numUnfinishedJobs -= 1;
+	}
+}
+
+void AssetLoader::QueueAssetsNamedBy(XmlElement const& element)
+{
+	for (tinyxml2::XMLAttribute const* attribute = element.FirstAttribute(); attribute != nullptr; attribute = attribute->Next())
+	{
+		QueueNamedAsset(attribute->Value());
+	}
+
+	for (XmlElement const* childElement = element.FirstChildElement(); childElement != nullptr; childElement = childElement->NextSiblingElement())
+	{
+		QueueAssetsNamedBy(*childElement);
+	}
+}
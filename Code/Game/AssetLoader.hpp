@@ -0,0 +1,112 @@
+#pragma once
+#include "Engine/Core/ErrorWarningAssert.hpp"
+#include "Engine/Core/XmlUtils.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+// -----------------------------------------------------------------------------
+class Image;
+class Texture;
+// -----------------------------------------------------------------------------
+// Main thread steps return true once they have nothing left to do
+typedef std::function<bool()> AssetLoadStep;
+// -----------------------------------------------------------------------------
+// Loads game data off the main thread. Workers parse the definition XML files,
+// then decode every image and read every sound file the XML names. Once they
+// are done the main thread runs the queued steps, which build definitions and
+// create textures, shaders and sounds, for at most a budget of time per frame
+// so a loading screen keeps drawing in between.
+// -----------------------------------------------------------------------------
+class AssetLoader
+{
+public:
+	explicit AssetLoader(int numWorkers);
+	~AssetLoader();
+
+	void QueueXmlFile(std::string const& filePath, bool queueNamedAssets = true);
+	void QueueImageFile(std::string const& filePath);
+	void QueueSoundFile(std::string const& filePath);
+	void QueueNamedAsset(std::string const& filePath);
+	void QueueMainThreadStep(AssetLoadStep const& step);
+	template <typename T>
+	void QueueDefinitionFile(std::string const& filePath, char const* elementName, std::vector<T*>& outDefinitions, bool queueNamedAssets = true);
+
+	bool Update(double budgetSeconds);
+	bool IsFinished() const;
+	float GetProgress() const;
+	int GetNumWorkers() const;
+	int GetNumTextures() const;
+	size_t GetTextureBytes() const;
+
+	// Only valid on the main thread once the workers are done
+	XmlDocument const& GetXmlFile(std::string const& filePath) const;
+	Image* TakeImage(std::string const& filePath);
+	Texture* CreateOrGetTexture(std::string const& filePath);
+
+	std::atomic<size_t> m_numImageBytesDecoded;
+	std::atomic<size_t> m_numSoundBytesRead;
+// -----------------------------------------------------------------------------
+private:
+	void QueueWorkerJob(std::function<void()> const& job);
+	void RunWorker();
+	void QueueAssetsNamedBy(XmlElement const& element);
+
+	std::vector<std::thread> m_workers;
+	std::atomic<int> m_numQueuedJobs;
+	std::atomic<int> m_numUnfinishedJobs;
+
+	// Guards the job queue and everything workers write
+	mutable std::mutex m_mutex;
+	std::condition_variable m_workerJobsChanged;
+	std::deque<std::function<void()>> m_workerJobs;
+	bool m_isShuttingDown = false;
+	std::set<std::string> m_queuedFiles;
+	std::map<std::string, XmlDocument*> m_xmlFiles;
+	std::map<std::string, XmlError> m_xmlErrors;
+	std::map<std::string, Image*> m_images;
+
+	// Main thread only
+	std::map<std::string, Texture*> m_textures;
+	std::deque<AssetLoadStep> m_mainThreadSteps;
+	int m_numQueuedSteps = 0;
+	int m_numFinishedSteps = 0;
+};
+// -----------------------------------------------------------------------------
+// Parses the file on a worker, then builds one definition per main thread step
+// so a file full of shaders and sprite sheets is spread over several frames.
+// -----------------------------------------------------------------------------
+template <typename T>
+void AssetLoader::QueueDefinitionFile(std::string const& filePath, char const* elementName, std::vector<T*>& outDefinitions, bool queueNamedAssets)
+{
+	QueueXmlFile(filePath, queueNamedAssets);
+
+	XmlElement const* nextElement = nullptr;
+	bool hasStarted = false;
+	QueueMainThreadStep([this, filePath, elementName, &outDefinitions, nextElement, hasStarted]() mutable
+	{
+		if (!hasStarted)
+		{
+			XmlElement const* rootElement = GetXmlFile(filePath).RootElement();
+			GUARANTEE_OR_DIE(rootElement, "RootElement not found!");
+			nextElement = rootElement->FirstChildElement();
+			hasStarted = true;
+		}
+		if (nextElement == nullptr)
+		{
+			return true;
+		}
+
+		std::string foundElementName = nextElement->Name();
+		GUARANTEE_OR_DIE(foundElementName == elementName, Stringf("Root child element in %s was <%s>, must be <%s>!", filePath.c_str(), foundElementName.c_str(), elementName));
+		outDefinitions.push_back(new T(*nextElement));
+		nextElement = nextElement->NextSiblingElement();
+		return nextElement == nullptr;
+	});
+}
@@ -0,0 +1,155 @@
+#include "Game/AssetResidency.hpp"
+#include "Game/GameCommon.h"
+#include "Game/AssetLoader.hpp"
+#include "Engine/Core/EngineCommon.h"
+#include "Engine/Core/DevConsole.hpp"
+#include "Engine/Core/ErrorWarningAssert.hpp"
+#include "Engine/Core/Image.hpp"
+#include "Engine/Renderer/Renderer.h"
+#include "Engine/Renderer/Texture.hpp"
+
+static char const* const ASSET_CATEGORY_NAMES[static_cast<int>(AssetCategory::COUNT)] =
+{
+	"Images",
+	"Textures",
+};
+
+static size_t GetRgba8Bytes(IntVec2 const& dimensions)
+{
+	return static_cast<size_t>(dimensions.x) * static_cast<size_t>(dimensions.y) * 4;
+}
+
+AssetResidency::~AssetResidency()
+{
+	// Anything still here was acquired without a matching release
+	for (auto& image : m_images)
+	{
+		DebuggerPrintf("WARNING: Image \"%s\" still had %d users at shutdown\n", image.first.c_str(), image.second.m_numUsers);
+		delete image.second.m_image;
+	}
+	for (auto& texture : m_textures)
+	{
+		DebuggerPrintf("WARNING: Texture \"%s\" still had %d users at shutdown\n", texture.first.c_str(), texture.second.m_numUsers);
+		delete texture.second.m_texture;
+	}
+}
+
+Image* AssetResidency::AcquireImage(std::string const& filePath)
+{
+	ResidentImage& resident = m_images[filePath];
+	if (resident.m_numUsers == 0)
+	{
+		resident.m_image = g_assetLoader->TakeImage(filePath);
+		resident.m_numBytes = GetRgba8Bytes(resident.m_image->GetDimensions());
+		AddResidentBytes(AssetCategory::IMAGE, resident.m_numBytes);
+	}
+	resident.m_numUsers += 1;
+	return resident.m_image;
+}
+
+void AssetResidency::ReleaseImage(std::string const& filePath)
+{
+	auto foundImage = m_images.find(filePath);
+	GUARANTEE_OR_DIE(foundImage != m_images.end(), Stringf("Released image \"%s\" that was never acquired", filePath.c_str()));
+
+	ResidentImage& resident = foundImage->second;
+	resident.m_numUsers -= 1;
+	if (resident.m_numUsers == 0)
+	{
+		RemoveResidentBytes(AssetCategory::IMAGE, resident.m_numBytes);
+		delete resident.m_image;
+		m_images.erase(foundImage);
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Textures are created from a decoded image rather than through the renderer's
+// file cache, which never lets go of what it loads.
+// -----------------------------------------------------------------------------
+Texture* AssetResidency::AcquireTexture(std::string const& filePath)
+{
+	ResidentTexture& resident = m_textures[filePath];
+	if (resident.m_numUsers == 0)
+	{
+		Image* image = g_assetLoader->TakeImage(filePath);
+		resident.m_texture = g_theRenderer->CreateTextureFromImage(*image);
+		resident.m_numBytes = GetRgba8Bytes(image->GetDimensions());
+		AddResidentBytes(AssetCategory::TEXTURE, resident.m_numBytes);
+		delete image;
+	}
+	resident.m_numUsers += 1;
+	return resident.m_texture;
+}
+
+void AssetResidency::ReleaseTexture(std::string const& filePath)
+{
+	auto foundTexture = m_textures.find(filePath);
+	GUARANTEE_OR_DIE(foundTexture != m_textures.end(), Stringf("Released texture \"%s\" that was never acquired", filePath.c_str()));
+
+	ResidentTexture& resident = foundTexture->second;
+	resident.m_numUsers -= 1;
+	if (resident.m_numUsers == 0)
+	{
+		RemoveResidentBytes(AssetCategory::TEXTURE, resident.m_numBytes);
+		delete resident.m_texture;
+		m_textures.erase(foundTexture);
+	}
+}
+
+int AssetResidency::GetNumResident(AssetCategory category) const
+{
+	if (category == AssetCategory::IMAGE)
+	{
+		return static_cast<int>(m_images.size());
+	}
+	return static_cast<int>(m_textures.size());
+}
+
+size_t AssetResidency::GetResidentBytes(AssetCategory category) const
+{
+	return m_residentBytes[static_cast<int>(category)];
+}
+
+size_t AssetResidency::GetPeakBytes(AssetCategory category) const
+{
+	return m_peakBytes[static_cast<int>(category)];
+}
+
+void AssetResidency::AddResidentBytes(AssetCategory category, size_t numBytes)
+{
+	int categoryIndex = static_cast<int>(category);
+	m_residentBytes[categoryIndex] += numBytes;
+	if (m_residentBytes[categoryIndex] > m_peakBytes[categoryIndex])
+	{
+		m_peakBytes[categoryIndex] = m_residentBytes[categoryIndex];
+	}
+}
+
+void AssetResidency::RemoveResidentBytes(AssetCategory category, size_t numBytes)
+{
+	m_residentBytes[static_cast<int>(category)] -= numBytes;
+}
+
+// -----------------------------------------------------------------------------
+// Dev console: AssetReport
+// Prints the resident count, bytes and peak bytes of each on demand category,
+// then the textures created at startup that stay for the whole session.
+// -----------------------------------------------------------------------------
+bool AssetResidency::Command_AssetReport(EventArgs& args)
+{
+	UNUSED(args);
+	size_t totalBytes = 0;
+	for (int categoryIndex = 0; categoryIndex < static_cast<int>(AssetCategory::COUNT); ++categoryIndex)
+	{
+		AssetCategory category = static_cast<AssetCategory>(categoryIndex);
+		size_t residentBytes = g_assetResidency->GetResidentBytes(category);
+		totalBytes += residentBytes;
+		g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, Stringf("%-9s %3d resident, %8.2f KB (peak %.2f KB)", ASSET_CATEGORY_NAMES[categoryIndex],
+			g_assetResidency->GetNumResident(category), static_cast<double>(residentBytes) / 1024.0,
+			static_cast<double>(g_assetResidency->GetPeakBytes(category)) / 1024.0));
+	}
+	g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, Stringf("On demand total: %.2f KB", static_cast<double>(totalBytes) / 1024.0));
+	g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, Stringf("Startup textures: %d resident, %.2f KB", g_assetLoader->GetNumTextures(),
+		static_cast<double>(g_assetLoader->GetTextureBytes()) / 1024.0));
+	return true;
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include "Engine/Core/EventSystem.hpp"
+#include <map>
+#include <string>
+// -----------------------------------------------------------------------------
+class Image;
+class Texture;
+// -----------------------------------------------------------------------------
+enum class AssetCategory
+{
+	IMAGE,
+	TEXTURE,
+	COUNT
+};
+// -----------------------------------------------------------------------------
+// Reference counted store for the images and textures only some maps need.
+// The first acquire of a path loads it, the last release frees it, so an asset
+// is resident exactly while something is using it. Every acquire must be
+// matched by a release of the same path.
+// -----------------------------------------------------------------------------
+class AssetResidency
+{
+public:
+	~AssetResidency();
+
+	Image* AcquireImage(std::string const& filePath);
+	void ReleaseImage(std::string const& filePath);
+	Texture* AcquireTexture(std::string const& filePath);
+	void ReleaseTexture(std::string const& filePath);
+
+	int GetNumResident(AssetCategory category) const;
+	size_t GetResidentBytes(AssetCategory category) const;
+	size_t GetPeakBytes(AssetCategory category) const;
+
+	static bool Command_AssetReport(EventArgs& args);
+// -----------------------------------------------------------------------------
+private:
+	struct ResidentImage
+	{
+		Image* m_image = nullptr;
+		int    m_numUsers = 0;
+		size_t m_numBytes = 0;
+	};
+	struct ResidentTexture
+	{
+		Texture* m_texture = nullptr;
+		int      m_numUsers = 0;
+		size_t   m_numBytes = 0;
+	};
+
+	void AddResidentBytes(AssetCategory category, size_t numBytes);
+	void RemoveResidentBytes(AssetCategory category, size_t numBytes);
+
+	std::map<std::string, ResidentImage> m_images;
+	std::map<std::string, ResidentTexture> m_textures;
+	size_t m_residentBytes[static_cast<int>(AssetCategory::COUNT)] = {};
+	size_t m_peakBytes[static_cast<int>(AssetCategory::COUNT)] = {};
+};
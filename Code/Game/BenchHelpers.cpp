@@ -0,0 +1,84 @@
+#include "Game/BenchHelpers.hpp"
+#include "Game/Game.h"
+#include "Game/GameCommon.h"
+#include "Game/Map.hpp"
+#include "Game/MapSaveState.hpp"
+#include "Game/Player.hpp"
+#include "Engine/Core/DevConsole.hpp"
+#include "Engine/Core/EngineCommon.h"
+
+static BenchRandom s_benchRng;
+
+BenchMapScope::BenchMapScope(Map& map)
+	: m_map(map)
+{
+	MapSaveState::Capture(m_map, m_savedMap);
+	for (Player* player : g_theGame->m_players)
+	{
+		m_savedLives.push_back(player->m_numPlayerLives);
+	}
+}
+
+BenchMapScope::~BenchMapScope()
+{
+	Restore();
+}
+
+// Benches that run several passes call this between them to start each from the same map
+void BenchMapScope::Restore() const
+{
+	MapSaveState::Restore(m_map, m_savedMap);
+	for (int playerIndex = 0; playerIndex < static_cast<int>(g_theGame->m_players.size()) && playerIndex < static_cast<int>(m_savedLives.size()); ++playerIndex)
+	{
+		g_theGame->m_players[playerIndex]->m_numPlayerLives = m_savedLives[playerIndex];
+	}
+}
+
+int BenchRandom::RollRandomIntInRange(int minInclusive, int maxInclusive)
+{
+	return std::uniform_int_distribution<int>(minInclusive, maxInclusive)(m_engine);
+}
+
+float BenchRandom::RollRandomFloatInRange(float minInclusive, float maxInclusive)
+{
+	return minInclusive + ((maxInclusive - minInclusive) * RollRandomFloatZeroToOne());
+}
+
+// The top 24 bits fill a float's mantissa exactly, so the roll never reaches 1
+float BenchRandom::RollRandomFloatZeroToOne()
+{
+	return static_cast<float>(m_engine() >> 8) * (1.f / 16777216.f);
+}
+
+BenchRandom& GetBenchRng()
+{
+	return s_benchRng;
+}
+
+// Gathered once per bench so spawn spots are rolled from a list instead of
+// retrying random tiles; a map without an open tile fails the bench
+bool GatherOpenTiles(Map const& map, char const* benchName, std::vector<IntVec2>& outTiles)
+{
+	outTiles.clear();
+	for (int tileY = 0; tileY < map.m_dimensions.y; ++tileY)
+	{
+		for (int tileX = 0; tileX < map.m_dimensions.x; ++tileX)
+		{
+			if (!map.IsTileSolid(tileX, tileY))
+			{
+				outTiles.push_back(IntVec2(tileX, tileY));
+			}
+		}
+	}
+	if (outTiles.empty())
+	{
+		g_theDevConsole->AddLine(Rgba8::RED, Stringf("%s found no open tiles", benchName));
+		return false;
+	}
+	return true;
+}
+
+IntVec2 RollOpenTile(std::vector<IntVec2> const& openTiles)
+{
+	return openTiles[s_benchRng.RollRandomIntInRange(0, static_cast<int>(openTiles.size()) - 1)];
+}
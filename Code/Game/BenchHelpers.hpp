@@ -0,0 +1,42 @@
+#pragma once
+#include "Engine/Math/IntVec2.h"
+#include <random>
+#include <vector>
+// -----------------------------------------------------------------------------
+class Map;
+// -----------------------------------------------------------------------------
+// Dev console benches fill the running map with throwaway actors. The scope
+// captures the map and player lives when a bench starts and puts both back
+// when it ends, so a bench leaves the game as it found it.
+// -----------------------------------------------------------------------------
+class BenchMapScope
+{
+public:
+	explicit BenchMapScope(Map& map);
+	~BenchMapScope();
+
+	void Restore() const;
+// -----------------------------------------------------------------------------
+private:
+	Map& m_map;
+	std::vector<unsigned char> m_savedMap;
+	std::vector<int> m_savedLives;
+};
+// -----------------------------------------------------------------------------
+// The game and replays roll from g_rng and the C runtime's rand(), so benches
+// roll from a generator of their own and leave that sequence where it was.
+// -----------------------------------------------------------------------------
+class BenchRandom
+{
+public:
+	int   RollRandomIntInRange(int minInclusive, int maxInclusive);
+	float RollRandomFloatInRange(float minInclusive, float maxInclusive);
+	float RollRandomFloatZeroToOne();
+// -----------------------------------------------------------------------------
+private:
+	std::mt19937 m_engine;
+};
+// -----------------------------------------------------------------------------
+BenchRandom& GetBenchRng();
+bool GatherOpenTiles(Map const& map, char const* benchName, std::vector<IntVec2>& outTiles);
+IntVec2 RollOpenTile(std::vector<IntVec2> const& openTiles);
@@ -0,0 +1,31 @@
+#pragma once
+#include <cstring>
+#include <vector>
+// -----------------------------------------------------------------------------
+// Raw value helpers for the game's binary formats (replays, snapshots). Values
+// are copied in the machine's own byte order.
+// -----------------------------------------------------------------------------
+template <typename T>
+inline void AppendBytes(std::vector<unsigned char>& buffer, T const& value)
+{
+	unsigned char const* valueBytes = reinterpret_cast<unsigned char const*>(&value);
+	buffer.insert(buffer.end(), valueBytes, valueBytes + sizeof(T));
+}
+
+template <typename T>
+inline void OverwriteBytes(std::vector<unsigned char>& buffer, size_t writePosition, T const& value)
+{
+	memcpy(&buffer[writePosition], &value, sizeof(T));
+}
+
+template <typename T>
+inline bool ReadBytes(std::vector<unsigned char> const& buffer, size_t& readPosition, T& outValue)
+{
+	if (readPosition + sizeof(T) > buffer.size())
+	{
+		return false;
+	}
+	memcpy(&outValue, &buffer[readPosition], sizeof(T));
+	readPosition += sizeof(T);
+	return true;
+}
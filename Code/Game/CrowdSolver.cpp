@@ -0,0 +1,502 @@
+#include "Game/CrowdSolver.hpp"
+#include "Game/GameCommon.h"
+#include "Game/Actor.hpp"
+#include "Game/ActorGrid.hpp"
+#include "Game/BenchHelpers.hpp"
+#include "Game/Game.h"
+#include "Game/Map.hpp"
+#include "Engine/Core/DevConsole.hpp"
+#include "Engine/Core/EngineCommon.h"
+#include "Engine/Core/Time.hpp"
+#include "Engine/Math/MathUtils.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+
+CrowdSolverSettings CrowdSolverSettings::LoadFromConfig()
+{
+	CrowdSolverSettings settings;
+	settings.m_numIterations = g_gameConfigBlackboard.GetValue("crowdIterations", settings.m_numIterations);
+	settings.m_relaxation    = g_gameConfigBlackboard.GetValue("crowdRelaxation", settings.m_relaxation);
+	settings.m_contactMargin = g_gameConfigBlackboard.GetValue("crowdContactMargin", settings.m_contactMargin);
+	settings.m_numThreads    = g_gameConfigBlackboard.GetValue("crowdThreads", settings.m_numThreads);
+	return settings;
+}
+
+// -----------------------------------------------------------------------------
+// Holds the threads of a solve between iterations, so none reads positions
+// another is still writing. Iterations are short, so waiting threads yield
+// rather than sleep.
+// -----------------------------------------------------------------------------
+class CrowdSolver::Barrier
+{
+public:
+	explicit Barrier(int numThreads)
+		:m_numThreads(numThreads)
+	{
+	}
+
+	void Wait()
+	{
+		int generation = m_generation.load(std::memory_order_acquire);
+		if (m_numArrived.fetch_add(1, std::memory_order_acq_rel) + 1 == m_numThreads)
+		{
+			m_numArrived.store(0, std::memory_order_relaxed);
+			m_generation.fetch_add(1, std::memory_order_release);
+			return;
+		}
+		while (m_generation.load(std::memory_order_acquire) == generation)
+		{
+			std::this_thread::yield();
+		}
+	}
+
+private:
+	int m_numThreads = 1;
+	std::atomic<int> m_numArrived{ 0 };
+	std::atomic<int> m_generation{ 0 };
+};
+
+CrowdSolver::~CrowdSolver()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_isShuttingDown = true;
+	}
+	m_solveStarted.notify_all();
+	for (int workerIndex = 0; workerIndex < static_cast<int>(m_workers.size()); ++workerIndex)
+	{
+		m_workers[workerIndex].join();
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Makes the same pair tests as the pairwise pass did, each pair once from its
+// lower index, and keeps the ones that overlap for the collision callbacks.
+// Pairs just short of touching are solved as well.
+// -----------------------------------------------------------------------------
+void CrowdSolver::Gather(ActorList const& actors, ActorGrid const& grid)
+{
+	m_numActors = static_cast<int>(actors.size());
+	m_startX.resize(m_numActors);
+	m_startY.resize(m_numActors);
+	m_radius.resize(m_numActors);
+	m_isMovable.resize(m_numActors);
+	m_isColliding.resize(m_numActors);
+	for (int actorIndex = 0; actorIndex < m_numActors; ++actorIndex)
+	{
+		Actor const* actor = actors[actorIndex];
+		bool isColliding = actor != nullptr && actor->m_actorDef->m_actorName != "SpawnPoint";
+		m_startX[actorIndex] = isColliding ? actor->m_position.x : 0.f;
+		m_startY[actorIndex] = isColliding ? actor->m_position.y : 0.f;
+		m_radius[actorIndex] = isColliding ? actor->GetPhysicsRadius() : 0.f;
+		m_isMovable[actorIndex] = (isColliding && actor->IsMovable()) ? 1 : 0;
+		m_isColliding[actorIndex] = isColliding ? 1 : 0;
+	}
+
+	m_contactPairs.clear();
+	m_touchingPairs.clear();
+	float margin = m_settings.m_contactMargin;
+	for (int actorAIndex = 0; actorAIndex < m_numActors; ++actorAIndex)
+	{
+		if (!m_isColliding[actorAIndex])
+		{
+			continue;
+		}
+
+		Actor const* actorA = actors[actorAIndex];
+		Vec2 positionA(m_startX[actorAIndex], m_startY[actorAIndex]);
+		float radiusA = m_radius[actorAIndex];
+		grid.GatherCandidateIndexes(positionA, radiusA + grid.GetMaxPhysicsRadius() + margin, m_candidates);
+		std::sort(m_candidates.begin(), m_candidates.end());
+		for (int candidateIndex = 0; candidateIndex < static_cast<int>(m_candidates.size()); ++candidateIndex)
+		{
+			int actorBIndex = m_candidates[candidateIndex];
+			if (actorBIndex < actorAIndex || !m_isColliding[actorBIndex] || (!m_isMovable[actorAIndex] && !m_isMovable[actorBIndex]))
+			{
+				continue;
+			}
+
+			Actor const* actorB = actors[actorBIndex];
+			bool overlappingOnZ = actorA->m_position.z <= actorB->m_position.z + actorB->GetPhysicsHeight() && actorA->m_position.z + actorA->GetPhysicsHeight() >= actorB->m_position.z;
+			if (!overlappingOnZ)
+			{
+				continue;
+			}
+
+			Vec2 positionB(m_startX[actorBIndex], m_startY[actorBIndex]);
+			float radiusB = m_radius[actorBIndex];
+			if (DoDiscsOverlap(positionA, radiusA, positionB, radiusB))
+			{
+				m_touchingPairs.push_back(std::make_pair(actorAIndex, actorBIndex));
+			}
+			float contactDistance = radiusA + radiusB + margin;
+			if (actorBIndex != actorAIndex && GetDistanceSquared2D(positionA, positionB) < contactDistance * contactDistance)
+			{
+				m_contactPairs.push_back(std::make_pair(actorAIndex, actorBIndex));
+			}
+		}
+	}
+
+	BuildContacts();
+}
+
+// Each movable actor lists its contacts in pair order, which fixes the order it sums pushes in
+void CrowdSolver::BuildContacts()
+{
+	m_contactStarts.assign(m_numActors + 1, 0);
+	for (int pairIndex = 0; pairIndex < static_cast<int>(m_contactPairs.size()); ++pairIndex)
+	{
+		std::pair<int, int> const& contactPair = m_contactPairs[pairIndex];
+		m_contactStarts[contactPair.first + 1] += m_isMovable[contactPair.first];
+		m_contactStarts[contactPair.second + 1] += m_isMovable[contactPair.second];
+	}
+	for (int actorIndex = 0; actorIndex < m_numActors; ++actorIndex)
+	{
+		m_contactStarts[actorIndex + 1] += m_contactStarts[actorIndex];
+	}
+
+	m_contacts.resize(m_contactStarts[m_numActors]);
+	std::vector<int>& nextContacts = m_candidates;
+	nextContacts.assign(m_contactStarts.begin(), m_contactStarts.end() - 1);
+	for (int pairIndex = 0; pairIndex < static_cast<int>(m_contactPairs.size()); ++pairIndex)
+	{
+		int actorAIndex = m_contactPairs[pairIndex].first;
+		int actorBIndex = m_contactPairs[pairIndex].second;
+		bool bothMovable = m_isMovable[actorAIndex] && m_isMovable[actorBIndex];
+		if (m_isMovable[actorAIndex])
+		{
+			Contact& contact = m_contacts[nextContacts[actorAIndex]++];
+			contact.m_otherIndex = actorBIndex;
+			contact.m_share = bothMovable ? 0.5f : 1.f;
+			contact.m_isCounted = true;
+		}
+		if (m_isMovable[actorBIndex])
+		{
+			Contact& contact = m_contacts[nextContacts[actorBIndex]++];
+			contact.m_otherIndex = actorAIndex;
+			contact.m_share = bothMovable ? 0.5f : 1.f;
+			contact.m_isCounted = !bothMovable;
+		}
+	}
+}
+
+// Starts again from the gathered positions, so a gathered crowd can be solved more than once
+void CrowdSolver::Solve()
+{
+	double solveStart = GetCurrentTimeSeconds();
+	int numIterations = (m_settings.m_numIterations < 0) ? 0 : m_settings.m_numIterations;
+	int numThreads = m_settings.m_numThreads;
+	if (numThreads <= 0)
+	{
+		numThreads = static_cast<int>(std::thread::hardware_concurrency());
+	}
+	int maxThreads = m_numActors / CROWD_MIN_ACTORS_PER_THREAD;
+	numThreads = (numThreads > maxThreads) ? maxThreads : numThreads;
+	numThreads = (numThreads < 1) ? 1 : numThreads;
+
+	m_threadIterationStats.assign(numThreads * numIterations, CrowdOverlapStats());
+	for (int bufferIndex = 0; bufferIndex < 2; ++bufferIndex)
+	{
+		m_positionX[bufferIndex].resize(m_numActors);
+		m_positionY[bufferIndex].resize(m_numActors);
+	}
+	// The calling thread takes the first range, workers take the rest
+	while (static_cast<int>(m_workers.size()) < numThreads - 1)
+	{
+		m_workers.emplace_back(&CrowdSolver::RunWorker, this, static_cast<int>(m_workers.size()) + 1, m_solveIndex);
+	}
+	Barrier barrier(numThreads);
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_solveNumThreads = numThreads;
+		m_solveBarrier = &barrier;
+		m_numBusyWorkers = numThreads - 1;
+		++m_solveIndex;
+	}
+	m_solveStarted.notify_all();
+	SolveRange(0, numThreads, barrier);
+	{
+		std::unique_lock<std::mutex> lock(m_mutex);
+		m_workerFinished.wait(lock, [this]() { return m_numBusyWorkers == 0; });
+		m_solveBarrier = nullptr;
+	}
+	m_resultBuffer = numIterations % 2;
+
+	m_lastReport.m_numActors = m_numActors;
+	m_lastReport.m_numContacts = static_cast<int>(m_contactPairs.size());
+	m_lastReport.m_numThreads = numThreads;
+	m_lastReport.m_iterationOverlaps.assign(numIterations, CrowdOverlapStats());
+	for (int threadIndex = 0; threadIndex < numThreads; ++threadIndex)
+	{
+		for (int iteration = 0; iteration < numIterations; ++iteration)
+		{
+			CrowdOverlapStats const& threadStats = m_threadIterationStats[threadIndex * numIterations + iteration];
+			CrowdOverlapStats& stats = m_lastReport.m_iterationOverlaps[iteration];
+			stats.m_numOverlaps += threadStats.m_numOverlaps;
+			stats.m_maxPenetration = (threadStats.m_maxPenetration > stats.m_maxPenetration) ? threadStats.m_maxPenetration : stats.m_maxPenetration;
+		}
+	}
+	m_lastReport.m_solveSeconds = GetCurrentTimeSeconds() - solveStart;
+}
+
+// -----------------------------------------------------------------------------
+// Actors sharing a position have no direction between them, so they split
+// along an angle picked from the pair's indexes, opposite ways for each side.
+// -----------------------------------------------------------------------------
+void CrowdSolver::SolveRange(int threadIndex, int numThreads, Barrier& barrier)
+{
+	int firstActor = static_cast<int>((static_cast<long long>(m_numActors) * threadIndex) / numThreads);
+	int endActor = static_cast<int>((static_cast<long long>(m_numActors) * (threadIndex + 1)) / numThreads);
+	for (int actorIndex = firstActor; actorIndex < endActor; ++actorIndex)
+	{
+		m_positionX[0][actorIndex] = m_startX[actorIndex];
+		m_positionY[0][actorIndex] = m_startY[actorIndex];
+		m_positionX[1][actorIndex] = m_startX[actorIndex];
+		m_positionY[1][actorIndex] = m_startY[actorIndex];
+	}
+	barrier.Wait();
+
+	int numIterations = (m_settings.m_numIterations < 0) ? 0 : m_settings.m_numIterations;
+	float relaxation = m_settings.m_relaxation;
+	for (int iteration = 0; iteration < numIterations; ++iteration)
+	{
+		std::vector<float> const& readX = m_positionX[iteration % 2];
+		std::vector<float> const& readY = m_positionY[iteration % 2];
+		std::vector<float>& writeX = m_positionX[(iteration + 1) % 2];
+		std::vector<float>& writeY = m_positionY[(iteration + 1) % 2];
+		CrowdOverlapStats& stats = m_threadIterationStats[threadIndex * numIterations + iteration];
+		for (int actorIndex = firstActor; actorIndex < endActor; ++actorIndex)
+		{
+			if (!m_isMovable[actorIndex])
+			{
+				continue;
+			}
+
+			float positionX = readX[actorIndex];
+			float positionY = readY[actorIndex];
+			float pushX = 0.f;
+			float pushY = 0.f;
+			for (int contactIndex = m_contactStarts[actorIndex]; contactIndex < m_contactStarts[actorIndex + 1]; ++contactIndex)
+			{
+				Contact const& contact = m_contacts[contactIndex];
+				float offsetX = positionX - readX[contact.m_otherIndex];
+				float offsetY = positionY - readY[contact.m_otherIndex];
+				float distanceSquared = (offsetX * offsetX) + (offsetY * offsetY);
+				float touchingDistance = m_radius[actorIndex] + m_radius[contact.m_otherIndex];
+				if (distanceSquared >= touchingDistance * touchingDistance)
+				{
+					continue;
+				}
+
+				float distance = sqrtf(distanceSquared);
+				float penetration = touchingDistance - distance;
+				if (contact.m_isCounted)
+				{
+					++stats.m_numOverlaps;
+					stats.m_maxPenetration = (penetration > stats.m_maxPenetration) ? penetration : stats.m_maxPenetration;
+				}
+				if (distance > 0.f)
+				{
+					float pushScale = (penetration * contact.m_share) / distance;
+					pushX += offsetX * pushScale;
+					pushY += offsetY * pushScale;
+				}
+				else
+				{
+					float splitRadians = static_cast<float>(actorIndex + contact.m_otherIndex) * 2.3999632f;
+					float side = (actorIndex < contact.m_otherIndex) ? 1.f : -1.f;
+					pushX += cosf(splitRadians) * penetration * contact.m_share * side;
+					pushY += sinf(splitRadians) * penetration * contact.m_share * side;
+				}
+			}
+			writeX[actorIndex] = positionX + (pushX * relaxation);
+			writeY[actorIndex] = positionY + (pushY * relaxation);
+		}
+		barrier.Wait();
+	}
+}
+
+// Workers beyond a solve's thread count sit that solve out and wait for the next one
+void CrowdSolver::RunWorker(int threadIndex, unsigned int solveIndex)
+{
+	for (;;)
+	{
+		int numThreads = 1;
+		Barrier* barrier = nullptr;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_solveStarted.wait(lock, [this, solveIndex]() { return m_isShuttingDown || m_solveIndex != solveIndex; });
+			if (m_isShuttingDown)
+			{
+				return;
+			}
+			solveIndex = m_solveIndex;
+			numThreads = m_solveNumThreads;
+			barrier = m_solveBarrier;
+		}
+		if (threadIndex >= numThreads)
+		{
+			continue;
+		}
+
+		SolveRange(threadIndex, numThreads, *barrier);
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_numBusyWorkers -= 1;
+		}
+		m_workerFinished.notify_one();
+	}
+}
+
+void CrowdSolver::Scatter(ActorList& actors) const
+{
+	std::vector<float> const& solvedX = m_positionX[m_resultBuffer];
+	std::vector<float> const& solvedY = m_positionY[m_resultBuffer];
+	for (int actorIndex = 0; actorIndex < m_numActors; ++actorIndex)
+	{
+		if (m_isMovable[actorIndex] && m_contactStarts[actorIndex] != m_contactStarts[actorIndex + 1])
+		{
+			actors[actorIndex]->m_position.x = solvedX[actorIndex];
+			actors[actorIndex]->m_position.y = solvedY[actorIndex];
+		}
+	}
+}
+
+Vec2 CrowdSolver::GetSolvedPosition(int actorIndex) const
+{
+	return Vec2(m_positionX[m_resultBuffer][actorIndex], m_positionY[m_resultBuffer][actorIndex]);
+}
+
+// What is left after the last iteration, the same count the iterations report
+CrowdOverlapStats CrowdSolver::MeasureOverlap() const
+{
+	CrowdOverlapStats stats;
+	for (int pairIndex = 0; pairIndex < static_cast<int>(m_contactPairs.size()); ++pairIndex)
+	{
+		int actorAIndex = m_contactPairs[pairIndex].first;
+		int actorBIndex = m_contactPairs[pairIndex].second;
+		float distance = GetDistance2D(GetSolvedPosition(actorAIndex), GetSolvedPosition(actorBIndex));
+		float penetration = m_radius[actorAIndex] + m_radius[actorBIndex] - distance;
+		if (penetration > 0.f)
+		{
+			++stats.m_numOverlaps;
+			stats.m_maxPenetration = (penetration > stats.m_maxPenetration) ? penetration : stats.m_maxPenetration;
+		}
+	}
+	return stats;
+}
+
+CrowdSolveReport const& CrowdSolver::GetLastReport() const
+{
+	return m_lastReport;
+}
+
+std::vector<std::pair<int, int>> const& CrowdSolver::GetTouchingPairs() const
+{
+	return m_touchingPairs;
+}
+
+// -----------------------------------------------------------------------------
+// Dev console: CrowdBench actors=<count> density=<per tile> iterations=<count> threads=<count> runs=<count>
+// Packs Imps onto a few floor tiles, solves the crowd on one thread and then
+// on the given threads from the same start, and prints the solve times, the
+// overlap left after each iteration, and how many positions differ between
+// the two. The map and player lives are restored afterwards.
+// -----------------------------------------------------------------------------
+static double TimeCrowdSolves(CrowdSolver& solver, int numRuns)
+{
+	double solveSeconds = 0.0;
+	for (int runIndex = 0; runIndex < numRuns; ++runIndex)
+	{
+		solver.Solve();
+		solveSeconds += solver.GetLastReport().m_solveSeconds;
+	}
+	return solveSeconds / static_cast<double>(numRuns);
+}
+
+bool CrowdSolver::Command_CrowdBench(EventArgs& args)
+{
+	Map* map = g_theGame->m_defaultMap;
+	if (g_theGame->m_currentState != GameState::PLAYING || map == nullptr)
+	{
+		g_theDevConsole->AddLine(Rgba8::RED, "CrowdBench needs a game in progress");
+		return false;
+	}
+
+	int numActors = args.GetValue("actors", 10000);
+	float density = args.GetValue("density", 2.f);
+	int numRuns = args.GetValue("runs", 10);
+	CrowdSolverSettings settings = map->m_crowdSolver.m_settings;
+	settings.m_numIterations = args.GetValue("iterations", settings.m_numIterations);
+	settings.m_numThreads = args.GetValue("threads", settings.m_numThreads);
+	int maxActors = static_cast<int>(ActorHandle::MAX_ACTOR_INDEX) - static_cast<int>(map->m_allActors.size());
+	numActors = (numActors < 1) ? 1 : ((numActors > maxActors) ? maxActors : numActors);
+	density = (density < 0.1f) ? 0.1f : density;
+	numRuns = (numRuns < 1) ? 1 : numRuns;
+
+	std::vector<IntVec2> floorTiles;
+	if (!GatherOpenTiles(*map, "CrowdBench", floorTiles))
+	{
+		return false;
+	}
+
+	BenchMapScope benchScope(*map);
+
+	// A random handful of tiles, each holding about density Imps
+	int numCrowdTiles = static_cast<int>(ceilf(static_cast<float>(numActors) / density));
+	numCrowdTiles = (numCrowdTiles > static_cast<int>(floorTiles.size())) ? static_cast<int>(floorTiles.size()) : numCrowdTiles;
+	for (int tileIndex = 0; tileIndex < numCrowdTiles; ++tileIndex)
+	{
+		int swapIndex = GetBenchRng().RollRandomIntInRange(tileIndex, static_cast<int>(floorTiles.size()) - 1);
+		std::swap(floorTiles[tileIndex], floorTiles[swapIndex]);
+	}
+	for (int spawnIndex = 0; spawnIndex < numActors; ++spawnIndex)
+	{
+		IntVec2 const& tileCoords = floorTiles[spawnIndex % numCrowdTiles];
+		SpawnInfo spawnInfo;
+		spawnInfo.m_actorDef = ActorDefinition::GetByActorName("Imp");
+		spawnInfo.m_position = Vec3(static_cast<float>(tileCoords.x) + GetBenchRng().RollRandomFloatZeroToOne(), static_cast<float>(tileCoords.y) + GetBenchRng().RollRandomFloatZeroToOne(), 0.f);
+		map->SpawnActor(spawnInfo);
+	}
+	map->m_actorGrid.Build(0.f);
+
+	CrowdSolver serialSolver;
+	serialSolver.m_settings = settings;
+	serialSolver.m_settings.m_numThreads = 1;
+	double gatherStart = GetCurrentTimeSeconds();
+	serialSolver.Gather(map->m_allActors, map->m_actorGrid);
+	double gatherSeconds = GetCurrentTimeSeconds() - gatherStart;
+	double serialSeconds = TimeCrowdSolves(serialSolver, numRuns);
+
+	CrowdSolver parallelSolver;
+	parallelSolver.m_settings = settings;
+	parallelSolver.Gather(map->m_allActors, map->m_actorGrid);
+	double parallelSeconds = TimeCrowdSolves(parallelSolver, numRuns);
+	CrowdSolveReport const& report = parallelSolver.GetLastReport();
+
+	int numMismatches = 0;
+	for (int actorIndex = 0; actorIndex < static_cast<int>(map->m_allActors.size()); ++actorIndex)
+	{
+		Vec2 serialPosition = serialSolver.GetSolvedPosition(actorIndex);
+		Vec2 parallelPosition = parallelSolver.GetSolvedPosition(actorIndex);
+		numMismatches += (memcmp(&serialPosition, &parallelPosition, sizeof(Vec2)) == 0) ? 0 : 1;
+	}
+
+	std::string convergence;
+	for (int iteration = 0; iteration < static_cast<int>(report.m_iterationOverlaps.size()); ++iteration)
+	{
+		CrowdOverlapStats const& stats = report.m_iterationOverlaps[iteration];
+		convergence += Stringf("%d/%.3f -> ", stats.m_numOverlaps, stats.m_maxPenetration);
+	}
+	CrowdOverlapStats finalStats = parallelSolver.MeasureOverlap();
+	convergence += Stringf("%d/%.3f", finalStats.m_numOverlaps, finalStats.m_maxPenetration);
+
+	g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, Stringf("%d Imps on %d tiles, %d contacts, %d iterations: gather %.3f ms, solve %.3f ms on 1 thread, %.3f ms on %d (%.2fx)",
+		numActors, numCrowdTiles, report.m_numContacts, static_cast<int>(report.m_iterationOverlaps.size()), gatherSeconds * 1000.0,
+		serialSeconds * 1000.0, parallelSeconds * 1000.0, report.m_numThreads, serialSeconds / parallelSeconds));
+	g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, Stringf("  overlapping pairs/deepest overlap per iteration: %s", convergence.c_str()));
+	g_theDevConsole->AddLine((numMismatches == 0) ? Rgba8::LIGHTYELLOW : Rgba8::RED, Stringf("  %d positions differ between 1 and %d threads", numMismatches, report.m_numThreads));
+	return true;
+}
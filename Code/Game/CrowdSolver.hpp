@@ -0,0 +1,112 @@
+#pragma once
+#include "Engine/Core/EventSystem.hpp"
+#include "Engine/Math/Vec2.hpp"
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+// -----------------------------------------------------------------------------
+class Actor;
+class ActorGrid;
+typedef std::vector<Actor*> ActorList;
+// -----------------------------------------------------------------------------
+constexpr int CROWD_MIN_ACTORS_PER_THREAD = 1024;	// Smaller crowds solve on fewer threads
+// -----------------------------------------------------------------------------
+// Read from GameConfig.xml, margin in tiles
+struct CrowdSolverSettings
+{
+	int   m_numIterations = 4;
+	float m_relaxation = 1.f;		// Scale on each actor's summed push per iteration
+	float m_contactMargin = 0.1f;	// Pairs this close are solved too, so pushes into a neighbor are caught
+	int   m_numThreads = 0;			// 0 uses every hardware thread
+
+	static CrowdSolverSettings LoadFromConfig();
+};
+// -----------------------------------------------------------------------------
+struct CrowdOverlapStats
+{
+	int   m_numOverlaps = 0;
+	float m_maxPenetration = 0.f;
+};
+// -----------------------------------------------------------------------------
+struct CrowdSolveReport
+{
+	int    m_numActors = 0;
+	int    m_numContacts = 0;
+	int    m_numThreads = 0;
+	double m_solveSeconds = 0.0;
+	std::vector<CrowdOverlapStats> m_iterationOverlaps;	// Measured at the start of each iteration
+};
+// -----------------------------------------------------------------------------
+// Pushes overlapping actors apart Jacobi style: every iteration each movable
+// actor sums the pushes from all of its contacts against last iteration's
+// positions into the other position buffer, so actors are independent within
+// an iteration and the map splits into index ranges across threads. Each
+// actor adds its contacts in the same order whatever the thread count, so the
+// result is the same bits on one thread or many. Worker threads start the
+// first time a solve needs them and wait for the next solve until the solver
+// goes away, so a tick only wakes them.
+// -----------------------------------------------------------------------------
+class CrowdSolver
+{
+public:
+	CrowdSolver() = default;
+	~CrowdSolver();
+
+	void Gather(ActorList const& actors, ActorGrid const& grid);
+	void Solve();
+	void Scatter(ActorList& actors) const;
+
+	Vec2 GetSolvedPosition(int actorIndex) const;
+	CrowdOverlapStats MeasureOverlap() const;
+	CrowdSolveReport const& GetLastReport() const;
+	std::vector<std::pair<int, int>> const& GetTouchingPairs() const;
+
+	CrowdSolverSettings m_settings;
+
+	static bool Command_CrowdBench(EventArgs& args);
+// -----------------------------------------------------------------------------
+private:
+	struct Contact
+	{
+		int   m_otherIndex = 0;
+		float m_share = 1.f;		// Half when the other actor moves too
+		bool  m_isCounted = false;	// One side of each pair counts it in the stats
+	};
+	class Barrier;
+
+	void SolveRange(int threadIndex, int numThreads, Barrier& barrier);
+	void RunWorker(int threadIndex, unsigned int solveIndex);
+	void BuildContacts();
+// -----------------------------------------------------------------------------
+	int m_numActors = 0;
+	std::vector<float> m_startX;
+	std::vector<float> m_startY;
+	std::vector<float> m_positionX[2];
+	std::vector<float> m_positionY[2];
+	std::vector<float> m_radius;
+	std::vector<unsigned char> m_isMovable;
+	std::vector<unsigned char> m_isColliding;	// Takes part in actor collision at all
+
+	std::vector<std::pair<int, int>> m_contactPairs;	// Within the margin, by lower index then higher
+	std::vector<std::pair<int, int>> m_touchingPairs;	// Overlapping when gathered, in pairwise test order
+	std::vector<int> m_contactStarts;
+	std::vector<Contact> m_contacts;
+	std::vector<int> m_candidates;
+
+	std::vector<CrowdOverlapStats> m_threadIterationStats;
+	int m_resultBuffer = 0;
+	CrowdSolveReport m_lastReport;
+
+	// Guards what the workers read to join a solve and their count of unfinished ranges
+	std::vector<std::thread> m_workers;
+	std::mutex m_mutex;
+	std::condition_variable m_solveStarted;
+	std::condition_variable m_workerFinished;
+	unsigned int m_solveIndex = 0;
+	int m_solveNumThreads = 1;
+	Barrier* m_solveBarrier = nullptr;
+	int m_numBusyWorkers = 0;
+	bool m_isShuttingDown = false;
+};
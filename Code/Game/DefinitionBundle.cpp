@@ -0,0 +1,1382 @@
+#include "Game/DefinitionBundle.hpp"
+#include "Game/GameCommon.h"
+#include "Game/ActorDefinition.hpp"
+#include "Game/AssetLoader.hpp"
+#include "Game/BinaryBuffer.hpp"
+#include "Game/MapDefinition.hpp"
+#include "Game/TileDefinition.hpp"
+#include "Game/WeaponDefinition.hpp"
+#include "Engine/Core/DevConsole.hpp"
+#include "Engine/Core/EngineCommon.h"
+#include "Engine/Core/ErrorWarningAssert.hpp"
+#include "Engine/Core/Time.hpp"
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <map>
+
+static char const* const BUNDLE_DEFAULT_FILE = "Data/Definitions/Definitions.ddb";
+static char const* const BENCH_ACTOR_FILE = "Data/Definitions/GeneratedActorDefinitions.xml";
+static char const* const BENCH_BUNDLE_FILE = "Data/Definitions/GeneratedDefinitions.ddb";
+static constexpr size_t BUNDLE_SECTION_ALIGNMENT = 8;
+
+// -----------------------------------------------------------------------------
+// Bundle layout. Records are copied straight out of memory, so a bundle only
+// loads on a build with the same struct layout; the record sizes are stored in
+// the header to catch a layout change made without a version bump.
+// -----------------------------------------------------------------------------
+enum class BundleSection
+{
+	STRINGS,
+	SOURCES,
+	TILES,
+	MAPS,
+	SPAWNS,
+	ACTORS,
+	ANIMATION_GROUPS,
+	ANIMATION_DIRECTIONS,
+	SOUNDS,
+	WEAPON_REFERENCES,
+	WEAPONS,
+	WEAPON_ANIMATIONS,
+	COUNT
+};
+static constexpr int NUM_BUNDLE_SECTIONS = static_cast<int>(BundleSection::COUNT);
+
+struct BundleSectionRange
+{
+	unsigned int m_offset;
+	unsigned int m_numRecords;
+};
+
+struct BundleHeader
+{
+	char               m_fourCC[4];
+	unsigned int       m_version;
+	unsigned int       m_numBytes;
+	unsigned int       m_recordSizes[NUM_BUNDLE_SECTIONS];
+	BundleSectionRange m_sections[NUM_BUNDLE_SECTIONS];
+};
+
+struct SourceRecord
+{
+	unsigned int       m_filePath;
+	unsigned int       m_padding;
+	unsigned long long m_numBytes;
+	long long          m_writeTime;
+};
+
+struct TileRecord
+{
+	unsigned int  m_name;
+	Rgba8         m_mapImageColor;
+	IntVec2       m_floorCoords;
+	IntVec2       m_wallCoords;
+	IntVec2       m_ceilingCoords;
+	unsigned char m_isSolid;
+};
+
+struct MapRecord
+{
+	unsigned int m_name;
+	unsigned int m_imagePath;
+	unsigned int m_shaderName;
+	unsigned int m_spriteSheetTexturePath;
+	IntVec2      m_spriteSheetCellCount;
+	unsigned int m_firstSpawn;
+	unsigned int m_numSpawns;
+};
+
+struct SpawnRecord
+{
+	int         m_actorIndex;
+	Vec3        m_position;
+	EulerAngles m_orientation;
+};
+
+struct ActorRecord
+{
+	unsigned int  m_name;
+	unsigned int  m_faction;
+	int           m_health;
+	float         m_corpseLifetime;
+	float         m_physicsRadius;
+	float         m_physicsHeight;
+	FloatRange    m_legHeight;
+	FloatRange    m_bodyHeight;
+	FloatRange    m_headHeight;
+	FloatRange    m_damageOnCollide;
+	float         m_impulseOnCollide;
+	float         m_flyHeight;
+	float         m_walkSpeed;
+	float         m_runSpeed;
+	float         m_drag;
+	float         m_turnSpeed;
+	float         m_eyeHeight;
+	float         m_cameraFOVDeg;
+	float         m_sightRadius;
+	float         m_sightAngle;
+	Vec2          m_spriteSize;
+	Vec2          m_spritePivot;
+	int           m_billboardType;
+	unsigned int  m_shaderName;
+	unsigned int  m_spriteSheetPath;
+	IntVec2       m_cellCount;
+	Rgba8         m_lightColor;
+	float         m_lightRadius;
+	int           m_enemyTypeIndex;
+	float         m_spawnInterval;
+	unsigned int  m_firstAnimationGroup;
+	unsigned int  m_numAnimationGroups;
+	unsigned int  m_firstSound;
+	unsigned int  m_numSounds;
+	unsigned int  m_firstWeaponReference;
+	unsigned int  m_numWeaponReferences;
+	unsigned char m_isVisible;
+	unsigned char m_canBePossessed;
+	unsigned char m_dieOnSpawn;
+	unsigned char m_collidesWithWorld;
+	unsigned char m_collidesWithActors;
+	unsigned char m_dieOnCollide;
+	unsigned char m_isSimulated;
+	unsigned char m_isFlying;
+	unsigned char m_isAIEnabled;
+	unsigned char m_renderLit;
+	unsigned char m_renderRounded;
+	unsigned char m_emitsLight;
+};
+
+struct AnimationGroupRecord
+{
+	unsigned int  m_name;
+	float         m_secondsPerFrame;
+	int           m_playbackMode;
+	unsigned int  m_firstDirection;
+	unsigned int  m_numDirections;
+	unsigned char m_scaleBySpeed;
+};
+
+struct AnimationDirectionRecord
+{
+	Vec3 m_direction;
+	int  m_startFrame;
+	int  m_endFrame;
+};
+
+struct SoundRecord
+{
+	unsigned int m_name;
+	unsigned int m_filePath;
+};
+
+struct WeaponRecord
+{
+	unsigned int  m_name;
+	float         m_refireTime;
+	int           m_rayCount;
+	float         m_rayCone;
+	float         m_rayRange;
+	FloatRange    m_rayDamage;
+	float         m_rayImpulse;
+	int           m_projectileCount;
+	int           m_projectileActorIndex;
+	float         m_projectileCone;
+	float         m_projectileSpeed;
+	float         m_maxRange;
+	int           m_meleeCount;
+	float         m_meleeArc;
+	float         m_meleeRange;
+	FloatRange    m_meleeDamage;
+	FloatRange    m_impMeleeDamage;
+	float         m_meleeImpulse;
+	unsigned int  m_hudShaderName;
+	unsigned int  m_baseTexturePath;
+	unsigned int  m_reticleTexturePath;
+	IntVec2       m_reticleSize;
+	Vec2          m_spriteSize;
+	Vec2          m_spritePivot;
+	unsigned int  m_firstAnimation;
+	unsigned int  m_numAnimations;
+	unsigned int  m_soundName;
+	unsigned int  m_soundFilePath;
+};
+
+struct WeaponAnimationRecord
+{
+	unsigned int m_name;
+	unsigned int m_shaderName;
+	unsigned int m_spriteSheetPath;
+	IntVec2      m_cellCount;
+	int          m_startFrame;
+	int          m_endFrame;
+	float        m_secondsPerFrame;
+};
+
+static unsigned int const BUNDLE_RECORD_SIZES[NUM_BUNDLE_SECTIONS] =
+{
+	1,
+	sizeof(SourceRecord),
+	sizeof(TileRecord),
+	sizeof(MapRecord),
+	sizeof(SpawnRecord),
+	sizeof(ActorRecord),
+	sizeof(AnimationGroupRecord),
+	sizeof(AnimationDirectionRecord),
+	sizeof(SoundRecord),
+	sizeof(int),
+	sizeof(WeaponRecord),
+	sizeof(WeaponAnimationRecord),
+};
+
+// -----------------------------------------------------------------------------
+// Cooking
+// -----------------------------------------------------------------------------
+static bool GetSourceStamp(std::string const& filePath, unsigned long long& outNumBytes, long long& outWriteTime)
+{
+	std::error_code error;
+	outNumBytes = static_cast<unsigned long long>(std::filesystem::file_size(filePath, error));
+	if (error)
+	{
+		return false;
+	}
+	outWriteTime = static_cast<long long>(std::filesystem::last_write_time(filePath, error).time_since_epoch().count());
+	return !error;
+}
+
+// Names are looked up only after every file is read, since weapons and actors refer to each other
+struct PendingReference
+{
+	std::string   m_name;
+	std::string   m_referencedBy;
+	BundleSection m_section = BundleSection::COUNT;
+	int           m_recordIndex = 0;
+};
+
+class DefinitionCooker
+{
+public:
+	DefinitionCooker()
+	{
+		m_strings.push_back('\0');
+	}
+
+	void CookFactionFile(std::string const& filePath);
+	void CookTileFile(std::string const& filePath);
+	void CookMapFile(std::string const& filePath);
+	void CookActorFile(std::string const& filePath);
+	void CookWeaponFile(std::string const& filePath);
+	void ResolveReferences();
+	void WriteBundle(std::vector<unsigned char>& outBytes) const;
+
+	std::vector<std::string> m_errors;
+// -----------------------------------------------------------------------------
+private:
+	XmlElement const* OpenDefinitionFile(XmlDocument& document, std::string const& filePath);
+	bool CheckElementName(XmlElement const& element, std::string const& filePath, char const* elementName);
+	unsigned int Intern(std::string const& text);
+	void CheckNameIsUnique(std::map<std::string, int>& names, std::string const& name, int index, char const* kind);
+	void CheckAssetExists(std::string const& filePath, std::string const& referencedBy);
+	void AddReference(std::string const& name, std::string const& referencedBy, BundleSection section, int recordIndex);
+	int FindReferenced(std::map<std::string, int> const& names, PendingReference const& reference, char const* kind);
+	template <typename T>
+	void AppendSection(std::vector<unsigned char>& bytes, BundleHeader& header, BundleSection section, std::vector<T> const& records) const;
+
+	std::vector<char> m_strings;
+	std::map<std::string, unsigned int> m_stringOffsets;
+	std::vector<SourceRecord> m_sources;
+	std::vector<TileRecord> m_tiles;
+	std::vector<MapRecord> m_maps;
+	std::vector<SpawnRecord> m_spawns;
+	std::vector<ActorRecord> m_actors;
+	std::vector<AnimationGroupRecord> m_animationGroups;
+	std::vector<AnimationDirectionRecord> m_animationDirections;
+	std::vector<SoundRecord> m_sounds;
+	std::vector<int> m_weaponReferences;
+	std::vector<WeaponRecord> m_weapons;
+	std::vector<WeaponAnimationRecord> m_weaponAnimations;
+
+	std::map<std::string, int> m_factionNames;
+	std::map<std::string, int> m_tileNames;
+	std::map<std::string, int> m_mapNames;
+	std::map<std::string, int> m_actorNames;
+	std::map<std::string, int> m_weaponNames;
+	std::vector<PendingReference> m_references;
+};
+
+XmlElement const* DefinitionCooker::OpenDefinitionFile(XmlDocument& document, std::string const& filePath)
+{
+	SourceRecord source = {};
+	source.m_filePath = Intern(filePath);
+	if (!GetSourceStamp(filePath, source.m_numBytes, source.m_writeTime) || document.LoadFile(filePath.c_str()) != tinyxml2::XML_SUCCESS)
+	{
+		m_errors.push_back(Stringf("Failed to open definitions file \"%s\"", filePath.c_str()));
+		return nullptr;
+	}
+	m_sources.push_back(source);
+
+	XmlElement const* rootElement = document.RootElement();
+	if (rootElement == nullptr)
+	{
+		m_errors.push_back(Stringf("%s has no root element", filePath.c_str()));
+	}
+	return rootElement;
+}
+
+bool DefinitionCooker::CheckElementName(XmlElement const& element, std::string const& filePath, char const* elementName)
+{
+	std::string foundElementName = element.Name();
+	if (foundElementName != elementName)
+	{
+		m_errors.push_back(Stringf("Root child element in %s was <%s>, must be <%s>!", filePath.c_str(), foundElementName.c_str(), elementName));
+		return false;
+	}
+	return true;
+}
+
+unsigned int DefinitionCooker::Intern(std::string const& text)
+{
+	if (text.empty())
+	{
+		return 0;
+	}
+	auto foundString = m_stringOffsets.find(text);
+	if (foundString != m_stringOffsets.end())
+	{
+		return foundString->second;
+	}
+
+	unsigned int stringOffset = static_cast<unsigned int>(m_strings.size());
+	m_strings.insert(m_strings.end(), text.begin(), text.end());
+	m_strings.push_back('\0');
+	m_stringOffsets[text] = stringOffset;
+	return stringOffset;
+}
+
+void DefinitionCooker::CheckNameIsUnique(std::map<std::string, int>& names, std::string const& name, int index, char const* kind)
+{
+	if (!names.insert(std::make_pair(name, index)).second)
+	{
+		m_errors.push_back(Stringf("%s definition \"%s\" is defined more than once", kind, name.c_str()));
+	}
+}
+
+void DefinitionCooker::CheckAssetExists(std::string const& filePath, std::string const& referencedBy)
+{
+	std::error_code error;
+	if (!std::filesystem::exists(filePath, error))
+	{
+		m_errors.push_back(Stringf("%s refers to missing file \"%s\"", referencedBy.c_str(), filePath.c_str()));
+	}
+}
+
+void DefinitionCooker::AddReference(std::string const& name, std::string const& referencedBy, BundleSection section, int recordIndex)
+{
+	PendingReference reference;
+	reference.m_name = name;
+	reference.m_referencedBy = referencedBy;
+	reference.m_section = section;
+	reference.m_recordIndex = recordIndex;
+	m_references.push_back(reference);
+}
+
+int DefinitionCooker::FindReferenced(std::map<std::string, int> const& names, PendingReference const& reference, char const* kind)
+{
+	auto foundName = names.find(reference.m_name);
+	if (foundName == names.end())
+	{
+		m_errors.push_back(Stringf("%s refers to unknown %s \"%s\"", reference.m_referencedBy.c_str(), kind, reference.m_name.c_str()));
+		return -1;
+	}
+	return foundName->second;
+}
+
+// Factions always load from XML, the file is only stamped and its names collected to check actors against
+void DefinitionCooker::CookFactionFile(std::string const& filePath)
+{
+	XmlDocument document;
+	XmlElement const* rootElement = OpenDefinitionFile(document, filePath);
+	if (rootElement == nullptr)
+	{
+		return;
+	}
+
+	for (XmlElement const* factionDefElement = rootElement->FirstChildElement("FactionDefinition"); factionDefElement != nullptr; factionDefElement = factionDefElement->NextSiblingElement("FactionDefinition"))
+	{
+		CheckNameIsUnique(m_factionNames, ParseXmlAttribute(*factionDefElement, "name", ""), static_cast<int>(m_factionNames.size()), "Faction");
+	}
+}
+
+void DefinitionCooker::CookTileFile(std::string const& filePath)
+{
+	XmlDocument document;
+	XmlElement const* rootElement = OpenDefinitionFile(document, filePath);
+	if (rootElement == nullptr)
+	{
+		return;
+	}
+
+	for (XmlElement const* tileDefElement = rootElement->FirstChildElement(); tileDefElement != nullptr; tileDefElement = tileDefElement->NextSiblingElement())
+	{
+		if (!CheckElementName(*tileDefElement, filePath, "TileDefinition"))
+		{
+			continue;
+		}
+
+		TileDefinition tileDef(*tileDefElement);
+		CheckNameIsUnique(m_tileNames, tileDef.m_name, static_cast<int>(m_tiles.size()), "Tile");
+
+		TileRecord tile = {};
+		tile.m_name          = Intern(tileDef.m_name);
+		tile.m_isSolid       = tileDef.m_isSolid ? 1 : 0;
+		tile.m_mapImageColor = tileDef.m_mapImageColor;
+		tile.m_floorCoords   = tileDef.m_floorCoords;
+		tile.m_wallCoords    = tileDef.m_wallCoords;
+		tile.m_ceilingCoords = tileDef.m_ceilingCoords;
+		m_tiles.push_back(tile);
+	}
+}
+
+void DefinitionCooker::CookMapFile(std::string const& filePath)
+{
+	XmlDocument document;
+	XmlElement const* rootElement = OpenDefinitionFile(document, filePath);
+	if (rootElement == nullptr)
+	{
+		return;
+	}
+
+	for (XmlElement const* mapDefElement = rootElement->FirstChildElement(); mapDefElement != nullptr; mapDefElement = mapDefElement->NextSiblingElement())
+	{
+		if (!CheckElementName(*mapDefElement, filePath, "MapDefinition"))
+		{
+			continue;
+		}
+
+		MapDefinition mapDef(*mapDefElement);
+		CheckNameIsUnique(m_mapNames, mapDef.m_name, static_cast<int>(m_maps.size()), "Map");
+		CheckAssetExists(mapDef.m_imagePath, mapDef.m_name);
+		CheckAssetExists(mapDef.m_spriteSheetTexturePath, mapDef.m_name);
+
+		MapRecord map = {};
+		map.m_name                   = Intern(mapDef.m_name);
+		map.m_imagePath              = Intern(mapDef.m_imagePath);
+		map.m_shaderName             = Intern(mapDef.m_shaderName);
+		map.m_spriteSheetTexturePath = Intern(mapDef.m_spriteSheetTexturePath);
+		map.m_spriteSheetCellCount   = mapDef.m_spriteSheetCellCount;
+		map.m_firstSpawn             = static_cast<unsigned int>(m_spawns.size());
+		for (int spawnInfoIndex = 0; spawnInfoIndex < static_cast<int>(mapDef.m_spawningInfo.size()); ++spawnInfoIndex)
+		{
+			SpawnInfo const& spawnInfo = mapDef.m_spawningInfo[spawnInfoIndex];
+			SpawnRecord spawn = {};
+			spawn.m_actorIndex  = -1;
+			spawn.m_position    = spawnInfo.m_position;
+			spawn.m_orientation = spawnInfo.m_orientation;
+			AddReference(spawnInfo.m_actorName, mapDef.m_name, BundleSection::SPAWNS, static_cast<int>(m_spawns.size()));
+			m_spawns.push_back(spawn);
+		}
+		map.m_numSpawns = static_cast<unsigned int>(m_spawns.size()) - map.m_firstSpawn;
+		m_maps.push_back(map);
+	}
+}
+
+void DefinitionCooker::CookActorFile(std::string const& filePath)
+{
+	XmlDocument document;
+	XmlElement const* rootElement = OpenDefinitionFile(document, filePath);
+	if (rootElement == nullptr)
+	{
+		return;
+	}
+
+	for (XmlElement const* actorDefElement = rootElement->FirstChildElement(); actorDefElement != nullptr; actorDefElement = actorDefElement->NextSiblingElement())
+	{
+		if (!CheckElementName(*actorDefElement, filePath, "ActorDefinition"))
+		{
+			continue;
+		}
+
+		// Parsed only, no assets
+		ActorDefinition actorDef;
+		actorDef.ParseXmlElement(*actorDefElement);
+		std::string const& name = actorDef.m_actorName;
+		CheckNameIsUnique(m_actorNames, name, static_cast<int>(m_actors.size()), "Actor");
+		if (m_factionNames.find(actorDef.m_faction) == m_factionNames.end())
+		{
+			m_errors.push_back(Stringf("%s refers to unknown faction \"%s\"", name.c_str(), actorDef.m_faction.c_str()));
+		}
+
+		ActorRecord actor = {};
+		actor.m_name               = Intern(name);
+		actor.m_isVisible          = actorDef.m_isVisible ? 1 : 0;
+		actor.m_health             = actorDef.m_health;
+		actor.m_corpseLifetime     = actorDef.m_corpseLifetime;
+		actor.m_faction            = Intern(actorDef.m_faction);
+		actor.m_canBePossessed     = actorDef.m_canBePossessed ? 1 : 0;
+		actor.m_dieOnSpawn         = actorDef.m_dieOnSpawn ? 1 : 0;
+		actor.m_physicsRadius      = actorDef.m_physicsRadius;
+		actor.m_physicsHeight      = actorDef.m_physicsHeight;
+		actor.m_legHeight          = actorDef.m_legHeight;
+		actor.m_bodyHeight         = actorDef.m_bodyHeight;
+		actor.m_headHeight         = actorDef.m_headHeight;
+		actor.m_collidesWithWorld  = actorDef.m_collidesWithWorld ? 1 : 0;
+		actor.m_collidesWithActors = actorDef.m_collidesWithActors ? 1 : 0;
+		actor.m_dieOnCollide       = actorDef.m_dieOnCollide ? 1 : 0;
+		actor.m_damageOnCollide    = actorDef.m_damageOnCollide;
+		actor.m_impulseOnCollide   = actorDef.m_impulseOnCollide;
+		actor.m_isSimulated        = actorDef.m_isSimulated ? 1 : 0;
+		actor.m_isFlying           = actorDef.m_isFlying ? 1 : 0;
+		actor.m_flyHeight          = actorDef.m_flyHeight;
+		actor.m_walkSpeed          = actorDef.m_walkSpeed;
+		actor.m_runSpeed           = actorDef.m_runSpeed;
+		actor.m_drag               = actorDef.m_drag;
+		actor.m_turnSpeed          = actorDef.m_turnSpeed;
+		actor.m_eyeHeight          = actorDef.m_eyeHeight;
+		actor.m_cameraFOVDeg       = actorDef.m_cameraFOVDeg;
+		actor.m_isAIEnabled        = actorDef.m_isAIEnabled ? 1 : 0;
+		actor.m_sightRadius        = actorDef.m_sightRadius;
+		actor.m_sightAngle         = actorDef.m_sightAngle;
+		actor.m_spriteSize         = actorDef.m_spriteSize;
+		actor.m_spritePivot        = actorDef.m_spritePivot;
+		actor.m_billboardType      = static_cast<int>(actorDef.m_billboardType);
+		actor.m_renderLit          = actorDef.m_renderLit ? 1 : 0;
+		actor.m_renderRounded      = actorDef.m_renderRounded ? 1 : 0;
+		actor.m_shaderName         = Intern(actorDef.m_shaderName);
+		actor.m_spriteSheetPath    = Intern(actorDef.m_spriteSheetPath);
+		actor.m_cellCount          = actorDef.m_cellCount;
+		actor.m_emitsLight         = actorDef.m_emitsLight ? 1 : 0;
+		actor.m_lightColor         = actorDef.m_lightColor;
+		actor.m_lightRadius        = actorDef.m_lightRadius;
+		actor.m_spawnInterval      = actorDef.m_spawnInterval;
+		if (!actorDef.m_spriteSheetPath.empty())
+		{
+			CheckAssetExists(actorDef.m_spriteSheetPath, name);
+		}
+
+		// Visuals
+		actor.m_firstAnimationGroup = static_cast<unsigned int>(m_animationGroups.size());
+		for (int animGroupIndex = 0; animGroupIndex < static_cast<int>(actorDef.m_animationGroupInfos.size()); ++animGroupIndex)
+		{
+			AnimationGroupInfo const& animGroupInfo = actorDef.m_animationGroupInfos[animGroupIndex];
+			AnimationGroupRecord animGroup = {};
+			animGroup.m_name            = Intern(animGroupInfo.m_name);
+			animGroup.m_secondsPerFrame = animGroupInfo.m_secondsPerFrame;
+			animGroup.m_playbackMode    = static_cast<int>(animGroupInfo.m_playbackMode);
+			animGroup.m_scaleBySpeed    = animGroupInfo.m_scaleBySpeed ? 1 : 0;
+			animGroup.m_firstDirection  = static_cast<unsigned int>(m_animationDirections.size());
+			for (int directionIndex = 0; directionIndex < static_cast<int>(animGroupInfo.m_directions.size()); ++directionIndex)
+			{
+				AnimationDirectionInfo const& directionInfo = animGroupInfo.m_directions[directionIndex];
+				AnimationDirectionRecord direction = {};
+				direction.m_direction  = directionInfo.m_direction;
+				direction.m_startFrame = directionInfo.m_startFrame;
+				direction.m_endFrame   = directionInfo.m_endFrame;
+				m_animationDirections.push_back(direction);
+			}
+			animGroup.m_numDirections = static_cast<unsigned int>(m_animationDirections.size()) - animGroup.m_firstDirection;
+			m_animationGroups.push_back(animGroup);
+		}
+		actor.m_numAnimationGroups = static_cast<unsigned int>(m_animationGroups.size()) - actor.m_firstAnimationGroup;
+
+		// Sounds
+		actor.m_firstSound = static_cast<unsigned int>(m_sounds.size());
+		for (int soundIndex = 0; soundIndex < static_cast<int>(actorDef.m_sounds.size()); ++soundIndex)
+		{
+			CheckAssetExists(actorDef.m_sounds[soundIndex].m_soundFilePath, name);
+			SoundRecord sound = {};
+			sound.m_name     = Intern(actorDef.m_sounds[soundIndex].m_soundName);
+			sound.m_filePath = Intern(actorDef.m_sounds[soundIndex].m_soundFilePath);
+			m_sounds.push_back(sound);
+		}
+		actor.m_numSounds = static_cast<unsigned int>(m_sounds.size()) - actor.m_firstSound;
+
+		// The spawned actor and weapons are resolved once every file is read
+		actor.m_enemyTypeIndex = -1;
+		AddReference(actorDef.m_enemyType, name, BundleSection::ACTORS, static_cast<int>(m_actors.size()));
+		actor.m_firstWeaponReference = static_cast<unsigned int>(m_weaponReferences.size());
+		for (int weaponIndex = 0; weaponIndex < static_cast<int>(actorDef.m_weaponNames.size()); ++weaponIndex)
+		{
+			AddReference(actorDef.m_weaponNames[weaponIndex], name, BundleSection::WEAPON_REFERENCES, static_cast<int>(m_weaponReferences.size()));
+			m_weaponReferences.push_back(-1);
+		}
+		actor.m_numWeaponReferences = static_cast<unsigned int>(m_weaponReferences.size()) - actor.m_firstWeaponReference;
+		m_actors.push_back(actor);
+	}
+}
+
+void DefinitionCooker::CookWeaponFile(std::string const& filePath)
+{
+	XmlDocument document;
+	XmlElement const* rootElement = OpenDefinitionFile(document, filePath);
+	if (rootElement == nullptr)
+	{
+		return;
+	}
+
+	for (XmlElement const* weaponDefElement = rootElement->FirstChildElement(); weaponDefElement != nullptr; weaponDefElement = weaponDefElement->NextSiblingElement())
+	{
+		if (!CheckElementName(*weaponDefElement, filePath, "WeaponDefinition"))
+		{
+			continue;
+		}
+
+		// Parsed only, no assets
+		WeaponDefinition weaponDef;
+		weaponDef.ParseXmlElement(*weaponDefElement);
+		std::string const& name = weaponDef.m_weaponName;
+		CheckNameIsUnique(m_weaponNames, name, static_cast<int>(m_weapons.size()), "Weapon");
+
+		WeaponRecord weapon = {};
+		weapon.m_name               = Intern(name);
+		weapon.m_refireTime         = weaponDef.m_refireTime;
+		weapon.m_rayCount           = weaponDef.m_rayCount;
+		weapon.m_rayCone            = weaponDef.m_rayCone;
+		weapon.m_rayRange           = weaponDef.m_rayRange;
+		weapon.m_rayDamage          = weaponDef.m_rayDamage;
+		weapon.m_rayImpulse         = weaponDef.m_rayImpulse;
+		weapon.m_projectileCount    = weaponDef.m_projectileCount;
+		weapon.m_projectileCone     = weaponDef.m_projectileCone;
+		weapon.m_projectileSpeed    = weaponDef.m_projectileSpeed;
+		weapon.m_maxRange           = weaponDef.m_maxRange;
+		weapon.m_meleeCount         = weaponDef.m_meleeCount;
+		weapon.m_meleeArc           = weaponDef.m_meleeArc;
+		weapon.m_meleeRange         = weaponDef.m_meleeRange;
+		weapon.m_meleeDamage        = weaponDef.m_meleeDamage;
+		weapon.m_impMeleeDamage     = weaponDef.m_impMeleeDamage;
+		weapon.m_meleeImpulse       = weaponDef.m_meleeImpulse;
+		weapon.m_hudShaderName      = Intern(weaponDef.m_hudShaderName);
+		weapon.m_baseTexturePath    = Intern(weaponDef.m_baseTexturePath);
+		weapon.m_reticleTexturePath = Intern(weaponDef.m_reticleTexturePath);
+		weapon.m_reticleSize        = weaponDef.m_reticleSize;
+		weapon.m_spriteSize         = weaponDef.m_spriteSize;
+		weapon.m_spritePivot        = weaponDef.m_spritePivot;
+		weapon.m_soundName          = Intern(weaponDef.m_soundName);
+		weapon.m_soundFilePath      = Intern(weaponDef.m_soundFilePath);
+		if (!weaponDef.m_baseTexturePath.empty())
+		{
+			CheckAssetExists(weaponDef.m_baseTexturePath, name);
+		}
+		if (!weaponDef.m_reticleTexturePath.empty())
+		{
+			CheckAssetExists(weaponDef.m_reticleTexturePath, name);
+		}
+		if (!weaponDef.m_soundFilePath.empty())
+		{
+			CheckAssetExists(weaponDef.m_soundFilePath, name);
+		}
+
+		// The projectile actor is resolved once every file is read
+		weapon.m_projectileActorIndex = -1;
+		if (!weaponDef.m_projectileActor.empty())
+		{
+			AddReference(weaponDef.m_projectileActor, name, BundleSection::WEAPONS, static_cast<int>(m_weapons.size()));
+		}
+
+		// HUD animations
+		weapon.m_firstAnimation = static_cast<unsigned int>(m_weaponAnimations.size());
+		for (int animIndex = 0; animIndex < static_cast<int>(weaponDef.m_animationInfos.size()); ++animIndex)
+		{
+			WeaponAnimationInfo const& animInfo = weaponDef.m_animationInfos[animIndex];
+			CheckAssetExists(animInfo.m_spriteSheetPath, name);
+
+			WeaponAnimationRecord animation = {};
+			animation.m_name            = Intern(animInfo.m_name);
+			animation.m_shaderName      = Intern(animInfo.m_shaderName);
+			animation.m_spriteSheetPath = Intern(animInfo.m_spriteSheetPath);
+			animation.m_cellCount       = animInfo.m_cellCount;
+			animation.m_startFrame      = animInfo.m_startFrame;
+			animation.m_endFrame        = animInfo.m_endFrame;
+			animation.m_secondsPerFrame = animInfo.m_secondsPerFrame;
+			m_weaponAnimations.push_back(animation);
+		}
+		weapon.m_numAnimations = static_cast<unsigned int>(m_weaponAnimations.size()) - weapon.m_firstAnimation;
+		m_weapons.push_back(weapon);
+	}
+}
+
+void DefinitionCooker::ResolveReferences()
+{
+	for (int referenceIndex = 0; referenceIndex < static_cast<int>(m_references.size()); ++referenceIndex)
+	{
+		PendingReference const& reference = m_references[referenceIndex];
+		switch (reference.m_section)
+		{
+			case BundleSection::SPAWNS:
+			{
+				m_spawns[reference.m_recordIndex].m_actorIndex = FindReferenced(m_actorNames, reference, "actor");
+				break;
+			}
+			case BundleSection::ACTORS:
+			{
+				m_actors[reference.m_recordIndex].m_enemyTypeIndex = FindReferenced(m_actorNames, reference, "actor");
+				break;
+			}
+			case BundleSection::WEAPONS:
+			{
+				m_weapons[reference.m_recordIndex].m_projectileActorIndex = FindReferenced(m_actorNames, reference, "actor");
+				break;
+			}
+			case BundleSection::WEAPON_REFERENCES:
+			{
+				m_weaponReferences[reference.m_recordIndex] = FindReferenced(m_weaponNames, reference, "weapon");
+				break;
+			}
+			default:
+			{
+				break;
+			}
+		}
+	}
+}
+
+template <typename T>
+void DefinitionCooker::AppendSection(std::vector<unsigned char>& bytes, BundleHeader& header, BundleSection section, std::vector<T> const& records) const
+{
+	while (bytes.size() % BUNDLE_SECTION_ALIGNMENT != 0)
+	{
+		bytes.push_back(0);
+	}
+
+	int sectionIndex = static_cast<int>(section);
+	header.m_sections[sectionIndex].m_offset = static_cast<unsigned int>(bytes.size());
+	header.m_sections[sectionIndex].m_numRecords = static_cast<unsigned int>(records.size());
+	for (int recordIndex = 0; recordIndex < static_cast<int>(records.size()); ++recordIndex)
+	{
+		AppendBytes(bytes, records[recordIndex]);
+	}
+}
+
+void DefinitionCooker::WriteBundle(std::vector<unsigned char>& outBytes) const
+{
+	BundleHeader header = {};
+	header.m_fourCC[0] = 'D';
+	header.m_fourCC[1] = 'D';
+	header.m_fourCC[2] = 'E';
+	header.m_fourCC[3] = 'F';
+	header.m_version = DEFINITION_BUNDLE_VERSION;
+	for (int sectionIndex = 0; sectionIndex < NUM_BUNDLE_SECTIONS; ++sectionIndex)
+	{
+		header.m_recordSizes[sectionIndex] = BUNDLE_RECORD_SIZES[sectionIndex];
+	}
+
+	outBytes.clear();
+	AppendBytes(outBytes, header);
+	AppendSection(outBytes, header, BundleSection::STRINGS, m_strings);
+	AppendSection(outBytes, header, BundleSection::SOURCES, m_sources);
+	AppendSection(outBytes, header, BundleSection::TILES, m_tiles);
+	AppendSection(outBytes, header, BundleSection::MAPS, m_maps);
+	AppendSection(outBytes, header, BundleSection::SPAWNS, m_spawns);
+	AppendSection(outBytes, header, BundleSection::ACTORS, m_actors);
+	AppendSection(outBytes, header, BundleSection::ANIMATION_GROUPS, m_animationGroups);
+	AppendSection(outBytes, header, BundleSection::ANIMATION_DIRECTIONS, m_animationDirections);
+	AppendSection(outBytes, header, BundleSection::SOUNDS, m_sounds);
+	AppendSection(outBytes, header, BundleSection::WEAPON_REFERENCES, m_weaponReferences);
+	AppendSection(outBytes, header, BundleSection::WEAPONS, m_weapons);
+	AppendSection(outBytes, header, BundleSection::WEAPON_ANIMATIONS, m_weaponAnimations);
+
+	header.m_numBytes = static_cast<unsigned int>(outBytes.size());
+	OverwriteBytes(outBytes, 0, header);
+}
+
+// -----------------------------------------------------------------------------
+// DefinitionSources
+// -----------------------------------------------------------------------------
+DefinitionSources DefinitionSources::GetDefault()
+{
+	DefinitionSources sources;
+	sources.m_factionFiles.push_back("Data/Definitions/FactionDefinitions.xml");
+	sources.m_tileFiles.push_back("Data/Definitions/TileDefinitions.xml");
+	sources.m_mapFiles.push_back("Data/Definitions/MapDefinitions.xml");
+	sources.m_weaponFiles.push_back("Data/Definitions/WeaponDefinitions.xml");
+	sources.m_actorFiles.push_back("Data/Definitions/ProjectileActorDefinitions.xml");
+	sources.m_actorFiles.push_back("Data/Definitions/ActorDefinitions.xml");
+	return sources;
+}
+
+// -----------------------------------------------------------------------------
+// DefinitionBundle
+// -----------------------------------------------------------------------------
+bool DefinitionBundle::Cook(DefinitionSources const& sources, std::vector<unsigned char>& outBytes, std::vector<std::string>& outErrors)
+{
+	DefinitionCooker cooker;
+	for (int fileIndex = 0; fileIndex < static_cast<int>(sources.m_factionFiles.size()); ++fileIndex)
+	{
+		cooker.CookFactionFile(sources.m_factionFiles[fileIndex]);
+	}
+	for (int fileIndex = 0; fileIndex < static_cast<int>(sources.m_tileFiles.size()); ++fileIndex)
+	{
+		cooker.CookTileFile(sources.m_tileFiles[fileIndex]);
+	}
+	for (int fileIndex = 0; fileIndex < static_cast<int>(sources.m_mapFiles.size()); ++fileIndex)
+	{
+		cooker.CookMapFile(sources.m_mapFiles[fileIndex]);
+	}
+	for (int fileIndex = 0; fileIndex < static_cast<int>(sources.m_actorFiles.size()); ++fileIndex)
+	{
+		cooker.CookActorFile(sources.m_actorFiles[fileIndex]);
+	}
+	for (int fileIndex = 0; fileIndex < static_cast<int>(sources.m_weaponFiles.size()); ++fileIndex)
+	{
+		cooker.CookWeaponFile(sources.m_weaponFiles[fileIndex]);
+	}
+	cooker.ResolveReferences();
+
+	outErrors = cooker.m_errors;
+	if (!outErrors.empty())
+	{
+		return false;
+	}
+	cooker.WriteBundle(outBytes);
+	return true;
+}
+
+bool DefinitionBundle::LoadFile(std::string const& filePath, std::string& outError)
+{
+	if (filePath.empty())
+	{
+		outError = "no definition bundle configured";
+		return false;
+	}
+
+	std::ifstream file(filePath, std::ios::binary);
+	if (!file)
+	{
+		outError = Stringf("%s not found, run CookDefinitions to build it", filePath.c_str());
+		return false;
+	}
+	std::vector<unsigned char> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	if (!Open(std::move(bytes), outError))
+	{
+		outError = Stringf("%s: %s", filePath.c_str(), outError.c_str());
+		return false;
+	}
+	if (!AreSourcesUnchanged())
+	{
+		outError = Stringf("%s is older than its XML, run CookDefinitions to rebuild it", filePath.c_str());
+		return false;
+	}
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Checks only what could make reading a record go out of bounds. Everything
+// else was validated by the cooker, so this is the whole cost of loading.
+// -----------------------------------------------------------------------------
+bool DefinitionBundle::Open(std::vector<unsigned char>&& bytes, std::string& outError)
+{
+	m_bytes.clear();
+	if (bytes.size() < sizeof(BundleHeader))
+	{
+		outError = "file is too small to be a definition bundle";
+		return false;
+	}
+
+	BundleHeader const& header = *reinterpret_cast<BundleHeader const*>(bytes.data());
+	if (header.m_fourCC[0] != 'D' || header.m_fourCC[1] != 'D' || header.m_fourCC[2] != 'E' || header.m_fourCC[3] != 'F')
+	{
+		outError = "not a definition bundle";
+		return false;
+	}
+	if (header.m_version != DEFINITION_BUNDLE_VERSION || header.m_numBytes != bytes.size())
+	{
+		outError = Stringf("bundle version %u does not match version %u", header.m_version, DEFINITION_BUNDLE_VERSION);
+		return false;
+	}
+	for (int sectionIndex = 0; sectionIndex < NUM_BUNDLE_SECTIONS; ++sectionIndex)
+	{
+		BundleSectionRange const& section = header.m_sections[sectionIndex];
+		size_t sectionEnd = static_cast<size_t>(section.m_offset) + static_cast<size_t>(section.m_numRecords) * BUNDLE_RECORD_SIZES[sectionIndex];
+		if (header.m_recordSizes[sectionIndex] != BUNDLE_RECORD_SIZES[sectionIndex] || section.m_offset % BUNDLE_SECTION_ALIGNMENT != 0 || sectionEnd > bytes.size())
+		{
+			outError = "bundle was cooked by a build with a different record layout";
+			return false;
+		}
+	}
+
+	BundleSectionRange const& strings = header.m_sections[static_cast<int>(BundleSection::STRINGS)];
+	if (strings.m_numRecords == 0 || bytes[strings.m_offset + strings.m_numRecords - 1] != '\0')
+	{
+		outError = "string table is not terminated";
+		return false;
+	}
+
+	m_bytes = std::move(bytes);
+	return true;
+}
+
+bool DefinitionBundle::AreSourcesUnchanged() const
+{
+	int numSources = 0;
+	SourceRecord const* sources = GetRecords<SourceRecord>(static_cast<int>(BundleSection::SOURCES), numSources);
+	for (int sourceIndex = 0; sourceIndex < numSources; ++sourceIndex)
+	{
+		unsigned long long numBytes = 0;
+		long long writeTime = 0;
+		if (!GetSourceStamp(GetString(sources[sourceIndex].m_filePath), numBytes, writeTime) ||
+			numBytes != sources[sourceIndex].m_numBytes || writeTime != sources[sourceIndex].m_writeTime)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+// Map layout images are left out, they only load once their map is built
+void DefinitionBundle::QueueNamedAssets(AssetLoader& loader) const
+{
+	int numActors = 0;
+	ActorRecord const* actors = GetRecords<ActorRecord>(static_cast<int>(BundleSection::ACTORS), numActors);
+	for (int actorIndex = 0; actorIndex < numActors; ++actorIndex)
+	{
+		loader.QueueNamedAsset(GetString(actors[actorIndex].m_spriteSheetPath));
+	}
+
+	int numSounds = 0;
+	SoundRecord const* sounds = GetRecords<SoundRecord>(static_cast<int>(BundleSection::SOUNDS), numSounds);
+	for (int soundIndex = 0; soundIndex < numSounds; ++soundIndex)
+	{
+		loader.QueueNamedAsset(GetString(sounds[soundIndex].m_filePath));
+	}
+
+	int numWeapons = 0;
+	WeaponRecord const* weapons = GetRecords<WeaponRecord>(static_cast<int>(BundleSection::WEAPONS), numWeapons);
+	for (int weaponIndex = 0; weaponIndex < numWeapons; ++weaponIndex)
+	{
+		loader.QueueNamedAsset(GetString(weapons[weaponIndex].m_baseTexturePath));
+		loader.QueueNamedAsset(GetString(weapons[weaponIndex].m_reticleTexturePath));
+		loader.QueueNamedAsset(GetString(weapons[weaponIndex].m_soundFilePath));
+	}
+
+	int numAnimations = 0;
+	WeaponAnimationRecord const* animations = GetRecords<WeaponAnimationRecord>(static_cast<int>(BundleSection::WEAPON_ANIMATIONS), numAnimations);
+	for (int animationIndex = 0; animationIndex < numAnimations; ++animationIndex)
+	{
+		loader.QueueNamedAsset(GetString(animations[animationIndex].m_spriteSheetPath));
+	}
+}
+
+void DefinitionBundle::CreateDefinitions() const
+{
+	CreateTileDefinitions(TileDefinition::s_definitions);
+	CreateMapDefinitions(MapDefinition::s_mapDefinitions);
+	CreateActorDefinitions(ActorDefinition::s_actorDefinitions);
+	CreateWeaponDefinitions(WeaponDefinition::s_weaponDefinitions);
+	LinkDefinitions(MapDefinition::s_mapDefinitions, ActorDefinition::s_actorDefinitions, WeaponDefinition::s_weaponDefinitions);
+}
+
+void DefinitionBundle::CreateTileDefinitions(std::vector<TileDefinition*>& outDefinitions) const
+{
+	int numTiles = 0;
+	TileRecord const* tiles = GetRecords<TileRecord>(static_cast<int>(BundleSection::TILES), numTiles);
+	for (int tileIndex = 0; tileIndex < numTiles; ++tileIndex)
+	{
+		TileRecord const& tile = tiles[tileIndex];
+		TileDefinition* tileDef = new TileDefinition();
+		tileDef->m_name          = GetString(tile.m_name);
+		tileDef->m_isSolid       = tile.m_isSolid != 0;
+		tileDef->m_mapImageColor = tile.m_mapImageColor;
+		tileDef->m_floorCoords   = tile.m_floorCoords;
+		tileDef->m_wallCoords    = tile.m_wallCoords;
+		tileDef->m_ceilingCoords = tile.m_ceilingCoords;
+		outDefinitions.push_back(tileDef);
+	}
+}
+
+// Spawned actors are set by LinkDefinitions once the actor definitions exist
+void DefinitionBundle::CreateMapDefinitions(std::vector<MapDefinition*>& outDefinitions) const
+{
+	int numMaps = 0;
+	MapRecord const* maps = GetRecords<MapRecord>(static_cast<int>(BundleSection::MAPS), numMaps);
+	int numSpawns = 0;
+	SpawnRecord const* spawns = GetRecords<SpawnRecord>(static_cast<int>(BundleSection::SPAWNS), numSpawns);
+
+	for (int mapIndex = 0; mapIndex < numMaps; ++mapIndex)
+	{
+		MapRecord const& map = maps[mapIndex];
+		MapDefinition* mapDef = new MapDefinition();
+		mapDef->m_name                   = GetString(map.m_name);
+		mapDef->m_imagePath              = GetString(map.m_imagePath);
+		mapDef->m_shaderName             = GetString(map.m_shaderName);
+		mapDef->m_spriteSheetTexturePath = GetString(map.m_spriteSheetTexturePath);
+		mapDef->m_spriteSheetCellCount   = map.m_spriteSheetCellCount;
+		for (unsigned int spawnIndex = map.m_firstSpawn; spawnIndex < map.m_firstSpawn + map.m_numSpawns; ++spawnIndex)
+		{
+			SpawnInfo spawnInfo;
+			spawnInfo.m_position    = spawns[spawnIndex].m_position;
+			spawnInfo.m_orientation = spawns[spawnIndex].m_orientation;
+			mapDef->m_spawningInfo.push_back(spawnInfo);
+		}
+		outDefinitions.push_back(mapDef);
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Sets the fields parsing would have and runs the same Initialize, so the
+// shaders, sprite sheets and sounds are created exactly as from XML.
+// -----------------------------------------------------------------------------
+void DefinitionBundle::CreateActorDefinitions(std::vector<ActorDefinition*>& outDefinitions) const
+{
+	int numActors = 0;
+	ActorRecord const* actors = GetRecords<ActorRecord>(static_cast<int>(BundleSection::ACTORS), numActors);
+	int numAnimGroups = 0;
+	AnimationGroupRecord const* animGroups = GetRecords<AnimationGroupRecord>(static_cast<int>(BundleSection::ANIMATION_GROUPS), numAnimGroups);
+	int numDirections = 0;
+	AnimationDirectionRecord const* directions = GetRecords<AnimationDirectionRecord>(static_cast<int>(BundleSection::ANIMATION_DIRECTIONS), numDirections);
+	int numSounds = 0;
+	SoundRecord const* sounds = GetRecords<SoundRecord>(static_cast<int>(BundleSection::SOUNDS), numSounds);
+
+	for (int actorIndex = 0; actorIndex < numActors; ++actorIndex)
+	{
+		ActorRecord const& actor = actors[actorIndex];
+		ActorDefinition* actorDef = new ActorDefinition();
+		actorDef->m_actorName          = GetString(actor.m_name);
+		actorDef->m_isVisible          = actor.m_isVisible != 0;
+		actorDef->m_health             = actor.m_health;
+		actorDef->m_corpseLifetime     = actor.m_corpseLifetime;
+		actorDef->m_faction            = GetString(actor.m_faction);
+		actorDef->m_canBePossessed     = actor.m_canBePossessed != 0;
+		actorDef->m_dieOnSpawn         = actor.m_dieOnSpawn != 0;
+		actorDef->m_physicsRadius      = actor.m_physicsRadius;
+		actorDef->m_physicsHeight      = actor.m_physicsHeight;
+		actorDef->m_legHeight          = actor.m_legHeight;
+		actorDef->m_bodyHeight         = actor.m_bodyHeight;
+		actorDef->m_headHeight         = actor.m_headHeight;
+		actorDef->m_collidesWithWorld  = actor.m_collidesWithWorld != 0;
+		actorDef->m_collidesWithActors = actor.m_collidesWithActors != 0;
+		actorDef->m_dieOnCollide       = actor.m_dieOnCollide != 0;
+		actorDef->m_damageOnCollide    = actor.m_damageOnCollide;
+		actorDef->m_impulseOnCollide   = actor.m_impulseOnCollide;
+		actorDef->m_isSimulated        = actor.m_isSimulated != 0;
+		actorDef->m_isFlying           = actor.m_isFlying != 0;
+		actorDef->m_flyHeight          = actor.m_flyHeight;
+		actorDef->m_walkSpeed          = actor.m_walkSpeed;
+		actorDef->m_runSpeed           = actor.m_runSpeed;
+		actorDef->m_drag               = actor.m_drag;
+		actorDef->m_turnSpeed          = actor.m_turnSpeed;
+		actorDef->m_eyeHeight          = actor.m_eyeHeight;
+		actorDef->m_cameraFOVDeg       = actor.m_cameraFOVDeg;
+		actorDef->m_isAIEnabled        = actor.m_isAIEnabled != 0;
+		actorDef->m_sightRadius        = actor.m_sightRadius;
+		actorDef->m_sightAngle         = actor.m_sightAngle;
+		actorDef->m_spriteSize         = actor.m_spriteSize;
+		actorDef->m_spritePivot        = actor.m_spritePivot;
+		actorDef->m_billboardType      = static_cast<BillboardType>(actor.m_billboardType);
+		actorDef->m_renderLit          = actor.m_renderLit != 0;
+		actorDef->m_renderRounded      = actor.m_renderRounded != 0;
+		actorDef->m_shaderName         = GetString(actor.m_shaderName);
+		actorDef->m_spriteSheetPath    = GetString(actor.m_spriteSheetPath);
+		actorDef->m_cellCount          = actor.m_cellCount;
+		actorDef->m_emitsLight         = actor.m_emitsLight != 0;
+		actorDef->m_lightColor         = actor.m_lightColor;
+		actorDef->m_lightRadius        = actor.m_lightRadius;
+		actorDef->m_spawnInterval      = actor.m_spawnInterval;
+
+		for (unsigned int animGroupIndex = actor.m_firstAnimationGroup; animGroupIndex < actor.m_firstAnimationGroup + actor.m_numAnimationGroups; ++animGroupIndex)
+		{
+			AnimationGroupRecord const& animGroup = animGroups[animGroupIndex];
+			AnimationGroupInfo animGroupInfo;
+			animGroupInfo.m_name            = GetString(animGroup.m_name);
+			animGroupInfo.m_secondsPerFrame = animGroup.m_secondsPerFrame;
+			animGroupInfo.m_playbackMode    = static_cast<SpriteAnimPlaybackType>(animGroup.m_playbackMode);
+			animGroupInfo.m_scaleBySpeed    = animGroup.m_scaleBySpeed != 0;
+			for (unsigned int directionIndex = animGroup.m_firstDirection; directionIndex < animGroup.m_firstDirection + animGroup.m_numDirections; ++directionIndex)
+			{
+				AnimationDirectionInfo direction;
+				direction.m_direction  = directions[directionIndex].m_direction;
+				direction.m_startFrame = directions[directionIndex].m_startFrame;
+				direction.m_endFrame   = directions[directionIndex].m_endFrame;
+				animGroupInfo.m_directions.push_back(direction);
+			}
+			actorDef->m_animationGroupInfos.push_back(animGroupInfo);
+		}
+
+		for (unsigned int soundIndex = actor.m_firstSound; soundIndex < actor.m_firstSound + actor.m_numSounds; ++soundIndex)
+		{
+			Sounds actorSound;
+			actorSound.m_soundName = GetString(sounds[soundIndex].m_name);
+			actorSound.m_soundFilePath = GetString(sounds[soundIndex].m_filePath);
+			actorDef->m_sounds.push_back(actorSound);
+		}
+
+		actorDef->Initialize();
+		outDefinitions.push_back(actorDef);
+	}
+}
+
+void DefinitionBundle::CreateWeaponDefinitions(std::vector<WeaponDefinition*>& outDefinitions) const
+{
+	int numWeapons = 0;
+	WeaponRecord const* weapons = GetRecords<WeaponRecord>(static_cast<int>(BundleSection::WEAPONS), numWeapons);
+	int numAnimations = 0;
+	WeaponAnimationRecord const* animations = GetRecords<WeaponAnimationRecord>(static_cast<int>(BundleSection::WEAPON_ANIMATIONS), numAnimations);
+
+	for (int weaponIndex = 0; weaponIndex < numWeapons; ++weaponIndex)
+	{
+		WeaponRecord const& weapon = weapons[weaponIndex];
+		WeaponDefinition* weaponDef = new WeaponDefinition();
+		weaponDef->m_weaponName         = GetString(weapon.m_name);
+		weaponDef->m_refireTime         = weapon.m_refireTime;
+		weaponDef->m_rayCount           = weapon.m_rayCount;
+		weaponDef->m_rayCone            = weapon.m_rayCone;
+		weaponDef->m_rayRange           = weapon.m_rayRange;
+		weaponDef->m_rayDamage          = weapon.m_rayDamage;
+		weaponDef->m_rayImpulse         = weapon.m_rayImpulse;
+		weaponDef->m_projectileCount    = weapon.m_projectileCount;
+		weaponDef->m_projectileCone     = weapon.m_projectileCone;
+		weaponDef->m_projectileSpeed    = weapon.m_projectileSpeed;
+		weaponDef->m_maxRange           = weapon.m_maxRange;
+		weaponDef->m_meleeCount         = weapon.m_meleeCount;
+		weaponDef->m_meleeArc           = weapon.m_meleeArc;
+		weaponDef->m_meleeRange         = weapon.m_meleeRange;
+		weaponDef->m_meleeDamage        = weapon.m_meleeDamage;
+		weaponDef->m_impMeleeDamage     = weapon.m_impMeleeDamage;
+		weaponDef->m_meleeImpulse       = weapon.m_meleeImpulse;
+		weaponDef->m_hudShaderName      = GetString(weapon.m_hudShaderName);
+		weaponDef->m_baseTexturePath    = GetString(weapon.m_baseTexturePath);
+		weaponDef->m_reticleTexturePath = GetString(weapon.m_reticleTexturePath);
+		weaponDef->m_reticleSize        = weapon.m_reticleSize;
+		weaponDef->m_spriteSize         = weapon.m_spriteSize;
+		weaponDef->m_spritePivot        = weapon.m_spritePivot;
+		weaponDef->m_soundName          = GetString(weapon.m_soundName);
+		weaponDef->m_soundFilePath      = GetString(weapon.m_soundFilePath);
+
+		for (unsigned int animationIndex = weapon.m_firstAnimation; animationIndex < weapon.m_firstAnimation + weapon.m_numAnimations; ++animationIndex)
+		{
+			WeaponAnimationRecord const& animation = animations[animationIndex];
+			WeaponAnimationInfo animInfo;
+			animInfo.m_name            = GetString(animation.m_name);
+			animInfo.m_shaderName      = GetString(animation.m_shaderName);
+			animInfo.m_spriteSheetPath = GetString(animation.m_spriteSheetPath);
+			animInfo.m_cellCount       = animation.m_cellCount;
+			animInfo.m_startFrame      = animation.m_startFrame;
+			animInfo.m_endFrame        = animation.m_endFrame;
+			animInfo.m_secondsPerFrame = animation.m_secondsPerFrame;
+			weaponDef->m_animationInfos.push_back(animInfo);
+		}
+
+		weaponDef->Initialize();
+		outDefinitions.push_back(weaponDef);
+	}
+}
+
+// -----------------------------------------------------------------------------
+// References were resolved to record indices while cooking, and the lists hold
+// this bundle's definitions in record order, so each is one index away.
+// -----------------------------------------------------------------------------
+void DefinitionBundle::LinkDefinitions(std::vector<MapDefinition*>& mapDefs, std::vector<ActorDefinition*>& actorDefs, std::vector<WeaponDefinition*>& weaponDefs) const
+{
+	int numMaps = 0;
+	MapRecord const* maps = GetRecords<MapRecord>(static_cast<int>(BundleSection::MAPS), numMaps);
+	int numSpawns = 0;
+	SpawnRecord const* spawns = GetRecords<SpawnRecord>(static_cast<int>(BundleSection::SPAWNS), numSpawns);
+	int numActors = 0;
+	ActorRecord const* actors = GetRecords<ActorRecord>(static_cast<int>(BundleSection::ACTORS), numActors);
+	int numWeaponReferences = 0;
+	int const* weaponReferences = GetRecords<int>(static_cast<int>(BundleSection::WEAPON_REFERENCES), numWeaponReferences);
+	int numWeapons = 0;
+	WeaponRecord const* weapons = GetRecords<WeaponRecord>(static_cast<int>(BundleSection::WEAPONS), numWeapons);
+	GUARANTEE_OR_DIE(static_cast<int>(mapDefs.size()) == numMaps && static_cast<int>(actorDefs.size()) == numActors && static_cast<int>(weaponDefs.size()) == numWeapons,
+		"Definitions linked from a bundle must be exactly the ones created from it");
+
+	for (int mapIndex = 0; mapIndex < numMaps; ++mapIndex)
+	{
+		for (unsigned int spawnIndex = 0; spawnIndex < maps[mapIndex].m_numSpawns; ++spawnIndex)
+		{
+			mapDefs[mapIndex]->m_spawningInfo[spawnIndex].m_actorDef = actorDefs[spawns[maps[mapIndex].m_firstSpawn + spawnIndex].m_actorIndex];
+		}
+	}
+
+	for (int actorIndex = 0; actorIndex < numActors; ++actorIndex)
+	{
+		ActorRecord const& actor = actors[actorIndex];
+		actorDefs[actorIndex]->m_enemyTypeDef = actorDefs[actor.m_enemyTypeIndex];
+		for (unsigned int referenceIndex = actor.m_firstWeaponReference; referenceIndex < actor.m_firstWeaponReference + actor.m_numWeaponReferences; ++referenceIndex)
+		{
+			actorDefs[actorIndex]->m_weaponDefs.push_back(weaponDefs[weaponReferences[referenceIndex]]);
+		}
+	}
+
+	for (int weaponIndex = 0; weaponIndex < numWeapons; ++weaponIndex)
+	{
+		if (weapons[weaponIndex].m_projectileActorIndex >= 0)
+		{
+			weaponDefs[weaponIndex]->m_projectileActorDef = actorDefs[weapons[weaponIndex].m_projectileActorIndex];
+		}
+	}
+}
+
+template <typename T>
+T const* DefinitionBundle::GetRecords(int sectionIndex, int& outNumRecords) const
+{
+	BundleHeader const& header = *reinterpret_cast<BundleHeader const*>(m_bytes.data());
+	outNumRecords = static_cast<int>(header.m_sections[sectionIndex].m_numRecords);
+	return reinterpret_cast<T const*>(m_bytes.data() + header.m_sections[sectionIndex].m_offset);
+}
+
+char const* DefinitionBundle::GetString(unsigned int stringOffset) const
+{
+	int numChars = 0;
+	char const* strings = GetRecords<char>(static_cast<int>(BundleSection::STRINGS), numChars);
+	return (stringOffset < static_cast<unsigned int>(numChars)) ? strings + stringOffset : "";
+}
+
+// -----------------------------------------------------------------------------
+// Dev console: CookDefinitions file=<path>
+// Validates every definition XML file and writes them as one bundle. Nothing
+// is written when a file is malformed or names something that doesn't exist.
+// -----------------------------------------------------------------------------
+bool DefinitionBundle::Command_CookDefinitions(EventArgs& args)
+{
+	std::string filePath = args.GetValue("file", BUNDLE_DEFAULT_FILE);
+
+	double cookStart = GetCurrentTimeSeconds();
+	std::vector<unsigned char> bytes;
+	std::vector<std::string> errors;
+	if (!Cook(DefinitionSources::GetDefault(), bytes, errors))
+	{
+		for (int errorIndex = 0; errorIndex < static_cast<int>(errors.size()); ++errorIndex)
+		{
+			g_theDevConsole->AddLine(Rgba8::RED, errors[errorIndex]);
+		}
+		g_theDevConsole->AddLine(Rgba8::RED, Stringf("Cooking failed with %d errors, %s was not written", static_cast<int>(errors.size()), filePath.c_str()));
+		return false;
+	}
+	double cookSeconds = GetCurrentTimeSeconds() - cookStart;
+
+	std::ofstream file(filePath, std::ios::binary);
+	file.write(reinterpret_cast<char const*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+	if (!file)
+	{
+		g_theDevConsole->AddLine(Rgba8::RED, Stringf("Could not write %s", filePath.c_str()));
+		return false;
+	}
+	g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, Stringf("Cooked %s in %.2f ms (%d bytes)", filePath.c_str(), cookSeconds * 1000.0, static_cast<int>(bytes.size())));
+	return true;
+}
+
+// Copies of the Demon with their own names, no shader so the timings are not all shader compiles
+static void WriteGeneratedActorFile(char const* filePath, int numActors, size_t& outNumBytes)
+{
+	static char const* const directionVectors[8] = { "-1,0,0", "-1,-1,0", "0,-1,0", "1,-1,0", "1,0,0", "1,1,0", "0,1,0", "-1,1,0" };
+
+	std::string xml = "<Definitions>\n";
+	for (int actorIndex = 0; actorIndex < numActors; ++actorIndex)
+	{
+		xml += Stringf("  <ActorDefinition name=\"Generated%d\" faction=\"Demon\" health=\"160\" canBePossessed=\"true\" corpseLifetime=\"1.0\" visible=\"true\">\n", actorIndex);
+		xml += "    <Collision radius=\"0.35\" height=\"0.85\" collidesWithWorld=\"true\" collidesWithActors=\"true\"/>\n";
+		xml += "    <Physics simulated=\"true\" walkSpeed=\"2.0f\" runSpeed=\"3.0f\" turnSpeed=\"180.0f\" drag=\"9.0f\"/>\n";
+		xml += "    <Camera eyeHeight=\"0.75f\" cameraFOV=\"120.0f\"/>\n";
+		xml += "    <AI aiEnabled=\"true\" sightRadius=\"64.0\" sightAngle=\"120.0\"/>\n";
+		xml += "    <Visuals size=\"2.1,2.1\" pivot=\"0.5,0.0\" billboardType=\"WorldUpFacing\" renderLit=\"true\" renderRounded=\"true\" shader=\"Default\" spriteSheet=\"Data/Images/Actor_Pinky_8x9.png\" cellCount=\"8,9\">\n";
+		xml += "      <AnimationGroup name=\"Walk\" scaleBySpeed=\"true\" secondsPerFrame=\"0.25\" playbackMode=\"Loop\">\n";
+		for (int directionIndex = 0; directionIndex < 8; ++directionIndex)
+		{
+			xml += Stringf("        <Direction vector=\"%s\"><Animation startFrame=\"%d\" endFrame=\"%d\"/></Direction>\n", directionVectors[directionIndex], directionIndex * 8, directionIndex * 8 + 3);
+		}
+		xml += "      </AnimationGroup>\n";
+		xml += "      <AnimationGroup name=\"Attack\" secondsPerFrame=\"0.25\" playbackMode=\"Once\">\n";
+		for (int directionIndex = 0; directionIndex < 8; ++directionIndex)
+		{
+			xml += Stringf("        <Direction vector=\"%s\"><Animation startFrame=\"%d\" endFrame=\"%d\"/></Direction>\n", directionVectors[directionIndex], directionIndex * 8 + 4, directionIndex * 8 + 6);
+		}
+		xml += "      </AnimationGroup>\n";
+		xml += "      <AnimationGroup name=\"Death\" secondsPerFrame=\"0.25\" playbackMode=\"Once\">\n";
+		xml += "        <Direction vector=\"1,0,0\"><Animation startFrame=\"64\" endFrame=\"69\"/></Direction>\n";
+		xml += "      </AnimationGroup>\n";
+		xml += "    </Visuals>\n";
+		xml += "    <Sounds>\n      <Sound sound=\"Hurt\" name=\"Data/Audio/DemonHurt.wav\"/>\n      <Sound sound=\"Death\" name=\"Data/Audio/DemonDeath.wav\"/>\n    </Sounds>\n";
+		xml += "    <Inventory>\n      <Weapon name=\"DemonMelee\" />\n    </Inventory>\n";
+		xml += "  </ActorDefinition>\n";
+	}
+	xml += "</Definitions>\n";
+
+	std::ofstream file(filePath, std::ios::binary);
+	file.write(xml.data(), static_cast<std::streamsize>(xml.size()));
+	outNumBytes = xml.size();
+}
+
+static void DeleteActorDefinitions(std::vector<ActorDefinition*>& actorDefs)
+{
+	for (int actorDefIndex = 0; actorDefIndex < static_cast<int>(actorDefs.size()); ++actorDefIndex)
+	{
+		delete actorDefs[actorDefIndex];
+	}
+	actorDefs.clear();
+}
+
+// -----------------------------------------------------------------------------
+// Dev console: DefinitionBench actors=<count>
+// Adds generated actor definitions to the real ones, then times building every
+// actor definition from XML against cooking once and loading the bundle.
+// -----------------------------------------------------------------------------
+bool DefinitionBundle::Command_DefinitionBench(EventArgs& args)
+{
+	int numGeneratedActors = args.GetValue("actors", 1000);
+	if (numGeneratedActors < 1)
+	{
+		g_theDevConsole->AddLine(Rgba8::RED, "DefinitionBench needs at least one actor");
+		return false;
+	}
+
+	size_t numGeneratedBytes = 0;
+	WriteGeneratedActorFile(BENCH_ACTOR_FILE, numGeneratedActors, numGeneratedBytes);
+	DefinitionSources sources = DefinitionSources::GetDefault();
+	sources.m_actorFiles.push_back(BENCH_ACTOR_FILE);
+
+	// XML, the way the game parses at startup
+	std::vector<ActorDefinition*> xmlActorDefs;
+	double xmlStart = GetCurrentTimeSeconds();
+	for (int fileIndex = 0; fileIndex < static_cast<int>(sources.m_actorFiles.size()); ++fileIndex)
+	{
+		XmlDocument actorDefsXml;
+		actorDefsXml.LoadFile(sources.m_actorFiles[fileIndex].c_str());
+		XmlElement const* rootElement = actorDefsXml.RootElement();
+		for (XmlElement const* actorDefElement = rootElement->FirstChildElement(); actorDefElement != nullptr; actorDefElement = actorDefElement->NextSiblingElement())
+		{
+			xmlActorDefs.push_back(new ActorDefinition(*actorDefElement));
+		}
+	}
+	double xmlSeconds = GetCurrentTimeSeconds() - xmlStart;
+
+	// Cooking is offline work, timed only for reference
+	double cookStart = GetCurrentTimeSeconds();
+	std::vector<unsigned char> bytes;
+	std::vector<std::string> errors;
+	bool didCook = Cook(sources, bytes, errors);
+	double cookSeconds = GetCurrentTimeSeconds() - cookStart;
+	if (didCook)
+	{
+		std::ofstream file(BENCH_BUNDLE_FILE, std::ios::binary);
+		file.write(reinterpret_cast<char const*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+	}
+
+	std::vector<ActorDefinition*> bundleActorDefs;
+	std::string loadError;
+	DefinitionBundle bundle;
+	double bundleStart = GetCurrentTimeSeconds();
+	bool didLoad = didCook && bundle.LoadFile(BENCH_BUNDLE_FILE, loadError);
+	if (didLoad)
+	{
+		bundle.CreateActorDefinitions(bundleActorDefs);
+	}
+	double bundleSeconds = GetCurrentTimeSeconds() - bundleStart;
+
+	bool doCountsMatch = xmlActorDefs.size() == bundleActorDefs.size();
+	int numActorDefs = static_cast<int>(xmlActorDefs.size());
+	DeleteActorDefinitions(xmlActorDefs);
+	DeleteActorDefinitions(bundleActorDefs);
+	std::error_code removeError;
+	std::filesystem::remove(BENCH_ACTOR_FILE, removeError);
+	std::filesystem::remove(BENCH_BUNDLE_FILE, removeError);
+
+	if (!didCook || !didLoad)
+	{
+		g_theDevConsole->AddLine(Rgba8::RED, didCook ? loadError : (errors.empty() ? std::string("Cooking failed") : errors[0]));
+		return false;
+	}
+	g_theDevConsole->AddLine(doCountsMatch ? Rgba8::LIGHTYELLOW : Rgba8::RED, Stringf("%d actor definitions (%d generated, %.2f KB of XML)",
+		numActorDefs, numGeneratedActors, static_cast<double>(numGeneratedBytes) / 1024.0));
+	g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, Stringf("XML: %.2f ms, bundle: %.2f ms (%.1fx), %.2f KB", xmlSeconds * 1000.0, bundleSeconds * 1000.0,
+		(bundleSeconds > 0.0) ? xmlSeconds / bundleSeconds : 0.0, static_cast<double>(bundle.GetNumBytes()) / 1024.0));
+	g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, Stringf("Cooking every definition file took %.2f ms", cookSeconds * 1000.0));
+	return true;
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include "Engine/Core/EventSystem.hpp"
+#include <string>
+#include <vector>
+// -----------------------------------------------------------------------------
+class AssetLoader;
+struct TileDefinition;
+struct MapDefinition;
+struct ActorDefinition;
+struct WeaponDefinition;
+// -----------------------------------------------------------------------------
+constexpr unsigned int DEFINITION_BUNDLE_VERSION = 3;
+// -----------------------------------------------------------------------------
+// The XML files cooked into one bundle, actor files in the order their
+// definitions are listed at runtime. Faction files are not cooked, they are
+// stamped so edited factions rebuild the bundle and checked against actors.
+// -----------------------------------------------------------------------------
+struct DefinitionSources
+{
+	std::vector<std::string> m_factionFiles;
+	std::vector<std::string> m_tileFiles;
+	std::vector<std::string> m_mapFiles;
+	std::vector<std::string> m_weaponFiles;
+	std::vector<std::string> m_actorFiles;
+
+	static DefinitionSources GetDefault();
+};
+// -----------------------------------------------------------------------------
+// Every definition file cooked into one flat binary. Records are plain structs
+// read in place from the loaded bytes, strings are interned into one table and
+// references between definitions are stored as indices resolved while cooking.
+// The bundle remembers the size and write time of each source file, so edited
+// XML is noticed and parsed instead of a stale bundle being used.
+// -----------------------------------------------------------------------------
+class DefinitionBundle
+{
+public:
+	static bool Cook(DefinitionSources const& sources, std::vector<unsigned char>& outBytes, std::vector<std::string>& outErrors);
+
+	bool LoadFile(std::string const& filePath, std::string& outError);
+	bool Open(std::vector<unsigned char>&& bytes, std::string& outError);
+	bool AreSourcesUnchanged() const;
+
+	void QueueNamedAssets(AssetLoader& loader) const;
+	void CreateDefinitions() const;
+	void CreateTileDefinitions(std::vector<TileDefinition*>& outDefinitions) const;
+	void CreateMapDefinitions(std::vector<MapDefinition*>& outDefinitions) const;
+	void CreateActorDefinitions(std::vector<ActorDefinition*>& outDefinitions) const;
+	void CreateWeaponDefinitions(std::vector<WeaponDefinition*>& outDefinitions) const;
+	void LinkDefinitions(std::vector<MapDefinition*>& mapDefs, std::vector<ActorDefinition*>& actorDefs, std::vector<WeaponDefinition*>& weaponDefs) const;
+
+	size_t GetNumBytes() const { return m_bytes.size(); }
+
+	static bool Command_CookDefinitions(EventArgs& args);
+	static bool Command_DefinitionBench(EventArgs& args);
+// -----------------------------------------------------------------------------
+private:
+	template <typename T>
+	T const* GetRecords(int sectionIndex, int& outNumRecords) const;
+	char const* GetString(unsigned int stringOffset) const;
+
+	std::vector<unsigned char> m_bytes;
+};
@@ -0,0 +1,222 @@
+#include "Game/FactionDefinition.hpp"
+#include "Game/GameCommon.h"
+#include "Game/ActorDefinition.hpp"
+#include "Game/BenchHelpers.hpp"
+#include "Engine/Core/DevConsole.hpp"
+#include "Engine/Core/EngineCommon.h"
+#include "Engine/Core/ErrorWarningAssert.hpp"
+#include "Engine/Core/Time.hpp"
+
+std::vector<FactionDefinition*> FactionDefinition::s_factionDefinitions;
+std::vector<FactionRelation> FactionDefinition::s_relations;
+int FactionDefinition::s_playerFactionId = -1;
+
+static FactionRelation ParseFactionRelation(XmlElement const& element, char const* attributeName, FactionRelation defaultRelation)
+{
+	std::string relationName = ParseXmlAttribute(element, attributeName, "");
+	if (relationName == "Hostile")
+	{
+		return FactionRelation::HOSTILE;
+	}
+	if (relationName == "Neutral")
+	{
+		return FactionRelation::NEUTRAL;
+	}
+	if (relationName == "Friendly")
+	{
+		return FactionRelation::FRIENDLY;
+	}
+	GUARANTEE_OR_DIE(relationName.empty(), Stringf("Unknown faction relation \"%s\", must be Hostile, Neutral or Friendly", relationName.c_str()));
+	return defaultRelation;
+}
+
+FactionDefinition::FactionDefinition(XmlElement const& factionDefElement, int factionId)
+	:m_id(factionId)
+{
+	m_name            = ParseXmlAttribute(factionDefElement, "name", m_name);
+	m_defaultRelation = ParseFactionRelation(factionDefElement, "defaultRelation", m_defaultRelation);
+}
+
+// -----------------------------------------------------------------------------
+// A pair with no FactionRelation element takes the friendlier of the two
+// factions' defaults, so a neutral faction is left alone by everyone.
+// Loaded before any actor definition, which looks its faction up by name.
+// -----------------------------------------------------------------------------
+void FactionDefinition::InitializeFactionDefs()
+{
+	XmlDocument factionDefsXml;
+	char const* filePath = "Data/Definitions/FactionDefinitions.xml";
+	XmlError result = factionDefsXml.LoadFile(filePath);
+	GUARANTEE_OR_DIE(result == tinyxml2::XML_SUCCESS, Stringf("Failed to open required faction definitions file \"%s\"", filePath));
+
+	XmlElement* rootElement = factionDefsXml.RootElement();
+	GUARANTEE_OR_DIE(rootElement, "RootElement not found!");
+
+	std::vector<XmlElement const*> relationElements;
+	XmlElement* factionDefElement = rootElement->FirstChildElement();
+	while (factionDefElement)
+	{
+		std::string elementName = factionDefElement->Name();
+		if (elementName == "FactionRelation")
+		{
+			relationElements.push_back(factionDefElement);
+		}
+		else
+		{
+			GUARANTEE_OR_DIE(elementName == "FactionDefinition", Stringf("Root child element in %s was <%s>, must be <FactionDefinition> or <FactionRelation>!", filePath, elementName.c_str()));
+			s_factionDefinitions.push_back(new FactionDefinition(*factionDefElement, static_cast<int>(s_factionDefinitions.size())));
+		}
+		factionDefElement = factionDefElement->NextSiblingElement();
+	}
+
+	int numFactions = static_cast<int>(s_factionDefinitions.size());
+	s_relations.assign(numFactions * numFactions, FactionRelation::HOSTILE);
+	for (int factionId = 0; factionId < numFactions; ++factionId)
+	{
+		for (int towardFactionId = 0; towardFactionId < numFactions; ++towardFactionId)
+		{
+			FactionRelation relation = FactionRelation::FRIENDLY;
+			if (factionId != towardFactionId)
+			{
+				FactionRelation defaultRelation = s_factionDefinitions[factionId]->m_defaultRelation;
+				FactionRelation towardDefaultRelation = s_factionDefinitions[towardFactionId]->m_defaultRelation;
+				relation = (defaultRelation > towardDefaultRelation) ? defaultRelation : towardDefaultRelation;
+			}
+			s_relations[(factionId * numFactions) + towardFactionId] = relation;
+		}
+	}
+
+	for (int relationIndex = 0; relationIndex < static_cast<int>(relationElements.size()); ++relationIndex)
+	{
+		XmlElement const& relationElement = *relationElements[relationIndex];
+		std::string factionName = ParseXmlAttribute(relationElement, "faction", "");
+		std::string towardName = ParseXmlAttribute(relationElement, "toward", "");
+		int factionId = GetIdByName(factionName);
+		int towardFactionId = GetIdByName(towardName);
+		GUARANTEE_OR_DIE(factionId >= 0 && towardFactionId >= 0, Stringf("FactionRelation in %s names an undeclared faction \"%s\" or \"%s\"", filePath, factionName.c_str(), towardName.c_str()));
+		s_relations[(factionId * numFactions) + towardFactionId] = ParseFactionRelation(relationElement, "relation", GetRelation(factionId, towardFactionId));
+	}
+
+	std::string playerFactionName = ParseXmlAttribute(*rootElement, "playerFaction", "");
+	s_playerFactionId = GetIdByName(playerFactionName);
+	GUARANTEE_OR_DIE(s_playerFactionId >= 0, Stringf("playerFaction \"%s\" in %s is not a declared faction", playerFactionName.c_str(), filePath));
+}
+
+void FactionDefinition::ClearDefinitions()
+{
+	for (int factionId = 0; factionId < static_cast<int>(s_factionDefinitions.size()); ++factionId)
+	{
+		delete s_factionDefinitions[factionId];
+	}
+	s_factionDefinitions.clear();
+	s_relations.clear();
+	s_playerFactionId = -1;
+}
+
+int FactionDefinition::GetIdByName(std::string const& name)
+{
+	for (int factionId = 0; factionId < static_cast<int>(s_factionDefinitions.size()); ++factionId)
+	{
+		if (s_factionDefinitions[factionId]->m_name == name)
+		{
+			return factionId;
+		}
+	}
+	return -1;
+}
+
+int FactionDefinition::GetNumFactions()
+{
+	return static_cast<int>(s_factionDefinitions.size());
+}
+
+int FactionDefinition::GetPlayerFactionId()
+{
+	return s_playerFactionId;
+}
+
+// -----------------------------------------------------------------------------
+// The checks the relationship table replaced, kept so the bench can time them
+// -----------------------------------------------------------------------------
+static bool WereFactionNamesHostile(ActorDefinition const& actorDef, ActorDefinition const& towardActorDef)
+{
+	if (actorDef.m_faction == towardActorDef.m_faction)
+	{
+		return false;
+	}
+	return actorDef.m_faction != "NEUTRAL" && towardActorDef.m_faction != "NEUTRAL";
+}
+
+static bool WereFactionNamesDifferent(ActorDefinition const& actorDef, ActorDefinition const& towardActorDef)
+{
+	return actorDef.m_faction != towardActorDef.m_faction;
+}
+
+// -----------------------------------------------------------------------------
+// Dev console: FactionBench pairs=<count>
+// Times the per-pair faction check used by perception (is it hostile) and by
+// collision damage (is it not friendly), comparing faction names against the
+// relationship table, over random pairs of actor definitions.
+// -----------------------------------------------------------------------------
+bool FactionDefinition::Command_FactionBench(EventArgs& args)
+{
+	int numPairs = args.GetValue("pairs", 1000000);
+	numPairs = (numPairs < 1) ? 1 : numPairs;
+	int numActorDefs = static_cast<int>(ActorDefinition::s_actorDefinitions.size());
+	if (numActorDefs == 0)
+	{
+		g_theDevConsole->AddLine(Rgba8::RED, "FactionBench needs actor definitions loaded");
+		return false;
+	}
+
+	std::vector<ActorDefinition const*> actorDefsA(numPairs);
+	std::vector<ActorDefinition const*> actorDefsB(numPairs);
+	for (int pairIndex = 0; pairIndex < numPairs; ++pairIndex)
+	{
+		actorDefsA[pairIndex] = ActorDefinition::s_actorDefinitions[GetBenchRng().RollRandomIntInRange(0, numActorDefs - 1)];
+		actorDefsB[pairIndex] = ActorDefinition::s_actorDefinitions[GetBenchRng().RollRandomIntInRange(0, numActorDefs - 1)];
+	}
+
+	int numNameHostile = 0;
+	double nameHostileStart = GetCurrentTimeSeconds();
+	for (int pairIndex = 0; pairIndex < numPairs; ++pairIndex)
+	{
+		numNameHostile += WereFactionNamesHostile(*actorDefsA[pairIndex], *actorDefsB[pairIndex]) ? 1 : 0;
+	}
+	double nameHostileSeconds = GetCurrentTimeSeconds() - nameHostileStart;
+
+	int numTableHostile = 0;
+	double tableHostileStart = GetCurrentTimeSeconds();
+	for (int pairIndex = 0; pairIndex < numPairs; ++pairIndex)
+	{
+		numTableHostile += IsHostile(actorDefsA[pairIndex]->m_factionId, actorDefsB[pairIndex]->m_factionId) ? 1 : 0;
+	}
+	double tableHostileSeconds = GetCurrentTimeSeconds() - tableHostileStart;
+
+	int numNameDifferent = 0;
+	double nameDifferentStart = GetCurrentTimeSeconds();
+	for (int pairIndex = 0; pairIndex < numPairs; ++pairIndex)
+	{
+		numNameDifferent += WereFactionNamesDifferent(*actorDefsA[pairIndex], *actorDefsB[pairIndex]) ? 1 : 0;
+	}
+	double nameDifferentSeconds = GetCurrentTimeSeconds() - nameDifferentStart;
+
+	int numTableUnfriendly = 0;
+	double tableUnfriendlyStart = GetCurrentTimeSeconds();
+	for (int pairIndex = 0; pairIndex < numPairs; ++pairIndex)
+	{
+		numTableUnfriendly += IsFriendly(actorDefsA[pairIndex]->m_factionId, actorDefsB[pairIndex]->m_factionId) ? 0 : 1;
+	}
+	double tableUnfriendlySeconds = GetCurrentTimeSeconds() - tableUnfriendlyStart;
+
+	double nanosecondsPerPair = 1000000000.0 / static_cast<double>(numPairs);
+	g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, Stringf("Perception check: names %.2f ns, table %.2f ns per pair (%d and %d hostile)",
+		nameHostileSeconds * nanosecondsPerPair, tableHostileSeconds * nanosecondsPerPair, numNameHostile, numTableHostile));
+	g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, Stringf("Collision check: names %.2f ns, table %.2f ns per pair (%d and %d unfriendly)",
+		nameDifferentSeconds * nanosecondsPerPair, tableUnfriendlySeconds * nanosecondsPerPair, numNameDifferent, numTableUnfriendly));
+	if (numNameHostile != numTableHostile || numNameDifferent != numTableUnfriendly)
+	{
+		g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, "Counts differ because FactionDefinitions.xml no longer matches the old name rules");
+	}
+	return true;
+}
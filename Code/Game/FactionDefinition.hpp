@@ -0,0 +1,56 @@
+#pragma once
+#include "Engine/Core/EventSystem.hpp"
+#include "Engine/Core/XmlUtils.hpp"
+#include <string>
+#include <vector>
+// -----------------------------------------------------------------------------
+enum class FactionRelation : unsigned char
+{
+	HOSTILE,
+	NEUTRAL,
+	FRIENDLY,
+	COUNT
+};
+// -----------------------------------------------------------------------------
+// Factions are declared in data and referred to by their index, so deciding
+// how two actors treat each other is one load from an NxN table instead of
+// comparing faction names.
+// -----------------------------------------------------------------------------
+struct FactionDefinition
+{
+	FactionDefinition(XmlElement const& factionDefElement, int factionId);
+	static std::vector<FactionDefinition*> s_factionDefinitions;
+	static void InitializeFactionDefs();
+	static void ClearDefinitions();
+
+	static int GetIdByName(std::string const& name);
+	static FactionRelation GetRelation(int factionId, int towardFactionId);
+	static bool IsHostile(int factionId, int towardFactionId);
+	static bool IsFriendly(int factionId, int towardFactionId);
+	static int  GetNumFactions();
+	static int  GetPlayerFactionId();
+
+	static bool Command_FactionBench(EventArgs& args);
+// -----------------------------------------------------------------------------
+	std::string     m_name;
+	int             m_id = -1;
+	FactionRelation m_defaultRelation = FactionRelation::HOSTILE;	// Toward other factions, own faction is friendly
+
+	static std::vector<FactionRelation> s_relations;	// Row is the faction, column who it is looking at
+	static int s_playerFactionId;
+};
+// -----------------------------------------------------------------------------
+inline FactionRelation FactionDefinition::GetRelation(int factionId, int towardFactionId)
+{
+	return s_relations[(factionId * static_cast<int>(s_factionDefinitions.size())) + towardFactionId];
+}
+
+inline bool FactionDefinition::IsHostile(int factionId, int towardFactionId)
+{
+	return GetRelation(factionId, towardFactionId) == FactionRelation::HOSTILE;
+}
+
+inline bool FactionDefinition::IsFriendly(int factionId, int towardFactionId)
+{
+	return GetRelation(factionId, towardFactionId) == FactionRelation::FRIENDLY;
+}
@@ -0,0 +1,261 @@
+#include "Game/FactionRoster.hpp"
+#include "Game/GameCommon.h"
+#include "Game/Actor.hpp"
+#include "Game/ActorDefinition.hpp"
+#include "Game/ActorHandle.hpp"
+#include "Game/BenchHelpers.hpp"
+#include "Game/FactionDefinition.hpp"
+#include "Game/Game.h"
+#include "Game/Map.hpp"
+#include "Engine/Core/DevConsole.hpp"
+#include "Engine/Core/EngineCommon.h"
+#include "Engine/Core/Time.hpp"
+
+void FactionRoster::Initialize(ActorList const& actors)
+{
+	m_actors = &actors;
+	Clear();
+}
+
+void FactionRoster::Clear()
+{
+	m_factions.resize(FactionDefinition::GetNumFactions());
+	for (int factionIndex = 0; factionIndex < static_cast<int>(m_factions.size()); ++factionIndex)
+	{
+		m_factions[factionIndex].m_actorIndexes.clear();
+		m_factions[factionIndex].m_numAlive = 0;
+	}
+}
+
+// For when actors were created or killed without going through the roster, like a save being restored
+void FactionRoster::Rebuild()
+{
+	Clear();
+	ActorList const& actors = *m_actors;
+	for (int actorIndex = 0; actorIndex < static_cast<int>(actors.size()); ++actorIndex)
+	{
+		if (actors[actorIndex] != nullptr)
+		{
+			AddActor(*actors[actorIndex]);
+		}
+	}
+}
+
+void FactionRoster::AddActor(Actor& actor)
+{
+	FactionActors& faction = m_factions[actor.m_actorDef->m_factionId];
+	actor.m_factionSlot = static_cast<int>(faction.m_actorIndexes.size());
+	faction.m_actorIndexes.push_back(static_cast<int>(actor.m_actorHandle.GetIndex()));
+	faction.m_numAlive += actor.m_isDead ? 0 : 1;
+}
+
+// The last actor in the faction moves into the freed slot
+void FactionRoster::RemoveActor(Actor& actor)
+{
+	if (actor.m_factionSlot < 0)
+	{
+		return;
+	}
+
+	FactionActors& faction = m_factions[actor.m_actorDef->m_factionId];
+	int lastActorIndex = faction.m_actorIndexes.back();
+	faction.m_actorIndexes[actor.m_factionSlot] = lastActorIndex;
+	(*m_actors)[lastActorIndex]->m_factionSlot = actor.m_factionSlot;
+	faction.m_actorIndexes.pop_back();
+	faction.m_numAlive -= actor.m_isDead ? 0 : 1;
+
+	actor.m_factionSlot = -1;
+}
+
+void FactionRoster::OnActorDied(Actor& actor)
+{
+	if (actor.m_factionSlot >= 0)
+	{
+		m_factions[actor.m_actorDef->m_factionId].m_numAlive -= 1;
+	}
+}
+
+int FactionRoster::GetNumFactions() const
+{
+	return static_cast<int>(m_factions.size());
+}
+
+FactionActors const& FactionRoster::GetFaction(int factionId) const
+{
+	return m_factions[factionId];
+}
+
+int FactionRoster::GetNumAliveHostileTo(int factionId) const
+{
+	int numAlive = 0;
+	for (int otherFactionId = 0; otherFactionId < static_cast<int>(m_factions.size()); ++otherFactionId)
+	{
+		if (FactionDefinition::IsHostile(factionId, otherFactionId))
+		{
+			numAlive += m_factions[otherFactionId].m_numAlive;
+		}
+	}
+	return numAlive;
+}
+
+// Dead actors count too, until they are destroyed
+int FactionRoster::GetNumHostileActors(int factionId) const
+{
+	int numHostileActors = 0;
+	for (int otherFactionId = 0; otherFactionId < static_cast<int>(m_factions.size()); ++otherFactionId)
+	{
+		if (FactionDefinition::IsHostile(factionId, otherFactionId))
+		{
+			numHostileActors += static_cast<int>(m_factions[otherFactionId].m_actorIndexes.size());
+		}
+	}
+	return numHostileActors;
+}
+
+// -----------------------------------------------------------------------------
+// Recounts every faction from the actor list and checks each listed actor
+// points back at its own slot. Returns the number of disagreements.
+// -----------------------------------------------------------------------------
+static int CountRosterMismatches(Map const& map, FactionRoster const& roster)
+{
+	std::vector<int> numActors(roster.GetNumFactions(), 0);
+	std::vector<int> numAlive(roster.GetNumFactions(), 0);
+	int numMismatches = 0;
+	for (int actorIndex = 0; actorIndex < static_cast<int>(map.m_allActors.size()); ++actorIndex)
+	{
+		Actor const* actor = map.m_allActors[actorIndex];
+		if (actor == nullptr)
+		{
+			continue;
+		}
+
+		int factionIndex = actor->m_actorDef->m_factionId;
+		if (actor->m_factionSlot < 0)
+		{
+			++numMismatches;
+			continue;
+		}
+		numActors[factionIndex] += 1;
+		numAlive[factionIndex] += actor->m_isDead ? 0 : 1;
+	}
+
+	for (int factionIndex = 0; factionIndex < roster.GetNumFactions(); ++factionIndex)
+	{
+		FactionActors const& faction = roster.GetFaction(factionIndex);
+		numMismatches += (numActors[factionIndex] != static_cast<int>(faction.m_actorIndexes.size())) ? 1 : 0;
+		numMismatches += (numAlive[factionIndex] != faction.m_numAlive) ? 1 : 0;
+		for (int slot = 0; slot < static_cast<int>(faction.m_actorIndexes.size()); ++slot)
+		{
+			Actor const* actor = map.m_allActors[faction.m_actorIndexes[slot]];
+			if (actor == nullptr || actor->m_actorDef->m_factionId != factionIndex || actor->m_factionSlot != slot)
+			{
+				++numMismatches;
+			}
+		}
+	}
+	return numMismatches;
+}
+
+// -----------------------------------------------------------------------------
+// Dev console: FactionCountTest steps=<count>
+// Randomly spawns, kills and destroys actors on the running map, checking the
+// roster against a full recount after every step, then times a faction count
+// against the scan it replaced.
+// -----------------------------------------------------------------------------
+bool FactionRoster::Command_FactionCountTest(EventArgs& args)
+{
+	Map* map = g_theGame->m_defaultMap;
+	if (g_theGame->m_currentState != GameState::PLAYING || map == nullptr)
+	{
+		g_theDevConsole->AddLine(Rgba8::RED, "FactionCountTest needs a game in progress");
+		return false;
+	}
+
+	int numSteps = args.GetValue("steps", 5000);
+	numSteps = (numSteps < 1) ? 1 : numSteps;
+	int maxActors = static_cast<int>(ActorHandle::MAX_ACTOR_INDEX) - static_cast<int>(map->m_allActors.size());
+
+	std::vector<IntVec2> openTiles;
+	if (!GatherOpenTiles(*map, "FactionCountTest", openTiles))
+	{
+		return false;
+	}
+
+	int numFailedSteps = 0;
+	std::vector<ActorHandle> benchActors;
+	for (int stepIndex = 0; stepIndex < numSteps; ++stepIndex)
+	{
+		int action = benchActors.empty() ? 0 : GetBenchRng().RollRandomIntInRange(0, 2);
+		if (action == 0 && static_cast<int>(benchActors.size()) < maxActors)
+		{
+			IntVec2 tileCoords = RollOpenTile(openTiles);
+
+			int definitionIndex = GetBenchRng().RollRandomIntInRange(0, static_cast<int>(ActorDefinition::s_actorDefinitions.size()) - 1);
+			SpawnInfo spawnInfo;
+			spawnInfo.m_actorDef = ActorDefinition::s_actorDefinitions[definitionIndex];
+			spawnInfo.m_position = Vec3(static_cast<float>(tileCoords.x) + 0.5f, static_cast<float>(tileCoords.y) + 0.5f, 0.f);
+			benchActors.push_back(map->SpawnActor(spawnInfo)->m_actorHandle);
+		}
+		else if (!benchActors.empty())
+		{
+			int benchIndex = GetBenchRng().RollRandomIntInRange(0, static_cast<int>(benchActors.size()) - 1);
+			Actor* actor = map->GetActorByHandle(benchActors[benchIndex]);
+			if (action == 1 && actor != nullptr)
+			{
+				actor->Die();
+			}
+			else
+			{
+				if (actor != nullptr)
+				{
+					actor->Destroy();
+				}
+				benchActors[benchIndex] = benchActors.back();
+				benchActors.pop_back();
+				map->DeleteDestroyedActors();
+			}
+		}
+		numFailedSteps += (CountRosterMismatches(*map, map->m_factionRoster) > 0) ? 1 : 0;
+	}
+
+	// Time the victory check both ways while the map is still full
+	int numTimingRuns = 1000;
+	int numAliveFound = 0;
+	double scanStart = GetCurrentTimeSeconds();
+	for (int runIndex = 0; runIndex < numTimingRuns; ++runIndex)
+	{
+		for (int actorIndex = 0; actorIndex < static_cast<int>(map->m_allActors.size()); ++actorIndex)
+		{
+			Actor const* actor = map->m_allActors[actorIndex];
+			numAliveFound += (actor != nullptr && !actor->IsDead() && actor->IsEnemy()) ? 1 : 0;
+		}
+	}
+	double scanSeconds = GetCurrentTimeSeconds() - scanStart;
+
+	double rosterStart = GetCurrentTimeSeconds();
+	for (int runIndex = 0; runIndex < numTimingRuns; ++runIndex)
+	{
+		numAliveFound += map->m_factionRoster.GetNumAliveHostileTo(FactionDefinition::GetPlayerFactionId());
+	}
+	double rosterSeconds = GetCurrentTimeSeconds() - rosterStart;
+
+	int numActorsAtEnd = static_cast<int>(benchActors.size());
+	for (int benchIndex = 0; benchIndex < static_cast<int>(benchActors.size()); ++benchIndex)
+	{
+		Actor* actor = map->GetActorByHandle(benchActors[benchIndex]);
+		if (actor != nullptr)
+		{
+			actor->Destroy();
+		}
+	}
+	map->DeleteDestroyedActors();
+	map->m_actorGrid.Build(0.f);
+	int numMismatchesAfterCleanup = CountRosterMismatches(*map, map->m_factionRoster);
+
+	Rgba8 resultColor = (numFailedSteps == 0 && numMismatchesAfterCleanup == 0) ? Rgba8::LIGHTYELLOW : Rgba8::RED;
+	g_theDevConsole->AddLine(resultColor, Stringf("Faction counts: %d steps, %d disagreed with a recount, %d after cleanup, %d bench actors left at the end",
+		numSteps, numFailedSteps, numMismatchesAfterCleanup, numActorsAtEnd));
+	g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, Stringf("Enemies alive check: scan %.3f us, roster %.3f us (%d found)",
+		scanSeconds * 1000000.0 / numTimingRuns, rosterSeconds * 1000000.0 / numTimingRuns, numAliveFound));
+	return true;
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include "Engine/Core/EventSystem.hpp"
+#include <vector>
+// -----------------------------------------------------------------------------
+class Actor;
+typedef std::vector<Actor*> ActorList;
+// -----------------------------------------------------------------------------
+struct FactionActors
+{
+	std::vector<int> m_actorIndexes;	// Into the map's actor list, in no particular order
+	int              m_numAlive = 0;
+};
+// -----------------------------------------------------------------------------
+// Every actor on the map grouped by faction id, kept current on spawn, death
+// and destroy. Counting the living members of a faction is a lookup instead of
+// a scan, and code hunting for enemies can walk only the hostile factions.
+// -----------------------------------------------------------------------------
+class FactionRoster
+{
+public:
+	FactionRoster() = default;
+
+	void Initialize(ActorList const& actors);
+	void Clear();
+	void Rebuild();
+	void AddActor(Actor& actor);
+	void RemoveActor(Actor& actor);
+	void OnActorDied(Actor& actor);
+
+	int  GetNumFactions() const;
+	FactionActors const& GetFaction(int factionId) const;
+	int  GetNumAliveHostileTo(int factionId) const;
+	int  GetNumHostileActors(int factionId) const;
+
+	static bool Command_FactionCountTest(EventArgs& args);
+// -----------------------------------------------------------------------------
+private:
+	ActorList const* m_actors = nullptr;
+	std::vector<FactionActors> m_factions;	// By FactionDefinition id
+};
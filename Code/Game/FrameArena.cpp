@@ -0,0 +1,36 @@
+#include "Game/FrameArena.hpp"
+
+void FrameArena::BeginFrame()
+{
+	m_numVertArraysInUse = 0;
+	m_numVertTBNArraysInUse = 0;
+}
+
+std::vector<Vertex_PCU>& FrameArena::AllocateVerts()
+{
+	if (m_numVertArraysInUse == static_cast<int>(m_vertArrays.size()))
+	{
+		m_vertArrays.emplace_back();
+	}
+	std::vector<Vertex_PCU>& verts = m_vertArrays[m_numVertArraysInUse];
+	m_numVertArraysInUse += 1;
+	verts.clear();
+	return verts;
+}
+
+std::vector<Vertex_PCUTBN>& FrameArena::AllocateVertsTBN()
+{
+	if (m_numVertTBNArraysInUse == static_cast<int>(m_vertTBNArrays.size()))
+	{
+		m_vertTBNArrays.emplace_back();
+	}
+	std::vector<Vertex_PCUTBN>& verts = m_vertTBNArrays[m_numVertTBNArraysInUse];
+	m_numVertTBNArraysInUse += 1;
+	verts.clear();
+	return verts;
+}
+
+int FrameArena::GetNumArraysInPool() const
+{
+	return static_cast<int>(m_vertArrays.size() + m_vertTBNArrays.size());
+}
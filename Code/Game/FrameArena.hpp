@@ -0,0 +1,29 @@
+#pragma once
+#include "Engine/Core/Vertex_PCU.h"
+#include "Engine/Core/Vertex_PCUTBN.hpp"
+#include <deque>
+#include <vector>
+// -----------------------------------------------------------------------------
+// Linear per-frame pool of vertex arrays for transient render geometry.
+// Arrays are handed out in order and all released together in BeginFrame.
+// Released arrays keep their capacity, so once the pool has warmed up a
+// rendered frame does not touch the heap for its vertexes.
+// -----------------------------------------------------------------------------
+class FrameArena
+{
+public:
+	FrameArena() = default;
+
+	void BeginFrame();
+	std::vector<Vertex_PCU>&    AllocateVerts();
+	std::vector<Vertex_PCUTBN>& AllocateVertsTBN();
+
+	int GetNumArraysInPool() const;
+// -----------------------------------------------------------------------------
+private:
+	// Deques keep handed out references valid while the pool grows
+	std::deque<std::vector<Vertex_PCU>>    m_vertArrays;
+	std::deque<std::vector<Vertex_PCUTBN>> m_vertTBNArrays;
+	int m_numVertArraysInUse = 0;
+	int m_numVertTBNArraysInUse = 0;
+};
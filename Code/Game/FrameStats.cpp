@@ -0,0 +1,106 @@
+#include "Game/FrameStats.hpp"
+#include "Game/GameCommon.h"
+#include "Game/FrameArena.hpp"
+#include "Engine/Core/DevConsole.hpp"
+#include "Engine/Core/EngineCommon.h"
+#include "Engine/Renderer/Renderer.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+static std::atomic<int> s_drawCalls(0);
+static std::atomic<int> s_heapAllocations(0);
+static int s_heapAllocationsAtRenderStart = 0;
+static int s_renderHeapAllocations = 0;
+static double s_hudSeconds = 0.0;
+static int s_overflowingLightChunks = 0;
+static int s_droppedPointLights = 0;
+static FrameStats s_lastFrame;
+
+void FrameStats::BeginFrame()
+{
+	s_lastFrame.m_drawCalls = s_drawCalls.exchange(0);
+	s_lastFrame.m_heapAllocations = s_heapAllocations.exchange(0);
+	s_lastFrame.m_renderHeapAllocations = s_renderHeapAllocations;
+	s_renderHeapAllocations = 0;
+	s_lastFrame.m_hudSeconds = s_hudSeconds;
+	s_hudSeconds = 0.0;
+	s_lastFrame.m_overflowingLightChunks = s_overflowingLightChunks;
+	s_overflowingLightChunks = 0;
+	s_lastFrame.m_droppedPointLights = s_droppedPointLights;
+	s_droppedPointLights = 0;
+}
+
+void FrameStats::AddDrawCall()
+{
+	++s_drawCalls;
+}
+
+void FrameStats::AddHeapAllocation()
+{
+	++s_heapAllocations;
+}
+
+void FrameStats::BeginRender()
+{
+	s_heapAllocationsAtRenderStart = s_heapAllocations;
+}
+
+void FrameStats::EndRender()
+{
+	s_renderHeapAllocations = s_heapAllocations - s_heapAllocationsAtRenderStart;
+}
+
+void FrameStats::AddHudSeconds(double seconds)
+{
+	s_hudSeconds += seconds;
+}
+
+void FrameStats::AddOverflowingLightChunk(int numDroppedLights)
+{
+	++s_overflowingLightChunks;
+	s_droppedPointLights += numDroppedLights;
+}
+
+FrameStats const& FrameStats::GetLastFrame()
+{
+	return s_lastFrame;
+}
+
+// -----------------------------------------------------------------------------
+// Dev console: FrameStats
+// Prints the draw calls and heap allocations of the last completed frame, how
+// many of those allocations happened while rendering, and how many chunk draws
+// dropped point lights past MAX_POINTLIGHTS.
+// -----------------------------------------------------------------------------
+bool FrameStats::Command_FrameStats(EventArgs& args)
+{
+	UNUSED(args);
+	g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, Stringf("Last frame: %d draw calls, %d heap allocations (%d while rendering)",
+		s_lastFrame.m_drawCalls, s_lastFrame.m_heapAllocations, s_lastFrame.m_renderHeapAllocations));
+	g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, Stringf("HUD: %.3f ms across all players", s_lastFrame.m_hudSeconds * 1000.0));
+	g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, Stringf("Frame arena: %d vertex arrays pooled", g_frameArena->GetNumArraysInPool()));
+	Rgba8 lightColor = (s_lastFrame.m_overflowingLightChunks > 0) ? Rgba8::RED : Rgba8::LIGHTYELLOW;
+	g_theDevConsole->AddLine(lightColor, Stringf("Light grid: %d chunk draws over %d point lights, %d lights dropped",
+		s_lastFrame.m_overflowingLightChunks, MAX_POINTLIGHTS, s_lastFrame.m_droppedPointLights));
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Global allocation hooks, so every new in the game and engine is counted
+// -----------------------------------------------------------------------------
+void* operator new(size_t size)
+{
+	FrameStats::AddHeapAllocation();
+	void* memory = malloc(size > 0 ? size : 1);
+	if (memory == nullptr)
+	{
+		throw std::bad_alloc();
+	}
+	return memory;
+}
+
+void operator delete(void* memory) noexcept
+{
+	free(memory);
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include "Engine/Core/EventSystem.hpp"
+// -----------------------------------------------------------------------------
+// Per-frame counters for the game's own draw calls, heap allocations and map
+// chunks whose light grid cell held more point lights than a draw can take.
+// Counting restarts in App::BeginFrame; the previous frame's totals stay
+// readable from the dev console through the FrameStats command.
+// -----------------------------------------------------------------------------
+struct FrameStats
+{
+	int m_drawCalls = 0;
+	int m_heapAllocations = 0;
+	int m_renderHeapAllocations = 0;
+	double m_hudSeconds = 0.0;
+	int m_overflowingLightChunks = 0;
+	int m_droppedPointLights = 0;
+// -----------------------------------------------------------------------------
+	static void BeginFrame();
+	static void AddDrawCall();
+	static void AddHeapAllocation();
+	static void BeginRender();
+	static void EndRender();
+	static void AddHudSeconds(double seconds);
+	static void AddOverflowingLightChunk(int numDroppedLights);
+	static FrameStats const& GetLastFrame();
+
+	static bool Command_FrameStats(EventArgs& args);
+};
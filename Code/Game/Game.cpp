@@ -6,6 +6,14 @@
 #include "Game/MapDefinition.hpp"
 #include "Game/WeaponDefinition.hpp"
 #include "Game/ActorDefinition.hpp"
+#include "Game/FactionDefinition.hpp"
+#include "Game/FrameArena.hpp"
+#include "Game/FrameStats.hpp"
+#include "Game/ReplaySystem.hpp"
+#include "Game/NetSession.hpp"
+#include "Game/MapSaveState.hpp"
+#include "Game/AssetLoader.hpp"
+#include "Game/DefinitionBundle.hpp"
 
 #include "Engine/Input/InputSystem.h"
 #include "Engine/Renderer/Renderer.h"
@@ -20,6 +28,14 @@
 #include "Engine/Math/MathUtils.h"
 #include "Engine/Math/AABB3.hpp"
 
+// Definitions parsed from XML name each other, and are linked once every file is loaded
+static void ResolveDefinitionReferences()
+{
+	MapDefinition::ResolveReferences();
+	ActorDefinition::ResolveReferences();
+	WeaponDefinition::ResolveReferences();
+}
+
 Game::Game(App* owner)
 	: m_app(owner)
 {
@@ -28,6 +44,11 @@ Game::Game(App* owner)
 	m_gameMusicPath = g_gameConfigBlackboard.GetValue("gameMusic", "default");
 	m_clickSoundPath = g_gameConfigBlackboard.GetValue("buttonClickSound", "default");
 	m_musicVolume = g_gameConfigBlackboard.GetValue("musicVolume", 0.f);
+	float simulationHz = g_gameConfigBlackboard.GetValue("simulationHz", 0.f);
+	m_fixedTickSeconds = (simulationHz > 0.f) ? 1.f / simulationHz : 0.f;
+	m_isMapCacheEnabled = g_gameConfigBlackboard.GetValue("cacheMaps", true);
+	m_isAsyncLoadingEnabled = g_gameConfigBlackboard.GetValue("asyncLoading", true);
+	m_loadingBudgetSeconds = static_cast<double>(g_gameConfigBlackboard.GetValue("loadingBudgetMs", 8.f)) * 0.001;
 
 	m_mainMenuMusic = g_theAudio->CreateOrGetSound(m_mainMenuMusicPath);
 	m_gameMusic = g_theAudio->CreateOrGetSound(m_gameMusicPath);
@@ -65,19 +86,119 @@ void Game::StartUp()
 	g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, "F6/F7 - Decrease/Increase sun intensity.");
 	g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, "F8/F9 - Decrease/Increase ambient intensity.");
 	g_theDevConsole->AddLine(Rgba8::SEAWEED, "----------------------------------------------------------------------");
-
-	// Loading XML elements
-	TileDefinition::InitializeTileDefs();
-	MapDefinition::InitializeMapDefs();
-	ActorDefinition::InitializeProjectileActorDefs();
-	WeaponDefinition::InitializeWeaponsDefs();
-	ActorDefinition::InitializeActorDefs();
+	g_theDevConsole->AddLine(Rgba8::CYAN, "DEBUG COMMANDS:");
+	g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, "LightGridTest lights=<count> - Validates and times light grid builds.");
+	g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, "FrameStats - Prints draw calls, heap allocations and light grid overflow of the last frame.");
+	g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, "HudCache enabled=<bool> - Toggles the retained HUD geometry.");
+	g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, "ReplayRecord file=<path> seed=<int> hashInterval=<ticks> - Restarts the map and records it.");
+	g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, "ReplayStop - Stops recording and writes the replay.");
+	g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, "ReplayRun file=<path> - Replays a recording headlessly and checks determinism.");
+	g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, "PlayerBots enabled=<bool> - Lets bots drive every player.");
+	g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, "BotSoak ticks=<count> - Runs bot-driven ticks headlessly and times them.");
+	g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, "NetLoopback clients=<count> relevancy=<bool> - Streams map snapshots to loopback clients.");
+	g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, "NetSnapshotBench players=<count> demons=<count> ticks=<count> - Times snapshot encoding.");
+	g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, "NetRelevancyBench clients=<count> seconds=<seconds> spawnMs=<milliseconds> - Compares bytes with and without relevancy.");
+	g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, "MapSave file=<path> - Checkpoints the running map, written in the background.");
+	g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, "MapLoad file=<path> - Restores the running map from a checkpoint.");
+	g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, "MapSaveTest - Checks that a map save round trips exactly.");
+	g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, "MapSaveBench actors=<count> iterations=<count> - Times map save and restore.");
+	g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, "AssetReport - Prints resident image and texture memory.");
+	g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, "CookDefinitions file=<path> - Validates the definition XML and cooks it into a bundle.");
+	g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, "DefinitionBench actors=<count> - Times loading definitions from XML and from a bundle.");
+	g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, "ShaderReport - Prints shader compiles and sharing, and bytecode cache hits, misses and time saved when the cache is on.");
+	g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, "ShaderCacheTest compileMs=<milliseconds> - Checks the compiled shader cache with a stub compiler.");
+	g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, "ActorQueryBench actors=<count> queries=<count> - Times disc, sector and nearest actor queries.");
+	g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, "FactionCountTest steps=<count> - Checks faction counts against a recount through random spawns and kills.");
+	g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, "FactionBench pairs=<count> - Times faction checks by name against the relationship table.");
+	g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, "VisibilityBench demons=<count> maps=<count> - Times player visibility fields against per-demon raycasts.");
+	g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, "AILod - Shows how many agents were in each AI level of detail tier last tick and their think time.");
+	g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, "AILodBench agents=<count> ticks=<count> - Times map ticks with AI level of detail off and on as the crowd grows.");
+	g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, "TimerWheelBench corpses=<count> spawners=<count> ticks=<count> - Times map ticks with corpses and spawners woken by the timer wheel.");
+	g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, "AnimationClockBench actors=<count> frames=<count> - Compares ticking per-actor clocks with reading animation timestamps.");
+	g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, "SpawnStressTest count=<count> - Spawns and destroys the count in one tick through the deferred spawn queue.");
+	g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, "PhysicsBench actors=<count> steps=<count> - Times scalar and SIMD actor physics integration.");
+	g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, "CrowdBench actors=<count> density=<per tile> iterations=<count> threads=<count> - Times the crowd separation solver on a packed Imp horde.");
+	g_theDevConsole->AddLine(Rgba8::SEAWEED, "----------------------------------------------------------------------");
 
 	m_gameClock = new Clock(Clock::GetSystemClock());
-	m_gameOverTexture = g_theRenderer->CreateOrGetTextureFromFile("Data/Images/gameover.png");
-	m_victoryTexture = g_theRenderer->CreateOrGetTextureFromFile("Data/Images/VictoryScreen.png");
-
 	m_font = g_theRenderer->CreateOrGetBitmapFont("Data/Fonts/SquirrelFixedFont");
+
+	// Actor definitions look their faction up by name, so factions always load first and from XML
+	FactionDefinition::InitializeFactionDefs();
+
+	// A cooked bundle skips XML parsing, anything wrong with it falls back to the XML files
+	DefinitionBundle* bundle = new DefinitionBundle();
+	std::string bundleError;
+	if (!bundle->LoadFile(g_gameConfigBlackboard.GetValue("definitionBundle", ""), bundleError))
+	{
+		g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, Stringf("Loading definitions from XML, %s", bundleError.c_str()));
+		delete bundle;
+		bundle = nullptr;
+	}
+
+	if (!m_isAsyncLoadingEnabled)
+	{
+		if (bundle)
+		{
+			bundle->CreateDefinitions();
+			delete bundle;
+		}
+		else
+		{
+			// Loading XML elements
+			TileDefinition::InitializeTileDefs();
+			MapDefinition::InitializeMapDefs();
+			ActorDefinition::InitializeProjectileActorDefs();
+			WeaponDefinition::InitializeWeaponsDefs();
+			ActorDefinition::InitializeActorDefs();
+			ResolveDefinitionReferences();
+		}
+		FinishStartUp();
+		return;
+	}
+
+	if (bundle)
+	{
+		bundle->QueueNamedAssets(*g_assetLoader);
+		g_assetLoader->QueueMainThreadStep([bundle]()
+		{
+			bundle->CreateDefinitions();
+			delete bundle;
+			return true;
+		});
+	}
+	else
+	{
+		// Same order as the synchronous path
+		g_assetLoader->QueueDefinitionFile("Data/Definitions/TileDefinitions.xml", "TileDefinition", TileDefinition::s_definitions);
+		g_assetLoader->QueueDefinitionFile("Data/Definitions/MapDefinitions.xml", "MapDefinition", MapDefinition::s_mapDefinitions, false);
+		g_assetLoader->QueueDefinitionFile("Data/Definitions/ProjectileActorDefinitions.xml", "ActorDefinition", ActorDefinition::s_actorDefinitions);
+		g_assetLoader->QueueDefinitionFile("Data/Definitions/WeaponDefinitions.xml", "WeaponDefinition", WeaponDefinition::s_weaponDefinitions);
+		g_assetLoader->QueueDefinitionFile("Data/Definitions/ActorDefinitions.xml", "ActorDefinition", ActorDefinition::s_actorDefinitions);
+		g_assetLoader->QueueMainThreadStep([]()
+		{
+			ResolveDefinitionReferences();
+			return true;
+		});
+	}
+	g_assetLoader->QueueImageFile("Data/Images/gameover.png");
+	g_assetLoader->QueueImageFile("Data/Images/VictoryScreen.png");
+	Map::QueueSkyBoxImages();
+	g_assetLoader->QueueMainThreadStep([this]()
+	{
+		FinishStartUp();
+		return true;
+	});
+
+	m_enterLoadingSeconds = GetCurrentTimeSeconds();
+	EnterState(GameState::LOADING);
+}
+
+void Game::FinishStartUp()
+{
+	m_gameOverTexture = g_assetLoader->CreateOrGetTexture("Data/Images/gameover.png");
+	m_victoryTexture = g_assetLoader->CreateOrGetTexture("Data/Images/VictoryScreen.png");
+
 	m_font->AddVertsForTextInBox2D(m_fontVerts, "Press SPACE to join with mouse and keyboard", AABB2(Vec2::ZERO, Vec2(SCREEN_SIZE_X, SCREEN_SIZE_Y)), 20.f, Rgba8::WHITE, 1.f, Vec2(0.5f, 0.2f));
 	m_font->AddVertsForTextInBox2D(m_fontVerts, "Press START to join with controller", AABB2(Vec2::ZERO, Vec2(SCREEN_SIZE_X, SCREEN_SIZE_Y)), 20.f, Rgba8::WHITE, 1.f, Vec2(0.5f, 0.15f));
 	m_font->AddVertsForTextInBox2D(m_fontVerts, "Press ESC or BACK to exit", AABB2(Vec2::ZERO, Vec2(SCREEN_SIZE_X, SCREEN_SIZE_Y)), 20.f, Rgba8::WHITE, 1.f, Vec2(0.5f, 0.1f));
@@ -90,7 +211,36 @@ void Game::Update()
 	// Setting clock time variables
 	double deltaSeconds = m_gameClock->GetDeltaSeconds();
 	AdjustForPauseAndTimeDistortion(static_cast<float>(deltaSeconds));
+
+	// The previous frame was the first attract frame the player could act on
+	if (m_hasDrawnAttractFrame && m_isStartupTimePending)
+	{
+		g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, Stringf("First interactive frame %.2f ms after startup (async loading %s)",
+			(GetCurrentTimeSeconds() - m_app->GetStartupSeconds()) * 1000.0, m_isAsyncLoadingEnabled ? "on" : "off"));
+		m_isStartupTimePending = false;
+	}
+
+	if (m_currentState == GameState::LOADING)
+	{
+		if (g_assetLoader->Update(m_loadingBudgetSeconds))
+		{
+			g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, Stringf("Loaded in %.2f ms on %d workers (%.2f MB images decoded, %.2f MB sounds read)",
+				(GetCurrentTimeSeconds() - m_enterLoadingSeconds) * 1000.0, g_assetLoader->GetNumWorkers(),
+				static_cast<double>(g_assetLoader->m_numImageBytesDecoded) / (1024.0 * 1024.0),
+				static_cast<double>(g_assetLoader->m_numSoundBytesRead) / (1024.0 * 1024.0)));
+			EnterState(GameState::ATTRACT);
+		}
+	}
+
+	// The previous frame was the first one of a match
+	if (m_enterPlayingSeconds > 0.0)
+	{
+		g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, Stringf("First frame of the match after %.2f ms (map cache %s)",
+			(GetCurrentTimeSeconds() - m_enterPlayingSeconds) * 1000.0, m_isMapCacheEnabled ? "on" : "off"));
+		m_enterPlayingSeconds = 0.0;
+	}
 	KeyInputPresses();
+	MapSaveState::PollPendingWrite();
 
 	if (m_currentState == GameState::PLAYING)
 	{
@@ -98,16 +248,58 @@ void Game::Update()
 			m_gameClock->GetTotalSeconds(), m_gameClock->GetFrameRate(), m_gameClock->GetTimeScale());
 		DebugAddScreenText(timeText, AABB2(Vec2::ZERO, Vec2(SCREEN_SIZE_X, SCREEN_SIZE_Y)), 12.f, Vec2(0.97f, 0.97f), 0.f, Rgba8::WHITE, Rgba8::WHITE);
 
+		// Input is sampled once at frame start, the simulation only consumes the queued commands
 		for (Player* player : m_players)
 		{
-			player->Update(static_cast<float>(deltaSeconds));
+			player->m_commandQueue.Push(player->SampleCommand(static_cast<float>(deltaSeconds)));
+		}
+
+		if (m_fixedTickSeconds <= 0.f)
+		{
+			SimulateTick(static_cast<float>(deltaSeconds));
+		}
+		else
+		{
+			// Capped so a long frame can't snowball into ever more ticks
+			m_tickAccumulatorSeconds += deltaSeconds;
+			int numTicks = 0;
+			while (m_tickAccumulatorSeconds >= m_fixedTickSeconds && numTicks < MAX_SIMULATION_TICKS_PER_FRAME)
+			{
+				SimulateTick(m_fixedTickSeconds);
+				m_tickAccumulatorSeconds -= m_fixedTickSeconds;
+				++numTicks;
+			}
+			if (numTicks == MAX_SIMULATION_TICKS_PER_FRAME)
+			{
+				m_tickAccumulatorSeconds = 0.0;
+			}
 		}
-		m_defaultMap->Update(static_cast<float>(deltaSeconds));
 		VictoryCondition(static_cast<float>(deltaSeconds));
 		GameOver(static_cast<float>(deltaSeconds));
 	}
 
 	UpdateCameras();
+	m_hasDrawnAttractFrame = (m_currentState == GameState::ATTRACT);
+}
+
+void Game::SimulateTick(float deltaSeconds)
+{
+	for (Player* player : m_players)
+	{
+		player->m_command = player->m_commandQueue.ConsumeForTick();
+		player->Update(deltaSeconds);
+	}
+	m_defaultMap->Update(deltaSeconds);
+	ReplaySystem::RecordTick(deltaSeconds, m_players, *m_defaultMap);
+	if (m_netSession != nullptr)
+	{
+		// Loopback clients take turns viewing from the local players
+		for (int clientIndex = 0; clientIndex < m_netSession->GetNumClients(); ++clientIndex)
+		{
+			m_netSession->SetClientViewer(clientIndex, m_players[clientIndex % static_cast<int>(m_players.size())]->m_currentHandle);
+		}
+		m_netSession->Tick(*m_defaultMap);
+	}
 }
 
 void Game::VictoryCondition(float deltaSeconds)
@@ -132,6 +324,12 @@ void Game::VictoryCondition(float deltaSeconds)
 
 void Game::Render() const
 {
+	if (m_currentState == GameState::LOADING)
+	{
+		g_theRenderer->BeginCamera(m_screenCamera);
+		RenderLoadingScreen();
+		g_theRenderer->EndCamera(m_screenCamera);
+	}
 	if (m_currentState == GameState::ATTRACT)
 	{
 		g_theRenderer->BeginCamera(m_screenCamera);
@@ -191,9 +389,9 @@ void Game::Render() const
 
 void Game::RenderGameOverScreen() const
 {
-	std::vector<Vertex_PCU> m_endScreenVerts;
 	if (m_gameOverSeconds > 0 && m_gameOverSeconds < 6)
 	{
+		std::vector<Vertex_PCU>& m_endScreenVerts = g_frameArena->AllocateVerts();
 		AddVertsForAABB2D(m_endScreenVerts, AABB2(Vec2::ZERO, Vec2(SCREEN_SIZE_X, SCREEN_SIZE_Y)), Rgba8::WHITE);
 		g_theRenderer->SetBlendMode(BlendMode::ALPHA);
 		g_theRenderer->SetRasterizerMode(RasterizerMode::SOLID_CULL_NONE);
@@ -201,6 +399,7 @@ void Game::RenderGameOverScreen() const
 		g_theRenderer->BindShader(nullptr);
 		g_theRenderer->BindTexture(m_gameOverTexture);
 		g_theRenderer->DrawVertexArray(m_endScreenVerts);
+		FrameStats::AddDrawCall();
 	}
 }
 
@@ -208,7 +407,7 @@ void Game::RenderVictoryScreen() const
 {
 	if (m_victorySeconds > 0.0f && m_victorySeconds < 3.0f)
 	{
-		std::vector<Vertex_PCU> m_victoryScreenVerts;
+		std::vector<Vertex_PCU>& m_victoryScreenVerts = g_frameArena->AllocateVerts();
 		AddVertsForAABB2D(m_victoryScreenVerts, AABB2(Vec2::ZERO, Vec2(SCREEN_SIZE_X, SCREEN_SIZE_Y)), Rgba8::WHITE);
 		g_theRenderer->SetBlendMode(BlendMode::ALPHA);
 		g_theRenderer->SetRasterizerMode(RasterizerMode::SOLID_CULL_NONE);
@@ -216,15 +415,22 @@ void Game::RenderVictoryScreen() const
 		g_theRenderer->BindShader(nullptr);
 		g_theRenderer->BindTexture(m_victoryTexture);
 		g_theRenderer->DrawVertexArray(m_victoryScreenVerts);
+		FrameStats::AddDrawCall();
 	}
 }
 
 void Game::Shutdown()
 {
+	MapSaveState::WaitForPendingWrite();
+
 	delete m_gameClock;
 	m_gameClock = nullptr;
 
+	delete m_netSession;
+	m_netSession = nullptr;
+
 	DestroyMap();
+	DestroyCachedMaps();
 	DestroyPlayer();
 }
 
@@ -239,10 +445,30 @@ void Game::DestroyPlayer()
 
 void Game::DestroyMap()
 {
-	delete m_defaultMap;
+	if (m_defaultMap == nullptr)
+	{
+		return;
+	}
+	if (m_isMapCacheEnabled)
+	{
+		m_defaultMap->ClearActors();
+	}
+	else
+	{
+		delete m_defaultMap;
+	}
 	m_defaultMap = nullptr;
 }
 
+void Game::DestroyCachedMaps()
+{
+	for (int mapIndex = 0; mapIndex < static_cast<int>(m_cachedMaps.size()); ++mapIndex)
+	{
+		delete m_cachedMaps[mapIndex];
+	}
+	m_cachedMaps.clear();
+}
+
 void Game::InitializePlayer()
 {
 	//m_player = new Player(m_defaultMap);
@@ -271,7 +497,24 @@ void Game::InitializeMap()
 {
 	std::string mapName = g_gameConfigBlackboard.GetValue("defaultMap", "");
 	MapDefinition* currentMap = MapDefinition::GetByName(mapName);
+	if (m_isMapCacheEnabled)
+	{
+		for (int mapIndex = 0; mapIndex < static_cast<int>(m_cachedMaps.size()); ++mapIndex)
+		{
+			if (m_cachedMaps[mapIndex]->m_definition == currentMap)
+			{
+				m_defaultMap = m_cachedMaps[mapIndex];
+				m_defaultMap->ResetSession();
+				return;
+			}
+		}
+	}
+
 	m_defaultMap = new Map(this, currentMap);
+	if (m_isMapCacheEnabled)
+	{
+		m_cachedMaps.push_back(m_defaultMap);
+	}
 }
 
 void Game::KeyInputPresses()
@@ -496,6 +739,31 @@ void Game::UpdateCameras()
 	//m_screenCamera.SetNormalizedViewport(Vec2::ZERO, Vec2(1.f, 0.5f));
 }
 
+void Game::RenderLoadingScreen() const
+{
+	float progress = g_assetLoader->GetProgress();
+	AABB2 barBounds = AABB2(Vec2(400.f, 380.f), Vec2(1200.f, 420.f));
+	AABB2 filledBounds = AABB2(barBounds.m_mins, Vec2(barBounds.m_mins.x + (barBounds.m_maxs.x - barBounds.m_mins.x) * progress, barBounds.m_maxs.y));
+
+	std::vector<Vertex_PCU>& barVerts = g_frameArena->AllocateVerts();
+	AddVertsForAABB2D(barVerts, barBounds, Rgba8(40, 40, 40, 255));
+	AddVertsForAABB2D(barVerts, filledBounds, Rgba8::WHITE);
+	g_theRenderer->SetModelConstants();
+	g_theRenderer->SetBlendMode(BlendMode::ALPHA);
+	g_theRenderer->SetRasterizerMode(RasterizerMode::SOLID_CULL_NONE);
+	g_theRenderer->SetDepthMode(DepthMode::DISABLED);
+	g_theRenderer->BindShader(nullptr);
+	g_theRenderer->BindTexture(nullptr);
+	g_theRenderer->DrawVertexArray(barVerts);
+	FrameStats::AddDrawCall();
+
+	std::vector<Vertex_PCU>& textVerts = g_frameArena->AllocateVerts();
+	m_font->AddVertsForTextInBox2D(textVerts, Stringf("Loading... %d%%", static_cast<int>(progress * 100.f)), AABB2(Vec2::ZERO, Vec2(SCREEN_SIZE_X, SCREEN_SIZE_Y)), 20.f, Rgba8::WHITE, 1.f, Vec2(0.5f, 0.4f));
+	g_theRenderer->BindTexture(&m_font->GetTexture());
+	g_theRenderer->DrawVertexArray(textVerts);
+	FrameStats::AddDrawCall();
+}
+
 void Game::RenderAttractMode() const
 {
 	g_theRenderer->SetModelConstants();
@@ -505,12 +773,13 @@ void Game::RenderAttractMode() const
 	g_theRenderer->BindShader(nullptr);
 	g_theRenderer->BindTexture(&m_font->GetTexture());
 	g_theRenderer->DrawVertexArray(m_fontVerts);
+	FrameStats::AddDrawCall();
 }
 
 void Game::RenderLobbyMode() const
 {
 	g_theRenderer->ClearScreen(Rgba8(70, 70, 70, 255));
-	std::vector<Vertex_PCU> textVerts;
+	std::vector<Vertex_PCU>& textVerts = g_frameArena->AllocateVerts();
 	AABB2 upperScreenBox = AABB2(Vec2(400.f, 400.f), Vec2(1200.f, 800.f));
 	AABB2 screenCenterBox = AABB2(Vec2(400.f, 200.f), Vec2(1200.f, 600.f));
 	AABB2 lowerScreenBox = AABB2(Vec2(400.f, 0.f), Vec2(1200.f, 400.f));
@@ -571,6 +840,7 @@ void Game::RenderLobbyMode() const
 	g_theRenderer->BindShader(nullptr);
 	g_theRenderer->BindTexture(&m_font->GetTexture());
 	g_theRenderer->DrawVertexArray(textVerts);
+	FrameStats::AddDrawCall();
 }
 
 GameState Game::GetCurrentGameState() const
@@ -589,6 +859,10 @@ void Game::EnterState(GameState state)
 	{
 		break;
 	}
+		case GameState::LOADING:
+		{
+			break;
+		}
 		case GameState::ATTRACT:
 		{
 			if (!g_theAudio->IsPlaying(m_mainMenuPlayback))
@@ -605,6 +879,7 @@ void Game::EnterState(GameState state)
 		{
 			m_hasPlayerWon = false;
 			m_hasGameOverPlayed = false;
+			m_enterPlayingSeconds = GetCurrentTimeSeconds();
 
 			InitializePlayer();
 			g_theAudio->StopSound(m_mainMenuPlayback);
@@ -650,6 +925,7 @@ void Game::ExitState(GameState state)
 		}
 		case GameState::PLAYING:
 		{
+			ReplaySystem::EndRecording();
 			g_theAudio->StopSound(m_gameMusicPlayback);
 			DestroyPlayer();
 			DestroyMap();
@@ -8,10 +8,12 @@
 // -----------------------------------------------------------------------------
 class Player;
 class BitmapFont;
+class NetSession;
 // -----------------------------------------------------------------------------
 enum class GameState
 {
 	NONE,
+	LOADING,
 	ATTRACT,
 	LOBBY,
 	PLAYING,
@@ -25,9 +27,10 @@ public:
 	Game(App* owner);
 	~Game();
 	void StartUp();
+	void FinishStartUp();
 
 	void Update();
-
+	void SimulateTick(float deltaSeconds);
 
 	void UpdateCameras();
 
@@ -36,6 +39,7 @@ public:
 	void RenderGameOverScreen() const;
 	void RenderVictoryScreen() const;
 
+	void RenderLoadingScreen() const;
 	void RenderAttractMode() const;
 	void RenderLobbyMode() const;
 
@@ -46,6 +50,7 @@ public:
 	void Shutdown();
 	void DestroyPlayer();
 	void DestroyMap();
+	void DestroyCachedMaps();
 
 	void InitializePlayer();
 	void InitializeMap();
@@ -63,6 +68,7 @@ public:
 
 	Map* GetMap() const;
 	Map*		m_defaultMap = nullptr;
+	std::vector<Map*> m_cachedMaps;
 
 	GameState	m_currentState = GameState::ATTRACT;
 	Clock*      m_gameClock = nullptr;
@@ -72,6 +78,7 @@ public:
 	Camera		m_screenCamera;
 	Camera      m_gameWorldCamera;
 	std::vector<Player*> m_players;
+	NetSession* m_netSession = nullptr;
 	BitmapFont* m_font = nullptr;
 // -----------------------------------------------------------------------------
 private:
@@ -85,6 +92,21 @@ private:
 	bool m_hasPlayerWon = false;
 	bool m_hasGameOverPlayed = false;
 
+	// Maps are kept per definition between matches and only their actors are reset
+	bool   m_isMapCacheEnabled = true;
+	double m_enterPlayingSeconds = 0.0;
+
+	// Definitions and their assets load on worker threads behind a loading screen
+	bool   m_isAsyncLoadingEnabled = true;
+	double m_loadingBudgetSeconds = 0.008;
+	double m_enterLoadingSeconds = 0.0;
+	bool   m_isStartupTimePending = true;
+	bool   m_hasDrawnAttractFrame = false;
+
+	// Simulation rate, zero ticks once per frame with the frame's delta time
+	float  m_fixedTickSeconds = 0.f;
+	double m_tickAccumulatorSeconds = 0.0;
+
 	// Music
 	std::string m_mainMenuMusicPath;
 	std::string m_gameMusicPath;
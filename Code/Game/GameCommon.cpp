@@ -1,4 +1,5 @@
 #include "GameCommon.h"
+#include "Game/FrameStats.hpp"
 #include <Engine/Math/Vec3.h>
 #include <Engine/Math/MathUtils.h>
 #include "Engine/Math/Vec2.hpp"
@@ -58,6 +59,7 @@ void DebugDrawRing(Vec2 const& center, float radius, float thickness, Rgba8 cons
 	}
 
 	g_theRenderer->DrawVertexArray(NUM_VERTS, verts);
+	FrameStats::AddDrawCall();
 
 
 }
@@ -98,6 +100,7 @@ void DebugDrawLine(Vec2 const& start, Vec2 const& end, float thickness, Rgba8 co
 	verts[5].m_color = color;
 
 	g_theRenderer->DrawVertexArray(NUM_VERTS, verts);
+	FrameStats::AddDrawCall();
 }
 
 
@@ -7,6 +7,10 @@ class Renderer;
 class InputSystem;
 class AudioSystem;
 class Window;
+class FrameArena;
+class AssetLoader;
+class AssetResidency;
+class ShaderRegistry;
 struct Vec2;
 struct Rgba8;
 
@@ -16,6 +20,7 @@ constexpr float SCREEN_CENTER_X = SCREEN_SIZE_X / 2.f;
 constexpr float SCREEN_CENTER_Y = SCREEN_SIZE_Y / 2.f;
 
 constexpr int STARTTRIANGLE_VERTS = 3;
+constexpr int MAX_SIMULATION_TICKS_PER_FRAME = 8;
 
 extern App* g_theApp;
 extern Game* g_theGame;
@@ -24,6 +29,10 @@ extern RandomNumberGenerator* g_rng;
 extern InputSystem* g_theInput;
 extern AudioSystem* g_theAudio;
 extern Window* g_theWindow;
+extern FrameArena* g_frameArena;
+extern AssetLoader* g_assetLoader;
+extern AssetResidency* g_assetResidency;
+extern ShaderRegistry* g_shaderRegistry;
 
 
 void DebugDrawRing(Vec2 const& center, float radius, float thickness, Rgba8 const& color);
@@ -0,0 +1,240 @@
+#include "Game/LightGrid.hpp"
+#include "Game/GameCommon.h"
+#include "Game/BenchHelpers.hpp"
+#include "Engine/Core/DevConsole.hpp"
+#include "Engine/Core/EngineCommon.h"
+#include "Engine/Core/Time.hpp"
+#include "Engine/Math/AABB2.h"
+#include "Engine/Math/MathUtils.h"
+#include "Engine/Renderer/Renderer.h"
+#include <algorithm>
+
+void LightGrid::Initialize(IntVec2 const& mapDimensions, int tilesPerCell)
+{
+	m_mapDimensions = mapDimensions;
+	m_tilesPerCell = tilesPerCell;
+	m_cellCounts.x = (mapDimensions.x + tilesPerCell - 1) / tilesPerCell;
+	m_cellCounts.y = (mapDimensions.y + tilesPerCell - 1) / tilesPerCell;
+
+	m_cellLightStarts.assign(GetNumCells() + 1, 0);
+	m_cellLightIndexes.clear();
+	m_lights.clear();
+}
+
+void LightGrid::Clear()
+{
+	m_lights.clear();
+}
+
+void LightGrid::AddLight(PointLightInfo const& light)
+{
+	m_lights.push_back(light);
+}
+
+void LightGrid::Build()
+{
+	int numCells = GetNumCells();
+	m_cellLightStarts.assign(numCells + 1, 0);
+
+	// Count how many lights touch each cell, offset by one for the prefix sum
+	for (int lightIndex = 0; lightIndex < static_cast<int>(m_lights.size()); ++lightIndex)
+	{
+		IntVec2 cellMins, cellMaxs;
+		if (!GetCellRangeForLight(m_lights[lightIndex], cellMins, cellMaxs))
+		{
+			continue;
+		}
+		for (int cellY = cellMins.y; cellY <= cellMaxs.y; ++cellY)
+		{
+			for (int cellX = cellMins.x; cellX <= cellMaxs.x; ++cellX)
+			{
+				if (DoesLightTouchCell(m_lights[lightIndex], cellX, cellY))
+				{
+					m_cellLightStarts[GetCellIndex(cellX, cellY) + 1] += 1;
+				}
+			}
+		}
+	}
+
+	// Turn the counts into start offsets
+	for (int cellIndex = 0; cellIndex < numCells; ++cellIndex)
+	{
+		m_cellLightStarts[cellIndex + 1] += m_cellLightStarts[cellIndex];
+	}
+	m_cellLightIndexes.resize(m_cellLightStarts[numCells]);
+
+	// Scatter light indexes into their cells, using the start offsets as write cursors
+	for (int lightIndex = 0; lightIndex < static_cast<int>(m_lights.size()); ++lightIndex)
+	{
+		IntVec2 cellMins, cellMaxs;
+		if (!GetCellRangeForLight(m_lights[lightIndex], cellMins, cellMaxs))
+		{
+			continue;
+		}
+		for (int cellY = cellMins.y; cellY <= cellMaxs.y; ++cellY)
+		{
+			for (int cellX = cellMins.x; cellX <= cellMaxs.x; ++cellX)
+			{
+				if (DoesLightTouchCell(m_lights[lightIndex], cellX, cellY))
+				{
+					m_cellLightIndexes[m_cellLightStarts[GetCellIndex(cellX, cellY)]++] = lightIndex;
+				}
+			}
+		}
+	}
+
+	// The scatter advanced every start to the next cell's start, so shift them back
+	for (int cellIndex = numCells; cellIndex > 0; --cellIndex)
+	{
+		m_cellLightStarts[cellIndex] = m_cellLightStarts[cellIndex - 1];
+	}
+	m_cellLightStarts[0] = 0;
+}
+
+int LightGrid::GetNumCells() const
+{
+	return m_cellCounts.x * m_cellCounts.y;
+}
+
+int LightGrid::GetCellIndex(int cellX, int cellY) const
+{
+	return (cellY * m_cellCounts.x) + cellX;
+}
+
+AABB2 LightGrid::GetCellBounds(int cellIndex) const
+{
+	int cellX = cellIndex % m_cellCounts.x;
+	int cellY = cellIndex / m_cellCounts.x;
+	float cellSize = static_cast<float>(m_tilesPerCell);
+	Vec2 mins = Vec2(static_cast<float>(cellX) * cellSize, static_cast<float>(cellY) * cellSize);
+	return AABB2(mins, mins + Vec2(cellSize, cellSize));
+}
+
+int LightGrid::GetNumLightsInCell(int cellIndex) const
+{
+	return m_cellLightStarts[cellIndex + 1] - m_cellLightStarts[cellIndex];
+}
+
+int LightGrid::GetLightIndexInCell(int cellIndex, int lightNum) const
+{
+	return m_cellLightIndexes[m_cellLightStarts[cellIndex] + lightNum];
+}
+
+PointLightInfo const& LightGrid::GetLight(int lightIndex) const
+{
+	return m_lights[lightIndex];
+}
+
+int LightGrid::GetNumLights() const
+{
+	return static_cast<int>(m_lights.size());
+}
+
+bool LightGrid::GetCellRangeForLight(PointLightInfo const& light, IntVec2& outMins, IntVec2& outMaxs) const
+{
+	float cellSize = static_cast<float>(m_tilesPerCell);
+	outMins.x = RoundDownToInt((light.m_position.x - light.m_radius) / cellSize);
+	outMins.y = RoundDownToInt((light.m_position.y - light.m_radius) / cellSize);
+	outMaxs.x = RoundDownToInt((light.m_position.x + light.m_radius) / cellSize);
+	outMaxs.y = RoundDownToInt((light.m_position.y + light.m_radius) / cellSize);
+
+	if (outMaxs.x < 0 || outMaxs.y < 0 || outMins.x >= m_cellCounts.x || outMins.y >= m_cellCounts.y)
+	{
+		return false;
+	}
+
+	outMins.x = (outMins.x < 0) ? 0 : outMins.x;
+	outMins.y = (outMins.y < 0) ? 0 : outMins.y;
+	outMaxs.x = (outMaxs.x > m_cellCounts.x - 1) ? m_cellCounts.x - 1 : outMaxs.x;
+	outMaxs.y = (outMaxs.y > m_cellCounts.y - 1) ? m_cellCounts.y - 1 : outMaxs.y;
+	return true;
+}
+
+bool LightGrid::DoesLightTouchCell(PointLightInfo const& light, int cellX, int cellY) const
+{
+	AABB2 cellBounds = GetCellBounds(GetCellIndex(cellX, cellY));
+	Vec2 lightPosXY = light.m_position.GetXY();
+	Vec2 nearestPoint = Vec2(GetClamped(lightPosXY.x, cellBounds.m_mins.x, cellBounds.m_maxs.x),
+							 GetClamped(lightPosXY.y, cellBounds.m_mins.y, cellBounds.m_maxs.y));
+	return GetDistanceSquared2D(nearestPoint, lightPosXY) <= light.m_radius * light.m_radius;
+}
+
+// -----------------------------------------------------------------------------
+// Dev console: LightGridTest lights=<count>
+// Builds grids of random lights over a 64x64 map, checks every cell's list
+// against a brute force overlap test and prints the build time per grid and
+// how many cells hold more lights than MAX_POINTLIGHTS, which a draw drops.
+// -----------------------------------------------------------------------------
+bool LightGrid::Command_LightGridTest(EventArgs& args)
+{
+	int requestedLights = args.GetValue("lights", 0);
+	std::vector<int> lightCounts;
+	if (requestedLights > 0)
+	{
+		lightCounts.push_back(requestedLights);
+	}
+	else
+	{
+		lightCounts = { 1000, 2500, 5000, 10000 };
+	}
+
+	IntVec2 mapDimensions = IntVec2(64, 64);
+	for (int countIndex = 0; countIndex < static_cast<int>(lightCounts.size()); ++countIndex)
+	{
+		int numLights = lightCounts[countIndex];
+		LightGrid grid;
+		grid.Initialize(mapDimensions, 8);
+		for (int lightIndex = 0; lightIndex < numLights; ++lightIndex)
+		{
+			PointLightInfo light;
+			light.m_position = Vec3(GetBenchRng().RollRandomFloatInRange(-2.f, 66.f), GetBenchRng().RollRandomFloatInRange(-2.f, 66.f), 0.5f);
+			light.m_radius = GetBenchRng().RollRandomFloatInRange(0.5f, 6.f);
+			grid.AddLight(light);
+		}
+
+		double buildStart = GetCurrentTimeSeconds();
+		grid.Build();
+		double buildMs = (GetCurrentTimeSeconds() - buildStart) * 1000.0;
+
+		// Every listed light must overlap the cell, and every overlapping light must be listed exactly once
+		int numErrors = 0;
+		int maxLightsInCell = 0;
+		int numOverflowingCells = 0;
+		std::vector<int> timesListed(numLights, 0);
+		for (int cellIndex = 0; cellIndex < grid.GetNumCells(); ++cellIndex)
+		{
+			AABB2 cellBounds = grid.GetCellBounds(cellIndex);
+			std::fill(timesListed.begin(), timesListed.end(), 0);
+			if (grid.GetNumLightsInCell(cellIndex) > maxLightsInCell)
+			{
+				maxLightsInCell = grid.GetNumLightsInCell(cellIndex);
+			}
+			if (grid.GetNumLightsInCell(cellIndex) > MAX_POINTLIGHTS)
+			{
+				++numOverflowingCells;
+			}
+			for (int lightNum = 0; lightNum < grid.GetNumLightsInCell(cellIndex); ++lightNum)
+			{
+				timesListed[grid.GetLightIndexInCell(cellIndex, lightNum)] += 1;
+			}
+
+			for (int lightIndex = 0; lightIndex < numLights; ++lightIndex)
+			{
+				PointLightInfo const& light = grid.GetLight(lightIndex);
+				Vec2 lightPosXY = light.m_position.GetXY();
+				Vec2 nearestPoint = Vec2(GetClamped(lightPosXY.x, cellBounds.m_mins.x, cellBounds.m_maxs.x),
+										 GetClamped(lightPosXY.y, cellBounds.m_mins.y, cellBounds.m_maxs.y));
+				bool shouldBeListed = GetDistanceSquared2D(nearestPoint, lightPosXY) <= light.m_radius * light.m_radius;
+				if (timesListed[lightIndex] != (shouldBeListed ? 1 : 0))
+				{
+					++numErrors;
+				}
+			}
+		}
+
+		Rgba8 resultColor = (numErrors == 0) ? Rgba8::GREEN : Rgba8::RED;
+		g_theDevConsole->AddLine(resultColor, Stringf("LightGrid %d lights: build %.3f ms, %d cells, max %d lights/cell, %d cells over %d, %d assignment errors",
+			numLights, buildMs, grid.GetNumCells(), maxLightsInCell, numOverflowingCells, MAX_POINTLIGHTS, numErrors));
+	}
+	return true;
+}
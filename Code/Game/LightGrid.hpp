@@ -0,0 +1,52 @@
+#pragma once
+#include "Engine/Core/Rgba8.h"
+#include "Engine/Core/EventSystem.hpp"
+#include "Engine/Math/IntVec2.h"
+#include "Engine/Math/Vec3.h"
+#include <vector>
+// -----------------------------------------------------------------------------
+struct AABB2;
+// -----------------------------------------------------------------------------
+struct PointLightInfo
+{
+	Vec3  m_position = Vec3::ZERO;
+	float m_radius = 0.f;
+	Rgba8 m_color = Rgba8::WHITE;
+};
+// -----------------------------------------------------------------------------
+// Uniform grid laid over the map's tile grid. Each cell holds a packed list of
+// the lights whose radius touches it, rebuilt once per frame with a counting sort
+// so the shading cost of a cell only depends on the lights that reach it.
+// -----------------------------------------------------------------------------
+class LightGrid
+{
+public:
+	LightGrid() = default;
+
+	void Initialize(IntVec2 const& mapDimensions, int tilesPerCell);
+	void Clear();
+	void AddLight(PointLightInfo const& light);
+	void Build();
+
+	int  GetNumCells() const;
+	int  GetCellIndex(int cellX, int cellY) const;
+	AABB2 GetCellBounds(int cellIndex) const;
+	int  GetNumLightsInCell(int cellIndex) const;
+	int  GetLightIndexInCell(int cellIndex, int lightNum) const;
+	PointLightInfo const& GetLight(int lightIndex) const;
+	int  GetNumLights() const;
+
+	static bool Command_LightGridTest(EventArgs& args);
+// -----------------------------------------------------------------------------
+private:
+	bool GetCellRangeForLight(PointLightInfo const& light, IntVec2& outMins, IntVec2& outMaxs) const;
+	bool DoesLightTouchCell(PointLightInfo const& light, int cellX, int cellY) const;
+// -----------------------------------------------------------------------------
+	IntVec2 m_mapDimensions = IntVec2::ZERO;
+	IntVec2 m_cellCounts = IntVec2::ZERO;
+	int     m_tilesPerCell = 8;
+
+	std::vector<PointLightInfo> m_lights;
+	std::vector<int> m_cellLightStarts;
+	std::vector<int> m_cellLightIndexes;
+};
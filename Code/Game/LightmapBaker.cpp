@@ -0,0 +1,198 @@
+#include "Game/LightmapBaker.hpp"
+#include "Game/Map.hpp"
+#include "Game/GameCommon.h"
+#include "Engine/Core/Time.hpp"
+#include "Engine/Core/Vertex_PCUTBN.hpp"
+#include "Engine/Math/MathUtils.h"
+#include <functional>
+#include <thread>
+
+LightmapBaker::LightmapBaker(Map const& map)
+	:m_map(map)
+{
+}
+
+void LightmapBaker::AddStaticLight(PointLightInfo const& light)
+{
+	m_staticLights.push_back(light);
+}
+
+LightmapBakeReport LightmapBaker::Bake(std::vector<MapChunk>& chunks, LightmapBakeSettings const& settings)
+{
+	m_settings = settings;
+	m_settings.m_sunDirection.Normalize();
+
+	int numThreads = settings.m_numThreads;
+	if (numThreads <= 0)
+	{
+		numThreads = static_cast<int>(std::thread::hardware_concurrency());
+	}
+	numThreads = (numThreads > static_cast<int>(chunks.size())) ? static_cast<int>(chunks.size()) : numThreads;
+	numThreads = (numThreads < 1) ? 1 : numThreads;
+
+	double bakeStart = GetCurrentTimeSeconds();
+
+	// Chunks are interleaved across threads so dense and empty areas of the map balance out
+	std::vector<LightmapBakeReport> threadReports(numThreads);
+	std::vector<std::thread> workers;
+	for (int threadIndex = 1; threadIndex < numThreads; ++threadIndex)
+	{
+		workers.emplace_back(&LightmapBaker::BakeChunks, this, std::ref(chunks), threadIndex, numThreads, std::ref(threadReports[threadIndex]));
+	}
+	BakeChunks(chunks, 0, numThreads, threadReports[0]);
+	for (int workerIndex = 0; workerIndex < static_cast<int>(workers.size()); ++workerIndex)
+	{
+		workers[workerIndex].join();
+	}
+
+	LightmapBakeReport report;
+	for (int threadIndex = 0; threadIndex < numThreads; ++threadIndex)
+	{
+		LightmapBakeReport const& threadReport = threadReports[threadIndex];
+		report.m_numVertexes += threadReport.m_numVertexes;
+		report.m_numSunShadowedVertexes += threadReport.m_numSunShadowedVertexes;
+		report.m_totalOcclusion += threadReport.m_totalOcclusion;
+		report.m_minLight = (threadReport.m_minLight < report.m_minLight) ? threadReport.m_minLight : report.m_minLight;
+		report.m_maxLight = (threadReport.m_maxLight > report.m_maxLight) ? threadReport.m_maxLight : report.m_maxLight;
+	}
+	report.m_bakeSeconds = GetCurrentTimeSeconds() - bakeStart;
+	report.m_numThreads = numThreads;
+	report.m_numStaticLights = static_cast<int>(m_staticLights.size());
+	return report;
+}
+
+void LightmapBaker::BakeChunks(std::vector<MapChunk>& chunks, int firstChunk, int chunkStride, LightmapBakeReport& report) const
+{
+	for (int chunkIndex = firstChunk; chunkIndex < static_cast<int>(chunks.size()); chunkIndex += chunkStride)
+	{
+		std::vector<Vertex_PCUTBN>& vertexes = chunks[chunkIndex].m_vertexes;
+
+		// Map geometry is built from AddVertsForQuad3D, four vertexes per quad
+		for (int vertIndex = 0; vertIndex + 3 < static_cast<int>(vertexes.size()); vertIndex += 4)
+		{
+			BakeQuad(&vertexes[vertIndex], report);
+		}
+	}
+}
+
+void LightmapBaker::BakeQuad(Vertex_PCUTBN* quadVertexes, LightmapBakeReport& report) const
+{
+	Vec3 quadCenter = (quadVertexes[0].m_position + quadVertexes[1].m_position + quadVertexes[2].m_position + quadVertexes[3].m_position) * 0.25f;
+	float mapDiagonal = Vec3(static_cast<float>(m_map.m_dimensions.x), static_cast<float>(m_map.m_dimensions.y), 1.f).GetLength();
+	Vec3 toSun = -m_settings.m_sunDirection;
+
+	for (int cornerIndex = 0; cornerIndex < 4; ++cornerIndex)
+	{
+		Vertex_PCUTBN& vertex = quadVertexes[cornerIndex];
+		Vec3 normal = vertex.m_normal.GetNormalized();
+
+		// Pull the sample off the surface and slightly toward the quad's own tile so corners don't land in a neighboring wall
+		Vec3 samplePos = vertex.m_position + (normal * 0.02f) + ((quadCenter - vertex.m_position) * 0.02f);
+
+		// Ambient, darkened by the solid tiles around this corner
+		float occlusion = ComputeAmbientOcclusion(vertex.m_position, normal);
+		float ambient = m_settings.m_ambientIntensity * occlusion;
+		Vec3 light = Vec3(ambient, ambient, ambient);
+
+		// Sun, shadowed by any wall between the sample and the sky
+		float sunFacing = GetClamped(DotProduct3D(normal, toSun), 0.f, 1.f);
+		if (sunFacing > 0.f)
+		{
+			float sunDistance = (toSun.z > 0.f) ? (1.f - samplePos.z) / toSun.z : mapDiagonal;
+			sunDistance = (sunDistance > mapDiagonal) ? mapDiagonal : sunDistance;
+			if (IsVisibleAlongRay(samplePos, toSun, sunDistance))
+			{
+				float sun = m_settings.m_sunIntensity * sunFacing;
+				light += Vec3(sun, sun, sun);
+			}
+			else
+			{
+				report.m_numSunShadowedVertexes += 1;
+			}
+		}
+
+		// Static lights, same falloff as the point lights in the shader
+		for (int lightIndex = 0; lightIndex < static_cast<int>(m_staticLights.size()); ++lightIndex)
+		{
+			PointLightInfo const& staticLight = m_staticLights[lightIndex];
+			Vec3 toLight = staticLight.m_position - samplePos;
+			float distance = toLight.GetLength();
+			if (distance >= staticLight.m_radius || distance <= 0.f)
+			{
+				continue;
+			}
+
+			Vec3 dirToLight = toLight / distance;
+			float lightFacing = GetClamped(DotProduct3D(normal, dirToLight), 0.f, 1.f);
+			if (lightFacing <= 0.f || !IsVisibleAlongRay(samplePos, dirToLight, distance))
+			{
+				continue;
+			}
+
+			float attenuation = 1.f / (1.f + 0.09f * distance + 0.032f * distance * distance);
+			float radiusWindow = 1.f - (distance / staticLight.m_radius);
+			attenuation *= radiusWindow * radiusWindow * lightFacing;
+
+			float lightColor[4];
+			Rgba8 staticLightColor = staticLight.m_color;
+			staticLightColor.GetAsFloats(lightColor);
+			light += Vec3(lightColor[0], lightColor[1], lightColor[2]) * attenuation;
+		}
+
+		float luminance = (light.x + light.y + light.z) / 3.f;
+		report.m_minLight = (luminance < report.m_minLight) ? luminance : report.m_minLight;
+		report.m_maxLight = (luminance > report.m_maxLight) ? luminance : report.m_maxLight;
+		report.m_totalOcclusion += 1.f - occlusion;
+		report.m_numVertexes += 1;
+
+		vertex.m_color = Rgba8(static_cast<unsigned char>(GetClamped(light.x, 0.f, 1.f) * 255.f),
+							   static_cast<unsigned char>(GetClamped(light.y, 0.f, 1.f) * 255.f),
+							   static_cast<unsigned char>(GetClamped(light.z, 0.f, 1.f) * 255.f), 255);
+	}
+}
+
+float LightmapBaker::ComputeAmbientOcclusion(Vec3 const& position, Vec3 const& normal) const
+{
+	// Look at the (up to four) tiles touching this corner on the open side of the surface
+	Vec3 openSide = position + (normal * 0.02f);
+	IntVec2 cornerTiles[4] =
+	{
+		m_map.GetTileCoordsForWorldPos(openSide + Vec3(-0.01f, -0.01f, 0.f)),
+		m_map.GetTileCoordsForWorldPos(openSide + Vec3( 0.01f, -0.01f, 0.f)),
+		m_map.GetTileCoordsForWorldPos(openSide + Vec3(-0.01f,  0.01f, 0.f)),
+		m_map.GetTileCoordsForWorldPos(openSide + Vec3( 0.01f,  0.01f, 0.f)),
+	};
+
+	int numOccluders = 0;
+	for (int tileIndex = 0; tileIndex < 4; ++tileIndex)
+	{
+		bool isDuplicate = false;
+		for (int prevIndex = 0; prevIndex < tileIndex; ++prevIndex)
+		{
+			isDuplicate = isDuplicate || (cornerTiles[prevIndex] == cornerTiles[tileIndex]);
+		}
+		if (!isDuplicate && m_map.IsTileSolid(cornerTiles[tileIndex]))
+		{
+			++numOccluders;
+		}
+	}
+
+	// The bottom edge of a wall also sits in the corner it makes with the floor
+	if (normal.z < 0.5f && normal.z > -0.5f && position.z < 0.01f)
+	{
+		++numOccluders;
+	}
+
+	return GetClamped(1.f - 0.2f * static_cast<float>(numOccluders), 0.25f, 1.f);
+}
+
+bool LightmapBaker::IsVisibleAlongRay(Vec3 const& start, Vec3 const& direction, float distance) const
+{
+	// Samples off the edge of the map only have open sky around them
+	if (!m_map.AreCoordsInBounds(m_map.GetTileCoordsForWorldPos(start)))
+	{
+		return true;
+	}
+	RaycastResult3D result = m_map.RaycastWorldXY(start, direction, distance);
+	return !result.m_didImpact;
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include "Game/LightGrid.hpp"
+#include "Engine/Math/Vec3.h"
+#include <vector>
+// -----------------------------------------------------------------------------
+class Map;
+struct MapChunk;
+struct Vertex_PCUTBN;
+// -----------------------------------------------------------------------------
+struct LightmapBakeSettings
+{
+	Vec3  m_sunDirection = Vec3(2.f, 1.f, -1.f);
+	float m_sunIntensity = 0.35f;
+	float m_ambientIntensity = 0.25f;
+	int   m_numThreads = 0;
+};
+// -----------------------------------------------------------------------------
+struct LightmapBakeReport
+{
+	double m_bakeSeconds = 0.0;
+	int    m_numThreads = 0;
+	int    m_numVertexes = 0;
+	int    m_numSunShadowedVertexes = 0;
+	int    m_numStaticLights = 0;
+	float  m_totalOcclusion = 0.f;
+	float  m_minLight = 1.f;
+	float  m_maxLight = 0.f;
+};
+// -----------------------------------------------------------------------------
+// Bakes sun visibility, tile ambient occlusion and static lights into the
+// vertex colors of the map's chunks. Chunks are split across worker threads,
+// which only read the map and write their own chunks' vertexes.
+// -----------------------------------------------------------------------------
+class LightmapBaker
+{
+public:
+	explicit LightmapBaker(Map const& map);
+
+	void AddStaticLight(PointLightInfo const& light);
+	LightmapBakeReport Bake(std::vector<MapChunk>& chunks, LightmapBakeSettings const& settings);
+// -----------------------------------------------------------------------------
+private:
+	void  BakeChunks(std::vector<MapChunk>& chunks, int firstChunk, int chunkStride, LightmapBakeReport& report) const;
+	void  BakeQuad(Vertex_PCUTBN* quadVertexes, LightmapBakeReport& report) const;
+	float ComputeAmbientOcclusion(Vec3 const& position, Vec3 const& normal) const;
+	bool  IsVisibleAlongRay(Vec3 const& start, Vec3 const& direction, float distance) const;
+// -----------------------------------------------------------------------------
+	Map const& m_map;
+	LightmapBakeSettings m_settings;
+	std::vector<PointLightInfo> m_staticLights;
+};
@@ -4,57 +4,106 @@
 #include "Game/Player.hpp"
 #include "Game/Ai.h"
 #include "Game/ActorHandle.hpp"
+#include "Game/FactionDefinition.hpp"
 #include "Game/TileDefinition.hpp"
 #include "Game/SpriteAnimationGroup.hpp"
+#include "Game/FrameStats.hpp"
+#include "Game/AssetLoader.hpp"
+#include "Game/AssetResidency.hpp"
+#include "Game/BenchHelpers.hpp"
 #include "Engine/Renderer/Renderer.h"
 #include "Engine/Input/InputSystem.h"
 #include "Engine/Math/MathUtils.h"
 #include "Engine/Core/DebugRender.hpp"
+#include "Engine/Core/DevConsole.hpp"
 #include "Engine/Core/EngineCommon.h"
+#include "Engine/Core/Time.hpp"
+#include <algorithm>
+
+// Reused between calls so collision and sight checks don't allocate each tick
+static ActorList s_sightCandidates;
+
+static constexpr int SKYBOX_NUM_FACES = 6;
+static char const* const SKYBOX_FACE_IMAGE_PATHS[SKYBOX_NUM_FACES] =
+{
+	"Data/Images/stormydays_rt.png",
+	"Data/Images/stormydays_lf.png",
+	"Data/Images/stormydays_bk.png",
+	"Data/Images/stormydays_ft.png",
+	"Data/Images/stormydays_up.png",
+	"Data/Images/stormydays_dn.png",
+};
 
 Map::Map(Game* owner, MapDefinition* definition)
 	:m_game(owner),
 	 m_definition(definition)
 {
-	// Get texture and shader
-	m_dimensions = m_definition->m_image->GetDimensions();
-	m_texture = g_theRenderer->CreateOrGetTextureFromFile("Data/Images/Terrain_8x8.png");
-	m_shader = g_theRenderer->CreateOrGetShader("Data/Shaders/Diffuse", VertexType::VERTEX_PCUTBN);
-	m_spriteSheet = new SpriteSheet(*m_texture, IntVec2(8, 8));
+	// The layout image is only needed to build the tiles
+	m_definition->AcquireAssets();
+	Image* mapImage = g_assetResidency->AcquireImage(m_definition->m_imagePath);
+	m_dimensions = mapImage->GetDimensions();
 
-	// Get skybox textures
-	m_skyBoxFrontTexture = g_theRenderer->CreateOrGetTextureFromFile("Data/Images/stormydays_ft.png");
-	m_skyBoxBackTexture = g_theRenderer->CreateOrGetTextureFromFile("Data/Images/stormydays_bk.png");
-	m_skyBoxLeftTexture = g_theRenderer->CreateOrGetTextureFromFile("Data/Images/stormydays_lf.png");
-	m_skyBoxRightTexture = g_theRenderer->CreateOrGetTextureFromFile("Data/Images/stormydays_rt.png");
-	m_skyBoxTopTexture = g_theRenderer->CreateOrGetTextureFromFile("Data/Images/stormydays_up.png");
-	m_skyBoxBottomTexture = g_theRenderer->CreateOrGetTextureFromFile("Data/Images/stormydays_dn.png");
+	// Texture and shader are the definition's, resident while this map exists
+	m_texture = m_definition->m_spriteSheetTexture;
+	m_shader = m_definition->m_shader;
+	m_spriteSheet = new SpriteSheet(*m_texture, m_definition->m_spriteSheetCellCount);
+
+	// Build the skybox atlas and buffers
+	CreateSkyBox();
 
 	// Initialize Tiles
-	CreateTiles();
+	CreateTiles(*mapImage);
+	g_assetResidency->ReleaseImage(m_definition->m_imagePath);
 
-	// Initialize Geometry
+	// Initialize Geometry, one chunk per light grid cell
+	m_lightGrid.Initialize(m_dimensions, MAP_CHUNK_SIZE);
 	CreateGeometry();
 
+	// Player visibility fields reach as far as any actor can see
+	for (int actorDefIndex = 0; actorDefIndex < static_cast<int>(ActorDefinition::s_actorDefinitions.size()); ++actorDefIndex)
+	{
+		m_maxSightRadius = std::max(m_maxSightRadius, ActorDefinition::s_actorDefinitions[actorDefIndex]->m_sightRadius);
+	}
+
+	m_aiLod.m_settings = AILodSettings::LoadFromConfig();
+	m_crowdSolver.m_settings = CrowdSolverSettings::LoadFromConfig();
+
 	// Spawn Actors
+	m_factionRoster.Initialize(m_allActors);
+	m_actorGrid.Initialize(m_allActors, m_factionRoster, m_dimensions, ACTOR_GRID_TILES_PER_CELL);
 	SpawnInitialActors();
 }
 
 Map::~Map()
 {
-	// Delete the vertexbuffer
-	delete m_vertexBuffer;
-	m_vertexBuffer = nullptr;
+	// Delete the chunk buffers
+	for (int chunkIndex = 0; chunkIndex < static_cast<int>(m_chunks.size()); ++chunkIndex)
+	{
+		delete m_chunks[chunkIndex].m_vertexBuffer;
+		m_chunks[chunkIndex].m_vertexBuffer = nullptr;
 
-	// Delete the indexbuffer
-	delete m_indexBuffer;
-	m_indexBuffer = nullptr;
+		delete m_chunks[chunkIndex].m_indexBuffer;
+		m_chunks[chunkIndex].m_indexBuffer = nullptr;
+	}
+
+	// Delete the skybox buffers
+	delete m_skyBoxVertexBuffer;
+	m_skyBoxVertexBuffer = nullptr;
+
+	delete m_skyBoxIndexBuffer;
+	m_skyBoxIndexBuffer = nullptr;
+
+	// The atlas is built from the face images by this map, so it owns the texture
+	delete m_skyBoxTexture;
+	m_skyBoxTexture = nullptr;
 
 	delete m_spriteSheet;
 	m_spriteSheet = nullptr;
+
+	m_definition->ReleaseAssets();
 }
 
-void Map::CreateTiles()
+void Map::CreateTiles(Image const& mapImage)
 {
 	m_tiles.reserve(m_dimensions.x * m_dimensions.y);
 
@@ -66,7 +115,7 @@ void Map::CreateTiles()
 			Vec3 tileMins = Vec3(static_cast<float>(tileX), static_cast<float>(tileY), 0.f);
 			Vec3 tileMaxs = Vec3(static_cast<float>(tileX) + 1.f, static_cast<float>(tileY) + 1.f, 1.f);
 
-			Rgba8 texColor = m_definition->m_image->GetTexelColor(tileCoords);
+			Rgba8 texColor = mapImage.GetTexelColor(tileCoords);
 			TileDefinition* tileDefColor = TileDefinition::GetByMapColor(texColor);
 			Tile tile = Tile(tileDefColor);
 			tile.m_bounds = AABB3(tileMins, tileMaxs);
@@ -79,16 +128,20 @@ void Map::CreateTiles()
 
 void Map::CreateGeometry()
 {
+	m_chunks.resize(m_lightGrid.GetNumCells());
 	for (int tileIndex = 0; tileIndex < static_cast<int>(m_tiles.size()); ++tileIndex)
 	{
 		TileDefinition const* tileDef = m_tiles[tileIndex].m_tileDef;
+		int tileX = tileIndex % m_dimensions.x;
+		int tileY = tileIndex / m_dimensions.x;
+		MapChunk& chunk = m_chunks[m_lightGrid.GetCellIndex(tileX / MAP_CHUNK_SIZE, tileY / MAP_CHUNK_SIZE)];
 
 		// Floor
 		if (!tileDef->m_isSolid)
 		{
 			IntVec2 floorTileCoords = tileDef->m_floorCoords;
 			AABB2 floorUVs = m_spriteSheet->GetSpriteUVCoords(floorTileCoords);
-			AddGeometryForFloor(m_vertexes, m_indexes, m_tiles[tileIndex].m_bounds, floorUVs);
+			AddGeometryForFloor(chunk.m_vertexes, chunk.m_indexes, m_tiles[tileIndex].m_bounds, floorUVs);
 		}
 
 		// Wall
@@ -96,7 +149,7 @@ void Map::CreateGeometry()
 		{
 			IntVec2 wallTileCoords = tileDef->m_wallCoords;
 			AABB2 wallUVs = m_spriteSheet->GetSpriteUVCoords(wallTileCoords);
-			AddGeometryForWall(m_vertexes, m_indexes, m_tiles[tileIndex].m_bounds, wallUVs);
+			AddGeometryForWall(chunk.m_vertexes, chunk.m_indexes, m_tiles[tileIndex].m_bounds, wallUVs);
 		}
 
 		// Ceiling
@@ -104,11 +157,27 @@ void Map::CreateGeometry()
 		//{
 		//	IntVec2 ceilingTileCoords = tileDef->m_ceilingCoords;
 		//	AABB2 ceilingUVs = m_spriteSheet->GetSpriteUVCoords(ceilingTileCoords);
-		//	AddGeometryForCeiling(m_vertexes, m_indexes, m_tiles[tileIndex].m_bounds, ceilingUVs);
+		//	AddGeometryForCeiling(chunk.m_vertexes, chunk.m_indexes, m_tiles[tileIndex].m_bounds, ceilingUVs);
 		//}
 	}
 
-	// Initialize Buffers
+	// Lights placed by the map that never move are baked with the sun and ambient
+	for (int spawnInfoIndex = 0; spawnInfoIndex < static_cast<int>(m_definition->m_spawningInfo.size()); ++spawnInfoIndex)
+	{
+		SpawnInfo const& spawnInfo = m_definition->m_spawningInfo[spawnInfoIndex];
+		ActorDefinition const* actorDef = spawnInfo.m_actorDef;
+		if (actorDef->HasStaticLight())
+		{
+			PointLightInfo staticLight;
+			staticLight.m_position = spawnInfo.m_position;
+			staticLight.m_radius = actorDef->m_lightRadius;
+			staticLight.m_color = actorDef->m_lightColor;
+			m_staticLights.push_back(staticLight);
+		}
+	}
+
+	// Bake lighting and initialize Buffers
+	BakeLightmap();
 	CreateBuffers();
 }
 
@@ -163,13 +232,146 @@ void Map::AddGeometryForCeiling(std::vector<Vertex_PCUTBN>& vertexes, std::vecto
 	AddVertsForQuad3D(vertexes, indexes, ceilingMinXMaxY, ceilingMaxs, ceilingMaxXMinY, ceilingMins, Rgba8::WHITE, UVs);
 }
 
+void Map::BakeLightmap()
+{
+	LightmapBaker baker(*this);
+	for (int lightIndex = 0; lightIndex < static_cast<int>(m_staticLights.size()); ++lightIndex)
+	{
+		baker.AddStaticLight(m_staticLights[lightIndex]);
+	}
+
+	LightmapBakeSettings settings;
+	settings.m_sunDirection = m_sunDirection;
+	settings.m_sunIntensity = m_sunIntensity;
+	settings.m_ambientIntensity = m_ambientIntensity;
+	m_lightmapReport = baker.Bake(m_chunks, settings);
+
+	float averageOcclusion = (m_lightmapReport.m_numVertexes > 0) ? m_lightmapReport.m_totalOcclusion / static_cast<float>(m_lightmapReport.m_numVertexes) : 0.f;
+	float shadowedPercent = (m_lightmapReport.m_numVertexes > 0) ? 100.f * static_cast<float>(m_lightmapReport.m_numSunShadowedVertexes) / static_cast<float>(m_lightmapReport.m_numVertexes) : 0.f;
+	g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, Stringf("Lightmap %s: %d vertexes in %.2f ms on %d threads, %d static lights",
+		m_definition->m_name.c_str(), m_lightmapReport.m_numVertexes, m_lightmapReport.m_bakeSeconds * 1000.0, m_lightmapReport.m_numThreads, m_lightmapReport.m_numStaticLights));
+	g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, Stringf("Lightmap %s: %.1f%% sun shadowed, average occlusion %.2f, light range %.2f-%.2f",
+		m_definition->m_name.c_str(), shadowedPercent, averageOcclusion, m_lightmapReport.m_minLight, m_lightmapReport.m_maxLight));
+}
+
 void Map::CreateBuffers()
 {
-	m_vertexBuffer = g_theRenderer->CreateVertexBuffer(static_cast<unsigned int>(m_vertexes.size()) * sizeof(Vertex_PCUTBN), sizeof(Vertex_PCUTBN));
-	m_indexBuffer = g_theRenderer->CreateIndexBuffer(static_cast<unsigned int>(m_indexes.size()) * sizeof(unsigned int), sizeof(unsigned int));
+	for (int chunkIndex = 0; chunkIndex < static_cast<int>(m_chunks.size()); ++chunkIndex)
+	{
+		MapChunk& chunk = m_chunks[chunkIndex];
+		if (chunk.m_indexes.empty())
+		{
+			continue;
+		}
+
+		// Rebakes reuse the buffers and only upload the new vertex colors
+		if (chunk.m_vertexBuffer == nullptr)
+		{
+			chunk.m_vertexBuffer = g_theRenderer->CreateVertexBuffer(static_cast<unsigned int>(chunk.m_vertexes.size()) * sizeof(Vertex_PCUTBN), sizeof(Vertex_PCUTBN));
+			chunk.m_indexBuffer = g_theRenderer->CreateIndexBuffer(static_cast<unsigned int>(chunk.m_indexes.size()) * sizeof(unsigned int), sizeof(unsigned int));
+		}
+
+		g_theRenderer->CopyCPUToGPU(chunk.m_vertexes.data(), chunk.m_vertexBuffer->GetSize(), chunk.m_vertexBuffer);
+		g_theRenderer->CopyCPUToGPU(chunk.m_indexes.data(), chunk.m_indexBuffer->GetSize(), chunk.m_indexBuffer);
+	}
+}
+
+// Lets the sky faces decode on loader workers before any map is built
+void Map::QueueSkyBoxImages()
+{
+	for (int faceIndex = 0; faceIndex < SKYBOX_NUM_FACES; ++faceIndex)
+	{
+		g_assetLoader->QueueImageFile(SKYBOX_FACE_IMAGE_PATHS[faceIndex]);
+	}
+}
+
+void Map::CreateSkyBox()
+{
+	// Pack the six faces side by side into one atlas so the whole box is a single draw
+	std::vector<Image*> faceImages;
+	for (int faceIndex = 0; faceIndex < SKYBOX_NUM_FACES; ++faceIndex)
+	{
+		faceImages.push_back(g_assetLoader->TakeImage(SKYBOX_FACE_IMAGE_PATHS[faceIndex]));
+	}
+
+	IntVec2 faceDimensions = faceImages[0]->GetDimensions();
+	Image atlasImage = Image(IntVec2(faceDimensions.x * SKYBOX_NUM_FACES, faceDimensions.y), Rgba8::WHITE);
+	for (int faceIndex = 0; faceIndex < SKYBOX_NUM_FACES; ++faceIndex)
+	{
+		GUARANTEE_OR_DIE(faceImages[faceIndex]->GetDimensions() == faceDimensions, Stringf("Skybox face \"%s\" does not match the size of the other faces", SKYBOX_FACE_IMAGE_PATHS[faceIndex]));
+		for (int texelY = 0; texelY < faceDimensions.y; ++texelY)
+		{
+			for (int texelX = 0; texelX < faceDimensions.x; ++texelX)
+			{
+				Rgba8 texelColor = faceImages[faceIndex]->GetTexelColor(IntVec2(texelX, texelY));
+				atlasImage.SetTexelColor(IntVec2(faceIndex * faceDimensions.x + texelX, texelY), texelColor);
+			}
+		}
+		delete faceImages[faceIndex];
+	}
+	m_skyBoxTexture = g_theRenderer->CreateTextureFromImage(atlasImage);
+
+	// The box is sized from the map, which never changes, so it is built once
+	Vec2 dimensionSize = Vec2(static_cast<float>(m_dimensions.x), static_cast<float>(m_dimensions.y));
+	Vec3 dimensions3D = dimensionSize.GetAsVec3(1.f);
+	AABB3 skyBoxBounds = AABB3(Vec3(-5.f, -5.f, -30.f) * dimensions3D, Vec3(5.f, 5.f, 30.f) * dimensions3D);
+	Vec3 mins = skyBoxBounds.m_mins;
+	Vec3 maxs = skyBoxBounds.m_maxs;
+
+	Vec3 bottomLeftFwd = Vec3(mins.x, maxs.y, mins.z);
+	Vec3 bottomRightFwd = Vec3(mins.x, mins.y, mins.z);
+	Vec3 topRightFwd = Vec3(mins.x, mins.y, maxs.z);
+	Vec3 topLeftFwd = Vec3(mins.x, maxs.y, maxs.z);
+	Vec3 bottomLeftBack = Vec3(maxs.x, maxs.y, mins.z);
+	Vec3 bottomRightBack = Vec3(maxs.x, mins.y, mins.z);
+	Vec3 topRightBack = Vec3(maxs.x, mins.y, maxs.z);
+	Vec3 topLeftBack = Vec3(maxs.x, maxs.y, maxs.z);
 
-	g_theRenderer->CopyCPUToGPU(m_vertexes.data(), m_vertexBuffer->GetSize(), m_vertexBuffer);
-	g_theRenderer->CopyCPUToGPU(m_indexes.data(), m_indexBuffer->GetSize(), m_indexBuffer);
+	// Same face order as the atlas
+	Vec3 faceCorners[SKYBOX_NUM_FACES][4] =
+	{
+		{ bottomLeftFwd, bottomRightFwd, topRightFwd, topLeftFwd },				// FRONT (+X)
+		{ bottomRightBack, bottomLeftBack, topLeftBack, topRightBack },			// BACK (-X)
+		{ bottomLeftBack, bottomLeftFwd, topLeftFwd, topLeftBack },				// LEFT (-Y)
+		{ bottomRightFwd, bottomRightBack, topRightBack, topRightFwd },			// RIGHT (+Y)
+		{ topLeftFwd, topRightFwd, topRightBack, topLeftBack },					// TOP (+Z)
+		{ bottomLeftBack, bottomRightBack, bottomRightFwd, bottomLeftFwd },		// BOTTOM (-Z)
+	};
+
+	// Inset by half a texel so faces don't bleed into their neighbors in the atlas
+	float halfTexelU = 0.5f / static_cast<float>(faceDimensions.x);
+	float halfTexelV = 0.5f / static_cast<float>(faceDimensions.y);
+
+	std::vector<Vertex_PCU> skyBoxVerts;
+	std::vector<unsigned int> skyBoxIndexes;
+	skyBoxVerts.reserve(SKYBOX_NUM_FACES * 4);
+	skyBoxIndexes.reserve(SKYBOX_NUM_FACES * 6);
+	for (int faceIndex = 0; faceIndex < SKYBOX_NUM_FACES; ++faceIndex)
+	{
+		float uMin = (static_cast<float>(faceIndex) + halfTexelU) / static_cast<float>(SKYBOX_NUM_FACES);
+		float uMax = (static_cast<float>(faceIndex + 1) - halfTexelU) / static_cast<float>(SKYBOX_NUM_FACES);
+		float vMin = halfTexelV;
+		float vMax = 1.f - halfTexelV;
+
+		unsigned int firstVert = static_cast<unsigned int>(skyBoxVerts.size());
+		skyBoxVerts.push_back(Vertex_PCU(faceCorners[faceIndex][0], Rgba8::WHITE, Vec2(uMin, vMin)));
+		skyBoxVerts.push_back(Vertex_PCU(faceCorners[faceIndex][1], Rgba8::WHITE, Vec2(uMax, vMin)));
+		skyBoxVerts.push_back(Vertex_PCU(faceCorners[faceIndex][2], Rgba8::WHITE, Vec2(uMax, vMax)));
+		skyBoxVerts.push_back(Vertex_PCU(faceCorners[faceIndex][3], Rgba8::WHITE, Vec2(uMin, vMax)));
+
+		skyBoxIndexes.push_back(firstVert + 0);
+		skyBoxIndexes.push_back(firstVert + 1);
+		skyBoxIndexes.push_back(firstVert + 2);
+		skyBoxIndexes.push_back(firstVert + 0);
+		skyBoxIndexes.push_back(firstVert + 2);
+		skyBoxIndexes.push_back(firstVert + 3);
+	}
+	m_skyBoxIndexCount = static_cast<unsigned int>(skyBoxIndexes.size());
+
+	m_skyBoxVertexBuffer = g_theRenderer->CreateVertexBuffer(static_cast<unsigned int>(skyBoxVerts.size()) * sizeof(Vertex_PCU), sizeof(Vertex_PCU));
+	m_skyBoxIndexBuffer = g_theRenderer->CreateIndexBuffer(m_skyBoxIndexCount * sizeof(unsigned int), sizeof(unsigned int));
+	g_theRenderer->CopyCPUToGPU(skyBoxVerts.data(), m_skyBoxVertexBuffer->GetSize(), m_skyBoxVertexBuffer);
+	g_theRenderer->CopyCPUToGPU(skyBoxIndexes.data(), m_skyBoxIndexBuffer->GetSize(), m_skyBoxIndexBuffer);
 }
 
 void Map::SpawnInitialActors()
@@ -186,6 +388,35 @@ void Map::SpawnInitialActors()
 	}
 }
 
+void Map::ClearActors()
+{
+	DiscardPendingChanges();
+	for (int actorIndex = 0; actorIndex < static_cast<int>(m_allActors.size()); ++actorIndex)
+	{
+		delete m_allActors[actorIndex];
+	}
+	m_allActors.clear();
+	m_spawnPoints.clear();
+	m_lightGrid.Clear();
+	m_actorGrid.Clear();
+	m_factionRoster.Clear();
+	m_timerWheel.Clear(m_simulationSeconds);
+}
+
+// -----------------------------------------------------------------------------
+// Starts a new match on a cached map. Tiles, chunk buffers, the lightmap and
+// the sky never change during play, so only the actors and clock start over.
+// -----------------------------------------------------------------------------
+void Map::ResetSession()
+{
+	ClearActors();
+	m_nextActorUID = 0;
+	m_simulationSeconds = 0.0;
+	m_timerWheel.Clear(m_simulationSeconds);
+	m_aiLod.Reset();
+	SpawnInitialActors();
+}
+
 IntVec2 Map::GetTileCoordsForWorldPos(Vec3 const& worldPos) const
 {
 	int tileX = RoundDownToInt(worldPos.x);
@@ -312,15 +543,7 @@ bool Map::IsInvalidActor(Actor const* actor, Actor* otherActor)
 	{
 		return true;
 	}
-	if (actor->m_actorDef->m_faction == otherActor->m_actorDef->m_faction)
-	{
-		return true;
-	}
-	if (actor->m_actorDef->m_faction == "NEUTRAL" || otherActor->m_actorDef->m_faction == "NEUTRAL")
-	{
-		return true;
-	}
-	return false;
+	return !FactionDefinition::IsHostile(otherActor->m_actorDef->m_factionId, actor->m_actorDef->m_factionId);
 }
 
 bool Map::IsWithinSightRange(Actor* actor, float distanceSquared)
@@ -342,7 +565,25 @@ bool Map::IsActorInFOV(Actor* scout, Actor const* actor)
 	return IsPointInsideDirectedSector2D(actorPosXY, scoutPosXY, forwardXY, scout->m_actorDef->m_sightAngle, scout->m_actorDef->m_sightRadius);
 }
 
+// -----------------------------------------------------------------------------
+// Looking at a player is a lookup of the scout's tile in that player's field.
+// Only walls block the field, other actors standing in between do not.
+// -----------------------------------------------------------------------------
 bool Map::HasLineOfSight(Actor* scout, Actor const* actor)
+{
+	Vec2 scoutPosXY = scout->m_position.GetXY();
+	for (int fieldIndex = 0; fieldIndex < static_cast<int>(m_visibilityFields.size()); ++fieldIndex)
+	{
+		VisibilityField const& field = m_visibilityFields[fieldIndex];
+		if (field.m_sourceHandle == actor->m_actorHandle && field.Covers(scoutPosXY))
+		{
+			return field.IsTileVisible(IntVec2(RoundDownToInt(scoutPosXY.x), RoundDownToInt(scoutPosXY.y)));
+		}
+	}
+	return HasLineOfSightByRaycast(scout, actor);
+}
+
+bool Map::HasLineOfSightByRaycast(Actor* scout, Actor const* actor)
 {
 	Vec3 direction3D = actor->GetEyePosition() - scout->GetEyePosition();
 	direction3D.Normalize();
@@ -357,26 +598,28 @@ bool Map::HasLineOfSight(Actor* scout, Actor const* actor)
 	return result.m_didImpact && IsPointInsideDisc2D(Vec2(result.m_impactPos.x, result.m_impactPos.y), actorPosXY, actor->m_physicsRadius + 0.1f);
 }
 
+// Enemies are every faction hostile to the players, see Actor::IsEnemy
 bool Map::AreAllEnemiesDead() const
 {
-	for (int actorIndex = 0; actorIndex < static_cast<int>(m_allActors.size()); ++actorIndex)
-	{
-		Actor* actor = m_allActors[actorIndex];
-		if (actor && !actor->IsDead() && actor->IsEnemy()) 
-		{
-			return false;
-		}
-	}
-	return true;
+	return m_factionRoster.GetNumAliveHostileTo(FactionDefinition::GetPlayerFactionId()) == 0;
 }
 
 void Map::Update(float deltaSeconds)
 {
+	m_simulationSeconds += static_cast<double>(deltaSeconds);
+	BeginDeferredChanges();
 	UpdateLighting();
+	m_actorGrid.Build(deltaSeconds);
+	UpdateVisibilityFields();
+	m_aiLod.BeginTick(*this);
+	UpdateTimers();
 	UpdateActors(deltaSeconds);
+	FlushPendingSpawns();
 	CollideActors();
 	CollideActorsWithMap();
 	DeleteDestroyedActors();
+	EndDeferredChanges();
+	UpdateLightGrid();
 
 	// Respawning player
 	for (Player* player : m_game->m_players)
@@ -399,6 +642,10 @@ void Map::UpdateLighting()
 	m_sunIntensity = GetClamped(m_sunIntensity, 0.f, 1.f);
 	m_ambientIntensity = GetClamped(m_ambientIntensity, 0.f, 1.f);
 
+	Vec3 previousSunDirection = m_sunDirection;
+	float previousSunIntensity = m_sunIntensity;
+	float previousAmbientIntensity = m_ambientIntensity;
+
 	// Move sun direction x component
 	if (g_theInput->WasKeyJustPressed(KEYCODE_F2))
 	{
@@ -462,83 +709,116 @@ void Map::UpdateLighting()
 		m_ambientIntensity += 0.05f;
 		DebugAddMessage(ambientIntensityMessage, 4.f);
 	}
+
+	// Sun and ambient are baked into the map's vertex colors, so any change needs a rebake
+	if (m_sunDirection != previousSunDirection || m_sunIntensity != previousSunIntensity || m_ambientIntensity != previousAmbientIntensity)
+	{
+		m_sunDirection.Normalize();
+		m_sunIntensity = GetClamped(m_sunIntensity, 0.f, 1.f);
+		m_ambientIntensity = GetClamped(m_ambientIntensity, 0.f, 1.f);
+		BakeLightmap();
+		CreateBuffers();
+	}
 }
 
-void Map::UpdateActors(float deltaSeconds)
+void Map::UpdateLightGrid()
 {
+	m_lightGrid.Clear();
 	for (int actorIndex = 0; actorIndex < static_cast<int>(m_allActors.size()); ++actorIndex)
 	{
-		if (m_allActors[actorIndex] != nullptr)
+		Actor const* actor = m_allActors[actorIndex];
+		if (actor == nullptr || !actor->m_actorDef->m_emitsLight || actor->m_actorDef->HasStaticLight())
 		{
-			m_allActors[actorIndex]->Update(deltaSeconds);
+			continue;
 		}
+
+		PointLightInfo light;
+		light.m_position = actor->m_position;
+		light.m_radius = actor->m_actorDef->m_lightRadius;
+		light.m_color = actor->m_actorDef->m_lightColor;
+		m_lightGrid.AddLight(light);
 	}
+	m_lightGrid.Build();
 }
 
-void Map::CollideActors()
+// Players move before the map updates, so each field is cast from where its player ends up this tick
+void Map::UpdateVisibilityFields()
 {
-	for (int actorAIndex = 0; actorAIndex < static_cast<int>(m_allActors.size()); ++actorAIndex)
+	std::vector<Player*> const& players = m_game->m_players;
+	m_visibilityFields.resize(players.size());
+	for (int playerIndex = 0; playerIndex < static_cast<int>(players.size()); ++playerIndex)
 	{
-		for (int actorBIndex = actorAIndex; actorBIndex < static_cast<int>(m_allActors.size()); ++actorBIndex)
+		Actor const* playerActor = GetActorByHandle(players[playerIndex]->m_currentHandle);
+		if (playerActor == nullptr || playerActor->IsDead())
 		{
-			CollideActors(m_allActors[actorAIndex], m_allActors[actorBIndex]);
+			m_visibilityFields[playerIndex].Invalidate();
+			continue;
 		}
+		m_visibilityFields[playerIndex].Compute(*this, playerActor->m_position.GetXY(), m_maxSightRadius, playerActor->m_actorHandle);
 	}
 }
 
-void Map::CollideActors(Actor* actorA, Actor* actorB)
+// Fired in the order they were scheduled; actors deleted since then are skipped
+void Map::UpdateTimers()
 {
-	if (actorA == nullptr || actorB == nullptr)
+	m_dueTimers.clear();
+	m_timerWheel.Advance(m_simulationSeconds, m_dueTimers);
+	for (int timerIndex = 0; timerIndex < static_cast<int>(m_dueTimers.size()); ++timerIndex)
 	{
-		return;
+		ScheduledTimer const& timer = m_dueTimers[timerIndex];
+		Actor* actor = GetActorByHandle(timer.m_actorHandle);
+		if (actor != nullptr)
+		{
+			actor->OnTimer(timer.m_event, timer.m_dueSeconds);
+		}
 	}
+}
+
+void Map::UpdateActors(float deltaSeconds)
+{
+	// Every moving actor integrates together before any of them thinks or animates
+	m_physicsBatch.Gather(m_allActors);
+	m_physicsBatch.Integrate(deltaSeconds);
+	m_physicsBatch.Scatter();
 
-	if (actorA->m_actorDef->m_actorName == "SpawnPoint" || actorB->m_actorDef->m_actorName == "SpawnPoint")
+	for (int actorIndex = 0; actorIndex < static_cast<int>(m_allActors.size()); ++actorIndex)
 	{
-		return;
+		if (m_allActors[actorIndex] != nullptr && m_allActors[actorIndex]->HasTickWork())
+		{
+			m_allActors[actorIndex]->Update(deltaSeconds);
+		}
 	}
+}
 
-	Vec2 actorAPosXY = actorA->m_position.GetXY();
-	Vec2 actorBPosXY = actorB->m_position.GetXY();
-	float actorAStart = actorA->m_position.z;
-	float actorAEnd = actorA->m_position.z + actorA->GetPhysicsHeight();
-	float actorBStart = actorB->m_position.z;
-	float actorBEnd = actorB->m_position.z + actorB->GetPhysicsHeight();
+// -----------------------------------------------------------------------------
+// The crowd solver separates every overlapping pair together over a few
+// iterations rather than one pair after another, then the collision callbacks
+// run for the pairs that were overlapping, in the order the pairwise pass
+// made them.
+// -----------------------------------------------------------------------------
+void Map::CollideActors()
+{
+	m_actorGrid.Build(0.f);
+	m_crowdSolver.Gather(m_allActors, m_actorGrid);
+	m_crowdSolver.Solve();
+	m_crowdSolver.Scatter(m_allActors);
 
-	if (!DoDiscsOverlap(actorAPosXY, actorA->GetPhysicsRadius(), actorBPosXY, actorB->GetPhysicsRadius()))
+	std::vector<std::pair<int, int>> const& touchingPairs = m_crowdSolver.GetTouchingPairs();
+	for (int pairIndex = 0; pairIndex < static_cast<int>(touchingPairs.size()); ++pairIndex)
 	{
-		return;
+		NotifyActorsCollided(m_allActors[touchingPairs[pairIndex].first], m_allActors[touchingPairs[pairIndex].second]);
 	}
+}
 
-	bool overlappingOnZ = (actorAStart <= actorBEnd && actorAEnd >= actorBStart);
-
-	if (overlappingOnZ)
+void Map::NotifyActorsCollided(Actor* actorA, Actor* actorB)
+{
+	if (actorA->IsMovable())
 	{
-		if (actorA->IsMovable() && !actorB->IsMovable())
-		{
-			PushDiscOutOfDisc2D(actorAPosXY, actorA->GetPhysicsRadius(), actorBPosXY, actorB->GetPhysicsRadius());
-			actorA->m_position.x = actorAPosXY.x;
-			actorA->m_position.y = actorAPosXY.y;
-			actorA->OnCollide(actorB);
-		}
-		else if (!actorA->IsMovable() && actorB->IsMovable())
-		{
-			PushDiscOutOfDisc2D(actorBPosXY, actorB->GetPhysicsRadius(), actorAPosXY, actorA->GetPhysicsRadius());
-			actorB->m_position.x = actorBPosXY.x;
-			actorB->m_position.y = actorBPosXY.y;
-			actorB->OnCollide(actorA);
-		}
-		else if (actorA->IsMovable() && actorB->IsMovable())
-		{
-			PushDiscsOutOfEachOther2D(actorAPosXY, actorA->GetPhysicsRadius(), actorBPosXY, actorB->GetPhysicsRadius());
-			actorA->m_position.x = actorAPosXY.x;
-			actorA->m_position.y = actorAPosXY.y;
-			actorB->m_position.x = actorBPosXY.x;
-			actorB->m_position.y = actorBPosXY.y;
-			actorA->OnCollide(actorB);
-			actorB->OnCollide(actorA);
-
-		}
+		actorA->OnCollide(actorB);
+	}
+	if (actorB->IsMovable())
+	{
+		actorB->OnCollide(actorA);
 	}
 }
 
@@ -578,7 +858,7 @@ void Map::CollideActorsWithMap(Actor* actor)
 		actorPos.z = floorZ;
 		if (actor->m_actorDef->m_dieOnCollide && actor->m_actorDef->m_actorName == "PlasmaProjectile")
 		{
-			actor->m_isDead = true;
+			actor->Die();
 		}
 	}
 
@@ -589,7 +869,7 @@ void Map::CollideActorsWithMap(Actor* actor)
 		actorPos.z = ceilingZ - actorHeight;
 		if (actor->m_actorDef->m_dieOnCollide && actor->m_actorDef->m_actorName == "PlasmaProjectile")
 		{
-			actor->m_isDead = true;
+			actor->Die();
 		}
 	}
 
@@ -602,7 +882,7 @@ void Map::CollideActorsWithMap(Actor* actor)
 			actorPos.y = actorPosXY.y;
 			if (actor->m_actorDef->m_dieOnCollide && actor->m_actorDef->m_actorName == "PlasmaProjectile")
 			{
-				actor->m_isDead = true;
+				actor->Die();
 			}
 		}
 	}
@@ -616,7 +896,7 @@ void Map::CollideActorsWithMap(Actor* actor)
 			actorPos.y = actorPosXY.y;
 			if (actor->m_actorDef->m_dieOnCollide && actor->m_actorDef->m_actorName == "PlasmaProjectile")
 			{
-				actor->m_isDead = true;
+				actor->Die();
 			}
 		}
 	}
@@ -630,7 +910,7 @@ void Map::CollideActorsWithMap(Actor* actor)
 			actorPos.y = actorPosXY.y;
 			if (actor->m_actorDef->m_dieOnCollide && actor->m_actorDef->m_actorName == "PlasmaProjectile")
 			{
-				actor->m_isDead = true;
+				actor->Die();
 			}
 		}
 	}
@@ -644,7 +924,7 @@ void Map::CollideActorsWithMap(Actor* actor)
 			actorPos.y = actorPosXY.y;
 			if (actor->m_actorDef->m_dieOnCollide && actor->m_actorDef->m_actorName == "PlasmaProjectile")
 			{
-				actor->m_isDead = true;
+				actor->Die();
 			}
 		}
 	}
@@ -690,17 +970,22 @@ void Map::CollideActorsWithMap(Actor* actor)
 	}
 }
 
+// Only the actors destroyed since the last sync point are visited, spawns go
+// in first so an actor built and destroyed in the same tick is found
 void Map::DeleteDestroyedActors()
 {
-	for (int actorIndex = 0; actorIndex < static_cast<int>(m_allActors.size()); ++actorIndex)
+	FlushPendingSpawns();
+	for (int destroyIndex = 0; destroyIndex < static_cast<int>(m_pendingDestroys.size()); ++destroyIndex)
 	{
-		Actor*& actor = m_allActors[actorIndex];
-		if (actor != nullptr && actor->IsDestroyed())
+		Actor* actor = GetActorByHandle(m_pendingDestroys[destroyIndex]);
+		if (actor != nullptr)
 		{
+			m_factionRoster.RemoveActor(*actor);
+			m_allActors[actor->m_actorHandle.GetIndex()] = nullptr;
 			delete actor;
-			actor = nullptr;
 		}
 	}
+	m_pendingDestroys.clear();
 }
 
 void Map::Render(Player const* facingPlayer) const
@@ -712,62 +997,15 @@ void Map::Render(Player const* facingPlayer) const
 
 void Map::RenderSkyBox() const
 {
-	Vec2 dimensionSize = Vec2(static_cast<float>(m_dimensions.x), static_cast<float>(m_dimensions.y));
-	Vec3 dimensions3D = dimensionSize.GetAsVec3(1.f);
-	//Vec3 dimensions3D = m_game->m_players[0]->m_position;
-	AABB3 skyBoxBounds = AABB3(Vec3(-5.f, -5.f, -30.f) * dimensions3D, Vec3(5.f, 5.f, 30.f) * dimensions3D);
-	Vec3 mins = skyBoxBounds.m_mins;
-	Vec3 maxs = skyBoxBounds.m_maxs;
-
-	Vec3 bottomLeftFwd = Vec3(mins.x, maxs.y, mins.z);
-	Vec3 bottomRightFwd = Vec3(mins.x, mins.y, mins.z);
-	Vec3 topRightFwd = Vec3(mins.x, mins.y, maxs.z);
-	Vec3 topLeftFwd = Vec3(mins.x, maxs.y, maxs.z);
-	Vec3 bottomLeftBack = Vec3(maxs.x, maxs.y, mins.z);
-	Vec3 bottomRightBack = Vec3(maxs.x, mins.y, mins.z);
-	Vec3 topRightBack = Vec3(maxs.x, mins.y, maxs.z);
-	Vec3 topLeftBack = Vec3(maxs.x, maxs.y, maxs.z);
-
+	// Drawn first with depth off, so the box never occludes the map and always reads as infinitely far away
+	g_theRenderer->SetModelConstants();
 	g_theRenderer->SetBlendMode(BlendMode::ALPHA);
 	g_theRenderer->SetRasterizerMode(RasterizerMode::SOLID_CULL_NONE);
-	g_theRenderer->SetDepthMode(DepthMode::READ_WRITE_LESS_EQUAL);
+	g_theRenderer->SetDepthMode(DepthMode::DISABLED);
 	g_theRenderer->BindShader(nullptr);
-
-	// FRONT (+X)
-	std::vector<Vertex_PCU> frontVerts;
-	AddVertsForQuad3D(frontVerts, bottomLeftFwd, bottomRightFwd, topRightFwd, topLeftFwd);
-	g_theRenderer->BindTexture(m_skyBoxRightTexture);
-	g_theRenderer->DrawVertexArray(frontVerts);
-
-	// BACK (-X)
-	std::vector<Vertex_PCU> backVerts;
-	AddVertsForQuad3D(backVerts, bottomRightBack, bottomLeftBack, topLeftBack, topRightBack);
-	g_theRenderer->BindTexture(m_skyBoxLeftTexture);
-	g_theRenderer->DrawVertexArray(backVerts);
-
-	// LEFT (-Y)
-	std::vector<Vertex_PCU> leftVerts;
-	AddVertsForQuad3D(leftVerts, bottomLeftBack, bottomLeftFwd, topLeftFwd, topLeftBack);
-	g_theRenderer->BindTexture(m_skyBoxBackTexture);
-	g_theRenderer->DrawVertexArray(leftVerts);
-
-	// RIGHT (+Y)
-	std::vector<Vertex_PCU> rightVerts;
-	AddVertsForQuad3D(rightVerts, bottomRightFwd, bottomRightBack, topRightBack, topRightFwd);
-	g_theRenderer->BindTexture(m_skyBoxFrontTexture);
-	g_theRenderer->DrawVertexArray(rightVerts);
-
-	// TOP (+Z)
-	std::vector<Vertex_PCU> topVerts;
-	AddVertsForQuad3D(topVerts, topLeftFwd, topRightFwd, topRightBack, topLeftBack);
-	g_theRenderer->BindTexture(m_skyBoxTopTexture);
-	g_theRenderer->DrawVertexArray(topVerts);
-
-	// BOTTOM (-Z)
-	std::vector<Vertex_PCU> bottomVerts;
-	AddVertsForQuad3D(bottomVerts, bottomLeftBack, bottomRightBack, bottomRightFwd, bottomLeftFwd);
-	g_theRenderer->BindTexture(m_skyBoxBottomTexture);
-	g_theRenderer->DrawVertexArray(bottomVerts);
+	g_theRenderer->BindTexture(m_skyBoxTexture);
+	g_theRenderer->DrawIndexedVertexBuffer(m_skyBoxVertexBuffer, m_skyBoxIndexBuffer, m_skyBoxIndexCount);
+	FrameStats::AddDrawCall();
 }
 
 void Map::RenderMap() const
@@ -778,36 +1016,40 @@ void Map::RenderMap() const
 	lightingConstants.m_sunIntensity = m_sunIntensity;
 	lightingConstants.NumPointLights = 0;
 
-	ActorDefinition const* plasmaDef = ActorDefinition::GetByActorName("PlasmaProjectile");
-	for (int actorIndex = 0; actorIndex < static_cast<int>(m_allActors.size()); ++actorIndex)
+	g_theRenderer->SetModelConstants();
+	g_theRenderer->SetBlendMode(BlendMode::OPAQUE);
+	g_theRenderer->SetRasterizerMode(RasterizerMode::SOLID_CULL_BACK);
+	g_theRenderer->SetDepthMode(DepthMode::READ_WRITE_LESS_EQUAL);
+	g_theRenderer->BindTexture(m_texture);
+	g_theRenderer->BindShader(m_shader);
+
+	// Each chunk only gets the lights its light grid cell overlaps
+	for (int chunkIndex = 0; chunkIndex < static_cast<int>(m_chunks.size()); ++chunkIndex)
 	{
-		if (m_allActors[actorIndex] == nullptr)
+		MapChunk const& chunk = m_chunks[chunkIndex];
+		if (chunk.m_indexBuffer == nullptr)
 		{
 			continue;
 		}
-		if (m_allActors[actorIndex]->m_actorDef != plasmaDef)
+
+		int numLightsInCell = m_lightGrid.GetNumLightsInCell(chunkIndex);
+		if (numLightsInCell > MAX_POINTLIGHTS)
 		{
-			continue;
+			FrameStats::AddOverflowingLightChunk(numLightsInCell - MAX_POINTLIGHTS);
 		}
-		Vec4 actorPosAsVec4 = Vec4(m_allActors[actorIndex]->m_position.x, m_allActors[actorIndex]->m_position.y, m_allActors[actorIndex]->m_position.z, 1.f);
-		lightingConstants.PointLights[lightingConstants.NumPointLights].Position = actorPosAsVec4;
-		Rgba8 lightColor = Rgba8::SAPPHIRE;
-		lightColor.GetAsFloats(lightingConstants.PointLights[lightingConstants.NumPointLights].Color);
-		lightingConstants.NumPointLights += 1;
-		if (lightingConstants.NumPointLights >= MAX_POINTLIGHTS)
+		lightingConstants.NumPointLights = (numLightsInCell < MAX_POINTLIGHTS) ? numLightsInCell : MAX_POINTLIGHTS;
+		for (int lightNum = 0; lightNum < lightingConstants.NumPointLights; ++lightNum)
 		{
-			break;
+			PointLightInfo const& light = m_lightGrid.GetLight(m_lightGrid.GetLightIndexInCell(chunkIndex, lightNum));
+			lightingConstants.PointLights[lightNum].Position = Vec4(light.m_position.x, light.m_position.y, light.m_position.z, light.m_radius);
+			Rgba8 lightColor = light.m_color;
+			lightColor.GetAsFloats(lightingConstants.PointLights[lightNum].Color);
 		}
-	}
 
-	g_theRenderer->SetLightingConstants(lightingConstants);
-	g_theRenderer->SetModelConstants();
-	g_theRenderer->SetBlendMode(BlendMode::OPAQUE);
-	g_theRenderer->SetRasterizerMode(RasterizerMode::SOLID_CULL_BACK);
-	g_theRenderer->SetDepthMode(DepthMode::READ_WRITE_LESS_EQUAL);
-	g_theRenderer->BindTexture(m_texture);
-	g_theRenderer->BindShader(m_shader);
-	g_theRenderer->DrawIndexedVertexBuffer(m_vertexBuffer, m_indexBuffer, static_cast<unsigned int>(m_indexes.size()));
+		g_theRenderer->SetLightingConstants(lightingConstants);
+		g_theRenderer->DrawIndexedVertexBuffer(chunk.m_vertexBuffer, chunk.m_indexBuffer, static_cast<unsigned int>(chunk.m_indexes.size()));
+		FrameStats::AddDrawCall();
+	}
 }
 
 void Map::RenderActors(Player const* facingPlayer) const
@@ -839,7 +1081,7 @@ Actor* Map::SpawnPlayer(Player* playerActor)
 	if (spawnPoint)
 	{
 		SpawnInfo spawnInfo;
-		spawnInfo.m_actorName = "Marine";
+		spawnInfo.m_actorDef = ActorDefinition::GetByActorName("Marine");
 		spawnInfo.m_position = spawnPoint->m_position;
 		spawnInfo.m_orientation = spawnPoint->m_orientation;
 
@@ -851,11 +1093,36 @@ Actor* Map::SpawnPlayer(Player* playerActor)
 	return nullptr;
 }
 
+// -----------------------------------------------------------------------------
+// The actor is built straight away so the caller can set it up, but while the
+// map updates it only joins m_allActors at the next sync point. Indexes are
+// handed out past the pending spawns, so the flush appends them all at once.
+// -----------------------------------------------------------------------------
 Actor* Map::SpawnActor(SpawnInfo const& spawnInfo)
 {
-	ActorHandle handle(m_nextActorUID++, static_cast<unsigned int>(m_allActors.size()));
+	unsigned int actorIndex = static_cast<unsigned int>(m_allActors.size() + m_pendingSpawns.size());
+	ActorHandle handle(m_nextActorUID++, actorIndex);
+	Actor* actor = new Actor(this, spawnInfo, handle);
+	m_pendingSpawns.push_back(actor);
+	if (!m_isDeferringChanges)
+	{
+		FlushPendingSpawns();
+	}
+	return actor;
+}
+
+// Creates the actor in the slot its handle names, which must already exist
+Actor* Map::PlaceActor(SpawnInfo const& spawnInfo, ActorHandle handle)
+{
 	Actor* actor = new Actor(this, spawnInfo, handle);
-	m_allActors.push_back(actor);
+	InsertActor(actor);
+	return actor;
+}
+
+void Map::InsertActor(Actor* actor)
+{
+	m_allActors[actor->m_actorHandle.GetIndex()] = actor;
+	m_factionRoster.AddActor(*actor);
 
 	if (actor->m_actorDef->m_isAIEnabled)
 	{
@@ -863,8 +1130,69 @@ Actor* Map::SpawnActor(SpawnInfo const& spawnInfo)
 		actor->m_controller = actor->m_aiController;
 		actor->m_controller->Possess(actor->m_actorHandle);
 	}
-	
-	return actor;
+}
+
+// Puts every time the actor is waiting for on the wheel, used when it first
+// appears and when a saved state brings it back
+void Map::ScheduleActorTimers(Actor const& actor)
+{
+	if (actor.m_removeSeconds >= 0.0)
+	{
+		m_timerWheel.Schedule(actor.m_removeSeconds, actor.m_actorHandle, TimerEvent::REMOVE_CORPSE);
+	}
+	if (actor.m_nextSpawnSeconds >= 0.0)
+	{
+		m_timerWheel.Schedule(actor.m_nextSpawnSeconds, actor.m_actorHandle, TimerEvent::SPAWN_ENEMY);
+	}
+	if (actor.m_isSlowed && actor.m_slowEndSeconds >= 0.0)
+	{
+		m_timerWheel.Schedule(actor.m_slowEndSeconds, actor.m_actorHandle, TimerEvent::END_SLOW);
+	}
+}
+
+void Map::BeginDeferredChanges()
+{
+	m_isDeferringChanges = true;
+}
+
+void Map::EndDeferredChanges()
+{
+	m_isDeferringChanges = false;
+	FlushPendingSpawns();
+}
+
+// One resize for the whole batch, then each actor takes the slot its handle names
+void Map::FlushPendingSpawns()
+{
+	if (m_pendingSpawns.empty())
+	{
+		return;
+	}
+
+	m_allActors.resize(m_allActors.size() + m_pendingSpawns.size(), nullptr);
+	for (int spawnIndex = 0; spawnIndex < static_cast<int>(m_pendingSpawns.size()); ++spawnIndex)
+	{
+		Actor* actor = m_pendingSpawns[spawnIndex];
+		InsertActor(actor);
+		ScheduleActorTimers(*actor);
+	}
+	m_pendingSpawns.clear();
+}
+
+void Map::QueueDestroy(ActorHandle handle)
+{
+	m_pendingDestroys.push_back(handle);
+}
+
+// For when the actor list is about to be replaced wholesale
+void Map::DiscardPendingChanges()
+{
+	for (int spawnIndex = 0; spawnIndex < static_cast<int>(m_pendingSpawns.size()); ++spawnIndex)
+	{
+		delete m_pendingSpawns[spawnIndex];
+	}
+	m_pendingSpawns.clear();
+	m_pendingDestroys.clear();
 }
 
 Actor* Map::GetActorByHandle(ActorHandle handle) const
@@ -898,48 +1226,49 @@ Actor* Map::GetActorByHandle(ActorHandle handle) const
 	}
 }
 
+// Enemies in the sight sector are tried nearest first, so usually only one line of sight raycast is needed
 Actor const* Map::GetClosestVisibleEnemy(Actor* chasingActor)
 {
-	float closestDist = 999999.f;
-	Actor const* chasedActor = nullptr;
+	Vec3 forward, left, up;
+	chasingActor->m_orientation.GetAsVectors_IFwd_JLeft_KUp(forward, left, up);
+	Vec2 chasingActorPosXY = chasingActor->m_position.GetXY();
 
-	for (int actorIndex = 0; actorIndex < static_cast<int>(m_allActors.size()); ++actorIndex)
-	{
-		Actor*& actor = m_allActors[actorIndex];
-		if (IsInvalidActor(actor, chasingActor))
-		{
-			continue;
-		}
+	ActorQueryFilter filter;
+	filter.m_ignoreActor = chasingActor;
+	filter.m_hostileTo = chasingActor;
+	ActorList& inSight = s_sightCandidates;
+	QueryActorsInSector(chasingActorPosXY, forward.GetXY(), chasingActor->m_actorDef->m_sightAngle, chasingActor->m_actorDef->m_sightRadius, filter, inSight);
 
-		Vec2 actorPosXY = actor->m_position.GetXY();
-		Vec2 chasingActorPosXY = chasingActor->m_position.GetXY();
-		float distSquared = GetDistanceSquared2D(actorPosXY, chasingActorPosXY);
+	std::sort(inSight.begin(), inSight.end(), [&chasingActorPosXY](Actor const* actorA, Actor const* actorB)
+	{
+		float distSquaredA = GetDistanceSquared2D(actorA->m_position.GetXY(), chasingActorPosXY);
+		float distSquaredB = GetDistanceSquared2D(actorB->m_position.GetXY(), chasingActorPosXY);
+		return (distSquaredA != distSquaredB) ? distSquaredA < distSquaredB : actorA->m_actorHandle.GetIndex() < actorB->m_actorHandle.GetIndex();
+	});
 
-		// Check if enemy is within range to move
-		if (!IsWithinSightRange(chasingActor, distSquared))
+	for (int actorIndex = 0; actorIndex < static_cast<int>(inSight.size()); ++actorIndex)
+	{
+		if (HasLineOfSight(chasingActor, inSight[actorIndex]))
 		{
-			continue;
+			return inSight[actorIndex];
 		}
+	}
+	return nullptr;
+}
 
-		// Check if enemy is within our visible arc
-		if (!IsActorInFOV(chasingActor, actor))
-		{
-			continue;
-		}
+void Map::QueryActorsInDisc(Vec2 const& center, float radius, ActorQueryFilter const& filter, ActorList& outActors) const
+{
+	m_actorGrid.QueryDisc(center, radius, filter, outActors);
+}
 
-		// Check if enemy is in our line of sight
-		if (!HasLineOfSight(chasingActor, actor))
-		{
-			continue;
-		}
+void Map::QueryActorsInSector(Vec2 const& center, Vec2 const& forward, float apertureDegrees, float radius, ActorQueryFilter const& filter, ActorList& outActors) const
+{
+	m_actorGrid.QuerySector(center, forward, apertureDegrees, radius, filter, outActors);
+}
 
-		if (distSquared < closestDist)
-		{
-			closestDist = distSquared;
-			chasedActor = actor;
-		}
-	}
-	return chasedActor;
+void Map::QueryKNearest(Vec2 const& center, int numNearest, float maxRadius, ActorQueryFilter const& filter, ActorList& outActors) const
+{
+	m_actorGrid.QueryKNearest(center, numNearest, maxRadius, filter, outActors);
 }
 
 void Map::DebugPossessNext()
@@ -1253,3 +1582,111 @@ RaycastResult3D Map::RaycastWorldActors(Actor const* ownerOfRaycast, ActorHandle
 	}
 	return raycastResult;
 }
+
+// -----------------------------------------------------------------------------
+// Dev console: SpawnStressTest count=<count>
+// Spawns the whole count inside one deferred tick the way actors spawn while
+// the map updates, runs a tick with them, then destroys them all, and does the
+// same spawn again one actor at a time. Checks every handle resolves to the
+// actor it was given for and prints the time for each step. The map and
+// player lives are restored afterwards.
+// -----------------------------------------------------------------------------
+static int CountUnresolvedHandles(Map const& map, std::vector<Actor*> const& actors, bool shouldResolve)
+{
+	int numUnresolved = 0;
+	for (int actorIndex = 0; actorIndex < static_cast<int>(actors.size()); ++actorIndex)
+	{
+		ActorHandle handle = actors[actorIndex]->m_actorHandle;
+		bool doesResolve = map.GetActorByHandle(handle) == actors[actorIndex] && actors[actorIndex]->m_factionSlot >= 0;
+		numUnresolved += (doesResolve == shouldResolve) ? 0 : 1;
+	}
+	return numUnresolved;
+}
+
+bool Map::Command_SpawnStressTest(EventArgs& args)
+{
+	Map* map = g_theGame->m_defaultMap;
+	if (g_theGame->m_currentState != GameState::PLAYING || map == nullptr)
+	{
+		g_theDevConsole->AddLine(Rgba8::RED, "SpawnStressTest needs a game in progress");
+		return false;
+	}
+
+	int numSpawns = args.GetValue("count", 10000);
+	int maxActors = (static_cast<int>(ActorHandle::MAX_ACTOR_INDEX) - static_cast<int>(map->m_allActors.size())) / 2;
+	numSpawns = (numSpawns < 1) ? 1 : ((numSpawns > maxActors) ? maxActors : numSpawns);
+
+	std::vector<IntVec2> openTiles;
+	if (!GatherOpenTiles(*map, "SpawnStressTest", openTiles))
+	{
+		return false;
+	}
+
+	BenchMapScope benchScope(*map);
+	std::vector<SpawnInfo> spawnInfos;
+	spawnInfos.reserve(numSpawns);
+	for (int spawnIndex = 0; spawnIndex < numSpawns; ++spawnIndex)
+	{
+		IntVec2 tileCoords = RollOpenTile(openTiles);
+
+		SpawnInfo spawnInfo;
+		spawnInfo.m_actorDef = ActorDefinition::GetByActorName("Demon");
+		spawnInfo.m_position = Vec3(static_cast<float>(tileCoords.x) + 0.5f, static_cast<float>(tileCoords.y) + 0.5f, 0.f);
+		spawnInfos.push_back(spawnInfo);
+	}
+
+	// All in one tick, joined at a single sync point
+	std::vector<Actor*> actors;
+	actors.reserve(numSpawns);
+	map->BeginDeferredChanges();
+	double queueStart = GetCurrentTimeSeconds();
+	for (int spawnIndex = 0; spawnIndex < numSpawns; ++spawnIndex)
+	{
+		actors.push_back(map->SpawnActor(spawnInfos[spawnIndex]));
+	}
+	double flushStart = GetCurrentTimeSeconds();
+	map->EndDeferredChanges();
+	double flushEnd = GetCurrentTimeSeconds();
+	int numUnresolved = CountUnresolvedHandles(*map, actors, true);
+
+	double tickStart = GetCurrentTimeSeconds();
+	map->Update(1.f / 60.f);
+	double tickSeconds = GetCurrentTimeSeconds() - tickStart;
+
+	double destroyStart = GetCurrentTimeSeconds();
+	for (int actorIndex = 0; actorIndex < static_cast<int>(actors.size()); ++actorIndex)
+	{
+		actors[actorIndex]->Destroy();
+	}
+	std::vector<ActorHandle> destroyedHandles;
+	for (Actor const* actor : actors)
+	{
+		destroyedHandles.push_back(actor->m_actorHandle);
+	}
+	map->DeleteDestroyedActors();
+	double destroySeconds = GetCurrentTimeSeconds() - destroyStart;
+	int numLingering = 0;
+	for (ActorHandle const& handle : destroyedHandles)
+	{
+		numLingering += (map->GetActorByHandle(handle) != nullptr) ? 1 : 0;
+	}
+
+	// Outside the update each spawn joins on its own
+	actors.clear();
+	double immediateStart = GetCurrentTimeSeconds();
+	for (int spawnIndex = 0; spawnIndex < numSpawns; ++spawnIndex)
+	{
+		actors.push_back(map->SpawnActor(spawnInfos[spawnIndex]));
+	}
+	double immediateSeconds = GetCurrentTimeSeconds() - immediateStart;
+	numUnresolved += CountUnresolvedHandles(*map, actors, true);
+
+	double spawnCount = static_cast<double>(numSpawns);
+	double queueSeconds = flushStart - queueStart;
+	double flushSeconds = flushEnd - flushStart;
+	g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, Stringf("%d spawns in one tick: queued %.3f ms + flushed %.3f ms (%.2f us each), one at a time %.3f ms (%.2f us each)",
+		numSpawns, queueSeconds * 1000.0, flushSeconds * 1000.0, ((queueSeconds + flushSeconds) * 1000000.0) / spawnCount, immediateSeconds * 1000.0, (immediateSeconds * 1000000.0) / spawnCount));
+	g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, Stringf("  tick with them %.3f ms, destroying them %.3f ms, %d actor slabs", tickSeconds * 1000.0, destroySeconds * 1000.0, Actor::GetNumSlabs()));
+	g_theDevConsole->AddLine((numUnresolved + numLingering == 0) ? Rgba8::LIGHTYELLOW : Rgba8::RED, Stringf("  %d handles failed to resolve, %d destroyed actors lingered", numUnresolved, numLingering));
+	return true;
+}
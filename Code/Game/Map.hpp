@@ -1,6 +1,15 @@
 #pragma once
 #include "Game/Tile.hpp"
+#include "Game/ActorGrid.hpp"
+#include "Game/FactionRoster.hpp"
+#include "Game/VisibilityField.hpp"
+#include "Game/AILevelOfDetail.hpp"
+#include "Game/TimerWheel.hpp"
+#include "Game/PhysicsBatch.hpp"
+#include "Game/CrowdSolver.hpp"
 #include "Game/MapDefinition.hpp"
+#include "Game/LightGrid.hpp"
+#include "Game/LightmapBaker.hpp"
 #include "Engine/Core/Vertex_PCUTBN.hpp"
 #include "Engine/Math/IntVec2.h"
 #include "Engine/Math/RaycastUtils.hpp"
@@ -16,8 +25,15 @@ class VertexBuffer;
 class IndexBuffer;
 class SpriteSheet;
 // -----------------------------------------------------------------------------
-//------------------------------------------------------------------------------
-typedef std::vector<Actor*> ActorList;
+constexpr int MAP_CHUNK_SIZE = 8;
+// -----------------------------------------------------------------------------
+struct MapChunk
+{
+	std::vector<Vertex_PCUTBN> m_vertexes;
+	std::vector<unsigned int> m_indexes;
+	VertexBuffer* m_vertexBuffer = nullptr;
+	IndexBuffer* m_indexBuffer = nullptr;
+};
 // -----------------------------------------------------------------------------
 class Map
 {
@@ -25,13 +41,18 @@ public:
 	Map(Game* owner, MapDefinition* definition);
 	~Map();
 
-	void CreateTiles();
+	void CreateTiles(Image const& mapImage);
 	void CreateGeometry();
 	void AddGeometryForWall(std::vector<Vertex_PCUTBN>& vertexes, std::vector<unsigned int>& indexes, AABB3 const& bounds, AABB2 const& UVs) const;
 	void AddGeometryForFloor(std::vector<Vertex_PCUTBN>& vertexes, std::vector<unsigned int>& indexes, AABB3 const& bounds, AABB2 const& UVs) const;
 	void AddGeometryForCeiling(std::vector<Vertex_PCUTBN>& vertexes, std::vector<unsigned int>& indexes, AABB3 const& bounds, AABB2 const& UVs) const;
+	void BakeLightmap();
 	void CreateBuffers();
+	void CreateSkyBox();
+	static void QueueSkyBoxImages();
 	void SpawnInitialActors();
+	void ClearActors();
+	void ResetSession();
 
 	IntVec2 GetTileCoordsForWorldPos(Vec3 const& worldPos) const;
 	AABB2 GetTileBounds(int tileX, int tileY) const;
@@ -53,13 +74,17 @@ public:
 	bool IsWithinSightRange(Actor* actor, float distanceSquared);
 	bool IsActorInFOV(Actor* scout, Actor const* actor);
 	bool HasLineOfSight(Actor* scout , Actor const* actor);
+	bool HasLineOfSightByRaycast(Actor* scout, Actor const* actor);
 	bool AreAllEnemiesDead() const;
 
 	void Update(float deltaSeconds);
 	void UpdateLighting();
+	void UpdateLightGrid();
+	void UpdateVisibilityFields();
+	void UpdateTimers();
 	void UpdateActors(float deltaSeconds);
 	void CollideActors();
-	void CollideActors(Actor* actorA, Actor* actorB);
+	void NotifyActorsCollided(Actor* actorA, Actor* actorB);
 	void CollideActorsWithMap();
 	void CollideActorsWithMap(Actor* actor);
 	void DeleteDestroyedActors();
@@ -71,8 +96,24 @@ public:
 
 	Actor* SpawnPlayer(Player* playerActor);
 	Actor* SpawnActor(SpawnInfo const& spawnInfo);
+	Actor* PlaceActor(SpawnInfo const& spawnInfo, ActorHandle handle);
+	void   ScheduleActorTimers(Actor const& actor);
+	void   InsertActor(Actor* actor);
+
+	// Spawns and deletions asked for while the map updates wait for its sync points
+	void BeginDeferredChanges();
+	void EndDeferredChanges();
+	void FlushPendingSpawns();
+	void QueueDestroy(ActorHandle handle);
+	void DiscardPendingChanges();
+	static bool Command_SpawnStressTest(EventArgs& args);
 	Actor* GetActorByHandle(ActorHandle handle) const;
 	Actor const* GetClosestVisibleEnemy(Actor* actor);
+
+	// Spatial queries, each replaces the contents of outActors
+	void QueryActorsInDisc(Vec2 const& center, float radius, ActorQueryFilter const& filter, ActorList& outActors) const;
+	void QueryActorsInSector(Vec2 const& center, Vec2 const& forward, float apertureDegrees, float radius, ActorQueryFilter const& filter, ActorList& outActors) const;
+	void QueryKNearest(Vec2 const& center, int numNearest, float maxRadius, ActorQueryFilter const& filter, ActorList& outActors) const;
 	void   DebugPossessNext();
 
 	RaycastResult3D RaycastAll(Vec3 const& start, Vec3 const& direction, float distance) const;
@@ -92,13 +133,13 @@ public:
 	IntVec2 m_dimensions;
 
 	// Rendering
-	std::vector<Vertex_PCUTBN> m_vertexes;
-	std::vector<unsigned int> m_indexes;
+	std::vector<MapChunk> m_chunks;
 	Texture* m_texture = nullptr;
 	SpriteSheet* m_spriteSheet = nullptr;
 	Shader* m_shader = nullptr;	
-	VertexBuffer* m_vertexBuffer = nullptr;
-	IndexBuffer* m_indexBuffer = nullptr;
+	LightGrid m_lightGrid;
+	std::vector<PointLightInfo> m_staticLights;
+	LightmapBakeReport m_lightmapReport;
 	Vec3 m_sunDirection = Vec3(2.f, 1.f, -1.f);
 	float m_sunIntensity = 0.35f;
 	float m_ambientIntensity = 0.25f;
@@ -106,13 +147,26 @@ public:
 	// Actors
 	ActorList m_allActors;
 	ActorList m_spawnPoints;
+	ActorGrid m_actorGrid;
+	FactionRoster m_factionRoster;
+	std::vector<VisibilityField> m_visibilityFields;	// One per player, cast from the actor they possess
+	float m_maxSightRadius = 0.f;
+	AILevelOfDetail m_aiLod;
+	TimerWheel m_timerWheel;
+	std::vector<ScheduledTimer> m_dueTimers;
+	PhysicsBatch m_physicsBatch;
+	CrowdSolver m_crowdSolver;
+	std::vector<Actor*> m_pendingSpawns;		// Built but not yet in m_allActors, in handle index order
+	std::vector<ActorHandle> m_pendingDestroys;
+	bool m_isDeferringChanges = false;
 	unsigned int m_nextActorUID = 0;
 
+	// Simulation time, advanced only by Map::Update so replays see the same clock
+	double m_simulationSeconds = 0.0;
+
 	// Skybox
-	Texture* m_skyBoxFrontTexture = nullptr;
-	Texture* m_skyBoxBackTexture = nullptr;
-	Texture* m_skyBoxLeftTexture = nullptr;
-	Texture* m_skyBoxRightTexture = nullptr;
-	Texture* m_skyBoxTopTexture = nullptr;
-	Texture* m_skyBoxBottomTexture = nullptr;
+	Texture* m_skyBoxTexture = nullptr;
+	VertexBuffer* m_skyBoxVertexBuffer = nullptr;
+	IndexBuffer* m_skyBoxIndexBuffer = nullptr;
+	unsigned int m_skyBoxIndexCount = 0;
 };
\ No newline at end of file
@@ -1,36 +1,30 @@
 #include "Game/MapDefinition.hpp"
 #include "Game/GameCommon.h"
+#include "Game/ActorDefinition.hpp"
+#include "Game/AssetResidency.hpp"
+#include "Game/ShaderRegistry.hpp"
 #include "Engine/Renderer/Renderer.h"
 #include "Engine/Core/ErrorWarningAssert.hpp"
 
 std::vector<MapDefinition*> MapDefinition::s_mapDefinitions;
 
+MapDefinition::MapDefinition()
+{
+}
+
 MapDefinition::MapDefinition(XmlElement const& mapDefElement)
 {
 	// Parsing name
 	m_name = ParseXmlAttribute(mapDefElement, "name", m_name);
 
 	// Parsing image
-	std::string imageName;
-	//m_image = ParseXmlAttribute(mapDefElement, "image", imageName).c_str();
-	imageName = ParseXmlAttribute(mapDefElement, "image", imageName);
-	m_image = new Image(imageName.c_str());
+	m_imagePath = ParseXmlAttribute(mapDefElement, "image", m_imagePath);
 
 	// Parsing shader
-	std::string shaderName;
-	shaderName = ParseXmlAttribute(mapDefElement, "shader", imageName).c_str();
-	if (shaderName == "Default")
-	{
-		m_shader = nullptr;
-	}
-	else
-	{
-		m_shader = g_theRenderer->CreateShader(shaderName.c_str(), VertexType::VERTEX_PCUTBN);
-	}
+	m_shaderName = ParseXmlAttribute(mapDefElement, "shader", m_imagePath);
 
 	// Parsing texture
-	Image texture = Image(ParseXmlAttribute(mapDefElement, "spriteSheetTexture", imageName).c_str());
-	m_spriteSheetTexture = g_theRenderer->CreateTextureFromImage(texture);
+	m_spriteSheetTexturePath = ParseXmlAttribute(mapDefElement, "spriteSheetTexture", m_imagePath);
 
 	// Parsing spritesheet cell count
 	m_spriteSheetCellCount = ParseXmlAttribute(mapDefElement, "spriteSheetCellCount", m_spriteSheetCellCount);
@@ -70,9 +64,28 @@ void MapDefinition::InitializeMapDefs()
 
 void MapDefinition::ClearDefinitions()
 {
+	for (int mapDefIndex = 0; mapDefIndex < static_cast<int>(s_mapDefinitions.size()); ++mapDefIndex)
+	{
+		delete s_mapDefinitions[mapDefIndex];
+	}
 	s_mapDefinitions.clear();
 }
 
+// Map definitions load before the actors they spawn
+void MapDefinition::ResolveReferences()
+{
+	for (int mapDefIndex = 0; mapDefIndex < static_cast<int>(s_mapDefinitions.size()); ++mapDefIndex)
+	{
+		MapDefinition* mapDef = s_mapDefinitions[mapDefIndex];
+		for (int spawnInfoIndex = 0; spawnInfoIndex < static_cast<int>(mapDef->m_spawningInfo.size()); ++spawnInfoIndex)
+		{
+			SpawnInfo& spawnInfo = mapDef->m_spawningInfo[spawnInfoIndex];
+			spawnInfo.m_actorDef = ActorDefinition::GetByActorName(spawnInfo.m_actorName);
+			GUARANTEE_OR_DIE(spawnInfo.m_actorDef != nullptr, Stringf("Map definition \"%s\" spawns unknown actor \"%s\"", mapDef->m_name.c_str(), spawnInfo.m_actorName.c_str()));
+		}
+	}
+}
+
 MapDefinition* MapDefinition::GetByName(std::string const& name)
 {
 	for (int mapDefIndex = 0; mapDefIndex < static_cast<int>(s_mapDefinitions.size()); ++mapDefIndex)
@@ -84,6 +97,35 @@ MapDefinition* MapDefinition::GetByName(std::string const& name)
 	}
 	return nullptr;
 }
+void MapDefinition::AcquireAssets()
+{
+	m_numAssetUsers += 1;
+	if (m_numAssetUsers > 1)
+	{
+		return;
+	}
+
+	m_spriteSheetTexture = g_assetResidency->AcquireTexture(m_spriteSheetTexturePath);
+	if (m_shaderName != "Default")
+	{
+		m_shader = g_shaderRegistry->CreateOrGetShader(m_shaderName, VertexType::VERTEX_PCUTBN);
+	}
+}
+
+void MapDefinition::ReleaseAssets()
+{
+	GUARANTEE_OR_DIE(m_numAssetUsers > 0, Stringf("Map definition \"%s\" released assets it never acquired", m_name.c_str()));
+	m_numAssetUsers -= 1;
+	if (m_numAssetUsers > 0)
+	{
+		return;
+	}
+
+	// Shaders belong to the shader registry and stay compiled
+	g_assetResidency->ReleaseTexture(m_spriteSheetTexturePath);
+	m_spriteSheetTexture = nullptr;
+	m_shader = nullptr;
+}
 // -----------------------------------------------------------------------------
 SpawnInfo::SpawnInfo(XmlElement const& spawnInfoElement)
 {
@@ -6,31 +6,48 @@
 #include "Engine/Renderer/Texture.hpp"
 #include <string>
 // -----------------------------------------------------------------------------
+struct ActorDefinition;
+// -----------------------------------------------------------------------------
 struct SpawnInfo
 {
 	SpawnInfo(XmlElement const& spawnInfoElement);
 	SpawnInfo();
 
-	std::string m_actorName;
+	std::string      m_actorName;			// As parsed from a map definition, see MapDefinition::ResolveReferences
+	ActorDefinition* m_actorDef = nullptr;	// What is spawned
 	Vec3		m_position = Vec3::ZERO;
 	EulerAngles m_orientation = EulerAngles::ZERO;
 	Vec3		m_velocity = Vec3::ZERO;
 };
 // -----------------------------------------------------------------------------
+// Only the names of a map's assets are kept until a map is built from it; the
+// sprite sheet and shader are resident between AcquireAssets and the matching
+// ReleaseAssets.
+// -----------------------------------------------------------------------------
 struct MapDefinition
 {
+	MapDefinition();
 	MapDefinition(XmlElement const& mapDefElement);
 	static std::vector<MapDefinition*> s_mapDefinitions;
 // -----------------------------------------------------------------------------
 	static void InitializeMapDefs();
 	static void ClearDefinitions();
+	static void ResolveReferences();
 	static MapDefinition* GetByName(std::string const& name);
+// -----------------------------------------------------------------------------
+	void AcquireAssets();
+	void ReleaseAssets();
 // -----------------------------------------------------------------------------
 	std::string m_name;
-	Image*		m_image = nullptr;
-	Shader*		m_shader = nullptr;
-	Texture*	m_spriteSheetTexture = nullptr;
+	std::string m_imagePath;
+	std::string m_shaderName;
+	std::string m_spriteSheetTexturePath;
 	IntVec2		m_spriteSheetCellCount = IntVec2::ZERO;
 	std::vector<SpawnInfo> m_spawningInfo;
+
+	// Resident only while a map built from this definition exists
+	int			m_numAssetUsers = 0;
+	Shader*		m_shader = nullptr;
+	Texture*	m_spriteSheetTexture = nullptr;
 };
 // -----------------------------------------------------------------------------
\ No newline at end of file
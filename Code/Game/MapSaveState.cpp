@@ -0,0 +1,669 @@
+#include "Game/MapSaveState.hpp"
+#include "Game/BenchHelpers.hpp"
+#include "Game/BinaryBuffer.hpp"
+#include "Game/Game.h"
+#include "Game/GameCommon.h"
+#include "Game/Map.hpp"
+#include "Game/Actor.hpp"
+#include "Game/Ai.h"
+#include "Game/Player.hpp"
+#include "Game/TileDefinition.hpp"
+#include "Game/ReplaySystem.hpp"
+#include "Engine/Core/DevConsole.hpp"
+#include "Engine/Core/EngineCommon.h"
+#include "Engine/Core/ErrorWarningAssert.hpp"
+#include "Engine/Core/Time.hpp"
+#include <atomic>
+#include <fstream>
+#include <iterator>
+#include <thread>
+
+static char const* const SAVE_DEFAULT_FILE = "MapSave.bin";
+static unsigned int const SAVE_FILE_VERSION = 3;
+
+// Actor flag bits
+static unsigned char const SAVE_FLAG_DEAD = 0x01;
+static unsigned char const SAVE_FLAG_DESTROYED = 0x02;
+static unsigned char const SAVE_FLAG_SLOWED = 0x04;
+
+// -----------------------------------------------------------------------------
+// Everything one actor needs on top of what its definition and spawn rebuild.
+// Handles are stored as their raw data so they come back unchanged.
+// -----------------------------------------------------------------------------
+struct SavedActor
+{
+	unsigned int   m_handleData = 0;
+	unsigned short m_actorDefIndex = 0;
+	Vec3           m_position;
+	EulerAngles    m_orientation;
+	Vec3           m_velocity;
+	Vec3           m_acceleration;
+	Rgba8          m_color;
+	int            m_health = 0;
+	unsigned char  m_flags = 0;
+	float          m_enemySpawnInterval = 0.f;
+	float          m_slowAmount = 1.f;
+	double         m_removeSeconds = -1.0;
+	double         m_nextSpawnSeconds = -1.0;
+	double         m_slowEndSeconds = -1.0;
+	unsigned int   m_firingActorHandleData = 0;
+	unsigned int   m_aiTargetHandleData = 0;
+	float          m_aiPendingSeconds = 0.f;
+	Vec3           m_aiMoveDirection;
+	float          m_aiMoveSpeed = 0.f;
+	signed char    m_animGroupIndex = -1;
+	signed char    m_playerIndex = -1;
+	signed char    m_equippedWeaponIndex = -1;
+	std::vector<double> m_weaponLastFireSeconds;
+};
+
+static std::thread s_writeThread;
+static std::atomic<bool> s_isWriteFinished(true);
+static std::atomic<bool> s_didWriteSucceed(false);
+static std::string s_writeFilePath;
+static size_t s_writeNumBytes = 0;
+static double s_writeStartSeconds = 0.0;
+
+static ActorHandle GetHandleFromData(unsigned int handleData)
+{
+	return ActorHandle(handleData >> 16, handleData & 0xffffu);
+}
+
+template <typename T>
+static int GetDefinitionIndex(std::vector<T*> const& definitions, T const* definition)
+{
+	for (int definitionIndex = 0; definitionIndex < static_cast<int>(definitions.size()); ++definitionIndex)
+	{
+		if (definitions[definitionIndex] == definition)
+		{
+			return definitionIndex;
+		}
+	}
+	return -1;
+}
+
+static SavedActor SaveActor(Map const& map, Actor const& actor)
+{
+	SavedActor saved;
+	saved.m_handleData = actor.m_actorHandle.GetData();
+	saved.m_actorDefIndex = static_cast<unsigned short>(GetDefinitionIndex(ActorDefinition::s_actorDefinitions, actor.m_actorDef));
+	saved.m_position = actor.m_position;
+	saved.m_orientation = actor.m_orientation;
+	saved.m_velocity = actor.m_velocity;
+	saved.m_acceleration = actor.m_acceleration;
+	saved.m_color = actor.m_color;
+	saved.m_health = actor.m_health;
+	saved.m_flags = static_cast<unsigned char>((actor.m_isDead ? SAVE_FLAG_DEAD : 0) | (actor.m_isDestroyed ? SAVE_FLAG_DESTROYED : 0) | (actor.m_isSlowed ? SAVE_FLAG_SLOWED : 0));
+	saved.m_enemySpawnInterval = actor.m_enemySpawnInterval;
+	saved.m_slowAmount = actor.m_slowAmount;
+	saved.m_removeSeconds = actor.m_removeSeconds;
+	saved.m_nextSpawnSeconds = actor.m_nextSpawnSeconds;
+	saved.m_slowEndSeconds = actor.m_slowEndSeconds;
+	saved.m_firingActorHandleData = (actor.m_actorFiringProjectile != nullptr) ? actor.m_actorFiringProjectile->m_actorHandle.GetData() : ActorHandle::INVALID.GetData();
+
+	AI const* ai = dynamic_cast<AI const*>(actor.m_aiController);
+	if (ai != nullptr)
+	{
+		saved.m_aiTargetHandleData = ai->m_targetActorHandle.GetData();
+		saved.m_aiPendingSeconds = ai->m_pendingSeconds;
+		saved.m_aiMoveDirection = ai->m_moveDirection;
+		saved.m_aiMoveSpeed = ai->m_moveSpeed;
+	}
+	else
+	{
+		saved.m_aiTargetHandleData = ActorHandle::INVALID.GetData();
+	}
+	saved.m_animGroupIndex = static_cast<signed char>(GetDefinitionIndex(actor.m_actorDef->m_animationGroups, actor.m_animGroup));
+
+	std::vector<Player*> const& players = map.m_game->m_players;
+	for (int playerIndex = 0; playerIndex < static_cast<int>(players.size()); ++playerIndex)
+	{
+		if (players[playerIndex]->m_currentHandle == actor.m_actorHandle)
+		{
+			saved.m_playerIndex = static_cast<signed char>(playerIndex);
+		}
+	}
+
+	for (int weaponIndex = 0; weaponIndex < static_cast<int>(actor.m_weapons.size()); ++weaponIndex)
+	{
+		Weapon const* weapon = actor.m_weapons[weaponIndex];
+		saved.m_weaponLastFireSeconds.push_back(weapon->m_lastFireSeconds);
+		if (weapon == actor.m_equippedWeapon)
+		{
+			saved.m_equippedWeaponIndex = static_cast<signed char>(weaponIndex);
+		}
+	}
+	return saved;
+}
+
+static void AppendSavedActor(std::vector<unsigned char>& buffer, SavedActor const& saved)
+{
+	AppendBytes(buffer, saved.m_handleData);
+	AppendBytes(buffer, saved.m_actorDefIndex);
+	AppendBytes(buffer, saved.m_position);
+	AppendBytes(buffer, saved.m_orientation);
+	AppendBytes(buffer, saved.m_velocity);
+	AppendBytes(buffer, saved.m_acceleration);
+	AppendBytes(buffer, saved.m_color);
+	AppendBytes(buffer, saved.m_health);
+	AppendBytes(buffer, saved.m_flags);
+	AppendBytes(buffer, saved.m_enemySpawnInterval);
+	AppendBytes(buffer, saved.m_slowAmount);
+	AppendBytes(buffer, saved.m_removeSeconds);
+	AppendBytes(buffer, saved.m_nextSpawnSeconds);
+	AppendBytes(buffer, saved.m_slowEndSeconds);
+	AppendBytes(buffer, saved.m_firingActorHandleData);
+	AppendBytes(buffer, saved.m_aiTargetHandleData);
+	AppendBytes(buffer, saved.m_aiPendingSeconds);
+	AppendBytes(buffer, saved.m_aiMoveDirection);
+	AppendBytes(buffer, saved.m_aiMoveSpeed);
+	AppendBytes(buffer, saved.m_animGroupIndex);
+	AppendBytes(buffer, saved.m_playerIndex);
+	AppendBytes(buffer, saved.m_equippedWeaponIndex);
+	AppendBytes(buffer, static_cast<unsigned char>(saved.m_weaponLastFireSeconds.size()));
+	for (int weaponIndex = 0; weaponIndex < static_cast<int>(saved.m_weaponLastFireSeconds.size()); ++weaponIndex)
+	{
+		AppendBytes(buffer, saved.m_weaponLastFireSeconds[weaponIndex]);
+	}
+}
+
+static bool ReadSavedActor(std::vector<unsigned char> const& buffer, size_t& readPosition, SavedActor& outSaved)
+{
+	unsigned char numWeapons = 0;
+	bool isValid = ReadBytes(buffer, readPosition, outSaved.m_handleData)
+		&& ReadBytes(buffer, readPosition, outSaved.m_actorDefIndex)
+		&& ReadBytes(buffer, readPosition, outSaved.m_position)
+		&& ReadBytes(buffer, readPosition, outSaved.m_orientation)
+		&& ReadBytes(buffer, readPosition, outSaved.m_velocity)
+		&& ReadBytes(buffer, readPosition, outSaved.m_acceleration)
+		&& ReadBytes(buffer, readPosition, outSaved.m_color)
+		&& ReadBytes(buffer, readPosition, outSaved.m_health)
+		&& ReadBytes(buffer, readPosition, outSaved.m_flags)
+		&& ReadBytes(buffer, readPosition, outSaved.m_enemySpawnInterval)
+		&& ReadBytes(buffer, readPosition, outSaved.m_slowAmount)
+		&& ReadBytes(buffer, readPosition, outSaved.m_removeSeconds)
+		&& ReadBytes(buffer, readPosition, outSaved.m_nextSpawnSeconds)
+		&& ReadBytes(buffer, readPosition, outSaved.m_slowEndSeconds)
+		&& ReadBytes(buffer, readPosition, outSaved.m_firingActorHandleData)
+		&& ReadBytes(buffer, readPosition, outSaved.m_aiTargetHandleData)
+		&& ReadBytes(buffer, readPosition, outSaved.m_aiPendingSeconds)
+		&& ReadBytes(buffer, readPosition, outSaved.m_aiMoveDirection)
+		&& ReadBytes(buffer, readPosition, outSaved.m_aiMoveSpeed)
+		&& ReadBytes(buffer, readPosition, outSaved.m_animGroupIndex)
+		&& ReadBytes(buffer, readPosition, outSaved.m_playerIndex)
+		&& ReadBytes(buffer, readPosition, outSaved.m_equippedWeaponIndex)
+		&& ReadBytes(buffer, readPosition, numWeapons);
+	if (!isValid)
+	{
+		return false;
+	}
+
+	outSaved.m_weaponLastFireSeconds.resize(numWeapons);
+	for (int weaponIndex = 0; weaponIndex < static_cast<int>(numWeapons); ++weaponIndex)
+	{
+		if (!ReadBytes(buffer, readPosition, outSaved.m_weaponLastFireSeconds[weaponIndex]))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// File layout: "DMSV", version, map name, dimensions, simulation time, AI
+// level of detail tick, next actor uid, number of actor slots, then one byte per tile holding its tile
+// definition index and finally each live actor.
+// -----------------------------------------------------------------------------
+void MapSaveState::Capture(Map const& map, std::vector<unsigned char>& outBytes)
+{
+	outBytes.clear();
+	outBytes.insert(outBytes.end(), { 'D', 'M', 'S', 'V' });
+	AppendBytes(outBytes, SAVE_FILE_VERSION);
+	std::string const& mapName = map.m_definition->m_name;
+	AppendBytes(outBytes, static_cast<unsigned int>(mapName.size()));
+	outBytes.insert(outBytes.end(), mapName.begin(), mapName.end());
+	AppendBytes(outBytes, map.m_dimensions);
+	AppendBytes(outBytes, map.m_simulationSeconds);
+	AppendBytes(outBytes, map.m_aiLod.GetTickIndex());
+	AppendBytes(outBytes, map.m_nextActorUID);
+	AppendBytes(outBytes, static_cast<unsigned int>(map.m_allActors.size()));
+
+	// Maps only use a handful of tile types, so a byte per tile is plenty
+	GUARANTEE_OR_DIE(TileDefinition::s_definitions.size() <= 256, "Map saves store tile definitions in one byte");
+	for (int tileIndex = 0; tileIndex < static_cast<int>(map.m_tiles.size()); ++tileIndex)
+	{
+		AppendBytes(outBytes, static_cast<unsigned char>(GetDefinitionIndex(TileDefinition::s_definitions, map.m_tiles[tileIndex].m_tileDef)));
+	}
+
+	size_t numActorsPosition = outBytes.size();
+	unsigned int numActors = 0;
+	AppendBytes(outBytes, numActors);
+	for (int actorIndex = 0; actorIndex < static_cast<int>(map.m_allActors.size()); ++actorIndex)
+	{
+		Actor const* actor = map.m_allActors[actorIndex];
+		if (actor != nullptr)
+		{
+			AppendSavedActor(outBytes, SaveActor(map, *actor));
+			numActors += 1;
+		}
+	}
+	OverwriteBytes(outBytes, numActorsPosition, numActors);
+}
+
+// -----------------------------------------------------------------------------
+// The whole save is read and checked before the map is touched, so a bad save
+// leaves the running map as it was.
+// -----------------------------------------------------------------------------
+bool MapSaveState::Restore(Map& map, std::vector<unsigned char> const& bytes)
+{
+	size_t readPosition = 0;
+	if (bytes.size() < 4 || bytes[0] != 'D' || bytes[1] != 'M' || bytes[2] != 'S' || bytes[3] != 'V')
+	{
+		return false;
+	}
+	readPosition = 4;
+
+	unsigned int version = 0;
+	unsigned int mapNameLength = 0;
+	if (!ReadBytes(bytes, readPosition, version) || version != SAVE_FILE_VERSION || !ReadBytes(bytes, readPosition, mapNameLength)
+		|| readPosition + mapNameLength > bytes.size())
+	{
+		return false;
+	}
+	std::string mapName(bytes.begin() + readPosition, bytes.begin() + readPosition + mapNameLength);
+	readPosition += mapNameLength;
+
+	IntVec2 dimensions;
+	double simulationSeconds = 0.0;
+	unsigned int aiLodTickIndex = 0;
+	unsigned int nextActorUID = 0;
+	unsigned int numActorSlots = 0;
+	if (!ReadBytes(bytes, readPosition, dimensions) || !ReadBytes(bytes, readPosition, simulationSeconds) || !ReadBytes(bytes, readPosition, aiLodTickIndex)
+		|| !ReadBytes(bytes, readPosition, nextActorUID)
+		|| !ReadBytes(bytes, readPosition, numActorSlots))
+	{
+		return false;
+	}
+	if (mapName != map.m_definition->m_name || dimensions.x != map.m_dimensions.x || dimensions.y != map.m_dimensions.y || numActorSlots > ActorHandle::MAX_ACTOR_INDEX)
+	{
+		return false;
+	}
+
+	int numTiles = static_cast<int>(map.m_tiles.size());
+	if (readPosition + numTiles > bytes.size())
+	{
+		return false;
+	}
+	std::vector<unsigned char> tileDefIndexes(bytes.begin() + readPosition, bytes.begin() + readPosition + numTiles);
+	readPosition += numTiles;
+
+	unsigned int numActors = 0;
+	if (!ReadBytes(bytes, readPosition, numActors) || numActors > numActorSlots)
+	{
+		return false;
+	}
+	// A slot named twice would place one actor over another, so such a save is rejected
+	std::vector<SavedActor> savedActors(numActors);
+	std::vector<unsigned char> isSlotUsed(numActorSlots, 0);
+	for (int actorIndex = 0; actorIndex < static_cast<int>(numActors); ++actorIndex)
+	{
+		SavedActor& saved = savedActors[actorIndex];
+		if (!ReadSavedActor(bytes, readPosition, saved) || (saved.m_handleData & 0xffffu) >= numActorSlots
+			|| saved.m_actorDefIndex >= ActorDefinition::s_actorDefinitions.size() || isSlotUsed[saved.m_handleData & 0xffffu])
+		{
+			return false;
+		}
+		isSlotUsed[saved.m_handleData & 0xffffu] = 1;
+	}
+	for (int tileIndex = 0; tileIndex < numTiles; ++tileIndex)
+	{
+		if (tileDefIndexes[tileIndex] >= TileDefinition::s_definitions.size())
+		{
+			return false;
+		}
+	}
+
+	// Tiles normally match already; only a changed layout pays for new geometry
+	bool didTilesChange = false;
+	for (int tileIndex = 0; tileIndex < numTiles; ++tileIndex)
+	{
+		TileDefinition* tileDef = TileDefinition::s_definitions[tileDefIndexes[tileIndex]];
+		didTilesChange = didTilesChange || (map.m_tiles[tileIndex].m_tileDef != tileDef);
+		map.m_tiles[tileIndex].m_tileDef = tileDef;
+	}
+	if (didTilesChange)
+	{
+		for (int chunkIndex = 0; chunkIndex < static_cast<int>(map.m_chunks.size()); ++chunkIndex)
+		{
+			MapChunk& chunk = map.m_chunks[chunkIndex];
+			chunk.m_vertexes.clear();
+			chunk.m_indexes.clear();
+			delete chunk.m_vertexBuffer;
+			chunk.m_vertexBuffer = nullptr;
+			delete chunk.m_indexBuffer;
+			chunk.m_indexBuffer = nullptr;
+		}
+		map.m_staticLights.clear();
+		map.CreateGeometry();
+	}
+
+	map.DiscardPendingChanges();
+	for (int actorIndex = 0; actorIndex < static_cast<int>(map.m_allActors.size()); ++actorIndex)
+	{
+		delete map.m_allActors[actorIndex];
+	}
+	map.m_allActors.assign(numActorSlots, nullptr);
+	map.m_factionRoster.Clear();
+	map.m_nextActorUID = nextActorUID;
+	map.m_simulationSeconds = simulationSeconds;
+	map.m_timerWheel.Clear(simulationSeconds);
+	map.m_aiLod.SetTickIndex(aiLodTickIndex);
+
+	// Create every actor first so the handles between them resolve
+	for (int actorIndex = 0; actorIndex < static_cast<int>(savedActors.size()); ++actorIndex)
+	{
+		SavedActor const& saved = savedActors[actorIndex];
+		SpawnInfo spawnInfo;
+		spawnInfo.m_actorDef = ActorDefinition::s_actorDefinitions[saved.m_actorDefIndex];
+		spawnInfo.m_position = saved.m_position;
+		spawnInfo.m_orientation = saved.m_orientation;
+		spawnInfo.m_velocity = saved.m_velocity;
+		Actor* actor = map.PlaceActor(spawnInfo, GetHandleFromData(saved.m_handleData));
+
+		actor->m_acceleration = saved.m_acceleration;
+		actor->m_color = saved.m_color;
+		actor->m_health = saved.m_health;
+		actor->m_isDead = (saved.m_flags & SAVE_FLAG_DEAD) != 0;
+		if ((saved.m_flags & SAVE_FLAG_DESTROYED) != 0)
+		{
+			actor->Destroy();
+		}
+		actor->m_isSlowed = (saved.m_flags & SAVE_FLAG_SLOWED) != 0;
+		actor->m_enemySpawnInterval = saved.m_enemySpawnInterval;
+		actor->m_slowAmount = saved.m_slowAmount;
+		actor->m_removeSeconds = saved.m_removeSeconds;
+		actor->m_nextSpawnSeconds = saved.m_nextSpawnSeconds;
+		actor->m_slowEndSeconds = saved.m_slowEndSeconds;
+		map.ScheduleActorTimers(*actor);
+
+		// Animation playback restarts, only which animation is playing is kept
+		if (saved.m_animGroupIndex >= 0 && saved.m_animGroupIndex < static_cast<int>(actor->m_actorDef->m_animationGroups.size()))
+		{
+			actor->m_animGroup = actor->m_actorDef->m_animationGroups[saved.m_animGroupIndex];
+		}
+
+		int numWeapons = static_cast<int>(actor->m_weapons.size());
+		for (int weaponIndex = 0; weaponIndex < numWeapons && weaponIndex < static_cast<int>(saved.m_weaponLastFireSeconds.size()); ++weaponIndex)
+		{
+			actor->m_weapons[weaponIndex]->m_lastFireSeconds = saved.m_weaponLastFireSeconds[weaponIndex];
+		}
+		if (saved.m_equippedWeaponIndex >= 0 && saved.m_equippedWeaponIndex < numWeapons)
+		{
+			actor->m_equippedWeapon = actor->m_weapons[saved.m_equippedWeaponIndex];
+		}
+	}
+
+	std::vector<Player*> const& players = map.m_game->m_players;
+	for (int actorIndex = 0; actorIndex < static_cast<int>(savedActors.size()); ++actorIndex)
+	{
+		SavedActor const& saved = savedActors[actorIndex];
+		ActorHandle handle = GetHandleFromData(saved.m_handleData);
+		Actor* actor = map.GetActorByHandle(handle);
+		actor->m_actorFiringProjectile = map.GetActorByHandle(GetHandleFromData(saved.m_firingActorHandleData));
+
+		AI* ai = dynamic_cast<AI*>(actor->m_aiController);
+		if (ai != nullptr)
+		{
+			ai->m_targetActorHandle = GetHandleFromData(saved.m_aiTargetHandleData);
+			ai->m_pendingSeconds = saved.m_aiPendingSeconds;
+			ai->m_moveDirection = saved.m_aiMoveDirection;
+			ai->m_moveSpeed = saved.m_aiMoveSpeed;
+		}
+		if (saved.m_playerIndex >= 0 && saved.m_playerIndex < static_cast<int>(players.size()))
+		{
+			players[saved.m_playerIndex]->Possess(handle);
+		}
+	}
+
+	// Grid slots no longer match the actor list, queries scan until the next build
+	map.m_actorGrid.Clear();
+
+	// Dead flags were restored directly, so count the factions again
+	map.m_factionRoster.Rebuild();
+	return true;
+}
+
+void MapSaveState::WriteFileAsync(std::string const& filePath, std::vector<unsigned char>&& bytes)
+{
+	WaitForPendingWrite();
+
+	s_writeFilePath = filePath;
+	s_writeNumBytes = bytes.size();
+	s_writeStartSeconds = GetCurrentTimeSeconds();
+	s_isWriteFinished = false;
+	s_writeThread = std::thread([filePath, ownedBytes = std::move(bytes)]()
+	{
+		std::ofstream file(filePath, std::ios::binary);
+		file.write(reinterpret_cast<char const*>(ownedBytes.data()), static_cast<std::streamsize>(ownedBytes.size()));
+		s_didWriteSucceed = static_cast<bool>(file);
+		s_isWriteFinished = true;
+	});
+}
+
+// -----------------------------------------------------------------------------
+// Called every frame; reports a background write once it has finished.
+// -----------------------------------------------------------------------------
+void MapSaveState::PollPendingWrite()
+{
+	if (s_writeThread.joinable() && s_isWriteFinished)
+	{
+		WaitForPendingWrite();
+	}
+}
+
+void MapSaveState::WaitForPendingWrite()
+{
+	if (!s_writeThread.joinable())
+	{
+		return;
+	}
+	s_writeThread.join();
+
+	if (!s_didWriteSucceed)
+	{
+		g_theDevConsole->AddLine(Rgba8::RED, Stringf("Could not write map save to %s", s_writeFilePath.c_str()));
+		return;
+	}
+	g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, Stringf("Wrote map save to %s (%d bytes) in %.2f ms", s_writeFilePath.c_str(),
+		static_cast<int>(s_writeNumBytes), (GetCurrentTimeSeconds() - s_writeStartSeconds) * 1000.0));
+}
+
+bool MapSaveState::ReadFile(std::string const& filePath, std::vector<unsigned char>& outBytes)
+{
+	// A save still being written must land before it can be read back
+	WaitForPendingWrite();
+
+	std::ifstream file(filePath, std::ios::binary);
+	if (!file)
+	{
+		return false;
+	}
+	outBytes.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Dev console: MapSave file=<path>
+// -----------------------------------------------------------------------------
+bool MapSaveState::Command_MapSave(EventArgs& args)
+{
+	Map* map = g_theGame->m_defaultMap;
+	if (g_theGame->m_currentState != GameState::PLAYING || map == nullptr)
+	{
+		g_theDevConsole->AddLine(Rgba8::RED, "MapSave needs a game in progress");
+		return false;
+	}
+
+	std::string filePath = args.GetValue("file", SAVE_DEFAULT_FILE);
+	double captureStart = GetCurrentTimeSeconds();
+	std::vector<unsigned char> bytes;
+	Capture(*map, bytes);
+	double captureSeconds = GetCurrentTimeSeconds() - captureStart;
+	g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, Stringf("Captured %s in %.2f ms (%d bytes), writing in the background",
+		map->m_definition->m_name.c_str(), captureSeconds * 1000.0, static_cast<int>(bytes.size())));
+	WriteFileAsync(filePath, std::move(bytes));
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Dev console: MapLoad file=<path>
+// -----------------------------------------------------------------------------
+bool MapSaveState::Command_MapLoad(EventArgs& args)
+{
+	Map* map = g_theGame->m_defaultMap;
+	if (g_theGame->m_currentState != GameState::PLAYING || map == nullptr)
+	{
+		g_theDevConsole->AddLine(Rgba8::RED, "MapLoad needs a game in progress");
+		return false;
+	}
+
+	std::string filePath = args.GetValue("file", SAVE_DEFAULT_FILE);
+	std::vector<unsigned char> bytes;
+	if (!ReadFile(filePath, bytes))
+	{
+		g_theDevConsole->AddLine(Rgba8::RED, Stringf("Could not read map save %s", filePath.c_str()));
+		return false;
+	}
+
+	double restoreStart = GetCurrentTimeSeconds();
+	if (!Restore(*map, bytes))
+	{
+		g_theDevConsole->AddLine(Rgba8::RED, Stringf("%s is not a valid save for %s", filePath.c_str(), map->m_definition->m_name.c_str()));
+		return false;
+	}
+	g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, Stringf("Restored %s from %s in %.2f ms", map->m_definition->m_name.c_str(), filePath.c_str(),
+		(GetCurrentTimeSeconds() - restoreStart) * 1000.0));
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Dev console: MapSaveTest
+// Captures the running map, restores it from that capture and captures again.
+// Both captures and the actor state hashes must match exactly.
+// -----------------------------------------------------------------------------
+bool MapSaveState::Command_MapSaveTest(EventArgs& args)
+{
+	UNUSED(args);
+	Map* map = g_theGame->m_defaultMap;
+	if (g_theGame->m_currentState != GameState::PLAYING || map == nullptr)
+	{
+		g_theDevConsole->AddLine(Rgba8::RED, "MapSaveTest needs a game in progress");
+		return false;
+	}
+
+	std::vector<unsigned char> savedBytes;
+	Capture(*map, savedBytes);
+	unsigned int savedHash = ReplaySystem::HashActorState(*map);
+
+	bool didRestore = Restore(*map, savedBytes);
+	std::vector<unsigned char> restoredBytes;
+	Capture(*map, restoredBytes);
+	unsigned int restoredHash = ReplaySystem::HashActorState(*map);
+
+	// A truncated save must be rejected without touching the map
+	std::vector<unsigned char> truncatedBytes(savedBytes.begin(), savedBytes.begin() + savedBytes.size() / 2);
+	bool didRejectTruncated = !Restore(*map, truncatedBytes);
+
+	bool didPass = didRestore && restoredBytes == savedBytes && restoredHash == savedHash && didRejectTruncated;
+	g_theDevConsole->AddLine(didPass ? Rgba8::LIGHTYELLOW : Rgba8::RED, Stringf("Map save round trip %s: restored %s, bytes %s, hash %s, truncated save %s",
+		didPass ? "passed" : "FAILED", didRestore ? "yes" : "no", (restoredBytes == savedBytes) ? "match" : "differ",
+		(restoredHash == savedHash) ? "matches" : "differs", didRejectTruncated ? "rejected" : "accepted"));
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Dev console: MapSaveBench actors=<count> iterations=<count>
+// Fills the running map with demons on open tiles, then times capture, the
+// background write, reading the file back and restoring. The map and player
+// lives are restored afterwards.
+// -----------------------------------------------------------------------------
+bool MapSaveState::Command_MapSaveBench(EventArgs& args)
+{
+	Map* map = g_theGame->m_defaultMap;
+	if (g_theGame->m_currentState != GameState::PLAYING || map == nullptr)
+	{
+		g_theDevConsole->AddLine(Rgba8::RED, "MapSaveBench needs a game in progress");
+		return false;
+	}
+
+	int numActors = args.GetValue("actors", 10000);
+	int numIterations = args.GetValue("iterations", 5);
+	numIterations = (numIterations < 1) ? 1 : numIterations;
+	int maxActors = static_cast<int>(ActorHandle::MAX_ACTOR_INDEX) - static_cast<int>(map->m_allActors.size());
+	numActors = (numActors < 0) ? 0 : ((numActors > maxActors) ? maxActors : numActors);
+
+	std::vector<IntVec2> openTiles;
+	if (!GatherOpenTiles(*map, "MapSaveBench", openTiles))
+	{
+		return false;
+	}
+
+	BenchMapScope benchScope(*map);
+	for (int spawnIndex = 0; spawnIndex < numActors; ++spawnIndex)
+	{
+		IntVec2 tileCoords = RollOpenTile(openTiles);
+		SpawnInfo spawnInfo;
+		spawnInfo.m_actorDef = ActorDefinition::GetByActorName("Demon");
+		spawnInfo.m_position = Vec3(static_cast<float>(tileCoords.x) + 0.5f, static_cast<float>(tileCoords.y) + 0.5f, 0.f);
+		spawnInfo.m_orientation = EulerAngles(GetBenchRng().RollRandomFloatInRange(0.f, 360.f), 0.f, 0.f);
+		map->SpawnActor(spawnInfo);
+	}
+
+	std::string filePath = "MapSaveBench.bin";
+	std::vector<unsigned char> savedBytes;
+	std::vector<unsigned char> readBytes;
+	double captureSeconds = 0.0;
+	double writeSeconds = 0.0;
+	double readSeconds = 0.0;
+	double restoreSeconds = 0.0;
+	bool didRestoreAll = true;
+	for (int iterationIndex = 0; iterationIndex < numIterations; ++iterationIndex)
+	{
+		double captureStart = GetCurrentTimeSeconds();
+		Capture(*map, savedBytes);
+		captureSeconds += GetCurrentTimeSeconds() - captureStart;
+
+		double writeStart = GetCurrentTimeSeconds();
+		WriteFileAsync(filePath, std::vector<unsigned char>(savedBytes));
+		while (!s_isWriteFinished)
+		{
+			std::this_thread::yield();
+		}
+		writeSeconds += GetCurrentTimeSeconds() - writeStart;
+
+		double readStart = GetCurrentTimeSeconds();
+		didRestoreAll = ReadFile(filePath, readBytes) && didRestoreAll;
+		readSeconds += GetCurrentTimeSeconds() - readStart;
+
+		double restoreStart = GetCurrentTimeSeconds();
+		didRestoreAll = Restore(*map, readBytes) && didRestoreAll;
+		restoreSeconds += GetCurrentTimeSeconds() - restoreStart;
+	}
+
+	int numSavedActors = 0;
+	for (int actorIndex = 0; actorIndex < static_cast<int>(map->m_allActors.size()); ++actorIndex)
+	{
+		numSavedActors += (map->m_allActors[actorIndex] != nullptr) ? 1 : 0;
+	}
+
+	double msPerIteration = 1000.0 / static_cast<double>(numIterations);
+	g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, Stringf("Map save bench: %d actors, %d bytes per save (%.1f bytes per actor), %d iterations",
+		numSavedActors, static_cast<int>(savedBytes.size()), static_cast<double>(savedBytes.size()) / static_cast<double>((numSavedActors > 0) ? numSavedActors : 1), numIterations));
+	g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, Stringf("Capture %.2f ms, background write %.2f ms, read %.2f ms, restore %.2f ms",
+		captureSeconds * msPerIteration, writeSeconds * msPerIteration, readSeconds * msPerIteration, restoreSeconds * msPerIteration));
+	if (!didRestoreAll)
+	{
+		g_theDevConsole->AddLine(Rgba8::RED, "Map save bench: a restore failed");
+	}
+	return true;
+}
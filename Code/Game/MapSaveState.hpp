@@ -0,0 +1,30 @@
+#pragma once
+#include "Engine/Core/EventSystem.hpp"
+#include <string>
+#include <vector>
+// -----------------------------------------------------------------------------
+class Map;
+// -----------------------------------------------------------------------------
+// Checkpoints a running map into a compact binary save: tiles by definition
+// index, then every actor with its handle, weapons and refire times, AI target
+// and throttled move, and spawner timer. Capturing is a straight copy on the
+// main thread so the save sees one consistent tick; the file write runs on a
+// background thread. Restore rebuilds the actors in place, keeping every
+// handle, without reloading the map.
+// -----------------------------------------------------------------------------
+class MapSaveState
+{
+public:
+	static void Capture(Map const& map, std::vector<unsigned char>& outBytes);
+	static bool Restore(Map& map, std::vector<unsigned char> const& bytes);
+
+	static void WriteFileAsync(std::string const& filePath, std::vector<unsigned char>&& bytes);
+	static void PollPendingWrite();
+	static void WaitForPendingWrite();
+	static bool ReadFile(std::string const& filePath, std::vector<unsigned char>& outBytes);
+
+	static bool Command_MapSave(EventArgs& args);
+	static bool Command_MapLoad(EventArgs& args);
+	static bool Command_MapSaveTest(EventArgs& args);
+	static bool Command_MapSaveBench(EventArgs& args);
+};
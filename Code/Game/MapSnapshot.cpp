@@ -0,0 +1,452 @@
+#include "Game/MapSnapshot.hpp"
+#include "Game/BinaryBuffer.hpp"
+#include "Game/SnapshotRelevancy.hpp"
+#include "Game/Map.hpp"
+#include "Game/Actor.hpp"
+#include "Engine/Core/Time.hpp"
+#include "Engine/Math/MathUtils.h"
+#include <cmath>
+
+// Field mask of one encoded actor entry
+static unsigned char const SNAPSHOT_FIELD_POSITION_X = 0x01;
+static unsigned char const SNAPSHOT_FIELD_POSITION_Y = 0x02;
+static unsigned char const SNAPSHOT_FIELD_POSITION_Z = 0x04;
+static unsigned char const SNAPSHOT_FIELD_YAW = 0x08;
+static unsigned char const SNAPSHOT_FIELD_ANIM_STATE = 0x10;
+static unsigned char const SNAPSHOT_FIELD_HEALTH = 0x20;
+static unsigned char const SNAPSHOT_FIELD_SMALL_POSITION = 0x40;	// Position fields are one byte offsets from the baseline
+static unsigned char const SNAPSHOT_FIELD_REMOVED = 0x80;
+static unsigned char const SNAPSHOT_FIELDS_ALL = 0x3f;
+
+static short QuantizePosition(float value)
+{
+	float steps = GetClamped(value * SNAPSHOT_POSITION_STEPS_PER_UNIT, -32767.f, 32767.f);
+	return static_cast<short>(RoundDownToInt(steps + 0.5f));
+}
+
+static unsigned short QuantizeYaw(float yawDegrees)
+{
+	float turns = yawDegrees / 360.f;
+	turns -= floorf(turns);
+	return static_cast<unsigned short>(static_cast<unsigned int>(turns * 65536.f) & 0xffffu);
+}
+
+static unsigned int GetActorIndex(ActorSnapshot const& actor)
+{
+	return actor.m_handleData & 0xffffu;
+}
+
+ActorSnapshot ActorSnapshot::Capture(Actor const& actor)
+{
+	ActorSnapshot snapshot;
+	snapshot.m_handleData = actor.m_actorHandle.GetData();
+	snapshot.m_position[0] = QuantizePosition(actor.m_position.x);
+	snapshot.m_position[1] = QuantizePosition(actor.m_position.y);
+	snapshot.m_position[2] = QuantizePosition(actor.m_position.z);
+	snapshot.m_yaw = QuantizeYaw(actor.m_orientation.m_yawDegrees);
+	snapshot.m_health = static_cast<short>(actor.m_health);
+
+	std::vector<SpriteAnimationGroup*> const& animGroups = actor.m_actorDef->m_animationGroups;
+	for (int groupIndex = 0; groupIndex < static_cast<int>(animGroups.size()) && groupIndex < 0xff; ++groupIndex)
+	{
+		if (animGroups[groupIndex] == actor.m_animGroup)
+		{
+			snapshot.m_animState = static_cast<unsigned char>(groupIndex);
+			break;
+		}
+	}
+	return snapshot;
+}
+
+bool ActorSnapshot::operator==(ActorSnapshot const& other) const
+{
+	return m_handleData == other.m_handleData &&
+		m_position[0] == other.m_position[0] && m_position[1] == other.m_position[1] && m_position[2] == other.m_position[2] &&
+		m_yaw == other.m_yaw && m_animState == other.m_animState && m_health == other.m_health;
+}
+
+MapSnapshot MapSnapshot::Capture(Map const& map, unsigned int tick)
+{
+	MapSnapshot snapshot;
+	snapshot.m_tick = tick;
+	snapshot.m_actors.reserve(map.m_allActors.size());
+	for (int actorIndex = 0; actorIndex < static_cast<int>(map.m_allActors.size()); ++actorIndex)
+	{
+		Actor const* actor = map.m_allActors[actorIndex];
+		if (actor != nullptr)
+		{
+			snapshot.m_actors.push_back(ActorSnapshot::Capture(*actor));
+		}
+	}
+	return snapshot;
+}
+
+// -----------------------------------------------------------------------------
+// Appends one entry for the actor, or nothing if it matches its baseline.
+// -----------------------------------------------------------------------------
+static bool AppendActorEntry(NetPacket& packet, ActorSnapshot const& actor, ActorSnapshot const* baseActor)
+{
+	unsigned char fieldMask = SNAPSHOT_FIELDS_ALL;
+	bool isSmallPosition = false;
+	if (baseActor != nullptr)
+	{
+		fieldMask = 0;
+		isSmallPosition = true;
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			int offset = static_cast<int>(actor.m_position[axis]) - static_cast<int>(baseActor->m_position[axis]);
+			fieldMask |= (offset != 0) ? static_cast<unsigned char>(SNAPSHOT_FIELD_POSITION_X << axis) : 0;
+			isSmallPosition = isSmallPosition && offset >= -127 && offset <= 127;
+		}
+		fieldMask |= (actor.m_yaw != baseActor->m_yaw) ? SNAPSHOT_FIELD_YAW : 0;
+		fieldMask |= (actor.m_animState != baseActor->m_animState) ? SNAPSHOT_FIELD_ANIM_STATE : 0;
+		fieldMask |= (actor.m_health != baseActor->m_health) ? SNAPSHOT_FIELD_HEALTH : 0;
+		if (fieldMask == 0)
+		{
+			return false;
+		}
+		fieldMask |= isSmallPosition ? SNAPSHOT_FIELD_SMALL_POSITION : 0;
+	}
+
+	AppendBytes(packet, actor.m_handleData);
+	AppendBytes(packet, fieldMask);
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		if ((fieldMask & (SNAPSHOT_FIELD_POSITION_X << axis)) == 0)
+		{
+			continue;
+		}
+		if (isSmallPosition)
+		{
+			AppendBytes(packet, static_cast<signed char>(actor.m_position[axis] - baseActor->m_position[axis]));
+		}
+		else
+		{
+			AppendBytes(packet, actor.m_position[axis]);
+		}
+	}
+	if ((fieldMask & SNAPSHOT_FIELD_YAW) != 0)
+	{
+		AppendBytes(packet, actor.m_yaw);
+	}
+	if ((fieldMask & SNAPSHOT_FIELD_ANIM_STATE) != 0)
+	{
+		AppendBytes(packet, actor.m_animState);
+	}
+	if ((fieldMask & SNAPSHOT_FIELD_HEALTH) != 0)
+	{
+		AppendBytes(packet, actor.m_health);
+	}
+	return true;
+}
+
+static void AppendRemovedEntry(NetPacket& packet, ActorSnapshot const& baseActor)
+{
+	AppendBytes(packet, baseActor.m_handleData);
+	AppendBytes(packet, SNAPSHOT_FIELD_REMOVED);
+}
+
+// -----------------------------------------------------------------------------
+// Packet layout: tick, baseline tick, entry count, then entries in actor index
+// order. An entry is the actor's handle, a field mask and the masked fields.
+// -----------------------------------------------------------------------------
+void MapSnapshot::EncodeDelta(MapSnapshot const* baseline, NetPacket& outPacket) const
+{
+	outPacket.clear();
+	AppendBytes(outPacket, m_tick);
+	AppendBytes(outPacket, (baseline != nullptr) ? baseline->m_tick : SNAPSHOT_NO_BASELINE);
+	size_t countPosition = outPacket.size();
+	unsigned short numEntries = 0;
+	AppendBytes(outPacket, numEntries);
+
+	static std::vector<ActorSnapshot> const s_noActors;
+	std::vector<ActorSnapshot> const& baseActors = (baseline != nullptr) ? baseline->m_actors : s_noActors;
+	int baseIndex = 0;
+	for (int actorIndex = 0; actorIndex < static_cast<int>(m_actors.size()); ++actorIndex)
+	{
+		ActorSnapshot const& actor = m_actors[actorIndex];
+
+		// Baseline actors that come before this one no longer exist
+		while (baseIndex < static_cast<int>(baseActors.size()) &&
+			(GetActorIndex(baseActors[baseIndex]) < GetActorIndex(actor) ||
+			(GetActorIndex(baseActors[baseIndex]) == GetActorIndex(actor) && baseActors[baseIndex].m_handleData != actor.m_handleData)))
+		{
+			AppendRemovedEntry(outPacket, baseActors[baseIndex]);
+			++baseIndex;
+			++numEntries;
+		}
+
+		ActorSnapshot const* baseActor = nullptr;
+		if (baseIndex < static_cast<int>(baseActors.size()) && baseActors[baseIndex].m_handleData == actor.m_handleData)
+		{
+			baseActor = &baseActors[baseIndex];
+			++baseIndex;
+		}
+		if (AppendActorEntry(outPacket, actor, baseActor))
+		{
+			++numEntries;
+		}
+	}
+	for (; baseIndex < static_cast<int>(baseActors.size()); ++baseIndex)
+	{
+		AppendRemovedEntry(outPacket, baseActors[baseIndex]);
+		++numEntries;
+	}
+
+	OverwriteBytes(outPacket, countPosition, numEntries);
+}
+
+bool MapSnapshot::DecodeDelta(NetPacket const& packet, MapSnapshot const* baseline, MapSnapshot& outSnapshot)
+{
+	size_t readPosition = 0;
+	unsigned int baselineTick = SNAPSHOT_NO_BASELINE;
+	unsigned short numEntries = 0;
+	if (!ReadBytes(packet, readPosition, outSnapshot.m_tick) || !ReadBytes(packet, readPosition, baselineTick) || !ReadBytes(packet, readPosition, numEntries))
+	{
+		return false;
+	}
+	if (baselineTick != SNAPSHOT_NO_BASELINE && (baseline == nullptr || baseline->m_tick != baselineTick))
+	{
+		return false;
+	}
+
+	static std::vector<ActorSnapshot> const s_noActors;
+	std::vector<ActorSnapshot> const& baseActors = (baselineTick != SNAPSHOT_NO_BASELINE) ? baseline->m_actors : s_noActors;
+	outSnapshot.m_actors.clear();
+	outSnapshot.m_actors.reserve(baseActors.size() + numEntries);
+
+	int baseIndex = 0;
+	for (int entryIndex = 0; entryIndex < static_cast<int>(numEntries); ++entryIndex)
+	{
+		unsigned int handleData = 0;
+		unsigned char fieldMask = 0;
+		if (!ReadBytes(packet, readPosition, handleData) || !ReadBytes(packet, readPosition, fieldMask))
+		{
+			return false;
+		}
+
+		// Unchanged baseline actors before this entry carry over as they are
+		while (baseIndex < static_cast<int>(baseActors.size()) && GetActorIndex(baseActors[baseIndex]) < (handleData & 0xffffu))
+		{
+			outSnapshot.m_actors.push_back(baseActors[baseIndex]);
+			++baseIndex;
+		}
+
+		ActorSnapshot actor;
+		bool hasBaseActor = baseIndex < static_cast<int>(baseActors.size()) && baseActors[baseIndex].m_handleData == handleData;
+		if (hasBaseActor)
+		{
+			actor = baseActors[baseIndex];
+			++baseIndex;
+		}
+		if ((fieldMask & SNAPSHOT_FIELD_REMOVED) != 0)
+		{
+			continue;
+		}
+		actor.m_handleData = handleData;
+
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			if ((fieldMask & (SNAPSHOT_FIELD_POSITION_X << axis)) == 0)
+			{
+				continue;
+			}
+			if ((fieldMask & SNAPSHOT_FIELD_SMALL_POSITION) != 0)
+			{
+				signed char offset = 0;
+				if (!hasBaseActor || !ReadBytes(packet, readPosition, offset))
+				{
+					return false;
+				}
+				actor.m_position[axis] = static_cast<short>(actor.m_position[axis] + offset);
+			}
+			else if (!ReadBytes(packet, readPosition, actor.m_position[axis]))
+			{
+				return false;
+			}
+		}
+		if (((fieldMask & SNAPSHOT_FIELD_YAW) != 0 && !ReadBytes(packet, readPosition, actor.m_yaw)) ||
+			((fieldMask & SNAPSHOT_FIELD_ANIM_STATE) != 0 && !ReadBytes(packet, readPosition, actor.m_animState)) ||
+			((fieldMask & SNAPSHOT_FIELD_HEALTH) != 0 && !ReadBytes(packet, readPosition, actor.m_health)))
+		{
+			return false;
+		}
+		outSnapshot.m_actors.push_back(actor);
+	}
+	for (; baseIndex < static_cast<int>(baseActors.size()); ++baseIndex)
+	{
+		outSnapshot.m_actors.push_back(baseActors[baseIndex]);
+	}
+	return readPosition == packet.size();
+}
+
+unsigned int MapSnapshot::PeekBaselineTick(NetPacket const& packet)
+{
+	size_t readPosition = sizeof(unsigned int);
+	unsigned int baselineTick = SNAPSHOT_NO_BASELINE;
+	ReadBytes(packet, readPosition, baselineTick);
+	return baselineTick;
+}
+
+SnapshotServer::SnapshotServer(NetTransport* transport, int serverEndpoint)
+	:m_transport(transport), m_serverEndpoint(serverEndpoint)
+{
+}
+
+// Defined here, where the relevancy the clients own is a complete type
+SnapshotServer::~SnapshotServer()
+{
+}
+
+void SnapshotServer::AddClient(int clientEndpoint)
+{
+	ClientState client;
+	client.m_endpoint = clientEndpoint;
+	client.m_relevancy = std::make_unique<SnapshotRelevancy>();
+	m_clients.push_back(std::move(client));
+}
+
+void SnapshotServer::SetClientViewer(int clientIndex, ActorHandle viewerHandle)
+{
+	m_clients[clientIndex].m_viewerHandle = viewerHandle;
+}
+
+void SnapshotServer::SetRelevancyEnabled(bool isRelevancyEnabled)
+{
+	m_isRelevancyEnabled = isRelevancyEnabled;
+}
+
+void SnapshotServer::SendSnapshots(Map const& map)
+{
+	double encodeStart = GetCurrentTimeSeconds();
+	MapSnapshot fullSnapshot = MapSnapshot::Capture(map, m_nextTick);
+	m_nextTick += 1;
+
+	NetPacket packet;
+	m_lastTickBytes = 0;
+	for (int clientIndex = 0; clientIndex < static_cast<int>(m_clients.size()); ++clientIndex)
+	{
+		ClientState& client = m_clients[clientIndex];
+		Actor const* viewer = map.GetActorByHandle(client.m_viewerHandle);
+		if (m_isRelevancyEnabled && viewer != nullptr)
+		{
+			MapSnapshot const* previousView = client.m_views.empty() ? nullptr : &client.m_views.back();
+			MapSnapshot view;
+			client.m_relevancy->BuildView(map, viewer, fullSnapshot, previousView, view);
+			client.m_views.push_back(std::move(view));
+		}
+		else
+		{
+			client.m_views.push_back(fullSnapshot);
+		}
+		if (static_cast<int>(client.m_views.size()) > SNAPSHOT_HISTORY_SIZE)
+		{
+			client.m_views.pop_front();
+		}
+
+		// A client whose ack has fallen out of the history gets a full snapshot
+		client.m_views.back().EncodeDelta(FindView(client, client.m_ackedTick), packet);
+		m_transport->Send(client.m_endpoint, packet);
+		m_lastTickBytes += packet.size();
+	}
+	m_lastTickEncodeSeconds = GetCurrentTimeSeconds() - encodeStart;
+}
+
+void SnapshotServer::ReceiveAcks()
+{
+	NetPacket packet;
+	while (m_transport->Receive(m_serverEndpoint, packet))
+	{
+		size_t readPosition = 0;
+		int clientEndpoint = -1;
+		unsigned int ackedTick = SNAPSHOT_NO_BASELINE;
+		if (!ReadBytes(packet, readPosition, clientEndpoint) || !ReadBytes(packet, readPosition, ackedTick))
+		{
+			continue;
+		}
+		for (int clientIndex = 0; clientIndex < static_cast<int>(m_clients.size()); ++clientIndex)
+		{
+			ClientState& client = m_clients[clientIndex];
+			if (client.m_endpoint != clientEndpoint || (client.m_ackedTick != SNAPSHOT_NO_BASELINE && ackedTick <= client.m_ackedTick))
+			{
+				continue;
+			}
+
+			// Views older than the ack can never be a baseline again
+			client.m_ackedTick = ackedTick;
+			while (!client.m_views.empty() && client.m_views.front().m_tick < ackedTick)
+			{
+				client.m_views.pop_front();
+			}
+		}
+	}
+}
+
+MapSnapshot const* SnapshotServer::GetLatestView(int clientIndex) const
+{
+	std::deque<MapSnapshot> const& views = m_clients[clientIndex].m_views;
+	return views.empty() ? nullptr : &views.back();
+}
+
+MapSnapshot const* SnapshotServer::FindView(ClientState const& client, unsigned int tick) const
+{
+	for (int viewIndex = static_cast<int>(client.m_views.size()) - 1; viewIndex >= 0; --viewIndex)
+	{
+		if (client.m_views[viewIndex].m_tick == tick)
+		{
+			return &client.m_views[viewIndex];
+		}
+	}
+	return nullptr;
+}
+
+SnapshotClient::SnapshotClient(NetTransport* transport, int clientEndpoint, int serverEndpoint)
+	:m_transport(transport), m_clientEndpoint(clientEndpoint), m_serverEndpoint(serverEndpoint)
+{
+}
+
+void SnapshotClient::ReceiveSnapshots()
+{
+	double decodeStart = GetCurrentTimeSeconds();
+	NetPacket packet;
+	while (m_transport->Receive(m_clientEndpoint, packet))
+	{
+		unsigned int baselineTick = MapSnapshot::PeekBaselineTick(packet);
+		MapSnapshot const* baseline = FindSnapshot(baselineTick);
+		MapSnapshot snapshot;
+		if ((baselineTick != SNAPSHOT_NO_BASELINE && baseline == nullptr) || !MapSnapshot::DecodeDelta(packet, baseline, snapshot))
+		{
+			m_numDroppedPackets += 1;
+			continue;
+		}
+
+		m_history.push_back(std::move(snapshot));
+		if (static_cast<int>(m_history.size()) > SNAPSHOT_HISTORY_SIZE)
+		{
+			m_history.pop_front();
+		}
+
+		NetPacket ack;
+		AppendBytes(ack, m_clientEndpoint);
+		AppendBytes(ack, m_history.back().m_tick);
+		m_transport->Send(m_serverEndpoint, ack);
+	}
+	m_lastDecodeSeconds = GetCurrentTimeSeconds() - decodeStart;
+}
+
+MapSnapshot const* SnapshotClient::GetLatestSnapshot() const
+{
+	return m_history.empty() ? nullptr : &m_history.back();
+}
+
+MapSnapshot const* SnapshotClient::FindSnapshot(unsigned int tick) const
+{
+	for (int historyIndex = static_cast<int>(m_history.size()) - 1; historyIndex >= 0; --historyIndex)
+	{
+		if (m_history[historyIndex].m_tick == tick)
+		{
+			return &m_history[historyIndex];
+		}
+	}
+	return nullptr;
+}
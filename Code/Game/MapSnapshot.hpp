@@ -0,0 +1,107 @@
+#pragma once
+#include "Game/NetTransport.hpp"
+#include "Game/ActorHandle.hpp"
+#include <deque>
+#include <memory>
+#include <vector>
+// -----------------------------------------------------------------------------
+class Map;
+class Actor;
+class SnapshotRelevancy;
+// -----------------------------------------------------------------------------
+constexpr unsigned int SNAPSHOT_NO_BASELINE = 0xffffffffu;
+constexpr int SNAPSHOT_HISTORY_SIZE = 32;
+constexpr float SNAPSHOT_POSITION_STEPS_PER_UNIT = 64.f;
+// -----------------------------------------------------------------------------
+// Quantized network view of one actor. Position is fixed point in 1/64 units,
+// yaw is a 16 bit angle and the anim state is the index of the actor's current
+// animation group in its definition.
+// -----------------------------------------------------------------------------
+struct ActorSnapshot
+{
+	unsigned int   m_handleData = 0;
+	short          m_position[3] = {};
+	unsigned short m_yaw = 0;
+	unsigned char  m_animState = 0xff;
+	short          m_health = 0;
+
+	static ActorSnapshot Capture(Actor const& actor);
+	bool operator==(ActorSnapshot const& other) const;
+};
+// -----------------------------------------------------------------------------
+// Every live actor of a map at one tick, in actor index order.
+// -----------------------------------------------------------------------------
+struct MapSnapshot
+{
+	unsigned int m_tick = 0;
+	std::vector<ActorSnapshot> m_actors;
+
+	static MapSnapshot Capture(Map const& map, unsigned int tick);
+
+	// Only the fields that changed since the baseline are written; with no baseline every actor is sent whole
+	void EncodeDelta(MapSnapshot const* baseline, NetPacket& outPacket) const;
+	static bool DecodeDelta(NetPacket const& packet, MapSnapshot const* baseline, MapSnapshot& outSnapshot);
+	static unsigned int PeekBaselineTick(NetPacket const& packet);
+};
+// -----------------------------------------------------------------------------
+// Server side of the snapshot stream. Each client has its own view of the map,
+// either every actor or the relevant ones around the actor it views from, and
+// its update is encoded against the newest view that client has acknowledged.
+// -----------------------------------------------------------------------------
+class SnapshotServer
+{
+public:
+	SnapshotServer(NetTransport* transport, int serverEndpoint);
+	~SnapshotServer();
+
+	void AddClient(int clientEndpoint);
+	void SetClientViewer(int clientIndex, ActorHandle viewerHandle);
+	void SetRelevancyEnabled(bool isRelevancyEnabled);
+	void SendSnapshots(Map const& map);
+	void ReceiveAcks();
+	MapSnapshot const* GetLatestView(int clientIndex) const;
+
+	size_t m_lastTickBytes = 0;
+	double m_lastTickEncodeSeconds = 0.0;
+// -----------------------------------------------------------------------------
+private:
+	struct ClientState
+	{
+		int m_endpoint = -1;
+		unsigned int m_ackedTick = SNAPSHOT_NO_BASELINE;
+		ActorHandle m_viewerHandle = ActorHandle::INVALID;
+		std::unique_ptr<SnapshotRelevancy> m_relevancy;
+		std::deque<MapSnapshot> m_views;
+	};
+
+	MapSnapshot const* FindView(ClientState const& client, unsigned int tick) const;
+
+	NetTransport* m_transport = nullptr;
+	int m_serverEndpoint = 0;
+	bool m_isRelevancyEnabled = false;
+	std::vector<ClientState> m_clients;
+	unsigned int m_nextTick = 0;
+};
+// -----------------------------------------------------------------------------
+// Client side of the snapshot stream. Rebuilds full snapshots from the deltas
+// it receives and acknowledges each one back to the server.
+// -----------------------------------------------------------------------------
+class SnapshotClient
+{
+public:
+	SnapshotClient(NetTransport* transport, int clientEndpoint, int serverEndpoint);
+
+	void ReceiveSnapshots();
+	MapSnapshot const* GetLatestSnapshot() const;
+
+	double m_lastDecodeSeconds = 0.0;
+	int m_numDroppedPackets = 0;
+// -----------------------------------------------------------------------------
+private:
+	MapSnapshot const* FindSnapshot(unsigned int tick) const;
+
+	NetTransport* m_transport = nullptr;
+	int m_clientEndpoint = 0;
+	int m_serverEndpoint = 0;
+	std::deque<MapSnapshot> m_history;
+};
@@ -0,0 +1,322 @@
+#include "Game/NetSession.hpp"
+#include "Game/BenchHelpers.hpp"
+#include "Game/Game.h"
+#include "Game/GameCommon.h"
+#include "Game/Map.hpp"
+#include "Game/Actor.hpp"
+#include "Engine/Core/DevConsole.hpp"
+#include "Engine/Core/EngineCommon.h"
+#include "Engine/Core/Time.hpp"
+
+// Endpoint 0 is the server, loopback clients follow it
+static int const SERVER_ENDPOINT = 0;
+
+NetSession::NetSession(int numLoopbackClients, bool isRelevancyEnabled)
+	:m_transport(numLoopbackClients + 1),
+	 m_server(&m_transport, SERVER_ENDPOINT)
+{
+	m_server.SetRelevancyEnabled(isRelevancyEnabled);
+	m_clients.reserve(numLoopbackClients);
+	for (int clientIndex = 0; clientIndex < numLoopbackClients; ++clientIndex)
+	{
+		m_server.AddClient(clientIndex + 1);
+		m_clients.emplace_back(&m_transport, clientIndex + 1, SERVER_ENDPOINT);
+	}
+}
+
+void NetSession::SetClientViewer(int clientIndex, ActorHandle viewerHandle)
+{
+	m_server.SetClientViewer(clientIndex, viewerHandle);
+}
+
+void NetSession::Tick(Map const& map)
+{
+	// Acks sent during the previous tick pick this tick's baselines
+	m_server.ReceiveAcks();
+	m_server.SendSnapshots(map);
+
+	m_lastTickDecodeSeconds = 0.0;
+	for (int clientIndex = 0; clientIndex < static_cast<int>(m_clients.size()); ++clientIndex)
+	{
+		m_clients[clientIndex].ReceiveSnapshots();
+		m_lastTickDecodeSeconds += m_clients[clientIndex].m_lastDecodeSeconds;
+	}
+}
+
+int NetSession::GetNumClients() const
+{
+	return static_cast<int>(m_clients.size());
+}
+
+// -----------------------------------------------------------------------------
+// Dev console: NetLoopback clients=<count> relevancy=<bool>
+// Streams snapshots of the running map to that many loopback clients every
+// tick, each viewing from one of the local players. Zero clients ends the
+// session.
+// -----------------------------------------------------------------------------
+bool NetSession::Command_NetLoopback(EventArgs& args)
+{
+	int numClients = args.GetValue("clients", 1);
+	bool isRelevancyEnabled = args.GetValue("relevancy", false);
+	delete g_theGame->m_netSession;
+	g_theGame->m_netSession = (numClients > 0) ? new NetSession(numClients, isRelevancyEnabled) : nullptr;
+	g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, Stringf("Snapshot loopback %s with %d clients, relevancy %s", (numClients > 0) ? "running" : "stopped",
+		numClients, isRelevancyEnabled ? "on" : "off"));
+	return true;
+}
+
+// Scatters actors of one type over random open tiles and keeps their handles, since they can die and be deleted mid bench
+static void SpawnBenchActors(Map& map, std::vector<IntVec2> const& openTiles, char const* actorName, int numActors, std::vector<ActorHandle>& outHandles)
+{
+	for (int spawnIndex = 0; spawnIndex < numActors; ++spawnIndex)
+	{
+		IntVec2 tileCoords = RollOpenTile(openTiles);
+		SpawnInfo spawnInfo;
+		spawnInfo.m_actorDef = ActorDefinition::GetByActorName(actorName);
+		spawnInfo.m_position = Vec3(static_cast<float>(tileCoords.x) + 0.5f, static_cast<float>(tileCoords.y) + 0.5f, 0.f);
+		spawnInfo.m_orientation = EulerAngles(GetBenchRng().RollRandomFloatInRange(0.f, 360.f), 0.f, 0.f);
+		Actor* actor = map.SpawnActor(spawnInfo);
+		outHandles.push_back(actor->m_actorHandle);
+	}
+}
+
+static void WanderBenchActors(Map& map, std::vector<ActorHandle> const& handles)
+{
+	for (int handleIndex = 0; handleIndex < static_cast<int>(handles.size()); ++handleIndex)
+	{
+		Actor* actor = map.GetActorByHandle(handles[handleIndex]);
+		if (actor != nullptr && !actor->IsDead())
+		{
+			actor->m_orientation.m_yawDegrees += GetBenchRng().RollRandomFloatInRange(-5.f, 5.f);
+			actor->MoveInDirection(actor->GetForwardNormal(), actor->m_actorDef->m_walkSpeed);
+		}
+	}
+}
+
+static void DestroyBenchActors(Map& map, std::vector<ActorHandle> const& handles)
+{
+	for (int handleIndex = 0; handleIndex < static_cast<int>(handles.size()); ++handleIndex)
+	{
+		Actor* actor = map.GetActorByHandle(handles[handleIndex]);
+		if (actor != nullptr)
+		{
+			actor->Destroy();
+		}
+	}
+	map.DeleteDestroyedActors();
+}
+
+// -----------------------------------------------------------------------------
+// Dev console: NetSnapshotBench players=<count> demons=<count> ticks=<count>
+// Spawns wandering marines and demons into the running map, streams each tick
+// to one loopback client per marine, and reports bytes per tick plus encode
+// and decode times. Every client's rebuilt snapshot is checked against the map.
+// -----------------------------------------------------------------------------
+bool NetSession::Command_NetSnapshotBench(EventArgs& args)
+{
+	Map* map = g_theGame->m_defaultMap;
+	if (g_theGame->m_currentState != GameState::PLAYING || map == nullptr)
+	{
+		g_theDevConsole->AddLine(Rgba8::RED, "NetSnapshotBench needs a game in progress");
+		return false;
+	}
+
+	int numPlayers = args.GetValue("players", 64);
+	int numDemons = args.GetValue("demons", 2000);
+	int numTicks = args.GetValue("ticks", 60);
+	numTicks = (numTicks < 1) ? 1 : numTicks;
+
+	std::vector<IntVec2> openTiles;
+	if (!GatherOpenTiles(*map, "NetSnapshotBench", openTiles))
+	{
+		return false;
+	}
+
+	std::vector<ActorHandle> benchPlayers;
+	std::vector<ActorHandle> benchDemons;
+	SpawnBenchActors(*map, openTiles, "Marine", numPlayers, benchPlayers);
+	SpawnBenchActors(*map, openTiles, "Demon", numDemons, benchDemons);
+
+	NetSession session(numPlayers, false);
+	float deltaSeconds = 1.f / 60.f;
+	size_t fullSnapshotBytes = 0;
+	size_t deltaBytes = 0;
+	double encodeSeconds = 0.0;
+	double decodeSeconds = 0.0;
+	for (int tickIndex = 0; tickIndex < numTicks; ++tickIndex)
+	{
+		WanderBenchActors(*map, benchPlayers);
+		map->Update(deltaSeconds);
+		session.Tick(*map);
+
+		if (tickIndex == 0)
+		{
+			fullSnapshotBytes = session.m_server.m_lastTickBytes;
+		}
+		else
+		{
+			deltaBytes += session.m_server.m_lastTickBytes;
+		}
+		encodeSeconds += session.m_server.m_lastTickEncodeSeconds;
+		decodeSeconds += session.m_lastTickDecodeSeconds;
+	}
+
+	// Every client has just decoded the latest tick, so it should match the map exactly
+	MapSnapshot serverSnapshot = MapSnapshot::Capture(*map, static_cast<unsigned int>(numTicks - 1));
+	int numMismatchedClients = 0;
+	int numDroppedPackets = 0;
+	for (int clientIndex = 0; clientIndex < session.GetNumClients(); ++clientIndex)
+	{
+		MapSnapshot const* clientSnapshot = session.m_clients[clientIndex].GetLatestSnapshot();
+		numDroppedPackets += session.m_clients[clientIndex].m_numDroppedPackets;
+		if (clientSnapshot == nullptr || clientSnapshot->m_actors != serverSnapshot.m_actors)
+		{
+			numMismatchedClients += 1;
+		}
+	}
+
+	DestroyBenchActors(*map, benchPlayers);
+	DestroyBenchActors(*map, benchDemons);
+
+	int numDeltaTicks = (numTicks > 1) ? numTicks - 1 : 1;
+	int numClients = (numPlayers > 0) ? numPlayers : 1;
+	g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, Stringf("Snapshot bench: %d players, %d demons, %d actors in snapshot, %d ticks",
+		numPlayers, numDemons, static_cast<int>(serverSnapshot.m_actors.size()), numTicks));
+	g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, Stringf("Full snapshot %d bytes per client, delta %.0f bytes per client per tick (%.0f bytes per tick total)",
+		static_cast<int>(fullSnapshotBytes) / numClients, static_cast<double>(deltaBytes) / numDeltaTicks / numClients, static_cast<double>(deltaBytes) / numDeltaTicks));
+	g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, Stringf("Capture and encode %.3f ms per tick, decode %.3f ms per tick across all clients",
+		encodeSeconds * 1000.0 / numTicks, decodeSeconds * 1000.0 / numTicks));
+	g_theDevConsole->AddLine((numMismatchedClients == 0) ? Rgba8::LIGHTYELLOW : Rgba8::RED, Stringf("%d of %d clients mismatched the server, %d packets dropped",
+		numMismatchedClients, session.GetNumClients(), numDroppedPackets));
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Dev console: NetRelevancyBench clients=<count> seconds=<seconds> spawnMs=<milliseconds>
+// Speeds up every enemy spawner in the running map, spawns one wandering marine
+// per client and streams the same ticks to two loopback sessions, one sending
+// every actor and one sending only relevant actors. Reports bytes per client per
+// second for both and checks every client against the view the server sent it.
+// -----------------------------------------------------------------------------
+bool NetSession::Command_NetRelevancyBench(EventArgs& args)
+{
+	Map* map = g_theGame->m_defaultMap;
+	if (g_theGame->m_currentState != GameState::PLAYING || map == nullptr)
+	{
+		g_theDevConsole->AddLine(Rgba8::RED, "NetRelevancyBench needs a game in progress");
+		return false;
+	}
+
+	int numClients = args.GetValue("clients", 16);
+	int numSeconds = args.GetValue("seconds", 10);
+	float spawnInterval = static_cast<float>(args.GetValue("spawnMs", 50)) * 0.001f;
+	numClients = (numClients < 1) ? 1 : numClients;
+	numSeconds = (numSeconds < 1) ? 1 : numSeconds;
+	spawnInterval = (spawnInterval < 0.001f) ? 0.001f : spawnInterval;
+
+	std::vector<IntVec2> openTiles;
+	if (!GatherOpenTiles(*map, "NetRelevancyBench", openTiles))
+	{
+		return false;
+	}
+
+	int numActorsBeforeBench = static_cast<int>(map->m_allActors.size());
+	std::vector<float> savedSpawnIntervals;
+	for (int actorIndex = 0; actorIndex < numActorsBeforeBench; ++actorIndex)
+	{
+		Actor* actor = map->m_allActors[actorIndex];
+		if (actor != nullptr && actor->m_actorDef->m_actorName == "EnemySpawner")
+		{
+			savedSpawnIntervals.push_back(actor->m_enemySpawnInterval);
+			actor->m_enemySpawnInterval = spawnInterval;
+		}
+	}
+
+	std::vector<ActorHandle> benchViewers;
+	SpawnBenchActors(*map, openTiles, "Marine", numClients, benchViewers);
+
+	NetSession fullSession(numClients, false);
+	NetSession relevantSession(numClients, true);
+	for (int clientIndex = 0; clientIndex < numClients; ++clientIndex)
+	{
+		fullSession.SetClientViewer(clientIndex, benchViewers[clientIndex]);
+		relevantSession.SetClientViewer(clientIndex, benchViewers[clientIndex]);
+	}
+
+	float deltaSeconds = 1.f / 60.f;
+	int numTicks = numSeconds * 60;
+	size_t fullBytes = 0;
+	size_t relevantBytes = 0;
+	double fullEncodeSeconds = 0.0;
+	double relevantEncodeSeconds = 0.0;
+	int peakActors = 0;
+	for (int tickIndex = 0; tickIndex < numTicks; ++tickIndex)
+	{
+		WanderBenchActors(*map, benchViewers);
+		map->Update(deltaSeconds);
+		fullSession.Tick(*map);
+		relevantSession.Tick(*map);
+		fullBytes += fullSession.m_server.m_lastTickBytes;
+		relevantBytes += relevantSession.m_server.m_lastTickBytes;
+		fullEncodeSeconds += fullSession.m_server.m_lastTickEncodeSeconds;
+		relevantEncodeSeconds += relevantSession.m_server.m_lastTickEncodeSeconds;
+		int numActors = 0;
+		for (int actorIndex = 0; actorIndex < static_cast<int>(map->m_allActors.size()); ++actorIndex)
+		{
+			numActors += (map->m_allActors[actorIndex] != nullptr) ? 1 : 0;
+		}
+		peakActors = (numActors > peakActors) ? numActors : peakActors;
+	}
+
+	// Each client has just decoded the latest tick, so it should match the view the server built for it
+	int numMismatchedClients = 0;
+	int numDroppedPackets = 0;
+	for (int clientIndex = 0; clientIndex < numClients; ++clientIndex)
+	{
+		NetSession const* sessions[2] = { &fullSession, &relevantSession };
+		for (int sessionIndex = 0; sessionIndex < 2; ++sessionIndex)
+		{
+			MapSnapshot const* clientSnapshot = sessions[sessionIndex]->m_clients[clientIndex].GetLatestSnapshot();
+			MapSnapshot const* serverView = sessions[sessionIndex]->m_server.GetLatestView(clientIndex);
+			numDroppedPackets += sessions[sessionIndex]->m_clients[clientIndex].m_numDroppedPackets;
+			if (clientSnapshot == nullptr || serverView == nullptr || clientSnapshot->m_actors != serverView->m_actors)
+			{
+				numMismatchedClients += 1;
+			}
+		}
+	}
+	int numRelevantActors = static_cast<int>(relevantSession.m_server.GetLatestView(0)->m_actors.size());
+
+	// Put the spawners back and clear out everything the bench added, leaving the players' own actors alone
+	int spawnerIndex = 0;
+	for (int actorIndex = 0; actorIndex < static_cast<int>(map->m_allActors.size()); ++actorIndex)
+	{
+		Actor* actor = map->m_allActors[actorIndex];
+		if (actor == nullptr)
+		{
+			continue;
+		}
+		if (actorIndex < numActorsBeforeBench && actor->m_actorDef->m_actorName == "EnemySpawner")
+		{
+			actor->m_enemySpawnInterval = savedSpawnIntervals[spawnerIndex];
+			spawnerIndex += 1;
+		}
+		bool isPlayerActor = actor->m_controller != nullptr && actor->m_controller != actor->m_aiController;
+		if (actorIndex >= numActorsBeforeBench && !isPlayerActor)
+		{
+			actor->Destroy();
+		}
+	}
+	map->DeleteDestroyedActors();
+
+	double clientSeconds = static_cast<double>(numClients) * static_cast<double>(numSeconds);
+	g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, Stringf("Relevancy bench on %s: %d clients, %d seconds, %d spawners every %.3f s, peak %d actors",
+		map->m_definition->m_name.c_str(), numClients, numSeconds, static_cast<int>(savedSpawnIntervals.size()), spawnInterval, peakActors));
+	g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, Stringf("All actors: %.0f bytes per client per second, encode %.3f ms per tick",
+		static_cast<double>(fullBytes) / clientSeconds, fullEncodeSeconds * 1000.0 / numTicks));
+	g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, Stringf("Relevant actors: %.0f bytes per client per second, encode %.3f ms per tick, %d actors in client 0's view",
+		static_cast<double>(relevantBytes) / clientSeconds, relevantEncodeSeconds * 1000.0 / numTicks, numRelevantActors));
+	g_theDevConsole->AddLine((numMismatchedClients == 0) ? Rgba8::LIGHTYELLOW : Rgba8::RED, Stringf("%d of %d client views mismatched the server, %d packets dropped",
+		numMismatchedClients, numClients * 2, numDroppedPackets));
+	return true;
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include "Game/MapSnapshot.hpp"
+#include "Game/NetTransport.hpp"
+#include "Game/ActorHandle.hpp"
+#include "Engine/Core/EventSystem.hpp"
+#include <vector>
+// -----------------------------------------------------------------------------
+class Map;
+// -----------------------------------------------------------------------------
+// Server-authoritative snapshot session over the loopback transport. The local
+// map is the server and every loopback client rebuilds it from the snapshot
+// stream, acknowledging each snapshot so the next one can be a delta. With
+// relevancy on, each client only receives the actors that matter to its viewer.
+// -----------------------------------------------------------------------------
+class NetSession
+{
+public:
+	NetSession(int numLoopbackClients, bool isRelevancyEnabled);
+
+	void SetClientViewer(int clientIndex, ActorHandle viewerHandle);
+	void Tick(Map const& map);
+	int GetNumClients() const;
+
+	static bool Command_NetLoopback(EventArgs& args);
+	static bool Command_NetSnapshotBench(EventArgs& args);
+	static bool Command_NetRelevancyBench(EventArgs& args);
+
+	LoopbackTransport m_transport;
+	SnapshotServer m_server;
+	std::vector<SnapshotClient> m_clients;
+	double m_lastTickDecodeSeconds = 0.0;
+};
@@ -0,0 +1,31 @@
+#include "Game/NetTransport.hpp"
+#include "Engine/Core/ErrorWarningAssert.hpp"
+
+LoopbackTransport::LoopbackTransport(int numEndpoints)
+	:m_endpointQueues(numEndpoints)
+{
+}
+
+void LoopbackTransport::Send(int toEndpoint, NetPacket const& packet)
+{
+	GUARANTEE_OR_DIE(toEndpoint >= 0 && toEndpoint < static_cast<int>(m_endpointQueues.size()), "Loopback send to an unknown endpoint");
+	m_endpointQueues[toEndpoint].push_back(packet);
+	m_totalBytesSent += packet.size();
+}
+
+bool LoopbackTransport::Receive(int endpoint, NetPacket& outPacket)
+{
+	std::deque<NetPacket>& queue = m_endpointQueues[endpoint];
+	if (queue.empty())
+	{
+		return false;
+	}
+	outPacket = std::move(queue.front());
+	queue.pop_front();
+	return true;
+}
+
+size_t LoopbackTransport::GetTotalBytesSent() const
+{
+	return m_totalBytesSent;
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <cstddef>
+#include <deque>
+#include <vector>
+// -----------------------------------------------------------------------------
+typedef std::vector<unsigned char> NetPacket;
+// -----------------------------------------------------------------------------
+// Unreliable packet delivery between numbered endpoints. Snapshot code only
+// talks to this interface, so a socket implementation can replace the loopback.
+// -----------------------------------------------------------------------------
+class NetTransport
+{
+public:
+	virtual ~NetTransport() = default;
+	virtual void Send(int toEndpoint, NetPacket const& packet) = 0;
+	virtual bool Receive(int endpoint, NetPacket& outPacket) = 0;
+};
+// -----------------------------------------------------------------------------
+// In-process transport, every packet sent to an endpoint waits in its queue
+// until that endpoint receives it. Counts the bytes it carries.
+// -----------------------------------------------------------------------------
+class LoopbackTransport : public NetTransport
+{
+public:
+	explicit LoopbackTransport(int numEndpoints);
+
+	void Send(int toEndpoint, NetPacket const& packet) override;
+	bool Receive(int endpoint, NetPacket& outPacket) override;
+
+	size_t GetTotalBytesSent() const;
+// -----------------------------------------------------------------------------
+private:
+	std::vector<std::deque<NetPacket>> m_endpointQueues;
+	size_t m_totalBytesSent = 0;
+};
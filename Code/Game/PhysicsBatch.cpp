@@ -0,0 +1,205 @@
+#include "Game/PhysicsBatch.hpp"
+#include "Game/GameCommon.h"
+#include "Game/Actor.hpp"
+#include "Game/BenchHelpers.hpp"
+#include "Game/SimdFloat.hpp"
+#include "Engine/Core/DevConsole.hpp"
+#include "Engine/Core/EngineCommon.h"
+#include "Engine/Core/Time.hpp"
+#include <cstring>
+
+// Actors that would have run physics in their own update: simulated, alive and animated
+void PhysicsBatch::Gather(std::vector<Actor*> const& actors)
+{
+	m_actors.clear();
+	for (int actorIndex = 0; actorIndex < static_cast<int>(actors.size()); ++actorIndex)
+	{
+		Actor* actor = actors[actorIndex];
+		if (actor != nullptr && actor->m_actorDef->m_isSimulated && actor->HasTickWork())
+		{
+			m_actors.push_back(actor);
+		}
+	}
+
+	Resize(static_cast<int>(m_actors.size()));
+	for (int batchIndex = 0; batchIndex < m_numActors; ++batchIndex)
+	{
+		Actor const* actor = m_actors[batchIndex];
+		m_positionX[batchIndex] = actor->m_position.x;
+		m_positionY[batchIndex] = actor->m_position.y;
+		m_positionZ[batchIndex] = actor->m_position.z;
+		m_velocityX[batchIndex] = actor->m_velocity.x;
+		m_velocityY[batchIndex] = actor->m_velocity.y;
+		m_velocityZ[batchIndex] = actor->m_velocity.z;
+		m_accelerationX[batchIndex] = actor->m_acceleration.x;
+		m_accelerationY[batchIndex] = actor->m_acceleration.y;
+		m_accelerationZ[batchIndex] = actor->m_acceleration.z;
+		m_negativeDrag[batchIndex] = -actor->m_actorDef->m_drag;
+		m_slowAmount[batchIndex] = actor->m_isSlowed ? actor->m_slowAmount : 1.f;
+		m_heightPinWeight[batchIndex] = actor->m_actorDef->m_heightPinWeight;
+		m_pinnedHeight[batchIndex] = actor->m_actorDef->m_pinnedHeight;
+	}
+}
+
+// -----------------------------------------------------------------------------
+// Same operations in the same order as IntegrateScalar, so both give the same
+// bits: pin the height, add drag to the acceleration, integrate velocity then
+// position, and scale the velocity by the slow.
+// -----------------------------------------------------------------------------
+void PhysicsBatch::Integrate(float deltaSeconds)
+{
+	SimdFloat deltaTime = SimdSet(deltaSeconds);
+	SimdFloat one = SimdSet(1.f);
+	for (int batchIndex = 0; batchIndex < m_numActors; batchIndex += SIMD_FLOAT_WIDTH)
+	{
+		SimdFloat negativeDrag = SimdLoad(&m_negativeDrag[batchIndex]);
+		SimdFloat slowAmount = SimdLoad(&m_slowAmount[batchIndex]);
+		SimdFloat pinWeight = SimdLoad(&m_heightPinWeight[batchIndex]);
+		SimdFloat pinnedZ = (SimdLoad(&m_positionZ[batchIndex]) * (one - pinWeight)) + (SimdLoad(&m_pinnedHeight[batchIndex]) * pinWeight);
+
+		float* positions[3] = { &m_positionX[batchIndex], &m_positionY[batchIndex], &m_positionZ[batchIndex] };
+		float* velocities[3] = { &m_velocityX[batchIndex], &m_velocityY[batchIndex], &m_velocityZ[batchIndex] };
+		float const* accelerations[3] = { &m_accelerationX[batchIndex], &m_accelerationY[batchIndex], &m_accelerationZ[batchIndex] };
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			SimdFloat position = (axis == 2) ? pinnedZ : SimdLoad(positions[axis]);
+			SimdFloat velocity = SimdLoad(velocities[axis]);
+			SimdFloat acceleration = SimdLoad(accelerations[axis]) + (negativeDrag * velocity);
+			velocity = velocity + (acceleration * deltaTime);
+			position = position + (velocity * deltaTime);
+			SimdStore(positions[axis], position);
+			SimdStore(velocities[axis], velocity * slowAmount);
+		}
+	}
+}
+
+void PhysicsBatch::IntegrateScalar(float deltaSeconds)
+{
+	for (int batchIndex = 0; batchIndex < m_numActors; ++batchIndex)
+	{
+		float pinWeight = m_heightPinWeight[batchIndex];
+		m_positionZ[batchIndex] = (m_positionZ[batchIndex] * (1.f - pinWeight)) + (m_pinnedHeight[batchIndex] * pinWeight);
+
+		float* positions[3] = { &m_positionX[batchIndex], &m_positionY[batchIndex], &m_positionZ[batchIndex] };
+		float* velocities[3] = { &m_velocityX[batchIndex], &m_velocityY[batchIndex], &m_velocityZ[batchIndex] };
+		float const* accelerations[3] = { &m_accelerationX[batchIndex], &m_accelerationY[batchIndex], &m_accelerationZ[batchIndex] };
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			float velocity = *velocities[axis];
+			float acceleration = *accelerations[axis] + (m_negativeDrag[batchIndex] * velocity);
+			velocity = velocity + (acceleration * deltaSeconds);
+			*positions[axis] = *positions[axis] + (velocity * deltaSeconds);
+			*velocities[axis] = velocity * m_slowAmount[batchIndex];
+		}
+	}
+}
+
+// Acceleration is used up by the step, so actors start the next one from zero
+void PhysicsBatch::Scatter() const
+{
+	for (int batchIndex = 0; batchIndex < m_numActors; ++batchIndex)
+	{
+		Actor* actor = m_actors[batchIndex];
+		actor->m_position = Vec3(m_positionX[batchIndex], m_positionY[batchIndex], m_positionZ[batchIndex]);
+		actor->m_velocity = Vec3(m_velocityX[batchIndex], m_velocityY[batchIndex], m_velocityZ[batchIndex]);
+		actor->m_acceleration = Vec3::ZERO;
+	}
+}
+
+// Padding lanes are zeroed so the last row integrates harmless numbers
+void PhysicsBatch::Resize(int numActors)
+{
+	m_numActors = numActors;
+	int numPadded = ((numActors + SIMD_FLOAT_WIDTH - 1) / SIMD_FLOAT_WIDTH) * SIMD_FLOAT_WIDTH;
+	std::vector<float>* arrays[] = { &m_positionX, &m_positionY, &m_positionZ, &m_velocityX, &m_velocityY, &m_velocityZ,
+		&m_accelerationX, &m_accelerationY, &m_accelerationZ, &m_negativeDrag, &m_slowAmount, &m_heightPinWeight, &m_pinnedHeight };
+	for (std::vector<float>* array : arrays)
+	{
+		array->resize(numPadded);
+		for (int padIndex = numActors; padIndex < numPadded; ++padIndex)
+		{
+			(*array)[padIndex] = 0.f;
+		}
+	}
+}
+
+int PhysicsBatch::GetNumActors() const
+{
+	return m_numActors;
+}
+
+// -----------------------------------------------------------------------------
+// Dev console: PhysicsBench actors=<count> steps=<count>
+// Fills a batch with random actors, a third walking, a third hovering and a
+// third flying freely with some slowed, then integrates copies of it with the
+// scalar loop and the SIMD kernel. Prints actor steps per second for each and
+// how many floats differ between the two.
+// -----------------------------------------------------------------------------
+static void FillBenchBatch(PhysicsBatch& batch, int numActors)
+{
+	BenchRandom& rng = GetBenchRng();
+	batch.Resize(numActors);
+	for (int actorIndex = 0; actorIndex < numActors; ++actorIndex)
+	{
+		batch.m_positionX[actorIndex] = rng.RollRandomFloatInRange(0.f, 64.f);
+		batch.m_positionY[actorIndex] = rng.RollRandomFloatInRange(0.f, 64.f);
+		batch.m_positionZ[actorIndex] = rng.RollRandomFloatInRange(0.f, 1.f);
+		batch.m_velocityX[actorIndex] = rng.RollRandomFloatInRange(-5.f, 5.f);
+		batch.m_velocityY[actorIndex] = rng.RollRandomFloatInRange(-5.f, 5.f);
+		batch.m_velocityZ[actorIndex] = rng.RollRandomFloatInRange(-1.f, 1.f);
+		batch.m_accelerationX[actorIndex] = rng.RollRandomFloatInRange(-20.f, 20.f);
+		batch.m_accelerationY[actorIndex] = rng.RollRandomFloatInRange(-20.f, 20.f);
+		batch.m_accelerationZ[actorIndex] = 0.f;
+		batch.m_negativeDrag[actorIndex] = -rng.RollRandomFloatInRange(0.f, 9.f);
+		batch.m_slowAmount[actorIndex] = (rng.RollRandomIntInRange(0, 9) == 0) ? 0.5f : 1.f;
+		int heightMode = actorIndex % 3;
+		batch.m_heightPinWeight[actorIndex] = (heightMode == 2) ? 0.f : 1.f;
+		batch.m_pinnedHeight[actorIndex] = (heightMode == 1) ? 0.35f : 0.f;
+	}
+}
+
+bool PhysicsBatch::Command_PhysicsBench(EventArgs& args)
+{
+	int numActors = args.GetValue("actors", 1000000);
+	int numSteps = args.GetValue("steps", 20);
+	numActors = (numActors < 1) ? 1 : numActors;
+	numSteps = (numSteps < 1) ? 1 : numSteps;
+	float deltaSeconds = 1.f / 60.f;
+
+	PhysicsBatch scalarBatch;
+	FillBenchBatch(scalarBatch, numActors);
+	PhysicsBatch simdBatch = scalarBatch;
+
+	double scalarStart = GetCurrentTimeSeconds();
+	for (int stepIndex = 0; stepIndex < numSteps; ++stepIndex)
+	{
+		scalarBatch.IntegrateScalar(deltaSeconds);
+	}
+	double scalarSeconds = GetCurrentTimeSeconds() - scalarStart;
+
+	double simdStart = GetCurrentTimeSeconds();
+	for (int stepIndex = 0; stepIndex < numSteps; ++stepIndex)
+	{
+		simdBatch.Integrate(deltaSeconds);
+	}
+	double simdSeconds = GetCurrentTimeSeconds() - simdStart;
+
+	int numMismatches = 0;
+	std::vector<float> const* scalarArrays[] = { &scalarBatch.m_positionX, &scalarBatch.m_positionY, &scalarBatch.m_positionZ, &scalarBatch.m_velocityX, &scalarBatch.m_velocityY, &scalarBatch.m_velocityZ };
+	std::vector<float> const* simdArrays[] = { &simdBatch.m_positionX, &simdBatch.m_positionY, &simdBatch.m_positionZ, &simdBatch.m_velocityX, &simdBatch.m_velocityY, &simdBatch.m_velocityZ };
+	for (int arrayIndex = 0; arrayIndex < 6; ++arrayIndex)
+	{
+		for (int actorIndex = 0; actorIndex < numActors; ++actorIndex)
+		{
+			numMismatches += (memcmp(&(*scalarArrays[arrayIndex])[actorIndex], &(*simdArrays[arrayIndex])[actorIndex], sizeof(float)) == 0) ? 0 : 1;
+		}
+	}
+
+	double actorSteps = static_cast<double>(numActors) * static_cast<double>(numSteps);
+	double scalarRate = actorSteps / (scalarSeconds * 1000000.0);
+	double simdRate = actorSteps / (simdSeconds * 1000000.0);
+	g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, Stringf("%d actors x %d steps: scalar %.1f M actor-steps/s, %s x%d %.1f M actor-steps/s (%.2fx)",
+		numActors, numSteps, scalarRate, GetSimdFloatName(), SIMD_FLOAT_WIDTH, simdRate, simdRate / scalarRate));
+	g_theDevConsole->AddLine((numMismatches == 0) ? Rgba8::LIGHTYELLOW : Rgba8::RED, Stringf("  %d floats differ between the two", numMismatches));
+	return true;
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include "Engine/Core/EventSystem.hpp"
+#include <vector>
+// -----------------------------------------------------------------------------
+class Actor;
+// -----------------------------------------------------------------------------
+// Physics state of every actor that moves this tick, one array per component
+// so drag, acceleration, velocity and position integrate a SIMD row of actors
+// at a time. Per-actor choices are gathered as numbers: the height pin is a
+// blend weight and an actor that is not slowed has a slow amount of one, so
+// the kernel never branches. Arrays are padded to a whole row.
+// -----------------------------------------------------------------------------
+class PhysicsBatch
+{
+public:
+	PhysicsBatch() = default;
+
+	void Gather(std::vector<Actor*> const& actors);
+	void Integrate(float deltaSeconds);
+	void IntegrateScalar(float deltaSeconds);
+	void Scatter() const;
+	void Resize(int numActors);
+	int  GetNumActors() const;
+
+	std::vector<float> m_positionX;
+	std::vector<float> m_positionY;
+	std::vector<float> m_positionZ;
+	std::vector<float> m_velocityX;
+	std::vector<float> m_velocityY;
+	std::vector<float> m_velocityZ;
+	std::vector<float> m_accelerationX;
+	std::vector<float> m_accelerationY;
+	std::vector<float> m_accelerationZ;
+	std::vector<float> m_negativeDrag;
+	std::vector<float> m_slowAmount;
+	std::vector<float> m_heightPinWeight;
+	std::vector<float> m_pinnedHeight;
+
+	static bool Command_PhysicsBench(EventArgs& args);
+// -----------------------------------------------------------------------------
+private:
+	std::vector<Actor*> m_actors;
+	int m_numActors = 0;
+};
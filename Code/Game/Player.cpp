@@ -1,10 +1,20 @@
 #include "Game/Player.hpp"
 #include "Game/Actor.hpp"
 #include "Game/App.h"
+#include "Game/FrameArena.hpp"
+#include "Game/FrameStats.hpp"
+#include "Game/WeaponDefinition.hpp"
 #include "Engine/Core/EngineCommon.h"
+#include "Engine/Core/DevConsole.hpp"
+#include "Engine/Core/Time.hpp"
 #include "Engine/Input/InputSystem.h"
 #include "Engine/Math/MathUtils.h"
 #include "Engine/Core/DebugRender.hpp"
+#include <cmath>
+
+static constexpr float BOT_FIRE_CONE_DEGREES = 5.f;	// Bots fire once the target is within this of dead ahead
+
+bool Player::s_isHudCacheEnabled = true;
 
 Player::Player(Map* map, int playerID)
 	:Controller(map), m_playerID(playerID)
@@ -39,16 +49,7 @@ void Player::Update(float deltaSeconds)
 			m_orientation.m_yawDegrees = possessedActor->m_orientation.m_yawDegrees;
 			m_orientation.m_pitchDegrees = possessedActor->m_orientation.m_pitchDegrees;
 			possessedActor->m_orientation.m_pitchDegrees = GetClamped(possessedActor->m_orientation.m_pitchDegrees, -85.f, 85.f);
-			if (m_playerID == 0)
-			{
-				HandleControllerPlayerMovement(deltaSeconds);
-			}
-			else if (m_playerID == 1)
-			{
-				possessedActor->m_orientation.m_yawDegrees += g_theInput->GetCursorClientDelta().x * 0.075f;
-				possessedActor->m_orientation.m_pitchDegrees -= g_theInput->GetCursorClientDelta().y * 0.075f;
-				HandleKeyboardPlayerMovement(deltaSeconds);
-			}
+			ExecuteCommand(m_command, deltaSeconds);
 		}
 		else if (possessedActor && possessedActor->m_isDead)
 		{
@@ -68,6 +69,97 @@ void Player::Update(float deltaSeconds)
 	m_playerCamera.SetPositionAndOrientation(m_position, m_orientation);
 }
 
+// -----------------------------------------------------------------------------
+// Reads this player's device, or asks its bot, for a command. Only camera
+// toggling acts on the spot, anything that changes the simulation is queued.
+// -----------------------------------------------------------------------------
+PlayerCommand Player::SampleCommand(float deltaSeconds)
+{
+	PlayerCommand command;
+	if (m_currentCameraMode != CameraMode::ACTOR_CAMERA || g_theGame->m_currentState != GameState::PLAYING)
+	{
+		return command;
+	}
+
+	Actor* possessedActor = GetActor();
+	if (possessedActor == nullptr || possessedActor->m_isDead)
+	{
+		return command;
+	}
+
+	if (m_commandSource == PlayerCommandSource::BOT)
+	{
+		command = SampleBotCommand(possessedActor, deltaSeconds);
+	}
+	else if (m_playerID == 0)
+	{
+		command = SampleControllerCommand(possessedActor, deltaSeconds);
+	}
+	else if (m_playerID == 1)
+	{
+		if (g_theInput->WasKeyJustPressed('F') && !g_theGame->m_hasTwoPlayers)
+		{
+			ToggleCameraMode(CameraMode::FREEFLY_CAMERA);
+		}
+		command = SampleKeyboardCommand();
+	}
+	command.Quantize();
+	return command;
+}
+
+void Player::ExecuteCommand(PlayerCommand const& command, float deltaSeconds)
+{
+	Actor* possessedActor = GetActor();
+	if (possessedActor == nullptr || possessedActor->m_isDead)
+	{
+		return;
+	}
+
+	// Look/aim
+	possessedActor->m_orientation.m_yawDegrees += command.m_lookDelta.x;
+	possessedActor->m_orientation.m_pitchDegrees += command.m_lookDelta.y;
+
+	Vec3 forward = possessedActor->GetModelToWorldTransform().GetIBasis3D();
+	Vec3 left = possessedActor->GetModelToWorldTransform().GetJBasis3D();
+	float movementSpeed = command.m_isRunning ? possessedActor->m_actorDef->m_runSpeed : possessedActor->m_actorDef->m_walkSpeed;
+
+	// Movement
+	if (command.m_isAnalogMove)
+	{
+		possessedActor->m_position += forward * command.m_move.x * movementSpeed * deltaSeconds;
+		possessedActor->m_position += left * command.m_move.y * movementSpeed * deltaSeconds;
+	}
+	else
+	{
+		if (command.m_move.x != 0.f)
+		{
+			possessedActor->MoveInDirection(forward * command.m_move.x, movementSpeed);
+			possessedActor->PlayAnimation("Walk");
+		}
+		if (command.m_move.y != 0.f)
+		{
+			possessedActor->MoveInDirection(left * command.m_move.y, movementSpeed);
+			possessedActor->PlayAnimation("Walk");
+		}
+	}
+
+	// Attack
+	if (command.m_isFiring)
+	{
+		possessedActor->Attack();
+	}
+
+	// Weapons
+	if (command.m_equipWeapon >= 0)
+	{
+		possessedActor->EquipWeapon(command.m_equipWeapon);
+	}
+	if (command.m_cycleWeapon != 0)
+	{
+		CycleWeapon(possessedActor, command.m_cycleWeapon);
+	}
+}
+
 void Player::Render() const
 {
 	g_theRenderer->BeginCamera(m_playerViewCamera);
@@ -76,7 +168,6 @@ void Player::Render() const
 		return;
 	}
 
-	std::vector<Vertex_PCU> hudVerts;
 	AABB2 screenBox = AABB2(GetNormalizedScreen().m_mins * Vec2(SCREEN_SIZE_X, SCREEN_SIZE_Y), GetNormalizedScreen().m_maxs * Vec2(SCREEN_SIZE_X, SCREEN_SIZE_Y));
 
 	Actor* possessedActor = GetActor();
@@ -87,7 +178,6 @@ void Player::Render() const
 
 	Weapon* weapon = possessedActor->m_equippedWeapon;
 	float weaponScale = (GetNormalizedScreen().GetDimensions().x * GetNormalizedScreen().GetDimensions().y);
-	Vec2 retSize = Vec2(static_cast<float>(weapon->m_weaponDef->m_reticleSize.x), static_cast<float>(weapon->m_weaponDef->m_reticleSize.y));
 	Vec2 bM = screenBox.GetPointAtUV(Vec2(0.5f, 0.128f / GetNormalizedScreen().GetDimensions().y));
 	Vec2 bL = bM - Vec2((float)weapon->m_weaponDef->m_spriteSize.x * 0.5f * weaponScale, 0.f);
 	Vec2 tR = bM + Vec2((float)weapon->m_weaponDef->m_spriteSize.x * 0.5f * weaponScale, (float)weapon->m_weaponDef->m_spriteSize.y * weaponScale);
@@ -96,62 +186,59 @@ void Player::Render() const
 	// If actor is dead draw transparent gray quad
 	if (possessedActor->m_isDead)
 	{
-		std::vector<Vertex_PCU> deadVerts;
+		std::vector<Vertex_PCU>& deadVerts = g_frameArena->AllocateVerts();
 		AddVertsForAABB2D(deadVerts, AABB2(Vec2::ZERO, Vec2(SCREEN_SIZE_X, SCREEN_SIZE_Y)), Rgba8(0, 0, 0, 80));
 		g_theRenderer->SetBlendMode(BlendMode::ALPHA);
 		g_theRenderer->SetRasterizerMode(RasterizerMode::SOLID_CULL_NONE);
 		g_theRenderer->BindTexture(nullptr);
 		g_theRenderer->DrawVertexArray(deadVerts);
+		FrameStats::AddDrawCall();
 	}
 
+	double hudStart = GetCurrentTimeSeconds();
+	UpdateHudCache(screenBox, possessedActor);
+
 	// Draw HUD base texture
-	AddVertsForAABB2D(hudVerts, screenBox.GetBoxAtUVs(Vec2::ZERO, Vec2(1.f, 0.128f / GetNormalizedScreen().GetDimensions().y)), Rgba8::WHITE);
 	g_theRenderer->SetBlendMode(BlendMode::OPAQUE);
 	g_theRenderer->SetDepthMode(DepthMode::DISABLED);
 	g_theRenderer->SetModelConstants();
 	g_theRenderer->SetRasterizerMode(RasterizerMode::SOLID_CULL_NONE);
 	g_theRenderer->BindShader(possessedActor->m_equippedWeapon->m_weaponDef->m_hudShader);
 	g_theRenderer->BindTexture(possessedActor->m_equippedWeapon->m_weaponDef->m_baseTexture);
-	g_theRenderer->DrawVertexArray(hudVerts);
+	g_theRenderer->DrawVertexArray(m_hudCache.m_baseVerts);
+	FrameStats::AddDrawCall();
 
 
 	// Draw the reticle
-	std::vector<Vertex_PCU> reticleVerts;
-	Vec2 screenCenter = screenBox.GetCenter();
-	AddVertsForAABB2D(reticleVerts, AABB2(screenCenter - retSize * 0.5f, screenCenter + retSize * 0.5f), Rgba8::WHITE);
 	g_theRenderer->BindTexture(weapon->m_weaponDef->m_reticleTexture);
-	g_theRenderer->DrawVertexArray(reticleVerts);
+	g_theRenderer->DrawVertexArray(m_hudCache.m_reticleVerts);
+	FrameStats::AddDrawCall();
 
 	// Draw HUD text
-	std::vector<Vertex_PCU> textVerts;
-	AABB2 healthScreenTextBox = screenBox.GetBoxAtUVs(Vec2(0.25f, 0.f), Vec2(0.36f, 0.128f / GetNormalizedScreen().GetDimensions().y));
-	AABB2 killScreenTextBox = screenBox.GetBoxAtUVs(Vec2(0.f, 0.f), Vec2(0.1f, 0.128f / GetNormalizedScreen().GetDimensions().y));
-	AABB2 deathScreenBox = screenBox.GetBoxAtUVs(Vec2(0.85f, 0.f), Vec2(1.f, 0.128f / GetNormalizedScreen().GetDimensions().y));
-	AABB2 livesScreenBox = screenBox.GetBoxAtUVs(Vec2(0.47f, 0.f), Vec2(0.8f, 0.128f / GetNormalizedScreen().GetDimensions().y));
-	g_theGame->m_font->AddVertsForTextInBox2D(textVerts, Stringf("%d", static_cast<int>(possessedActor->m_health)), healthScreenTextBox, 40.f, Rgba8::WHITE, 1.f, Vec2(0.5f, 0.4f));
-	g_theGame->m_font->AddVertsForTextInBox2D(textVerts, Stringf("%d", m_numPlayerLives), livesScreenBox, 40.f, Rgba8::WHITE, 1.f, Vec2(0.4f, 0.4f));
-	g_theGame->m_font->AddVertsForTextInBox2D(textVerts, Stringf("%d", m_deaths), deathScreenBox, 40.f, Rgba8::WHITE, 1.f, Vec2(0.6f, 0.4f));
-	g_theGame->m_font->AddVertsForTextInBox2D(textVerts, Stringf("%d", m_kills), killScreenTextBox, 40.f, Rgba8::WHITE, 1.f, Vec2(0.6f, 0.4f));
 	g_theRenderer->BindTexture(&g_theGame->m_font->GetTexture());
-	g_theRenderer->DrawVertexArray(textVerts);
+	g_theRenderer->DrawVertexArray(m_hudCache.m_textVerts);
+	FrameStats::AddDrawCall();
 
 	// Draw weapon
-	std::vector<Vertex_PCU> weaponSpriteVerts;
+	std::vector<Vertex_PCU>& weaponSpriteVerts = g_frameArena->AllocateVerts();
 	SpriteAnimDefinition* anim = weapon->m_currentAnimation;
 	if (anim == nullptr)
 	{
 		anim = weapon->m_weaponDef->GetAnimationByName("Idle");
 	}
-	if (anim->GetDuration() < weapon->m_animationClock->GetTotalSeconds())
+	double weaponAnimSeconds = weapon->m_animationPlayback.GetElapsedSeconds(possessedActor->m_theMap->m_simulationSeconds);
+	if (anim->GetDuration() < weaponAnimSeconds)
 	{
 		anim = weapon->m_weaponDef->GetAnimationByName("Idle");
 	}
 
-	SpriteDefinition const spriteAtTime = anim->GetSpriteDefAtTime(static_cast<float>(weapon->m_animationClock->GetTotalSeconds()));
+	SpriteDefinition const spriteAtTime = anim->GetSpriteDefAtTime(static_cast<float>(weaponAnimSeconds));
 	AddVertsForAABB2D(weaponSpriteVerts, weaponSpriteBox, Rgba8::WHITE, spriteAtTime.GetUVs().m_mins, spriteAtTime.GetUVs().m_maxs);
 	g_theRenderer->BindShader(weapon->m_weaponDef->m_animationShader);
 	g_theRenderer->BindTexture(&spriteAtTime.GetTexture());
 	g_theRenderer->DrawVertexArray(weaponSpriteVerts);
+	FrameStats::AddDrawCall();
+	FrameStats::AddHudSeconds(GetCurrentTimeSeconds() - hudStart);
 
 	if (possessedActor->m_actorDef->m_actorName == "Marine")
 	{
@@ -163,6 +250,126 @@ void Player::Render() const
 	g_theRenderer->EndCamera(m_playerViewCamera);
 }
 
+void Player::UpdateHudCache(AABB2 const& screenBox, Actor const* possessedActor) const
+{
+	WeaponDefinition const* weaponDef = possessedActor->m_equippedWeapon->m_weaponDef;
+	int health = static_cast<int>(possessedActor->m_health);
+	bool viewportChanged = !(m_hudCache.m_screenBox.m_mins == screenBox.m_mins && m_hudCache.m_screenBox.m_maxs == screenBox.m_maxs);
+	bool weaponChanged = m_hudCache.m_weaponDef != weaponDef;
+	bool valuesChanged = m_hudCache.m_health != health || m_hudCache.m_lives != m_numPlayerLives || m_hudCache.m_deaths != m_deaths || m_hudCache.m_kills != m_kills;
+	bool rebuildAll = !s_isHudCacheEnabled;
+
+	float hudHeightV = 0.128f / GetNormalizedScreen().GetDimensions().y;
+
+	// Base and reticle only depend on the viewport and the equipped weapon
+	if (rebuildAll || viewportChanged || weaponChanged)
+	{
+		m_hudCache.m_baseVerts.clear();
+		AddVertsForAABB2D(m_hudCache.m_baseVerts, screenBox.GetBoxAtUVs(Vec2::ZERO, Vec2(1.f, hudHeightV)), Rgba8::WHITE);
+
+		m_hudCache.m_reticleVerts.clear();
+		Vec2 retSize = Vec2(static_cast<float>(weaponDef->m_reticleSize.x), static_cast<float>(weaponDef->m_reticleSize.y));
+		Vec2 screenCenter = screenBox.GetCenter();
+		AddVertsForAABB2D(m_hudCache.m_reticleVerts, AABB2(screenCenter - retSize * 0.5f, screenCenter + retSize * 0.5f), Rgba8::WHITE);
+	}
+
+	if (rebuildAll || viewportChanged || valuesChanged)
+	{
+		m_hudCache.m_textVerts.clear();
+		AABB2 healthScreenTextBox = screenBox.GetBoxAtUVs(Vec2(0.25f, 0.f), Vec2(0.36f, hudHeightV));
+		AABB2 killScreenTextBox = screenBox.GetBoxAtUVs(Vec2(0.f, 0.f), Vec2(0.1f, hudHeightV));
+		AABB2 deathScreenBox = screenBox.GetBoxAtUVs(Vec2(0.85f, 0.f), Vec2(1.f, hudHeightV));
+		AABB2 livesScreenBox = screenBox.GetBoxAtUVs(Vec2(0.47f, 0.f), Vec2(0.8f, hudHeightV));
+		g_theGame->m_font->AddVertsForTextInBox2D(m_hudCache.m_textVerts, Stringf("%d", health), healthScreenTextBox, 40.f, Rgba8::WHITE, 1.f, Vec2(0.5f, 0.4f));
+		g_theGame->m_font->AddVertsForTextInBox2D(m_hudCache.m_textVerts, Stringf("%d", m_numPlayerLives), livesScreenBox, 40.f, Rgba8::WHITE, 1.f, Vec2(0.4f, 0.4f));
+		g_theGame->m_font->AddVertsForTextInBox2D(m_hudCache.m_textVerts, Stringf("%d", m_deaths), deathScreenBox, 40.f, Rgba8::WHITE, 1.f, Vec2(0.6f, 0.4f));
+		g_theGame->m_font->AddVertsForTextInBox2D(m_hudCache.m_textVerts, Stringf("%d", m_kills), killScreenTextBox, 40.f, Rgba8::WHITE, 1.f, Vec2(0.6f, 0.4f));
+	}
+
+	m_hudCache.m_screenBox = screenBox;
+	m_hudCache.m_weaponDef = weaponDef;
+	m_hudCache.m_health = health;
+	m_hudCache.m_lives = m_numPlayerLives;
+	m_hudCache.m_deaths = m_deaths;
+	m_hudCache.m_kills = m_kills;
+}
+
+// -----------------------------------------------------------------------------
+// Dev console: HudCache enabled=<true|false>
+// Turning the cache off rebuilds every HUD part each frame, for comparing the
+// HUD time reported by FrameStats.
+// -----------------------------------------------------------------------------
+bool Player::Command_HudCache(EventArgs& args)
+{
+	s_isHudCacheEnabled = args.GetValue("enabled", !s_isHudCacheEnabled);
+	g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, Stringf("HUD cache %s", s_isHudCacheEnabled ? "enabled" : "disabled"));
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Dev console: PlayerBots enabled=<true|false>
+// -----------------------------------------------------------------------------
+bool Player::Command_PlayerBots(EventArgs& args)
+{
+	bool areBotsEnabled = args.GetValue("enabled", true);
+	for (Player* player : g_theGame->m_players)
+	{
+		player->m_commandSource = areBotsEnabled ? PlayerCommandSource::BOT : PlayerCommandSource::INPUT;
+		player->m_botRandomState = 0x9e3779b9u + static_cast<unsigned int>(player->m_playerID);
+		player->m_botWanderSeconds = 0.f;
+	}
+	g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, Stringf("Player bots %s", areBotsEnabled ? "enabled" : "disabled"));
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Dev console: BotSoak ticks=<count>
+// Hands every player to a bot and runs fixed 60 Hz ticks back to back without
+// rendering, the same way a frame samples commands and then simulates.
+// -----------------------------------------------------------------------------
+bool Player::Command_BotSoak(EventArgs& args)
+{
+	if (g_theGame->m_currentState != GameState::PLAYING || g_theGame->m_defaultMap == nullptr)
+	{
+		g_theDevConsole->AddLine(Rgba8::RED, "BotSoak needs a game in progress");
+		return false;
+	}
+
+	int numTicks = args.GetValue("ticks", 600);
+	float deltaSeconds = 1.f / 60.f;
+	std::vector<Player*>& players = g_theGame->m_players;
+	std::vector<PlayerCommandSource> commandSources;
+	for (Player* player : players)
+	{
+		commandSources.push_back(player->m_commandSource);
+		player->m_commandSource = PlayerCommandSource::BOT;
+	}
+
+	double slowestTickSeconds = 0.0;
+	double soakStart = GetCurrentTimeSeconds();
+	for (int tickIndex = 0; tickIndex < numTicks; ++tickIndex)
+	{
+		double tickStart = GetCurrentTimeSeconds();
+		for (Player* player : players)
+		{
+			player->m_commandQueue.Push(player->SampleCommand(deltaSeconds));
+		}
+		g_theGame->SimulateTick(deltaSeconds);
+		double tickSeconds = GetCurrentTimeSeconds() - tickStart;
+		slowestTickSeconds = (tickSeconds > slowestTickSeconds) ? tickSeconds : slowestTickSeconds;
+	}
+	double soakSeconds = GetCurrentTimeSeconds() - soakStart;
+
+	for (int playerIndex = 0; playerIndex < static_cast<int>(players.size()); ++playerIndex)
+	{
+		players[playerIndex]->m_commandSource = commandSources[playerIndex];
+	}
+
+	g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, Stringf("Bot soak: %d ticks in %.2f ms (%.3f ms/tick), slowest tick %.3f ms",
+		numTicks, soakSeconds * 1000.0, (numTicks > 0) ? soakSeconds * 1000.0 / numTicks : 0.0, slowestTickSeconds * 1000.0));
+	return true;
+}
+
 Vec3 Player::GetForwardNormal() const
 {
 	return Vec3::MakeFromPolarDegrees(m_orientation.m_pitchDegrees, m_orientation.m_yawDegrees);
@@ -275,37 +482,21 @@ void Player::CameraKeyPresses(float deltaSeconds)
 
 }
 
-void Player::HandleControllerPlayerMovement(float deltaSeconds)
+PlayerCommand Player::SampleControllerCommand(Actor const* possessedActor, float deltaSeconds) const
 {
-	if (g_theGame->m_currentState != GameState::PLAYING)
-	{
-		return;
-	}
+	PlayerCommand command;
+	command.m_isAnalogMove = true;
 
-	Actor* possessedActor = GetActor();
-	if (possessedActor == nullptr)
-	{
-		return;
-	}
-
-	XboxController controller = g_theInput->GetController(0);
-	Vec3 forward = possessedActor->GetModelToWorldTransform().GetIBasis3D();
-	Vec3 left = possessedActor->GetModelToWorldTransform().GetJBasis3D();
-
-	float movementSpeed = possessedActor->m_actorDef->m_walkSpeed;
-	if (controller.IsButtonDown(XBOX_BUTTON_A))
-	{
-		movementSpeed = possessedActor->m_actorDef->m_runSpeed;
-	}
+	XboxController const& controller = g_theInput->GetController(0);
+	command.m_isRunning = controller.IsButtonDown(XBOX_BUTTON_A);
+	float movementSpeed = command.m_isRunning ? possessedActor->m_actorDef->m_runSpeed : possessedActor->m_actorDef->m_walkSpeed;
 
 	// Movement
 	float orientation = controller.GetLeftStick().GetOrientationDegrees();
 	float magnitude = controller.GetLeftStick().GetMagnitude();
 	Vec2 movement = Vec2::MakeFromPolarDegrees(orientation, magnitude);
 	movement.RotateMinus90Degrees();
-
-	possessedActor->m_position += forward * movement.x * movementSpeed * deltaSeconds;
-	possessedActor->m_position += left * movement.y * movementSpeed * deltaSeconds;
+	command.m_move = movement;
 
 	// Look/aim
 	Vec2 rightStick = controller.GetRightStick().GetPosition();
@@ -315,114 +506,110 @@ void Player::HandleControllerPlayerMovement(float deltaSeconds)
 	{
 		float turnRate = possessedActor->m_actorDef->m_turnSpeed;
 		Vec2 deltaAim = rightStick * movementSpeed * rightMagnitude * turnRate * deltaSeconds;
-		possessedActor->m_orientation.m_yawDegrees += -deltaAim.x;
-		possessedActor->m_orientation.m_pitchDegrees += -deltaAim.y;
+		command.m_lookDelta = Vec2(-deltaAim.x, -deltaAim.y);
 	}
 
 	// Attack
-	if (controller.GetRightTrigger() > 0.0f)
-	{
-		possessedActor->Attack();
-	}
+	command.m_isFiring = controller.GetRightTrigger() > 0.0f;
 
 	// Weapons
 	if (controller.WasButtonJustPressed(XBOX_BUTTON_X))
 	{
-		possessedActor->EquipWeapon(0);
+		command.m_equipWeapon = 0;
 	}
 	if (controller.WasButtonJustPressed(XBOX_BUTTON_Y))
 	{
-		possessedActor->EquipWeapon(1);
+		command.m_equipWeapon = 1;
 	}
 	if (controller.WasButtonJustPressed(XBOX_BUTTON_DPAD_DOWN))
 	{
-		CycleWeapon(possessedActor, -1);
+		command.m_cycleWeapon = -1;
 	}
 	if (controller.WasButtonJustPressed(XBOX_BUTTON_DPAD_UP))
 	{
-		CycleWeapon(possessedActor, 1);
+		command.m_cycleWeapon = 1;
 	}
+	return command;
 }
 
-void Player::HandleKeyboardPlayerMovement(float deltaSeconds)
+PlayerCommand Player::SampleKeyboardCommand() const
 {
-	UNUSED(deltaSeconds);
-
-	if (g_theGame->m_currentState != GameState::PLAYING)
-	{
-		return;
-	}
-
-	if (g_theInput->WasKeyJustPressed('F') && !g_theGame->m_hasTwoPlayers)
-	{
-		ToggleCameraMode(CameraMode::FREEFLY_CAMERA);
-	}
-
-	//if (g_theInput->WasKeyJustPressed('N') && !g_theGame->m_hasTwoPlayers)
-	//{
-	//	m_theMap->DebugPossessNext();
-	//}
-
-	Actor* possessedActor = GetActor();
-	if (possessedActor == nullptr)
-	{
-		return;
-	}
-
-	Vec3 forward = possessedActor->GetModelToWorldTransform().GetIBasis3D();
-	Vec3 left = possessedActor->GetModelToWorldTransform().GetJBasis3D();
-
-	float movementSpeed = possessedActor->m_actorDef->m_walkSpeed;
-	if (g_theInput->IsKeyDown(KEYCODE_SHIFT))
-	{
-		movementSpeed = possessedActor->m_actorDef->m_runSpeed;
-	}
+	PlayerCommand command;
+	command.m_lookDelta.x = g_theInput->GetCursorClientDelta().x * 0.075f;
+	command.m_lookDelta.y = -g_theInput->GetCursorClientDelta().y * 0.075f;
+	command.m_isRunning = g_theInput->IsKeyDown(KEYCODE_SHIFT);
 
 	// Movement
 	if (g_theInput->IsKeyDown('W'))
 	{
-		possessedActor->MoveInDirection(forward, movementSpeed);
-		possessedActor->PlayAnimation("Walk");
+		command.m_move.x += 1.f;
 	}
-	if (g_theInput->IsKeyDown('A'))
+	if (g_theInput->IsKeyDown('S'))
 	{
-		possessedActor->MoveInDirection(left, movementSpeed);
-		possessedActor->PlayAnimation("Walk");
+		command.m_move.x -= 1.f;
 	}
-	if (g_theInput->IsKeyDown('S'))
+	if (g_theInput->IsKeyDown('A'))
 	{
-		possessedActor->MoveInDirection(-forward, movementSpeed);
-		possessedActor->PlayAnimation("Walk");
+		command.m_move.y += 1.f;
 	}
 	if (g_theInput->IsKeyDown('D'))
 	{
-		possessedActor->MoveInDirection(-left, movementSpeed);
-		possessedActor->PlayAnimation("Walk");
+		command.m_move.y -= 1.f;
 	}
 
 	// Attack
-	if (g_theInput->IsKeyDown(KEYCODE_LEFT_MOUSE))
-	{
-		possessedActor->Attack();
-	}
+	command.m_isFiring = g_theInput->IsKeyDown(KEYCODE_LEFT_MOUSE);
 
 	// Weapons
 	if (g_theInput->WasKeyJustPressed('1'))
 	{
-		possessedActor->EquipWeapon(0);
+		command.m_equipWeapon = 0;
 	}
 	if (g_theInput->WasKeyJustPressed('2'))
 	{
-		possessedActor->EquipWeapon(1);
+		command.m_equipWeapon = 1;
 	}
 	if (g_theInput->WasKeyJustPressed(KEYCODE_LEFTARROW))
 	{
-		CycleWeapon(possessedActor, -1);
+		command.m_cycleWeapon = -1;
 	}
 	if (g_theInput->WasKeyJustPressed(KEYCODE_RIGHTARROW))
 	{
-		CycleWeapon(possessedActor, 1);
+		command.m_cycleWeapon = 1;
 	}
+	return command;
+}
+
+PlayerCommand Player::SampleBotCommand(Actor* possessedActor, float deltaSeconds)
+{
+	PlayerCommand command;
+	command.m_isRunning = true;
+	float yawDegrees = possessedActor->m_orientation.m_yawDegrees;
+	float maxTurnDegrees = possessedActor->m_actorDef->m_turnSpeed * deltaSeconds;
+
+	// Chase and shoot the closest enemy in sight
+	Actor const* target = m_theMap->GetClosestVisibleEnemy(possessedActor);
+	if (target != nullptr && !target->IsDead())
+	{
+		Vec3 toTarget = target->m_position - possessedActor->m_position;
+		float goalYawDegrees = toTarget.GetAngleAboutZDegrees();
+		command.m_lookDelta.x = GetTurnedTowardDegrees(yawDegrees, goalYawDegrees, maxTurnDegrees) - yawDegrees;
+		command.m_isFiring = fabsf(GetShortestAngularDispDegrees(yawDegrees, goalYawDegrees)) <= BOT_FIRE_CONE_DEGREES;
+		command.m_move.x = (toTarget.GetLength() > 3.f) ? 1.f : 0.f;
+		return command;
+	}
+
+	// Otherwise wander, picking a new heading every couple of seconds
+	m_botWanderSeconds -= deltaSeconds;
+	if (m_botWanderSeconds <= 0.f)
+	{
+		m_botRandomState = m_botRandomState * 1664525u + 1013904223u;
+		m_botWanderYawDegrees = static_cast<float>((m_botRandomState >> 8) % 360u);
+		m_botWanderSeconds = 2.f;
+	}
+	command.m_lookDelta.x = GetTurnedTowardDegrees(yawDegrees, m_botWanderYawDegrees, maxTurnDegrees) - yawDegrees;
+	command.m_move.x = 1.f;
+	return command;
 }
 
 void Player::CycleWeapon(Actor* actor, int direction)
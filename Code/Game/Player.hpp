@@ -1,7 +1,13 @@
 #pragma once
 #include "Game/Game.h"
 #include "Game/Controller.hpp"
+#include "Game/PlayerCommand.hpp"
 #include "Engine/Renderer/Camera.h"
+#include "Engine/Core/Vertex_PCU.h"
+#include "Engine/Math/AABB2.h"
+#include <vector>
+// -----------------------------------------------------------------------------
+struct WeaponDefinition;
 // -----------------------------------------------------------------------------
 enum class CameraMode
 {
@@ -9,6 +15,28 @@ enum class CameraMode
 	ACTOR_CAMERA
 };
 // -----------------------------------------------------------------------------
+enum class PlayerCommandSource
+{
+	INPUT,
+	BOT
+};
+// -----------------------------------------------------------------------------
+// Retained HUD geometry. Each part is only rebuilt when the values it shows,
+// the equipped weapon or the player's viewport change.
+// -----------------------------------------------------------------------------
+struct HudCache
+{
+	std::vector<Vertex_PCU> m_baseVerts;
+	std::vector<Vertex_PCU> m_reticleVerts;
+	std::vector<Vertex_PCU> m_textVerts;
+	AABB2 m_screenBox = AABB2::ZERO_TO_ONE;
+	WeaponDefinition const* m_weaponDef = nullptr;
+	int m_health = -1;
+	int m_lives = -1;
+	int m_deaths = -1;
+	int m_kills = -1;
+};
+// -----------------------------------------------------------------------------
 class Player : public Controller
 {
 public:
@@ -17,7 +45,10 @@ public:
 	~Player();
 
 	void Update(float deltaSeconds);
+	PlayerCommand SampleCommand(float deltaSeconds);
+	void ExecuteCommand(PlayerCommand const& command, float deltaSeconds);
 	void Render() const;
+	void UpdateHudCache(AABB2 const& screenBox, Actor const* possessedActor) const;
 	Vec3 GetForwardNormal() const;
 
 	Camera GetPlayerCamera() const;
@@ -27,6 +58,10 @@ public:
 	void Possess(ActorHandle& actorHandle) override;
 
 	void ToggleCameraMode(CameraMode cameraMode);
+	static bool Command_HudCache(EventArgs& args);
+	static bool Command_PlayerBots(EventArgs& args);
+	static bool Command_BotSoak(EventArgs& args);
+	static bool s_isHudCacheEnabled;
 	CameraMode m_currentCameraMode = CameraMode::ACTOR_CAMERA;
 	Camera m_playerCamera;
 	int    m_playerID = 0;
@@ -37,11 +72,21 @@ public:
 public:
 	void CameraKeyPresses(float deltaSeconds);
 	void CameraControllerPresses(float deltaSeconds);
-	void HandleControllerPlayerMovement(float deltaSeconds);
-	void HandleKeyboardPlayerMovement(float deltaSeconds);
+	PlayerCommand SampleControllerCommand(Actor const* possessedActor, float deltaSeconds) const;
+	PlayerCommand SampleKeyboardCommand() const;
+	PlayerCommand SampleBotCommand(Actor* possessedActor, float deltaSeconds);
 	void CycleWeapon(Actor* actor, int direction);
 	Camera m_playerViewCamera;
 	Rgba8 m_color = Rgba8::WHITE;
+	mutable HudCache m_hudCache;
+	PlayerCommandQueue m_commandQueue;
+	PlayerCommand m_command;
+	PlayerCommandSource m_commandSource = PlayerCommandSource::INPUT;
+
+	// Bot wandering, with its own random state so bots never consume g_rng rolls
+	unsigned int m_botRandomState = 1;
+	float m_botWanderYawDegrees = 0.f;
+	float m_botWanderSeconds = 0.f;
 
 	Vec3 m_position;
 	EulerAngles m_orientation = EulerAngles::ZERO;
@@ -0,0 +1,104 @@
+#include "Game/PlayerCommand.hpp"
+#include "Engine/Math/MathUtils.h"
+#include <cstring>
+
+static signed char QuantizeUnitFloat(float value)
+{
+	return static_cast<signed char>(RoundDownToInt(GetClamped(value, -1.f, 1.f) * 127.f + 0.5f));
+}
+
+void PlayerCommand::Quantize()
+{
+	m_move.x = static_cast<float>(QuantizeUnitFloat(m_move.x)) / 127.f;
+	m_move.y = static_cast<float>(QuantizeUnitFloat(m_move.y)) / 127.f;
+}
+
+void PlayerCommand::MergeFrom(PlayerCommand const& laterCommand)
+{
+	// Held state follows the latest sample, look deltas add up and one-shots keep the latest request
+	m_move = laterCommand.m_move;
+	m_lookDelta += laterCommand.m_lookDelta;
+	m_isRunning = laterCommand.m_isRunning;
+	m_isFiring = m_isFiring || laterCommand.m_isFiring;
+	m_isAnalogMove = laterCommand.m_isAnalogMove;
+	m_equipWeapon = (laterCommand.m_equipWeapon >= 0) ? laterCommand.m_equipWeapon : m_equipWeapon;
+	m_cycleWeapon = (laterCommand.m_cycleWeapon != 0) ? laterCommand.m_cycleWeapon : m_cycleWeapon;
+}
+
+// -----------------------------------------------------------------------------
+// Packed layout: move x/y as one signed byte each, look yaw/pitch as raw floats,
+// one flags byte and the equip index as a signed byte.
+// -----------------------------------------------------------------------------
+void PlayerCommand::AppendPacked(std::vector<unsigned char>& buffer) const
+{
+	unsigned char packed[PLAYER_COMMAND_PACKED_BYTES];
+	packed[0] = static_cast<unsigned char>(QuantizeUnitFloat(m_move.x));
+	packed[1] = static_cast<unsigned char>(QuantizeUnitFloat(m_move.y));
+	memcpy(&packed[2], &m_lookDelta.x, sizeof(float));
+	memcpy(&packed[6], &m_lookDelta.y, sizeof(float));
+
+	unsigned char flags = 0;
+	flags |= m_isRunning ? 0x01 : 0x00;
+	flags |= m_isFiring ? 0x02 : 0x00;
+	flags |= m_isAnalogMove ? 0x04 : 0x00;
+	flags |= (m_cycleWeapon < 0) ? 0x08 : 0x00;
+	flags |= (m_cycleWeapon > 0) ? 0x10 : 0x00;
+	packed[10] = flags;
+	packed[11] = static_cast<unsigned char>(static_cast<signed char>(m_equipWeapon));
+
+	buffer.insert(buffer.end(), packed, packed + PLAYER_COMMAND_PACKED_BYTES);
+}
+
+PlayerCommand PlayerCommand::ReadPacked(unsigned char const* packedBytes)
+{
+	PlayerCommand command;
+	command.m_move.x = static_cast<float>(static_cast<signed char>(packedBytes[0])) / 127.f;
+	command.m_move.y = static_cast<float>(static_cast<signed char>(packedBytes[1])) / 127.f;
+	memcpy(&command.m_lookDelta.x, &packedBytes[2], sizeof(float));
+	memcpy(&command.m_lookDelta.y, &packedBytes[6], sizeof(float));
+
+	unsigned char flags = packedBytes[10];
+	command.m_isRunning = (flags & 0x01) != 0;
+	command.m_isFiring = (flags & 0x02) != 0;
+	command.m_isAnalogMove = (flags & 0x04) != 0;
+	command.m_cycleWeapon = ((flags & 0x08) != 0) ? -1 : (((flags & 0x10) != 0) ? 1 : 0);
+	command.m_equipWeapon = static_cast<int>(static_cast<signed char>(packedBytes[11]));
+	return command;
+}
+
+void PlayerCommandQueue::Push(PlayerCommand const& command)
+{
+	m_pending.push_back(command);
+}
+
+PlayerCommand PlayerCommandQueue::ConsumeForTick()
+{
+	if (m_pending.empty())
+	{
+		PlayerCommand repeated = m_held;
+		repeated.m_lookDelta = Vec2::ZERO;
+		repeated.m_equipWeapon = -1;
+		repeated.m_cycleWeapon = 0;
+		return repeated;
+	}
+
+	PlayerCommand merged = m_pending.front();
+	for (int commandIndex = 1; commandIndex < static_cast<int>(m_pending.size()); ++commandIndex)
+	{
+		merged.MergeFrom(m_pending[commandIndex]);
+	}
+	m_pending.clear();
+	m_held = merged;
+	return merged;
+}
+
+void PlayerCommandQueue::Clear()
+{
+	m_pending.clear();
+	m_held = PlayerCommand();
+}
+
+int PlayerCommandQueue::GetNumPending() const
+{
+	return static_cast<int>(m_pending.size());
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include "Engine/Math/Vec2.hpp"
+#include <deque>
+#include <vector>
+// -----------------------------------------------------------------------------
+constexpr int PLAYER_COMMAND_PACKED_BYTES = 12;
+// -----------------------------------------------------------------------------
+// Everything a player asks of their possessed actor for one simulation tick.
+// Commands are quantized as soon as they are sampled, so a command read back
+// from a replay log drives the simulation exactly like the live one did.
+// -----------------------------------------------------------------------------
+struct PlayerCommand
+{
+	Vec2 m_move = Vec2::ZERO;		// x forward, y left, each in [-1, 1]
+	Vec2 m_lookDelta = Vec2::ZERO;	// Yaw and pitch change in degrees
+	bool m_isRunning = false;
+	bool m_isFiring = false;
+	bool m_isAnalogMove = false;	// Stick moves the actor directly, keys push it
+	int  m_equipWeapon = -1;		// Weapon index to equip, -1 keeps the current one
+	int  m_cycleWeapon = 0;			// -1, 0 or 1
+
+	void Quantize();
+	void MergeFrom(PlayerCommand const& laterCommand);
+	void AppendPacked(std::vector<unsigned char>& buffer) const;
+	static PlayerCommand ReadPacked(unsigned char const* packedBytes);
+};
+// -----------------------------------------------------------------------------
+// Commands sampled at frame start wait here until the simulation consumes them.
+// Samples taken between two ticks are merged into one command, and a tick with
+// no new sample repeats the held movement and fire without the one-shot actions.
+// -----------------------------------------------------------------------------
+class PlayerCommandQueue
+{
+public:
+	void Push(PlayerCommand const& command);
+	PlayerCommand ConsumeForTick();
+	void Clear();
+	int GetNumPending() const;
+// -----------------------------------------------------------------------------
+private:
+	std::deque<PlayerCommand> m_pending;
+	PlayerCommand m_held;
+};
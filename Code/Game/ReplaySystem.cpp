@@ -0,0 +1,373 @@
+#include "Game/ReplaySystem.hpp"
+#include "Game/BinaryBuffer.hpp"
+#include "Game/Game.h"
+#include "Game/GameCommon.h"
+#include "Game/Map.hpp"
+#include "Game/Actor.hpp"
+#include "Game/Player.hpp"
+#include "Engine/Core/DevConsole.hpp"
+#include "Engine/Core/EngineCommon.h"
+#include "Engine/Core/Time.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+static char const* const REPLAY_DEFAULT_FILE = "Replay.bin";
+static unsigned int const REPLAY_FILE_VERSION = 1;
+
+// -----------------------------------------------------------------------------
+// A replay log read back into memory. Commands are stored tick by tick, one per
+// player in the order of m_playerIDs.
+// -----------------------------------------------------------------------------
+struct ReplayLog
+{
+	unsigned int m_seed = 0;
+	int m_hashInterval = REPLAY_DEFAULT_HASH_INTERVAL;
+	std::string m_mapName;
+	std::vector<int> m_playerIDs;
+	std::vector<float> m_tickDeltaSeconds;
+	std::vector<PlayerCommand> m_commands;
+	std::vector<unsigned int> m_stateHashes;
+};
+
+static bool s_isRecording = false;
+static std::string s_recordingFilePath;
+static int s_recordingHashInterval = REPLAY_DEFAULT_HASH_INTERVAL;
+static int s_numRecordedTicks = 0;
+static std::vector<unsigned char> s_recordingBytes;
+
+static void HashBytes(unsigned int& hash, void const* data, size_t numBytes)
+{
+	// FNV-1a
+	unsigned char const* bytes = static_cast<unsigned char const*>(data);
+	for (size_t byteIndex = 0; byteIndex < numBytes; ++byteIndex)
+	{
+		hash ^= bytes[byteIndex];
+		hash *= 16777619u;
+	}
+}
+
+static bool ReadReplayLog(std::string const& filePath, ReplayLog& outLog)
+{
+	std::ifstream file(filePath, std::ios::binary);
+	if (!file)
+	{
+		return false;
+	}
+	std::vector<unsigned char> buffer((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+	size_t readPosition = 0;
+	char magic[4] = {};
+	unsigned int version = 0;
+	unsigned int numPlayers = 0;
+	unsigned int mapNameLength = 0;
+	if (!ReadBytes(buffer, readPosition, magic) || memcmp(magic, "DRPL", 4) != 0 ||
+		!ReadBytes(buffer, readPosition, version) || version != REPLAY_FILE_VERSION ||
+		!ReadBytes(buffer, readPosition, outLog.m_seed) ||
+		!ReadBytes(buffer, readPosition, outLog.m_hashInterval) || outLog.m_hashInterval <= 0 ||
+		!ReadBytes(buffer, readPosition, numPlayers))
+	{
+		return false;
+	}
+	outLog.m_playerIDs.resize(numPlayers);
+	for (unsigned int playerIndex = 0; playerIndex < numPlayers; ++playerIndex)
+	{
+		if (!ReadBytes(buffer, readPosition, outLog.m_playerIDs[playerIndex]))
+		{
+			return false;
+		}
+	}
+	if (!ReadBytes(buffer, readPosition, mapNameLength) || readPosition + mapNameLength > buffer.size())
+	{
+		return false;
+	}
+	outLog.m_mapName.assign(reinterpret_cast<char const*>(buffer.data() + readPosition), mapNameLength);
+	readPosition += mapNameLength;
+
+	// Ticks run to the end of the file, with a state hash after every m_hashInterval of them
+	while (readPosition < buffer.size())
+	{
+		float deltaSeconds = 0.f;
+		if (!ReadBytes(buffer, readPosition, deltaSeconds) || readPosition + numPlayers * PLAYER_COMMAND_PACKED_BYTES > buffer.size())
+		{
+			return false;
+		}
+		outLog.m_tickDeltaSeconds.push_back(deltaSeconds);
+		for (unsigned int playerIndex = 0; playerIndex < numPlayers; ++playerIndex)
+		{
+			outLog.m_commands.push_back(PlayerCommand::ReadPacked(&buffer[readPosition]));
+			readPosition += PLAYER_COMMAND_PACKED_BYTES;
+		}
+
+		if (static_cast<int>(outLog.m_tickDeltaSeconds.size()) % outLog.m_hashInterval == 0)
+		{
+			unsigned int stateHash = 0;
+			if (!ReadBytes(buffer, readPosition, stateHash))
+			{
+				return false;
+			}
+			outLog.m_stateHashes.push_back(stateHash);
+		}
+	}
+	return true;
+}
+
+static void RestartMapWithSeed(unsigned int seed)
+{
+	// A fresh g_rng on a reseeded C runtime, so every roll after the restart follows from the seed
+	delete g_rng;
+	g_rng = new RandomNumberGenerator();
+	srand(seed);
+	g_theGame->DestroyMap();
+	g_theGame->InitializeMap();
+	for (Player* player : g_theGame->m_players)
+	{
+		player->m_command = PlayerCommand();
+		player->m_commandQueue.Clear();
+	}
+}
+
+void ReplaySystem::BeginRecording(std::string const& filePath, unsigned int seed, int hashInterval)
+{
+	s_isRecording = true;
+	s_recordingFilePath = filePath;
+	s_recordingHashInterval = (hashInterval > 0) ? hashInterval : REPLAY_DEFAULT_HASH_INTERVAL;
+	s_numRecordedTicks = 0;
+	s_recordingBytes.clear();
+
+	RestartMapWithSeed(seed);
+
+	std::string const& mapName = g_theGame->m_defaultMap->m_definition->m_name;
+	s_recordingBytes.insert(s_recordingBytes.end(), { 'D', 'R', 'P', 'L' });
+	AppendBytes(s_recordingBytes, REPLAY_FILE_VERSION);
+	AppendBytes(s_recordingBytes, seed);
+	AppendBytes(s_recordingBytes, s_recordingHashInterval);
+	AppendBytes(s_recordingBytes, static_cast<unsigned int>(g_theGame->m_players.size()));
+	for (Player* player : g_theGame->m_players)
+	{
+		AppendBytes(s_recordingBytes, player->m_playerID);
+	}
+	AppendBytes(s_recordingBytes, static_cast<unsigned int>(mapName.size()));
+	s_recordingBytes.insert(s_recordingBytes.end(), mapName.begin(), mapName.end());
+}
+
+void ReplaySystem::EndRecording()
+{
+	if (!s_isRecording)
+	{
+		return;
+	}
+	s_isRecording = false;
+
+	std::ofstream file(s_recordingFilePath, std::ios::binary);
+	file.write(reinterpret_cast<char const*>(s_recordingBytes.data()), static_cast<std::streamsize>(s_recordingBytes.size()));
+	if (!file)
+	{
+		g_theDevConsole->AddLine(Rgba8::RED, Stringf("Could not write replay to %s", s_recordingFilePath.c_str()));
+		return;
+	}
+	g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, Stringf("Recorded %d ticks to %s (%d bytes)",
+		s_numRecordedTicks, s_recordingFilePath.c_str(), static_cast<int>(s_recordingBytes.size())));
+	s_recordingBytes.clear();
+}
+
+bool ReplaySystem::IsRecording()
+{
+	return s_isRecording;
+}
+
+void ReplaySystem::RecordTick(float deltaSeconds, std::vector<Player*> const& players, Map const& map)
+{
+	if (!s_isRecording)
+	{
+		return;
+	}
+
+	AppendBytes(s_recordingBytes, deltaSeconds);
+	for (int playerIndex = 0; playerIndex < static_cast<int>(players.size()); ++playerIndex)
+	{
+		players[playerIndex]->m_command.AppendPacked(s_recordingBytes);
+	}
+
+	s_numRecordedTicks += 1;
+	if (s_numRecordedTicks % s_recordingHashInterval == 0)
+	{
+		AppendBytes(s_recordingBytes, HashActorState(map));
+	}
+}
+
+unsigned int ReplaySystem::HashActorState(Map const& map)
+{
+	unsigned int hash = 2166136261u;
+	for (int actorIndex = 0; actorIndex < static_cast<int>(map.m_allActors.size()); ++actorIndex)
+	{
+		Actor const* actor = map.m_allActors[actorIndex];
+		if (actor == nullptr)
+		{
+			continue;
+		}
+
+		unsigned int handleIndex = actor->m_actorHandle.GetIndex();
+		float state[8] =
+		{
+			actor->m_position.x, actor->m_position.y, actor->m_position.z,
+			actor->m_velocity.x, actor->m_velocity.y, actor->m_velocity.z,
+			actor->m_orientation.m_yawDegrees, actor->m_orientation.m_pitchDegrees
+		};
+		HashBytes(hash, &handleIndex, sizeof(handleIndex));
+		HashBytes(hash, state, sizeof(state));
+		HashBytes(hash, &actor->m_health, sizeof(actor->m_health));
+		HashBytes(hash, &actor->m_isDead, sizeof(actor->m_isDead));
+	}
+	return hash;
+}
+
+// -----------------------------------------------------------------------------
+// Dev console: ReplayRecord file=<path> seed=<int> hashInterval=<ticks>
+// Reseeds the RNG, restarts the current map and records every tick until
+// ReplayStop or until the game leaves the playing state.
+// -----------------------------------------------------------------------------
+bool ReplaySystem::Command_ReplayRecord(EventArgs& args)
+{
+	if (g_theGame->m_currentState != GameState::PLAYING || g_theGame->m_defaultMap == nullptr)
+	{
+		g_theDevConsole->AddLine(Rgba8::RED, "ReplayRecord needs a game in progress");
+		return false;
+	}
+	if (s_isRecording)
+	{
+		EndRecording();
+	}
+
+	std::string filePath = args.GetValue("file", REPLAY_DEFAULT_FILE);
+	int seed = args.GetValue("seed", static_cast<int>(GetCurrentTimeSeconds() * 1000.0));
+	int hashInterval = args.GetValue("hashInterval", REPLAY_DEFAULT_HASH_INTERVAL);
+	BeginRecording(filePath, static_cast<unsigned int>(seed), hashInterval);
+	g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, Stringf("Recording to %s with seed %u", filePath.c_str(), static_cast<unsigned int>(seed)));
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Dev console: ReplayStop
+// -----------------------------------------------------------------------------
+bool ReplaySystem::Command_ReplayStop(EventArgs& args)
+{
+	UNUSED(args);
+	if (!s_isRecording)
+	{
+		g_theDevConsole->AddLine(Rgba8::RED, "Not recording");
+		return false;
+	}
+	EndRecording();
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Dev console: ReplayRun file=<path>
+// Restarts the map with the recorded seed and runs every recorded tick back to
+// back without rendering. Prints the total and slowest tick times, and checks
+// each recorded state hash to report the first tick the replay diverged.
+// -----------------------------------------------------------------------------
+bool ReplaySystem::Command_ReplayRun(EventArgs& args)
+{
+	if (s_isRecording)
+	{
+		g_theDevConsole->AddLine(Rgba8::RED, "Stop recording before running a replay");
+		return false;
+	}
+	if (g_theGame->m_currentState != GameState::PLAYING || g_theGame->m_defaultMap == nullptr)
+	{
+		g_theDevConsole->AddLine(Rgba8::RED, "ReplayRun needs a game in progress");
+		return false;
+	}
+
+	std::string filePath = args.GetValue("file", REPLAY_DEFAULT_FILE);
+	ReplayLog log;
+	if (!ReadReplayLog(filePath, log))
+	{
+		g_theDevConsole->AddLine(Rgba8::RED, Stringf("Could not read replay %s", filePath.c_str()));
+		return false;
+	}
+
+	// The replay only holds commands, so the game has to be set up like it was when recording
+	std::vector<Player*>& players = g_theGame->m_players;
+	bool doPlayersMatch = (players.size() == log.m_playerIDs.size());
+	for (int playerIndex = 0; doPlayersMatch && playerIndex < static_cast<int>(players.size()); ++playerIndex)
+	{
+		doPlayersMatch = (players[playerIndex]->m_playerID == log.m_playerIDs[playerIndex]);
+	}
+	if (!doPlayersMatch || g_theGame->m_defaultMap->m_definition->m_name != log.m_mapName)
+	{
+		g_theDevConsole->AddLine(Rgba8::RED, Stringf("Replay was recorded on %s with %d players", log.m_mapName.c_str(), static_cast<int>(log.m_playerIDs.size())));
+		return false;
+	}
+
+	RestartMapWithSeed(log.m_seed);
+	std::vector<CameraMode> cameraModes;
+	for (Player* player : players)
+	{
+		cameraModes.push_back(player->m_currentCameraMode);
+		player->m_currentCameraMode = CameraMode::ACTOR_CAMERA;
+	}
+
+	int numPlayers = static_cast<int>(players.size());
+	int numTicks = static_cast<int>(log.m_tickDeltaSeconds.size());
+	int numHashesMatched = 0;
+	int firstDivergentTick = -1;
+	int slowestTick = -1;
+	double slowestTickSeconds = 0.0;
+	double totalTickSeconds = 0.0;
+
+	for (int tickIndex = 0; tickIndex < numTicks; ++tickIndex)
+	{
+		float deltaSeconds = log.m_tickDeltaSeconds[tickIndex];
+		double tickStart = GetCurrentTimeSeconds();
+		for (int playerIndex = 0; playerIndex < numPlayers; ++playerIndex)
+		{
+			players[playerIndex]->m_command = log.m_commands[tickIndex * numPlayers + playerIndex];
+			players[playerIndex]->Update(deltaSeconds);
+		}
+		g_theGame->m_defaultMap->Update(deltaSeconds);
+		double tickSeconds = GetCurrentTimeSeconds() - tickStart;
+
+		totalTickSeconds += tickSeconds;
+		if (tickSeconds > slowestTickSeconds)
+		{
+			slowestTickSeconds = tickSeconds;
+			slowestTick = tickIndex;
+		}
+
+		if ((tickIndex + 1) % log.m_hashInterval == 0)
+		{
+			int hashIndex = (tickIndex + 1) / log.m_hashInterval - 1;
+			if (HashActorState(*g_theGame->m_defaultMap) == log.m_stateHashes[hashIndex])
+			{
+				numHashesMatched += 1;
+			}
+			else if (firstDivergentTick < 0)
+			{
+				firstDivergentTick = tickIndex;
+			}
+		}
+	}
+
+	for (int playerIndex = 0; playerIndex < numPlayers; ++playerIndex)
+	{
+		players[playerIndex]->m_command = PlayerCommand();
+		players[playerIndex]->m_currentCameraMode = cameraModes[playerIndex];
+	}
+
+	g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, Stringf("Replayed %d ticks in %.2f ms (%.3f ms/tick), slowest tick %d took %.3f ms",
+		numTicks, totalTickSeconds * 1000.0, (numTicks > 0) ? totalTickSeconds * 1000.0 / numTicks : 0.0, slowestTick, slowestTickSeconds * 1000.0));
+	if (firstDivergentTick < 0)
+	{
+		g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, Stringf("Deterministic: all %d state hashes matched", static_cast<int>(log.m_stateHashes.size())));
+	}
+	else
+	{
+		g_theDevConsole->AddLine(Rgba8::RED, Stringf("Diverged at tick %d, %d of %d state hashes matched",
+			firstDivergentTick, numHashesMatched, static_cast<int>(log.m_stateHashes.size())));
+	}
+	return true;
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include "Game/PlayerCommand.hpp"
+#include "Engine/Core/EventSystem.hpp"
+#include <string>
+#include <vector>
+// -----------------------------------------------------------------------------
+class Map;
+class Player;
+// -----------------------------------------------------------------------------
+constexpr int REPLAY_DEFAULT_HASH_INTERVAL = 30;
+// -----------------------------------------------------------------------------
+// Records the RNG seed, then the delta time and every player's command for each
+// simulation tick into a compact binary log. A log is played back headlessly
+// against Map::Update as fast as it will run, so a slow frame can be reproduced
+// and profiled as often as needed. Recording also stores a hash of all actor
+// state every few ticks, which the replay checks to find where it diverged.
+// -----------------------------------------------------------------------------
+class ReplaySystem
+{
+public:
+	static void BeginRecording(std::string const& filePath, unsigned int seed, int hashInterval);
+	static void EndRecording();
+	static bool IsRecording();
+	static void RecordTick(float deltaSeconds, std::vector<Player*> const& players, Map const& map);
+	static unsigned int HashActorState(Map const& map);
+
+	static bool Command_ReplayRecord(EventArgs& args);
+	static bool Command_ReplayStop(EventArgs& args);
+	static bool Command_ReplayRun(EventArgs& args);
+};
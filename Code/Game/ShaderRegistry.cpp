@@ -0,0 +1,359 @@
+#include "Game/ShaderRegistry.hpp"
+#include "Game/GameCommon.h"
+#include "Engine/Core/DevConsole.hpp"
+#include "Engine/Core/EngineCommon.h"
+#include "Engine/Core/Time.hpp"
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+static char const* const SHADER_CACHE_TEST_DIRECTORY = "Data/Shaders/CacheTest";
+static constexpr unsigned int SHADER_CACHE_VERSION = 1;
+
+struct CompiledShaderHeader
+{
+	char               m_fourCC[4];
+	unsigned int       m_version;
+	unsigned long long m_sourceHash;
+	double             m_compileSeconds;
+	unsigned long long m_numBytes;
+};
+
+static void HashBytes(unsigned long long& hash, void const* data, size_t numBytes)
+{
+	unsigned char const* bytes = static_cast<unsigned char const*>(data);
+	for (size_t byteIndex = 0; byteIndex < numBytes; ++byteIndex)
+	{
+		hash ^= bytes[byteIndex];
+		hash *= 1099511628211ull;
+	}
+}
+
+// "A;B=2" becomes "#define A\n#define B 2\n"
+static std::string GetDefinesPreamble(std::string const& defines)
+{
+	std::string preamble;
+	size_t defineStart = 0;
+	while (defineStart < defines.size())
+	{
+		size_t defineEnd = defines.find(';', defineStart);
+		if (defineEnd == std::string::npos)
+		{
+			defineEnd = defines.size();
+		}
+		std::string define = defines.substr(defineStart, defineEnd - defineStart);
+		defineStart = defineEnd + 1;
+		if (define.empty())
+		{
+			continue;
+		}
+		size_t equalsIndex = define.find('=');
+		if (equalsIndex != std::string::npos)
+		{
+			define[equalsIndex] = ' ';
+		}
+		preamble += "#define " + define + "\n";
+	}
+	return preamble;
+}
+
+static bool ReadShaderSource(std::string const& shaderName, std::string& outSource)
+{
+	std::ifstream file(shaderName + ".hlsl", std::ios::binary);
+	if (!file)
+	{
+		return false;
+	}
+	outSource.assign((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// ShaderKey
+// -----------------------------------------------------------------------------
+std::string ShaderKey::ToString() const
+{
+	return Stringf("%s|%s|%d", m_shaderName.c_str(), m_defines.c_str(), static_cast<int>(m_vertexType));
+}
+
+// -----------------------------------------------------------------------------
+// CompiledShaderCache
+// -----------------------------------------------------------------------------
+CompiledShaderCache::CompiledShaderCache(std::string const& directory)
+	:m_directory(directory)
+{
+}
+
+bool CompiledShaderCache::GetOrCompile(ShaderKey const& key, std::string const& source, ShaderCompileFunction const& compile, std::vector<unsigned char>& outBytecode)
+{
+	unsigned long long sourceHash = HashSource(key, source);
+	double compileSeconds = 0.0;
+	if (Find(sourceHash, outBytecode, compileSeconds))
+	{
+		m_numHits += 1;
+		m_savedSeconds += compileSeconds;
+		return true;
+	}
+
+	m_numMisses += 1;
+	double compileStart = GetCurrentTimeSeconds();
+	if (!compile(key, source, outBytecode))
+	{
+		return false;
+	}
+	compileSeconds = GetCurrentTimeSeconds() - compileStart;
+	m_compileSeconds += compileSeconds;
+	Store(sourceHash, outBytecode, compileSeconds);
+	return true;
+}
+
+bool CompiledShaderCache::Find(unsigned long long sourceHash, std::vector<unsigned char>& outBytecode, double& outCompileSeconds) const
+{
+	std::ifstream file(GetEntryPath(sourceHash), std::ios::binary);
+	if (!file)
+	{
+		return false;
+	}
+
+	CompiledShaderHeader header = {};
+	file.read(reinterpret_cast<char*>(&header), sizeof(header));
+	if (!file || header.m_fourCC[0] != 'S' || header.m_fourCC[1] != 'H' || header.m_fourCC[2] != 'D' || header.m_fourCC[3] != 'C' ||
+		header.m_version != SHADER_CACHE_VERSION || header.m_sourceHash != sourceHash || header.m_numBytes == 0)
+	{
+		return false;
+	}
+
+	std::vector<unsigned char> bytecode(static_cast<size_t>(header.m_numBytes));
+	file.read(reinterpret_cast<char*>(bytecode.data()), static_cast<std::streamsize>(bytecode.size()));
+	if (!file || file.peek() != std::ifstream::traits_type::eof())
+	{
+		return false;
+	}
+	outBytecode = std::move(bytecode);
+	outCompileSeconds = header.m_compileSeconds;
+	return true;
+}
+
+void CompiledShaderCache::Store(unsigned long long sourceHash, std::vector<unsigned char> const& bytecode, double compileSeconds) const
+{
+	std::error_code error;
+	std::filesystem::create_directories(m_directory, error);
+
+	CompiledShaderHeader header = { { 'S', 'H', 'D', 'C' }, SHADER_CACHE_VERSION, sourceHash, compileSeconds, bytecode.size() };
+	std::ofstream file(GetEntryPath(sourceHash), std::ios::binary);
+	file.write(reinterpret_cast<char const*>(&header), sizeof(header));
+	file.write(reinterpret_cast<char const*>(bytecode.data()), static_cast<std::streamsize>(bytecode.size()));
+}
+
+void CompiledShaderCache::Clear() const
+{
+	std::error_code error;
+	std::filesystem::remove_all(m_directory, error);
+}
+
+unsigned long long CompiledShaderCache::HashSource(ShaderKey const& key, std::string const& source)
+{
+	unsigned long long hash = 14695981039346656037ull;
+	int vertexType = static_cast<int>(key.m_vertexType);
+	HashBytes(hash, &vertexType, sizeof(vertexType));
+	HashBytes(hash, key.m_defines.data(), key.m_defines.size() + 1);
+	HashBytes(hash, source.data(), source.size());
+	return hash;
+}
+
+std::string CompiledShaderCache::GetEntryPath(unsigned long long sourceHash) const
+{
+	return Stringf("%s/%016llx.cso", m_directory.c_str(), sourceHash);
+}
+
+// -----------------------------------------------------------------------------
+// ShaderRegistry
+// -----------------------------------------------------------------------------
+ShaderRegistry::ShaderRegistry(std::string const& cacheDirectory)
+	:m_cache(cacheDirectory)
+{
+}
+
+Shader* ShaderRegistry::CreateOrGetShader(std::string const& shaderName, VertexType vertexType, std::string const& defines)
+{
+	m_numRequests += 1;
+	ShaderKey key;
+	key.m_shaderName = shaderName;
+	key.m_defines = defines;
+	key.m_vertexType = vertexType;
+
+	std::string keyString = key.ToString();
+	auto foundShader = m_shadersByKey.find(keyString);
+	if (foundShader != m_shadersByKey.end())
+	{
+		return foundShader->second;
+	}
+
+	// Unreadable source is left to the renderer, which reports it the usual way
+	std::string source;
+	if (!ReadShaderSource(shaderName, source))
+	{
+		Shader* shader = g_theRenderer->CreateShader(shaderName.c_str(), vertexType);
+		m_numCompiles += 1;
+		m_shadersByKey[keyString] = shader;
+		return shader;
+	}
+	source = GetDefinesPreamble(defines) + source;
+
+	// A copied file under another name compiles to the same shader
+	unsigned long long sourceHash = CompiledShaderCache::HashSource(key, source);
+	auto foundSource = m_shadersBySource.find(sourceHash);
+	if (foundSource != m_shadersBySource.end())
+	{
+		m_numSharedSources += 1;
+		m_shadersByKey[keyString] = foundSource->second;
+		return foundSource->second;
+	}
+
+	Shader* shader = CompileShader(key, source);
+	m_shadersByKey[keyString] = shader;
+	m_shadersBySource[sourceHash] = shader;
+	return shader;
+}
+
+// -----------------------------------------------------------------------------
+// The renderer only builds shaders from source, so the bytecode cache is off
+// until something able to compile to and create from bytecode is installed.
+// -----------------------------------------------------------------------------
+void ShaderRegistry::SetBytecodeHooks(ShaderCompileFunction const& compile, ShaderBytecodeFunction const& create)
+{
+	m_compile = compile;
+	m_createFromBytecode = create;
+}
+
+Shader* ShaderRegistry::CompileShader(ShaderKey const& key, std::string const& source)
+{
+	m_numCompiles += 1;
+	double compileStart = GetCurrentTimeSeconds();
+	Shader* shader = nullptr;
+	std::vector<unsigned char> bytecode;
+	if (m_compile && m_createFromBytecode && m_cache.GetOrCompile(key, source, m_compile, bytecode))
+	{
+		shader = m_createFromBytecode(key, bytecode);
+	}
+	if (shader == nullptr)
+	{
+		shader = g_theRenderer->CreateShader(key.m_shaderName.c_str(), source.c_str(), key.m_vertexType);
+	}
+	m_compileSeconds += GetCurrentTimeSeconds() - compileStart;
+	return shader;
+}
+
+// -----------------------------------------------------------------------------
+// Dev console: ShaderReport
+// Prints how many shader requests were served without compiling and roughly
+// how much startup time that saved, at the average cost of a real compile.
+// -----------------------------------------------------------------------------
+bool ShaderRegistry::Command_ShaderReport(EventArgs& args)
+{
+	UNUSED(args);
+	ShaderRegistry const& registry = *g_shaderRegistry;
+	int numShared = registry.m_numRequests - registry.m_numCompiles;
+	double averageCompileSeconds = (registry.m_numCompiles > 0) ? registry.m_compileSeconds / static_cast<double>(registry.m_numCompiles) : 0.0;
+	g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, Stringf("%d shader requests, %d compiles (%.2f ms), %d shared (%d by identical source)",
+		registry.m_numRequests, registry.m_numCompiles, registry.m_compileSeconds * 1000.0, numShared, registry.m_numSharedSources));
+	g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, Stringf("Sharing saved about %.2f ms", averageCompileSeconds * static_cast<double>(numShared) * 1000.0));
+	if (registry.m_compile && registry.m_createFromBytecode)
+	{
+		g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, Stringf("Bytecode cache: %d hits, %d misses, %.2f ms compiling, %.2f ms saved", registry.m_cache.m_numHits,
+			registry.m_cache.m_numMisses, registry.m_cache.m_compileSeconds * 1000.0, registry.m_cache.m_savedSeconds * 1000.0));
+	}
+	else
+	{
+		g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, "Bytecode cache: off, the renderer compiles from source");
+	}
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+// Dev console: ShaderCacheTest compileMs=<milliseconds>
+// Runs the bytecode cache against a stub compiler that takes compileMs per
+// shader: a cold run, a warm run, an edited source and a damaged cache file.
+// -----------------------------------------------------------------------------
+bool ShaderRegistry::Command_ShaderCacheTest(EventArgs& args)
+{
+	double compileSeconds = static_cast<double>(args.GetValue("compileMs", 5.f)) * 0.001;
+
+	int numStubCompiles = 0;
+	ShaderCompileFunction stubCompile = [&numStubCompiles, compileSeconds](ShaderKey const& key, std::string const& source, std::vector<unsigned char>& outBytecode)
+	{
+		numStubCompiles += 1;
+		double compileStart = GetCurrentTimeSeconds();
+		while (GetCurrentTimeSeconds() - compileStart < compileSeconds)
+		{
+		}
+		std::string keyString = key.ToString();
+		outBytecode.assign(source.rbegin(), source.rend());
+		outBytecode.insert(outBytecode.end(), keyString.begin(), keyString.end());
+		return true;
+	};
+
+	ShaderKey keys[4];
+	keys[0].m_shaderName = "Data/Shaders/Diffuse";
+	keys[0].m_vertexType = VertexType::VERTEX_PCUTBN;
+	keys[1] = keys[0];
+	keys[1].m_defines = "LIT;MAX_LIGHTS=8";
+	keys[2] = keys[0];
+	keys[2].m_vertexType = VertexType::VERTEX_PCU;
+	keys[3].m_shaderName = "Data/Shaders/Default";
+	std::string diffuseSource = "float4 PixelMain() { return diffuse; }";
+	std::string defaultSource = "float4 PixelMain() { return color; }";
+
+	// Runs every key through a fresh cache, the way one startup would
+	auto runStartup = [&](std::vector<std::vector<unsigned char>>& outBytecodes)
+	{
+		CompiledShaderCache cache(SHADER_CACHE_TEST_DIRECTORY);
+		outBytecodes.clear();
+		for (int keyIndex = 0; keyIndex < 4; ++keyIndex)
+		{
+			std::vector<unsigned char> bytecode;
+			cache.GetOrCompile(keys[keyIndex], (keyIndex < 3) ? diffuseSource : defaultSource, stubCompile, bytecode);
+			outBytecodes.push_back(bytecode);
+		}
+		return cache;
+	};
+
+	CompiledShaderCache testCache(SHADER_CACHE_TEST_DIRECTORY);
+	testCache.Clear();
+	std::vector<std::vector<unsigned char>> coldBytecodes;
+	double coldStart = GetCurrentTimeSeconds();
+	CompiledShaderCache cold = runStartup(coldBytecodes);
+	double coldSeconds = GetCurrentTimeSeconds() - coldStart;
+	int numColdCompiles = numStubCompiles;
+
+	numStubCompiles = 0;
+	std::vector<std::vector<unsigned char>> warmBytecodes;
+	double warmStart = GetCurrentTimeSeconds();
+	CompiledShaderCache warm = runStartup(warmBytecodes);
+	double warmSeconds = GetCurrentTimeSeconds() - warmStart;
+	bool isWarmCorrect = numStubCompiles == 0 && warm.m_numHits == 4 && warmBytecodes == coldBytecodes;
+
+	// Editing Diffuse misses its three variants and nothing else
+	numStubCompiles = 0;
+	diffuseSource += "\n// edited";
+	std::vector<std::vector<unsigned char>> editedBytecodes;
+	CompiledShaderCache edited = runStartup(editedBytecodes);
+	bool isEditCorrect = numStubCompiles == 3 && edited.m_numHits == 1 && editedBytecodes[0] != coldBytecodes[0] && editedBytecodes[3] == coldBytecodes[3];
+
+	// A truncated entry reads as a miss and is rewritten
+	std::error_code error;
+	std::string defaultEntryPath = testCache.GetEntryPath(CompiledShaderCache::HashSource(keys[3], defaultSource));
+	std::filesystem::resize_file(defaultEntryPath, sizeof(CompiledShaderHeader) + 2, error);
+	numStubCompiles = 0;
+	std::vector<std::vector<unsigned char>> repairedBytecodes;
+	CompiledShaderCache repaired = runStartup(repairedBytecodes);
+	bool isRepairCorrect = numStubCompiles == 1 && repairedBytecodes == editedBytecodes;
+	testCache.Clear();
+
+	bool didPass = numColdCompiles == 4 && cold.m_numMisses == 4 && isWarmCorrect && isEditCorrect && isRepairCorrect;
+	g_theDevConsole->AddLine(didPass ? Rgba8::LIGHTYELLOW : Rgba8::RED, Stringf("Shader cache test %s: warm run %s, edited source %s, damaged entry %s",
+		didPass ? "passed" : "FAILED", isWarmCorrect ? "ok" : "wrong", isEditCorrect ? "ok" : "wrong", isRepairCorrect ? "ok" : "wrong"));
+	g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, Stringf("Cold: %d misses, %.2f ms. Warm: %d hits, %.2f ms, %.2f ms saved", cold.m_numMisses, coldSeconds * 1000.0,
+		warm.m_numHits, warmSeconds * 1000.0, warm.m_savedSeconds * 1000.0));
+	return true;
+}
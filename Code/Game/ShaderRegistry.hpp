@@ -0,0 +1,79 @@
+#pragma once
+#include "Engine/Core/EventSystem.hpp"
+#include "Engine/Renderer/Renderer.h"
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+// -----------------------------------------------------------------------------
+class Shader;
+// -----------------------------------------------------------------------------
+// Defines are a semicolon separated list, "NAME" or "NAME=VALUE"
+struct ShaderKey
+{
+	std::string m_shaderName;
+	std::string m_defines;
+	VertexType  m_vertexType = VertexType::VERTEX_PCU;
+
+	std::string ToString() const;
+};
+// -----------------------------------------------------------------------------
+typedef std::function<bool(ShaderKey const& key, std::string const& source, std::vector<unsigned char>& outBytecode)> ShaderCompileFunction;
+typedef std::function<Shader*(ShaderKey const& key, std::vector<unsigned char> const& bytecode)> ShaderBytecodeFunction;
+// -----------------------------------------------------------------------------
+// Compiled bytecode on disk, one file per source hash. The hash covers the
+// source text, defines and vertex type, so editing a shader simply misses and
+// recompiles, and a file that fails to read back is treated the same way.
+// -----------------------------------------------------------------------------
+class CompiledShaderCache
+{
+public:
+	explicit CompiledShaderCache(std::string const& directory);
+
+	bool GetOrCompile(ShaderKey const& key, std::string const& source, ShaderCompileFunction const& compile, std::vector<unsigned char>& outBytecode);
+	bool Find(unsigned long long sourceHash, std::vector<unsigned char>& outBytecode, double& outCompileSeconds) const;
+	void Store(unsigned long long sourceHash, std::vector<unsigned char> const& bytecode, double compileSeconds) const;
+	void Clear() const;
+	std::string GetEntryPath(unsigned long long sourceHash) const;
+
+	static unsigned long long HashSource(ShaderKey const& key, std::string const& source);
+
+	int    m_numHits = 0;
+	int    m_numMisses = 0;
+	double m_compileSeconds = 0.0;
+	double m_savedSeconds = 0.0;
+// -----------------------------------------------------------------------------
+private:
+	std::string m_directory;
+};
+// -----------------------------------------------------------------------------
+// Hands out one shader per path, defines and vertex type, and one per distinct
+// source, so definitions naming the same shader share a single compile. When
+// a bytecode hook is installed compiles also go through the on-disk cache;
+// without one the renderer compiles from source.
+// -----------------------------------------------------------------------------
+class ShaderRegistry
+{
+public:
+	explicit ShaderRegistry(std::string const& cacheDirectory);
+
+	Shader* CreateOrGetShader(std::string const& shaderName, VertexType vertexType = VertexType::VERTEX_PCU, std::string const& defines = "");
+	void SetBytecodeHooks(ShaderCompileFunction const& compile, ShaderBytecodeFunction const& create);
+
+	static bool Command_ShaderReport(EventArgs& args);
+	static bool Command_ShaderCacheTest(EventArgs& args);
+
+	int    m_numRequests = 0;
+	int    m_numCompiles = 0;
+	int    m_numSharedSources = 0;
+	double m_compileSeconds = 0.0;
+// -----------------------------------------------------------------------------
+private:
+	Shader* CompileShader(ShaderKey const& key, std::string const& source);
+
+	std::map<std::string, Shader*> m_shadersByKey;
+	std::map<unsigned long long, Shader*> m_shadersBySource;
+	CompiledShaderCache m_cache;
+	ShaderCompileFunction m_compile;
+	ShaderBytecodeFunction m_createFromBytecode;
+};
@@ -0,0 +1,55 @@
+#pragma once
+// -----------------------------------------------------------------------------
+// A row of floats worked on together, 8 wide when the build targets AVX, 4 wide
+// with SSE2 (every x64 build and /arch:SSE2 on Win32), and a single float
+// otherwise, so kernels written against it build anywhere. Loads and stores
+// are unaligned and only the basic arithmetic the kernels need is wrapped.
+// -----------------------------------------------------------------------------
+#if defined(__AVX__)
+#include <immintrin.h>
+#define SIMD_FLOAT_AVX 1
+#elif defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SIMD_FLOAT_SSE 1
+#endif
+// -----------------------------------------------------------------------------
+#if defined(SIMD_FLOAT_AVX)
+constexpr int SIMD_FLOAT_WIDTH = 8;
+struct SimdFloat
+{
+	__m256 m_lanes;
+};
+inline SimdFloat SimdLoad(float const* source)			{ return SimdFloat{ _mm256_loadu_ps(source) }; }
+inline void SimdStore(float* destination, SimdFloat a)	{ _mm256_storeu_ps(destination, a.m_lanes); }
+inline SimdFloat SimdSet(float value)					{ return SimdFloat{ _mm256_set1_ps(value) }; }
+inline SimdFloat operator+(SimdFloat a, SimdFloat b)	{ return SimdFloat{ _mm256_add_ps(a.m_lanes, b.m_lanes) }; }
+inline SimdFloat operator-(SimdFloat a, SimdFloat b)	{ return SimdFloat{ _mm256_sub_ps(a.m_lanes, b.m_lanes) }; }
+inline SimdFloat operator*(SimdFloat a, SimdFloat b)	{ return SimdFloat{ _mm256_mul_ps(a.m_lanes, b.m_lanes) }; }
+inline char const* GetSimdFloatName()					{ return "AVX"; }
+#elif defined(SIMD_FLOAT_SSE)
+constexpr int SIMD_FLOAT_WIDTH = 4;
+struct SimdFloat
+{
+	__m128 m_lanes;
+};
+inline SimdFloat SimdLoad(float const* source)			{ return SimdFloat{ _mm_loadu_ps(source) }; }
+inline void SimdStore(float* destination, SimdFloat a)	{ _mm_storeu_ps(destination, a.m_lanes); }
+inline SimdFloat SimdSet(float value)					{ return SimdFloat{ _mm_set1_ps(value) }; }
+inline SimdFloat operator+(SimdFloat a, SimdFloat b)	{ return SimdFloat{ _mm_add_ps(a.m_lanes, b.m_lanes) }; }
+inline SimdFloat operator-(SimdFloat a, SimdFloat b)	{ return SimdFloat{ _mm_sub_ps(a.m_lanes, b.m_lanes) }; }
+inline SimdFloat operator*(SimdFloat a, SimdFloat b)	{ return SimdFloat{ _mm_mul_ps(a.m_lanes, b.m_lanes) }; }
+inline char const* GetSimdFloatName()					{ return "SSE2"; }
+#else
+constexpr int SIMD_FLOAT_WIDTH = 1;
+struct SimdFloat
+{
+	float m_lanes;
+};
+inline SimdFloat SimdLoad(float const* source)			{ return SimdFloat{ *source }; }
+inline void SimdStore(float* destination, SimdFloat a)	{ *destination = a.m_lanes; }
+inline SimdFloat SimdSet(float value)					{ return SimdFloat{ value }; }
+inline SimdFloat operator+(SimdFloat a, SimdFloat b)	{ return SimdFloat{ a.m_lanes + b.m_lanes }; }
+inline SimdFloat operator-(SimdFloat a, SimdFloat b)	{ return SimdFloat{ a.m_lanes - b.m_lanes }; }
+inline SimdFloat operator*(SimdFloat a, SimdFloat b)	{ return SimdFloat{ a.m_lanes * b.m_lanes }; }
+inline char const* GetSimdFloatName()					{ return "scalar"; }
+#endif
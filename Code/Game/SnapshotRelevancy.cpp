@@ -0,0 +1,85 @@
+#include "Game/SnapshotRelevancy.hpp"
+#include "Game/Map.hpp"
+#include "Game/Actor.hpp"
+
+// -----------------------------------------------------------------------------
+// Relevant actors carry their fresh state into the view, the rest keep whatever
+// the client last received. Actors the client has never received stay out until
+// they come up, and actors no longer in the map drop out of the view.
+// -----------------------------------------------------------------------------
+void SnapshotRelevancy::BuildView(Map const& map, Actor const* viewer, MapSnapshot const& fullSnapshot, MapSnapshot const* previousView, MapSnapshot& outView)
+{
+	outView.m_tick = fullSnapshot.m_tick;
+	outView.m_actors.clear();
+	if (m_accumulatedPriority.size() < map.m_allActors.size())
+	{
+		m_accumulatedPriority.resize(map.m_allActors.size(), 1.f);
+		m_priorityHandleData.resize(map.m_allActors.size(), ActorHandle::INVALID.GetData());
+	}
+
+	int previousIndex = 0;
+	int numPreviousActors = (previousView != nullptr) ? static_cast<int>(previousView->m_actors.size()) : 0;
+	for (int actorIndex = 0; actorIndex < static_cast<int>(fullSnapshot.m_actors.size()); ++actorIndex)
+	{
+		ActorSnapshot const& actorSnapshot = fullSnapshot.m_actors[actorIndex];
+		unsigned int mapIndex = actorSnapshot.m_handleData & 0xffffu;
+
+		// Both snapshots are in actor index order
+		while (previousIndex < numPreviousActors && (previousView->m_actors[previousIndex].m_handleData & 0xffffu) < mapIndex)
+		{
+			++previousIndex;
+		}
+		ActorSnapshot const* previousSnapshot = nullptr;
+		if (previousIndex < numPreviousActors && previousView->m_actors[previousIndex].m_handleData == actorSnapshot.m_handleData)
+		{
+			previousSnapshot = &previousView->m_actors[previousIndex];
+		}
+
+		Actor const* actor = map.m_allActors[mapIndex];
+		float& accumulatedPriority = m_accumulatedPriority[mapIndex];
+		if (m_priorityHandleData[mapIndex] != actorSnapshot.m_handleData)
+		{
+			m_priorityHandleData[mapIndex] = actorSnapshot.m_handleData;
+			accumulatedPriority = 1.f;
+		}
+		accumulatedPriority += (viewer != nullptr) ? GetActorPriority(map, *viewer, *actor) : 1.f;
+		if (accumulatedPriority >= 1.f || actor == viewer)
+		{
+			accumulatedPriority = 0.f;
+			outView.m_actors.push_back(actorSnapshot);
+		}
+		else if (previousSnapshot != nullptr)
+		{
+			outView.m_actors.push_back(*previousSnapshot);
+		}
+	}
+}
+
+float SnapshotRelevancy::GetActorPriority(Map const& map, Actor const& viewer, Actor const& actor) const
+{
+	IntVec2 viewerTile = map.GetTileCoordsForWorldPos(viewer.m_position);
+	IntVec2 actorTile = map.GetTileCoordsForWorldPos(actor.m_position);
+	int tileDistanceX = (actorTile.x > viewerTile.x) ? actorTile.x - viewerTile.x : viewerTile.x - actorTile.x;
+	int tileDistanceY = (actorTile.y > viewerTile.y) ? actorTile.y - viewerTile.y : viewerTile.y - actorTile.y;
+	int tileDistance = (tileDistanceX > tileDistanceY) ? tileDistanceX : tileDistanceY;
+
+	if (tileDistance <= m_settings.m_nearTiles)
+	{
+		return 1.f;
+	}
+	if (tileDistance > m_settings.m_farTiles)
+	{
+		return m_settings.m_distantPriority;
+	}
+
+	// In range, so the walls between the viewer's eye and the actor decide
+	Vec3 eyePosition = viewer.GetEyePosition();
+	Vec3 toActor = Vec3(actor.m_position.x, actor.m_position.y, eyePosition.z) - eyePosition;
+	float distance = toActor.GetLength();
+	if (distance <= 0.f)
+	{
+		return 1.f;
+	}
+	RaycastResult3D result = map.RaycastWorldXY(eyePosition, toActor / distance, distance);
+	return result.m_didImpact ? m_settings.m_hiddenPriority : 1.f;
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include "Game/MapSnapshot.hpp"
+#include <vector>
+// -----------------------------------------------------------------------------
+class Map;
+class Actor;
+// -----------------------------------------------------------------------------
+struct RelevancySettings
+{
+	int   m_nearTiles = 4;				// Always sent every tick
+	int   m_farTiles = 24;				// Sent every tick when in sight
+	float m_hiddenPriority = 0.25f;		// Within far range but behind walls
+	float m_distantPriority = 0.05f;	// Beyond far range
+};
+// -----------------------------------------------------------------------------
+// Picks which actors go into one client's update. Each actor's priority,
+// from tile distance and wall visibility to the client's viewer, accumulates
+// every tick and the actor is refreshed once it reaches one, so far away and
+// hidden actors still update now and then.
+// -----------------------------------------------------------------------------
+class SnapshotRelevancy
+{
+public:
+	void BuildView(Map const& map, Actor const* viewer, MapSnapshot const& fullSnapshot, MapSnapshot const* previousView, MapSnapshot& outView);
+	float GetActorPriority(Map const& map, Actor const& viewer, Actor const& actor) const;
+
+	RelevancySettings m_settings;
+// -----------------------------------------------------------------------------
+private:
+	std::vector<float> m_accumulatedPriority;	// By actor index
+	std::vector<unsigned int> m_priorityHandleData;	// Handle each index's priority belongs to, so a reused slot starts over
+};
@@ -2,42 +2,20 @@
 #include "Engine/Math/MathUtils.h"
 #include "Engine/Core/ErrorWarningAssert.hpp"
 
-SpriteAnimationGroup::SpriteAnimationGroup(XmlElement const& element, SpriteSheet* spritesheet)
-	:m_spriteSheet(spritesheet)
+SpriteAnimationGroup::SpriteAnimationGroup(std::string const& name, SpriteSheet* spritesheet, float secondsPerFrame, SpriteAnimPlaybackType playbackMode, bool scaleBySpeed)
+	:m_spriteSheet(spritesheet),
+	 m_animationGroupName(name),
+	 m_secondsPerFrame(secondsPerFrame),
+	 m_playbackMode(playbackMode),
+	 m_scaleBySpeed(scaleBySpeed)
 {
-	m_animationGroupName = ParseXmlAttribute(element, "name", m_animationGroupName);
- 	float secondsPerFrame = ParseXmlAttribute(element, "secondsPerFrame", 0.f);
-
-	std::string playbackMode = ParseXmlAttribute(element, "playbackMode", playbackMode);
-	if (playbackMode == "Loop")
-	{
-		m_playbackMode = SpriteAnimPlaybackType::LOOP;
-	}
-	else if (playbackMode == "Once")
-	{
-		m_playbackMode = SpriteAnimPlaybackType::ONCE;
-	}
-
-	m_scaleBySpeed = ParseXmlAttribute(element, "scaleBySpeed", m_scaleBySpeed);
-
-	XmlElement const* directionElement = element.FirstChildElement("Direction");
-	while (directionElement != nullptr)
-	{
-		Vec3 direction = ParseXmlAttribute(*directionElement, "vector", direction);
-		direction.Normalize();
-
-		XmlElement const* animElement = directionElement->FirstChildElement("Animation");
-		if (animElement == nullptr)
-		{
-			ERROR_AND_DIE(Stringf("Could not find animation element for \"%s\"", directionElement->Name()));
-		}
+}
 
-		m_directions.push_back(direction);
-		SpriteAnimDefinition animDef(*spritesheet, -1, -1, secondsPerFrame, m_playbackMode);
-		animDef.LoadFromXmlElement(animElement);
-		m_anims.push_back(animDef);
-		directionElement = directionElement->NextSiblingElement("Direction");
-	}
+// Directions added this way are expected to be normalized already
+void SpriteAnimationGroup::AddDirection(Vec3 const& direction, int startFrame, int endFrame)
+{
+	m_directions.push_back(direction);
+	m_anims.push_back(SpriteAnimDefinition(*m_spriteSheet, startFrame, endFrame, m_secondsPerFrame, m_playbackMode));
 }
 
 SpriteAnimDefinition SpriteAnimationGroup::GetAnimDirection(Vec3 const& direction)
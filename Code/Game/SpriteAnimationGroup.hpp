@@ -7,7 +7,8 @@ class SpriteSheet;
 class SpriteAnimationGroup
 {
 public:
-	SpriteAnimationGroup(XmlElement const& element, SpriteSheet* spritesheet);
+	SpriteAnimationGroup(std::string const& name, SpriteSheet* spritesheet, float secondsPerFrame, SpriteAnimPlaybackType playbackMode, bool scaleBySpeed);
+	void AddDirection(Vec3 const& direction, int startFrame, int endFrame);
 	SpriteAnimDefinition GetAnimDirection(Vec3 const& direction);
 	float                GetAnimationDuration();
 // -----------------------------------------------------------------------------
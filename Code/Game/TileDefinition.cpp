@@ -3,6 +3,10 @@
 
 std::vector<TileDefinition*> TileDefinition::s_definitions;
 
+TileDefinition::TileDefinition()
+{
+}
+
 TileDefinition::TileDefinition(XmlElement const& tileDefElement)
 {
 	m_name			= ParseXmlAttribute(tileDefElement, "name", m_name);
@@ -6,6 +6,7 @@
 // -----------------------------------------------------------------------------
 struct TileDefinition
 {
+	TileDefinition();
 	TileDefinition(XmlElement const& tileDefElement);
 	static std::vector<TileDefinition*> s_definitions;
 	static void InitializeTileDefs();
@@ -14,7 +15,7 @@ struct TileDefinition
 	static bool  AreTexelColorsEqual(Rgba8 colorA, Rgba8 colorB);
 // -----------------------------------------------------------------------------
 	std::string m_name;
-	bool		m_isSolid;
+	bool		m_isSolid = false;
 	Rgba8		m_mapImageColor;
 	IntVec2     m_floorCoords   = IntVec2::ZERO;
 	IntVec2		m_wallCoords    = IntVec2::ZERO;
@@ -0,0 +1,231 @@
+#include "Game/TimerWheel.hpp"
+#include "Game/GameCommon.h"
+#include "Game/Actor.hpp"
+#include "Game/BenchHelpers.hpp"
+#include "Game/Game.h"
+#include "Game/Map.hpp"
+#include "Engine/Core/DevConsole.hpp"
+#include "Engine/Core/EngineCommon.h"
+#include "Engine/Core/Time.hpp"
+#include <cmath>
+
+static unsigned long long const TIMER_WHEEL_SLOT_MASK = TIMER_WHEEL_SLOTS_PER_LEVEL - 1;
+
+void TimerWheel::Clear(double nowSeconds)
+{
+	for (int level = 0; level < TIMER_WHEEL_NUM_LEVELS; ++level)
+	{
+		for (int slotIndex = 0; slotIndex < TIMER_WHEEL_SLOTS_PER_LEVEL; ++slotIndex)
+		{
+			m_slots[level][slotIndex].clear();
+		}
+	}
+	m_overflow.clear();
+	m_currentTick = GetSlotTick(nowSeconds);
+	m_numScheduled = 0;
+	m_numFiredLastAdvance = 0;
+}
+
+void TimerWheel::Schedule(double dueSeconds, ActorHandle actorHandle, TimerEvent event)
+{
+	ScheduledTimer timer;
+	timer.m_dueSeconds = dueSeconds;
+	timer.m_actorHandle = actorHandle;
+	timer.m_event = event;
+	Insert(timer);
+	++m_numScheduled;
+}
+
+// -----------------------------------------------------------------------------
+// Every slot the clock passed fires whole; the slot the clock is in fires only
+// what is due and is visited again next time.
+// -----------------------------------------------------------------------------
+void TimerWheel::Advance(double nowSeconds, std::vector<ScheduledTimer>& outDueTimers)
+{
+	unsigned long long targetTick = GetSlotTick(nowSeconds);
+	size_t numDueBefore = outDueTimers.size();
+	while (m_currentTick < targetTick)
+	{
+		std::vector<ScheduledTimer>& slot = m_slots[0][m_currentTick & TIMER_WHEEL_SLOT_MASK];
+		outDueTimers.insert(outDueTimers.end(), slot.begin(), slot.end());
+		slot.clear();
+
+		++m_currentTick;
+		if ((m_currentTick & TIMER_WHEEL_SLOT_MASK) == 0)
+		{
+			int highestLevel = 1;
+			while (highestLevel < TIMER_WHEEL_NUM_LEVELS - 1 && ((m_currentTick >> (TIMER_WHEEL_SLOT_BITS * highestLevel)) & TIMER_WHEEL_SLOT_MASK) == 0)
+			{
+				++highestLevel;
+			}
+			for (int level = highestLevel; level >= 1; --level)
+			{
+				Cascade(level);
+			}
+		}
+	}
+
+	std::vector<ScheduledTimer>& currentSlot = m_slots[0][m_currentTick & TIMER_WHEEL_SLOT_MASK];
+	m_firingSlot.swap(currentSlot);
+	for (int timerIndex = 0; timerIndex < static_cast<int>(m_firingSlot.size()); ++timerIndex)
+	{
+		ScheduledTimer const& timer = m_firingSlot[timerIndex];
+		if (timer.m_dueSeconds <= nowSeconds)
+		{
+			outDueTimers.push_back(timer);
+		}
+		else
+		{
+			currentSlot.push_back(timer);
+		}
+	}
+	m_firingSlot.clear();
+
+	m_numFiredLastAdvance = static_cast<int>(outDueTimers.size() - numDueBefore);
+	m_numScheduled -= m_numFiredLastAdvance;
+}
+
+int TimerWheel::GetNumScheduled() const
+{
+	return m_numScheduled;
+}
+
+int TimerWheel::GetNumFiredLastAdvance() const
+{
+	return m_numFiredLastAdvance;
+}
+
+// Level 0 holds the next 64 ticks by their own tick, higher levels by the
+// block of ticks they fall in
+void TimerWheel::Insert(ScheduledTimer const& timer)
+{
+	unsigned long long tick = GetSlotTick(timer.m_dueSeconds);
+	tick = (tick < m_currentTick) ? m_currentTick : tick;
+	unsigned long long ticksAhead = tick - m_currentTick;
+	for (int level = 0; level < TIMER_WHEEL_NUM_LEVELS; ++level)
+	{
+		int levelShift = TIMER_WHEEL_SLOT_BITS * level;
+		if (ticksAhead < (1ull << (levelShift + TIMER_WHEEL_SLOT_BITS)))
+		{
+			m_slots[level][(tick >> levelShift) & TIMER_WHEEL_SLOT_MASK].push_back(timer);
+			return;
+		}
+	}
+	m_overflow.push_back(timer);
+}
+
+// The wheel just entered the block this level's slot covers, so its timers
+// are now close enough for the levels below
+void TimerWheel::Cascade(int level)
+{
+	std::vector<ScheduledTimer>& slot = m_slots[level][(m_currentTick >> (TIMER_WHEEL_SLOT_BITS * level)) & TIMER_WHEEL_SLOT_MASK];
+	m_firingSlot.swap(slot);
+	if (level == TIMER_WHEEL_NUM_LEVELS - 1)
+	{
+		m_firingSlot.insert(m_firingSlot.end(), m_overflow.begin(), m_overflow.end());
+		m_overflow.clear();
+	}
+	for (int timerIndex = 0; timerIndex < static_cast<int>(m_firingSlot.size()); ++timerIndex)
+	{
+		Insert(m_firingSlot[timerIndex]);
+	}
+	m_firingSlot.clear();
+}
+
+unsigned long long TimerWheel::GetSlotTick(double seconds)
+{
+	if (seconds <= 0.0)
+	{
+		return 0;
+	}
+	return static_cast<unsigned long long>(floor(seconds / TIMER_WHEEL_SLOT_SECONDS));
+}
+
+// -----------------------------------------------------------------------------
+// Dev console: TimerWheelBench corpses=<count> spawners=<count> ticks=<count>
+// Runs headless map ticks with a field of corpses kept around for the whole
+// run and a set of enemy spawners, and prints the tick time next to how many
+// actors still needed a per-tick update and how many timers fired. The map
+// and player lives are restored afterwards.
+// -----------------------------------------------------------------------------
+static void SpawnBenchActors(Map& map, std::vector<IntVec2> const& openTiles, char const* actorName, int numActors, std::vector<Actor*>& outActors)
+{
+	for (int spawnIndex = 0; spawnIndex < numActors; ++spawnIndex)
+	{
+		IntVec2 tileCoords = RollOpenTile(openTiles);
+
+		SpawnInfo spawnInfo;
+		spawnInfo.m_actorDef = ActorDefinition::GetByActorName(actorName);
+		spawnInfo.m_position = Vec3(static_cast<float>(tileCoords.x) + 0.5f, static_cast<float>(tileCoords.y) + 0.5f, 0.f);
+		outActors.push_back(map.SpawnActor(spawnInfo));
+	}
+}
+
+bool TimerWheel::Command_TimerWheelBench(EventArgs& args)
+{
+	Map* map = g_theGame->m_defaultMap;
+	if (g_theGame->m_currentState != GameState::PLAYING || map == nullptr)
+	{
+		g_theDevConsole->AddLine(Rgba8::RED, "TimerWheelBench needs a game in progress");
+		return false;
+	}
+
+	int numCorpses = args.GetValue("corpses", 10000);
+	int numSpawners = args.GetValue("spawners", 1000);
+	int numTicks = args.GetValue("ticks", 240);
+	numTicks = (numTicks < 1) ? 1 : numTicks;
+	int maxActors = static_cast<int>(ActorHandle::MAX_ACTOR_INDEX) - static_cast<int>(map->m_allActors.size());
+	numCorpses = (numCorpses < 0) ? 0 : ((numCorpses > maxActors) ? maxActors : numCorpses);
+	numSpawners = (numSpawners < 0) ? 0 : ((numSpawners > maxActors - numCorpses) ? maxActors - numCorpses : numSpawners);
+
+	std::vector<IntVec2> openTiles;
+	if (!GatherOpenTiles(*map, "TimerWheelBench", openTiles))
+	{
+		return false;
+	}
+
+	BenchMapScope benchScope(*map);
+
+	// Corpses stay for the whole run so the count holds; their first removal timers go stale
+	float deltaSeconds = 1.f / 60.f;
+	double corpseRemoveSeconds = map->m_simulationSeconds + (static_cast<double>(numTicks + 1) * static_cast<double>(deltaSeconds));
+	std::vector<Actor*> corpses;
+	SpawnBenchActors(*map, openTiles, "Demon", numCorpses, corpses);
+	for (Actor* corpse : corpses)
+	{
+		corpse->Die();
+		corpse->m_removeSeconds = corpseRemoveSeconds;
+		map->ScheduleActorTimers(*corpse);
+	}
+	std::vector<Actor*> spawners;
+	SpawnBenchActors(*map, openTiles, "EnemySpawner", numSpawners, spawners);
+
+	double sumSeconds = 0.0;
+	double worstSeconds = 0.0;
+	long long numTicked = 0;
+	long long numFired = 0;
+	for (int tickIndex = 0; tickIndex < numTicks; ++tickIndex)
+	{
+		double tickStart = GetCurrentTimeSeconds();
+		map->Update(deltaSeconds);
+		double tickSeconds = GetCurrentTimeSeconds() - tickStart;
+		sumSeconds += tickSeconds;
+		worstSeconds = (tickSeconds > worstSeconds) ? tickSeconds : worstSeconds;
+		numFired += map->m_timerWheel.GetNumFiredLastAdvance();
+		for (Actor const* actor : map->m_allActors)
+		{
+			numTicked += (actor != nullptr && actor->HasTickWork()) ? 1 : 0;
+		}
+	}
+
+	int numActors = 0;
+	for (Actor const* actor : map->m_allActors)
+	{
+		numActors += (actor != nullptr) ? 1 : 0;
+	}
+	g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, Stringf("%d corpses, %d spawners, %d ticks: %.3f ms/tick, worst %.3f ms", numCorpses, numSpawners, numTicks,
+		(sumSeconds * 1000.0) / static_cast<double>(numTicks), worstSeconds * 1000.0));
+	g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, Stringf("  %.1f of %d actors updated per tick, %.2f timers fired per tick, %d still scheduled",
+		static_cast<double>(numTicked) / static_cast<double>(numTicks), numActors, static_cast<double>(numFired) / static_cast<double>(numTicks), map->m_timerWheel.GetNumScheduled()));
+	return true;
+}
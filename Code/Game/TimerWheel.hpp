@@ -0,0 +1,57 @@
+#pragma once
+#include "Game/ActorHandle.hpp"
+#include "Engine/Core/EventSystem.hpp"
+#include <vector>
+// -----------------------------------------------------------------------------
+constexpr double TIMER_WHEEL_SLOT_SECONDS = 1.0 / 60.0;
+constexpr int    TIMER_WHEEL_SLOT_BITS = 6;
+constexpr int    TIMER_WHEEL_SLOTS_PER_LEVEL = 1 << TIMER_WHEEL_SLOT_BITS;
+constexpr int    TIMER_WHEEL_NUM_LEVELS = 4;	// 64^4 slots, a little over three days of simulation
+// -----------------------------------------------------------------------------
+enum class TimerEvent : unsigned char
+{
+	SPAWN_ENEMY,	// Spawner's next enemy is due
+	REMOVE_CORPSE,	// Dead or die-on-spawn actor has lived out its corpse lifetime
+	END_SLOW,		// Leg-shot slow wears off
+	COUNT
+};
+// -----------------------------------------------------------------------------
+struct ScheduledTimer
+{
+	double      m_dueSeconds = 0.0;
+	ActorHandle m_actorHandle = ActorHandle::INVALID;
+	TimerEvent  m_event = TimerEvent::COUNT;
+};
+// -----------------------------------------------------------------------------
+// Hierarchical timer wheel over map simulation time. The first level holds
+// one slot per tick for the next 64 ticks, each level above covers 64 of the
+// slots below it, and a level's slot is spread into the levels below when the
+// wheel reaches it, so advancing costs one slot per tick however many timers
+// are waiting. Timers are never cancelled: the owner compares the due time it
+// fired with against its own and ignores the stale ones.
+// -----------------------------------------------------------------------------
+class TimerWheel
+{
+public:
+	TimerWheel() = default;
+
+	void Clear(double nowSeconds);
+	void Schedule(double dueSeconds, ActorHandle actorHandle, TimerEvent event);
+	void Advance(double nowSeconds, std::vector<ScheduledTimer>& outDueTimers);
+	int  GetNumScheduled() const;
+	int  GetNumFiredLastAdvance() const;
+
+	static bool Command_TimerWheelBench(EventArgs& args);
+// -----------------------------------------------------------------------------
+private:
+	void Insert(ScheduledTimer const& timer);
+	void Cascade(int level);
+	static unsigned long long GetSlotTick(double seconds);
+// -----------------------------------------------------------------------------
+	std::vector<ScheduledTimer> m_slots[TIMER_WHEEL_NUM_LEVELS][TIMER_WHEEL_SLOTS_PER_LEVEL];
+	std::vector<ScheduledTimer> m_overflow;	// Further out than the top level reaches
+	std::vector<ScheduledTimer> m_firingSlot;
+	unsigned long long m_currentTick = 0;	// First level-0 slot not yet emptied
+	int m_numScheduled = 0;
+	int m_numFiredLastAdvance = 0;
+};
@@ -0,0 +1,367 @@
+#include "Game/VisibilityField.hpp"
+#include "Game/GameCommon.h"
+#include "Game/Actor.hpp"
+#include "Game/BenchHelpers.hpp"
+#include "Game/Game.h"
+#include "Game/Map.hpp"
+#include "Game/Player.hpp"
+#include "Game/TileDefinition.hpp"
+#include "Engine/Core/DevConsole.hpp"
+#include "Engine/Core/EngineCommon.h"
+#include "Engine/Core/Time.hpp"
+#include "Engine/Math/MathUtils.h"
+#include <algorithm>
+#include <cfloat>
+
+// Keeps slopes finite when the eye sits exactly on a tile edge
+static constexpr float VISIBILITY_MIN_MAJOR_DISTANCE = 0.0001f;
+
+void VisibilityField::Compute(Map const& map, Vec2 const& eyePosition, float radius, ActorHandle sourceHandle)
+{
+	m_dimensions = map.m_dimensions;
+	m_eyePosition = eyePosition;
+	m_radius = radius;
+	m_sourceHandle = sourceHandle;
+	m_isValid = true;
+	m_visibleBits.assign(((m_dimensions.x * m_dimensions.y) + 31) / 32, 0u);
+
+	int eyeTileX = RoundDownToInt(eyePosition.x);
+	int eyeTileY = RoundDownToInt(eyePosition.y);
+	if (eyeTileX < 0 || eyeTileY < 0 || eyeTileX >= m_dimensions.x || eyeTileY >= m_dimensions.y)
+	{
+		return;
+	}
+	SetTileVisible(eyeTileX, eyeTileY);
+
+	// Every combination of which axis leads and which way each axis points
+	for (int octant = 0; octant < 8; ++octant)
+	{
+		bool isMajorX = (octant & 4) == 0;
+		int majorSign = (octant & 2) ? -1 : 1;
+		int minorSign = (octant & 1) ? -1 : 1;
+		CastOctant(map, isMajorX, majorSign, minorSign);
+	}
+}
+
+void VisibilityField::Invalidate()
+{
+	m_isValid = false;
+	m_sourceHandle = ActorHandle::INVALID;
+}
+
+bool VisibilityField::IsValid() const
+{
+	return m_isValid;
+}
+
+// Only positions within the radius were cast, anything further is unknown rather than hidden
+bool VisibilityField::Covers(Vec2 const& position) const
+{
+	return m_isValid && GetDistanceSquared2D(position, m_eyePosition) <= m_radius * m_radius;
+}
+
+bool VisibilityField::IsTileVisible(IntVec2 const& tileCoords) const
+{
+	if (tileCoords.x < 0 || tileCoords.y < 0 || tileCoords.x >= m_dimensions.x || tileCoords.y >= m_dimensions.y)
+	{
+		return false;
+	}
+	int tileIndex = (tileCoords.y * m_dimensions.x) + tileCoords.x;
+	return ((m_visibleBits[tileIndex >> 5] >> (tileIndex & 31)) & 1u) != 0;
+}
+
+int VisibilityField::GetNumVisibleTiles() const
+{
+	int numVisibleTiles = 0;
+	for (int wordIndex = 0; wordIndex < static_cast<int>(m_visibleBits.size()); ++wordIndex)
+	{
+		for (unsigned int bits = m_visibleBits[wordIndex]; bits != 0; bits &= bits - 1)
+		{
+			++numVisibleTiles;
+		}
+	}
+	return numVisibleTiles;
+}
+
+// -----------------------------------------------------------------------------
+// Walks rows of tiles moving away from the eye along the major axis. Slopes
+// are minor over major distance measured from the real eye position, not the
+// center of its tile, so a solid tile shadows exactly the directions that pass
+// through it. A tile is visible when the slope to its center is unshadowed.
+// -----------------------------------------------------------------------------
+void VisibilityField::CastOctant(Map const& map, bool isMajorX, int majorSign, int minorSign)
+{
+	float eyeMajor = isMajorX ? m_eyePosition.x : m_eyePosition.y;
+	float eyeMinor = isMajorX ? m_eyePosition.y : m_eyePosition.x;
+	int eyeMajorTile = RoundDownToInt(eyeMajor);
+	int eyeMinorTile = RoundDownToInt(eyeMinor);
+	int majorTileCount = isMajorX ? m_dimensions.x : m_dimensions.y;
+	int minorTileCount = isMajorX ? m_dimensions.y : m_dimensions.x;
+
+	// Distance from the eye to the far edge of its own tile in this octant's directions
+	float majorEdge = (majorSign > 0) ? static_cast<float>(eyeMajorTile + 1) - eyeMajor : eyeMajor - static_cast<float>(eyeMajorTile);
+	float minorEdge = (minorSign > 0) ? static_cast<float>(eyeMinorTile + 1) - eyeMinor : eyeMinor - static_cast<float>(eyeMinorTile);
+	float radiusSquared = m_radius * m_radius;
+
+	// The nearest wall beside the eye in its own row hides everything steeper than its near corner
+	m_shadows.clear();
+	for (int column = 1; ; ++column)
+	{
+		int minorTile = eyeMinorTile + (minorSign * column);
+		float lowMinor = minorEdge + static_cast<float>(column - 1);
+		if (minorTile < 0 || minorTile >= minorTileCount || lowMinor > m_radius)
+		{
+			break;
+		}
+		if (map.IsTileSolid(isMajorX ? eyeMajorTile : minorTile, isMajorX ? minorTile : eyeMajorTile))
+		{
+			m_shadows.push_back(std::make_pair(lowMinor / std::max(majorEdge, VISIBILITY_MIN_MAJOR_DISTANCE), FLT_MAX));
+			break;
+		}
+	}
+
+	for (int row = 1; ; ++row)
+	{
+		int majorTile = eyeMajorTile + (majorSign * row);
+		float nearMajor = std::max(majorEdge + static_cast<float>(row - 1), VISIBILITY_MIN_MAJOR_DISTANCE);
+		float farMajor = majorEdge + static_cast<float>(row);
+		bool isFullyShadowed = m_shadows.size() == 1 && m_shadows[0].first <= 0.f && m_shadows[0].second >= 1.f;
+		if (majorTile < 0 || majorTile >= majorTileCount || nearMajor > m_radius || isFullyShadowed)
+		{
+			return;
+		}
+
+		float centerMajor = majorEdge + static_cast<float>(row) - 0.5f;
+		m_rowShadows.clear();
+		for (int column = 0; ; ++column)
+		{
+			int minorTile = eyeMinorTile + (minorSign * column);
+			float lowMinor = minorEdge + static_cast<float>(column - 1);
+			float highMinor = lowMinor + 1.f;
+			if (minorTile < 0 || minorTile >= minorTileCount || lowMinor > farMajor)
+			{
+				break;
+			}
+
+			int tileX = isMajorX ? majorTile : minorTile;
+			int tileY = isMajorX ? minorTile : majorTile;
+			if (map.IsTileSolid(tileX, tileY))
+			{
+				float lowSlope = lowMinor / ((lowMinor >= 0.f) ? farMajor : nearMajor);
+				float highSlope = highMinor / ((highMinor >= 0.f) ? nearMajor : farMajor);
+				m_rowShadows.push_back(std::make_pair(lowSlope, highSlope));
+				continue;
+			}
+
+			// Centers outside this octant belong to a neighboring one
+			float centerMinor = lowMinor + 0.5f;
+			float centerSlope = centerMinor / centerMajor;
+			if (centerSlope < 0.f || centerSlope > 1.f || (centerMajor * centerMajor) + (centerMinor * centerMinor) > radiusSquared)
+			{
+				continue;
+			}
+			if (!IsSlopeInShadow(centerSlope))
+			{
+				SetTileVisible(tileX, tileY);
+			}
+		}
+
+		// A row's walls only shadow the rows beyond it
+		AddShadows(m_rowShadows);
+	}
+}
+
+bool VisibilityField::IsSlopeInShadow(float slope) const
+{
+	// First shadow starting past the slope, the one before it is the only one that can contain it
+	std::vector<std::pair<float, float>>::const_iterator after = std::upper_bound(m_shadows.begin(), m_shadows.end(), std::make_pair(slope, FLT_MAX));
+	if (after == m_shadows.begin())
+	{
+		return false;
+	}
+	--after;
+	return slope <= after->second;
+}
+
+void VisibilityField::AddShadows(std::vector<std::pair<float, float>> const& newShadows)
+{
+	if (newShadows.empty())
+	{
+		return;
+	}
+
+	m_shadows.insert(m_shadows.end(), newShadows.begin(), newShadows.end());
+	std::sort(m_shadows.begin(), m_shadows.end());
+
+	int numMerged = 0;
+	for (int shadowIndex = 1; shadowIndex < static_cast<int>(m_shadows.size()); ++shadowIndex)
+	{
+		if (m_shadows[shadowIndex].first <= m_shadows[numMerged].second)
+		{
+			m_shadows[numMerged].second = std::max(m_shadows[numMerged].second, m_shadows[shadowIndex].second);
+		}
+		else
+		{
+			m_shadows[++numMerged] = m_shadows[shadowIndex];
+		}
+	}
+	m_shadows.resize(numMerged + 1);
+}
+
+void VisibilityField::SetTileVisible(int tileX, int tileY)
+{
+	int tileIndex = (tileY * m_dimensions.x) + tileX;
+	m_visibleBits[tileIndex >> 5] |= 1u << (tileIndex & 31);
+}
+
+// -----------------------------------------------------------------------------
+// Compares the field for one eye against a wall raycast to the center of every
+// open tile it covers. Returns the number of tiles checked.
+// -----------------------------------------------------------------------------
+static int CountFieldDisagreements(Map const& map, VisibilityField const& field, Vec2 const& eyePosition, float radius, int& outNumDisagreements)
+{
+	int numChecked = 0;
+	for (int tileY = 0; tileY < map.m_dimensions.y; ++tileY)
+	{
+		for (int tileX = 0; tileX < map.m_dimensions.x; ++tileX)
+		{
+			Vec2 tileCenter(static_cast<float>(tileX) + 0.5f, static_cast<float>(tileY) + 0.5f);
+			float distance = GetDistance2D(eyePosition, tileCenter);
+			if (map.IsTileSolid(tileX, tileY) || distance > radius || distance <= 0.f)
+			{
+				continue;
+			}
+
+			Vec2 direction = (tileCenter - eyePosition) / distance;
+			RaycastResult3D result = map.RaycastWorldXY(Vec3(eyePosition.x, eyePosition.y, 0.5f), Vec3(direction.x, direction.y, 0.f), distance);
+			bool isRayClear = !result.m_didImpact || result.m_impactDist >= distance;
+			outNumDisagreements += (isRayClear != field.IsTileVisible(IntVec2(tileX, tileY))) ? 1 : 0;
+			++numChecked;
+		}
+	}
+	return numChecked;
+}
+
+static Vec2 GetRandomOpenPosition(std::vector<IntVec2> const& openTiles)
+{
+	IntVec2 tileCoords = RollOpenTile(openTiles);
+	return Vec2(static_cast<float>(tileCoords.x) + GetBenchRng().RollRandomFloatInRange(0.f, 1.f), static_cast<float>(tileCoords.y) + GetBenchRng().RollRandomFloatInRange(0.f, 1.f));
+}
+
+// -----------------------------------------------------------------------------
+// Dev console: VisibilityBench demons=<count> maps=<count>
+// Times sight checks from many demons to the first player with a raycast each
+// against one shadowcast plus a lookup each, then checks the field against
+// wall raycasts on the running map and on randomly generated layouts.
+// -----------------------------------------------------------------------------
+bool VisibilityField::Command_VisibilityBench(EventArgs& args)
+{
+	Map* map = g_theGame->m_defaultMap;
+	Actor* playerActor = (map != nullptr && !g_theGame->m_players.empty()) ? map->GetActorByHandle(g_theGame->m_players[0]->m_currentHandle) : nullptr;
+	if (g_theGame->m_currentState != GameState::PLAYING || playerActor == nullptr)
+	{
+		g_theDevConsole->AddLine(Rgba8::RED, "VisibilityBench needs a game in progress with a player");
+		return false;
+	}
+
+	int numDemons = args.GetValue("demons", 5000);
+	int numMaps = args.GetValue("maps", 8);
+	int maxActors = static_cast<int>(ActorHandle::MAX_ACTOR_INDEX) - static_cast<int>(map->m_allActors.size());
+	numDemons = (numDemons < 0) ? 0 : ((numDemons > maxActors) ? maxActors : numDemons);
+
+	std::vector<IntVec2> openTiles;
+	if (!GatherOpenTiles(*map, "VisibilityBench", openTiles))
+	{
+		return false;
+	}
+
+	std::vector<ActorHandle> benchActors;
+	for (int spawnIndex = 0; spawnIndex < numDemons; ++spawnIndex)
+	{
+		Vec2 position = GetRandomOpenPosition(openTiles);
+		SpawnInfo spawnInfo;
+		spawnInfo.m_actorDef = ActorDefinition::GetByActorName("Demon");
+		spawnInfo.m_position = Vec3(position.x, position.y, 0.f);
+		benchActors.push_back(map->SpawnActor(spawnInfo)->m_actorHandle);
+	}
+
+	Vec2 eyePosition = playerActor->m_position.GetXY();
+	float radius = map->m_maxSightRadius;
+
+	int numRaycastVisible = 0;
+	double raycastStart = GetCurrentTimeSeconds();
+	for (int benchIndex = 0; benchIndex < static_cast<int>(benchActors.size()); ++benchIndex)
+	{
+		Actor* demon = map->GetActorByHandle(benchActors[benchIndex]);
+		numRaycastVisible += map->HasLineOfSightByRaycast(demon, playerActor) ? 1 : 0;
+	}
+	double raycastSeconds = GetCurrentTimeSeconds() - raycastStart;
+
+	VisibilityField field;
+	int numFieldVisible = 0;
+	double fieldStart = GetCurrentTimeSeconds();
+	field.Compute(*map, eyePosition, radius, playerActor->m_actorHandle);
+	for (int benchIndex = 0; benchIndex < static_cast<int>(benchActors.size()); ++benchIndex)
+	{
+		Vec2 demonPosition = map->GetActorByHandle(benchActors[benchIndex])->m_position.GetXY();
+		numFieldVisible += (field.Covers(demonPosition) && field.IsTileVisible(IntVec2(RoundDownToInt(demonPosition.x), RoundDownToInt(demonPosition.y)))) ? 1 : 0;
+	}
+	double fieldSeconds = GetCurrentTimeSeconds() - fieldStart;
+
+	int numMapDisagreements = 0;
+	int numMapChecked = CountFieldDisagreements(*map, field, eyePosition, radius, numMapDisagreements);
+
+	for (int benchIndex = 0; benchIndex < static_cast<int>(benchActors.size()); ++benchIndex)
+	{
+		map->GetActorByHandle(benchActors[benchIndex])->Destroy();
+	}
+	map->DeleteDestroyedActors();
+
+	// Random layouts: a solid border and scattered walls, several eyes each
+	TileDefinition* solidDef = nullptr;
+	TileDefinition* openDef = nullptr;
+	for (int tileDefIndex = 0; tileDefIndex < static_cast<int>(TileDefinition::s_definitions.size()); ++tileDefIndex)
+	{
+		TileDefinition* tileDef = TileDefinition::s_definitions[tileDefIndex];
+		solidDef = (solidDef == nullptr && tileDef->m_isSolid) ? tileDef : solidDef;
+		openDef = (openDef == nullptr && !tileDef->m_isSolid) ? tileDef : openDef;
+	}
+
+	int numGeneratedDisagreements = 0;
+	int numGeneratedChecked = 0;
+	if (solidDef != nullptr && openDef != nullptr)
+	{
+		std::vector<Tile> savedTiles = map->m_tiles;
+		for (int mapIndex = 0; mapIndex < numMaps; ++mapIndex)
+		{
+			float wallChance = GetBenchRng().RollRandomFloatInRange(0.05f, 0.4f);
+			for (int tileY = 0; tileY < map->m_dimensions.y; ++tileY)
+			{
+				for (int tileX = 0; tileX < map->m_dimensions.x; ++tileX)
+				{
+					bool isBorder = tileX == 0 || tileY == 0 || tileX == map->m_dimensions.x - 1 || tileY == map->m_dimensions.y - 1;
+					bool isSolid = isBorder || GetBenchRng().RollRandomFloatZeroToOne() < wallChance;
+					map->m_tiles[(tileY * map->m_dimensions.x) + tileX].m_tileDef = isSolid ? solidDef : openDef;
+				}
+			}
+			std::vector<IntVec2> generatedOpenTiles;
+			if (!GatherOpenTiles(*map, "VisibilityBench layout", generatedOpenTiles))
+			{
+				continue;
+			}
+			for (int eyeIndex = 0; eyeIndex < 4; ++eyeIndex)
+			{
+				Vec2 generatedEye = GetRandomOpenPosition(generatedOpenTiles);
+				field.Compute(*map, generatedEye, radius, ActorHandle::INVALID);
+				numGeneratedChecked += CountFieldDisagreements(*map, field, generatedEye, radius, numGeneratedDisagreements);
+			}
+		}
+		map->m_tiles = savedTiles;
+	}
+
+	g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, Stringf("Sight checks for %d demons: raycasts %.3f ms (%d visible), one field %.3f ms (%d visible)",
+		numDemons, raycastSeconds * 1000.0, numRaycastVisible, fieldSeconds * 1000.0, numFieldVisible));
+	g_theDevConsole->AddLine(Rgba8::LIGHTYELLOW, Stringf("Field vs wall raycasts: running map %d of %d tiles disagree, %d generated maps %d of %d tiles disagree",
+		numMapDisagreements, numMapChecked, numMaps, numGeneratedDisagreements, numGeneratedChecked));
+	return true;
+}
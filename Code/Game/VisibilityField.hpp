@@ -0,0 +1,46 @@
+#pragma once
+#include "Game/ActorHandle.hpp"
+#include "Engine/Core/EventSystem.hpp"
+#include "Engine/Math/IntVec2.h"
+#include "Engine/Math/Vec2.hpp"
+#include <utility>
+#include <vector>
+// -----------------------------------------------------------------------------
+class Map;
+// -----------------------------------------------------------------------------
+// Which tiles have a clear line to one eye, found with a shadowcast over the
+// map tiles out to a radius. A tile counts as visible when nothing solid lies
+// between the eye and its center, so looking up an actor's tile stands in for
+// a raycast from the eye to that actor.
+// -----------------------------------------------------------------------------
+class VisibilityField
+{
+public:
+	VisibilityField() = default;
+
+	void Compute(Map const& map, Vec2 const& eyePosition, float radius, ActorHandle sourceHandle);
+	void Invalidate();
+	bool IsValid() const;
+	bool Covers(Vec2 const& position) const;
+	bool IsTileVisible(IntVec2 const& tileCoords) const;
+	int  GetNumVisibleTiles() const;
+
+	ActorHandle m_sourceHandle = ActorHandle::INVALID;	// Whose eye this was cast from
+
+	static bool Command_VisibilityBench(EventArgs& args);
+// -----------------------------------------------------------------------------
+private:
+	void CastOctant(Map const& map, bool isMajorX, int majorSign, int minorSign);
+	bool IsSlopeInShadow(float slope) const;
+	void AddShadows(std::vector<std::pair<float, float>> const& newShadows);
+	void SetTileVisible(int tileX, int tileY);
+// -----------------------------------------------------------------------------
+	IntVec2 m_dimensions = IntVec2::ZERO;
+	Vec2    m_eyePosition = Vec2(0.f, 0.f);
+	float   m_radius = 0.f;
+	bool    m_isValid = false;
+
+	std::vector<unsigned int> m_visibleBits;	// One bit per tile
+	std::vector<std::pair<float, float>> m_shadows;	// Sorted, non-overlapping slope ranges for the octant being cast
+	std::vector<std::pair<float, float>> m_rowShadows;
+};
@@ -5,30 +5,35 @@
 #include "Game/Actor.hpp"
 #include "Game/Player.hpp"
 #include "Game/SpriteAnimationGroup.hpp"
-#include "Engine/Core/Timer.hpp"
 #include "Engine/Core/DebugRender.hpp"
 #include "Engine/Math/MathUtils.h"
 
+// Reused between melee swings so a swing does not allocate
+static ActorList s_meleeCandidates;
+
 Weapon::Weapon(Actor* weaponHolder, WeaponDefinition* weaponDefinition)
 	:m_owner(weaponHolder), m_weaponDef(weaponDefinition)
 {
-	m_refireTimer = new Timer(static_cast<double>(m_weaponDef->m_refireTime), g_theGame->m_gameClock);
-	m_refireTimer->Start();
-	m_animationClock = new Clock(*g_theGame->m_gameClock);
+	m_lastFireSeconds = m_owner->m_theMap->m_simulationSeconds;
 	m_currentAnimation = m_weaponDef->GetAnimationByName("Idle");
-
-	// Reset the animation clock
-	m_animationClock->Reset();
+	m_animationPlayback.Restart(m_lastFireSeconds);
 }
 
 void Weapon::Fire()
 {
-	if (!m_refireTimer->HasPeriodElapsed() || m_owner == nullptr)
+	if (m_owner == nullptr)
+	{
+		return;
+	}
+
+	// Refire is measured in map simulation time so recorded games replay identically
+	double simulationSeconds = m_owner->m_theMap->m_simulationSeconds;
+	if (simulationSeconds - m_lastFireSeconds < static_cast<double>(m_weaponDef->m_refireTime))
 	{
 		return;
 	}
 
-	m_refireTimer->Start();
+	m_lastFireSeconds = simulationSeconds;
 
 	// Cache definition values
 	int rayCount = m_weaponDef->m_rayCount;
@@ -39,21 +44,21 @@ void Weapon::Fire()
 	// Animation + sound
 	//-------------------------------------------------------------------------
 	m_currentAnimation = m_weaponDef->GetAnimationByName("Attack");
-	m_animationClock->Reset();
+	m_animationPlayback.Restart(simulationSeconds);
 
 	m_owner->m_animGroup = m_owner->m_actorDef->GetAnimationByName("Attack");
 
 	if (m_owner->m_animGroup->m_scaleBySpeed)
 	{
 		float speedScale = m_owner->m_velocity.GetLength() / m_owner->m_actorDef->m_runSpeed;
-		m_owner->m_animationClock->SetTimeScale(speedScale);
+		m_owner->m_animationPlayback.SetTimeScale(speedScale, simulationSeconds);
 	}
 	else
 	{
-		m_owner->m_animationClock->SetTimeScale(1.0f);
+		m_owner->m_animationPlayback.SetTimeScale(1.0f, simulationSeconds);
 	}
 
-	m_owner->m_animationClock->Reset();
+	m_owner->m_animationPlayback.Restart(simulationSeconds);
 
 	SoundID fireSound = g_theAudio->CreateOrGetSound(m_weaponDef->m_soundFilePath);
 	g_theAudio->StartSoundAt(fireSound, m_owner->m_position, false, 0.5f);
@@ -77,16 +82,6 @@ void Weapon::Fire()
 			10.f
 		);
 
-		if (raycastResult.m_didImpact)
-		{
-			SpawnInfo bulletHit;
-			bulletHit.m_actorName = "BulletHit";
-			bulletHit.m_position = raycastResult.m_impactPos;
-			bulletHit.m_position.x = GetClamped(bulletHit.m_position.x, 0.f, 31.f);
-			bulletHit.m_position.y = GetClamped(bulletHit.m_position.y, 0.f, 31.f);
-			// g_theGame->m_defaultMap->SpawnActor(bulletHit);
-		}
-
 		Actor* target = m_owner->m_theMap->GetActorByHandle(targetHandle);
 		if (!target || target == m_owner)
 		{
@@ -114,9 +109,7 @@ void Weapon::Fire()
 		else if (legs.isOnRange(localHitZ))
 		{
 			damage *= 0.5f;
-			target->m_isSlowed = true;
-			target->m_slowAmount = 0.5f;
-			target->m_slowTimer = 3.0f;
+			target->ApplySlow(0.5f, 3.0f);
 			DebugAddMessage("Legshot", 1.f);
 		}
 
@@ -133,7 +126,7 @@ void Weapon::Fire()
 		randomDir.GetAsVectors_IFwd_JLeft_KUp(forward, left, up);
 
 		SpawnInfo spawnInfo;
-		spawnInfo.m_actorName = m_weaponDef->m_projectileActor;
+		spawnInfo.m_actorDef = m_weaponDef->m_projectileActorDef;
 		spawnInfo.m_position = m_owner->GetEyePosition() + m_owner->GetForwardNormal();
 		spawnInfo.m_orientation = randomDir;
 		spawnInfo.m_velocity = forward * m_weaponDef->m_projectileSpeed;
@@ -152,45 +145,20 @@ void Weapon::Fire()
 		Vec2 ownerPosXY = m_owner->m_position.GetXY();
 		Vec2 forwardXY = forward.GetXY();
 
-		float meleeArc = m_weaponDef->m_meleeArc * 0.5f;
-		float meleeRangeSq = m_weaponDef->m_meleeRange * m_weaponDef->m_meleeRange;
+		ActorQueryFilter filter;
+		filter.m_ignoreActor = m_owner;
+		filter.m_hostileTo = m_owner;
+		ActorList& inArc = s_meleeCandidates;
+		m_owner->m_theMap->QueryActorsInSector(ownerPosXY, forwardXY, m_weaponDef->m_meleeArc, m_weaponDef->m_meleeRange, filter, inArc);
 
 		Actor* closestTarget = nullptr;
 		float closestDistSq = FLT_MAX;
 
-		for (Actor* actor : m_owner->m_theMap->m_allActors)
+		for (Actor* actor : inArc)
 		{
-			if (!actor || actor == m_owner)
-			{
-				continue;
-			}
-
-			if (actor->m_actorDef->m_faction == m_owner->m_actorDef->m_faction)
-			{
-				continue;
-			}
-
-			if (actor->m_actorDef->m_faction == "NEUTRAL" ||
-				m_owner->m_actorDef->m_faction == "NEUTRAL")
-			{
-				continue;
-			}
-
-			Vec2 targetPosXY = actor->m_position.GetXY();
-			float distSq = GetDistanceSquared2D(ownerPosXY, targetPosXY);
-			if (distSq > meleeRangeSq)
-			{
-				continue;
-			}
-
-			Vec2 toTarget = (targetPosXY - ownerPosXY).GetNormalized();
-			float angle = GetAngleDegreesBetweenVectors2D(forwardXY, toTarget);
-			if (angle > meleeArc)
-			{
-				continue;
-			}
-
-			if (distSq < closestDistSq)
+			// Ties go to the lower index so the pick doesn't depend on grid order
+			float distSq = GetDistanceSquared2D(ownerPosXY, actor->m_position.GetXY());
+			if (distSq < closestDistSq || (distSq == closestDistSq && actor->m_actorHandle.GetIndex() < closestTarget->m_actorHandle.GetIndex()))
 			{
 				closestDistSq = distSq;
 				closestTarget = actor;
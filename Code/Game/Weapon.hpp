@@ -1,10 +1,9 @@
 #pragma once
 #include "Game/WeaponDefinition.hpp"
+#include "Game/AnimationPlayback.hpp"
 #include "Engine/Math/AABB2.h"
 // -----------------------------------------------------------------------------
 class Actor;
-class Timer;
-class Clock;
 // -----------------------------------------------------------------------------
 class Weapon
 {
@@ -16,8 +15,8 @@ public:
 // -----------------------------------------------------------------------------
 public:
 	Actor* m_owner = nullptr;
-	Timer* m_refireTimer = nullptr;
-	Clock* m_animationClock = nullptr;
+	double m_lastFireSeconds = 0.0;
+	AnimationPlayback m_animationPlayback;
 	WeaponDefinition* m_weaponDef = nullptr;
 	SpriteAnimDefinition* m_currentAnimation = nullptr;
 };
\ No newline at end of file
@@ -1,12 +1,25 @@
 #include "Game/WeaponDefinition.hpp"
 #include "Game/GameCommon.h"
+#include "Game/AssetLoader.hpp"
+#include "Game/ShaderRegistry.hpp"
+#include "Game/ActorDefinition.hpp"
 #include "Engine/Renderer/Renderer.h"
 #include "Engine/Core/ErrorWarningAssert.hpp"
 #include "Engine/Audio/AudioSystem.hpp"
 
 std::vector<WeaponDefinition*> WeaponDefinition::s_weaponDefinitions;
 
+WeaponDefinition::WeaponDefinition()
+{
+}
+
 WeaponDefinition::WeaponDefinition(XmlElement const& weaponDefElement)
+{
+	ParseXmlElement(weaponDefElement);
+	Initialize();
+}
+
+void WeaponDefinition::ParseXmlElement(XmlElement const& weaponDefElement)
 {
 	// General
 	m_weaponName = ParseXmlAttribute(weaponDefElement, "name", m_weaponName);
@@ -41,6 +54,48 @@ WeaponDefinition::WeaponDefinition(XmlElement const& weaponDefElement)
 	ParseSound(weaponDefElement);
 }
 
+void WeaponDefinition::Initialize()
+{
+	if (!m_hudShaderName.empty() && m_hudShaderName != "ERRORCELL")
+	{
+		m_hudShader = g_shaderRegistry->CreateOrGetShader(m_hudShaderName);
+	}
+	if (!m_baseTexturePath.empty())
+	{
+		m_baseTexture = g_assetLoader->CreateOrGetTexture(m_baseTexturePath);
+	}
+	if (!m_reticleTexturePath.empty())
+	{
+		m_reticleTexture = g_assetLoader->CreateOrGetTexture(m_reticleTexturePath);
+	}
+
+	for (int animIndex = 0; animIndex < static_cast<int>(m_animationInfos.size()); ++animIndex)
+	{
+		WeaponAnimationInfo const& animInfo = m_animationInfos[animIndex];
+		if (!animInfo.m_name.empty())
+		{
+			m_animationNames.push_back(animInfo.m_name);
+		}
+		if (!animInfo.m_shaderName.empty())
+		{
+			m_animationShader = g_shaderRegistry->CreateOrGetShader(animInfo.m_shaderName);
+		}
+
+		Texture* texture = g_assetLoader->CreateOrGetTexture(animInfo.m_spriteSheetPath);
+		SpriteSheet* sheet = new SpriteSheet(*texture, animInfo.m_cellCount);
+		m_animationDefs.push_back(new SpriteAnimDefinition(*sheet, animInfo.m_startFrame, animInfo.m_endFrame, animInfo.m_secondsPerFrame, SpriteAnimPlaybackType::ONCE));
+		if (!m_spriteSheet)
+		{
+			m_spriteSheet = sheet;
+		}
+	}
+
+	if (!m_soundFilePath.empty())
+	{
+		g_theAudio->CreateOrGetSound(m_soundFilePath);
+	}
+}
+
 void WeaponDefinition::InitializeWeaponsDefs()
 {
 	XmlDocument weaponDefsXml;
@@ -70,18 +125,10 @@ void WeaponDefinition::ParseHUD(XmlElement const& hudDefElement)
 		return;
 	}
 
-	// Parse the default shader
-	std::string shader = ParseXmlAttribute(*hudElement, "shader", shader);
-	if (shader != "ERRORCELL")
-	{
-		m_hudShader = g_theRenderer->CreateShader(shader.c_str());
-	}
-
-	// Parse the HUD textures
- 	std::string baseTexture = ParseXmlAttribute(*hudElement, "baseTexture", baseTexture);
-	m_baseTexture = g_theRenderer->CreateOrGetTextureFromFile(baseTexture.c_str());
-	std::string reticleTexture = ParseXmlAttribute(*hudElement, "reticleTexture", reticleTexture);
-	m_reticleTexture = g_theRenderer->CreateOrGetTextureFromFile(reticleTexture.c_str());
+	// Parse the default shader and HUD textures
+	m_hudShaderName = ParseXmlAttribute(*hudElement, "shader", m_hudShaderName);
+	m_baseTexturePath = ParseXmlAttribute(*hudElement, "baseTexture", m_baseTexturePath);
+	m_reticleTexturePath = ParseXmlAttribute(*hudElement, "reticleTexture", m_reticleTexturePath);
 
 	// Parse sizes and pivot
 	m_reticleSize = ParseXmlAttribute(*hudElement, "reticleSize", m_reticleSize);
@@ -96,35 +143,17 @@ void WeaponDefinition::ParseAnimation(XmlElement const* hudElement)
 {
 	for (XmlElement const* animElement = hudElement->FirstChildElement("Animation"); animElement != nullptr; animElement = animElement->NextSiblingElement("Animation"))
 	{
-		std::string animName = ParseXmlAttribute(*animElement, "name", "default");
-		if (!animName.empty())
-		{
-			m_animationNames.push_back(animName);
-		}
-
-		std::string animShader = ParseXmlAttribute(*animElement, "shader", "");
-		if (!animShader.empty())
-		{
-			m_animationShader = g_theRenderer->CreateShader(animShader.c_str());
-		}
+		WeaponAnimationInfo animInfo;
+		animInfo.m_name            = ParseXmlAttribute(*animElement, "name", animInfo.m_name);
+		animInfo.m_shaderName      = ParseXmlAttribute(*animElement, "shader", animInfo.m_shaderName);
 
 		// Parse spritesheet and animation settings
-		std::string spriteSheetPath = ParseXmlAttribute(*animElement, "spriteSheet", "");
-		IntVec2 cellCount = ParseXmlAttribute(*animElement, "cellCount", IntVec2(1, 1));
-		int startFrame = ParseXmlAttribute(*animElement, "startFrame", 0);
-		int endFrame = ParseXmlAttribute(*animElement, "endFrame", 0);
-		float secondsPerFrame = ParseXmlAttribute(*animElement, "secondsPerFrame", 1.0f);
-
-		Texture* texture = g_theRenderer->CreateOrGetTextureFromFile(spriteSheetPath.c_str());
-		SpriteSheet* sheet = new SpriteSheet(*texture, cellCount);
-		SpriteAnimDefinition* animDef = new SpriteAnimDefinition(*sheet, startFrame, endFrame, secondsPerFrame, SpriteAnimPlaybackType::ONCE);
-
-		m_animationDefs.push_back(animDef);
-
-		if (!m_spriteSheet)
-		{
-			m_spriteSheet = sheet;
-		}
+		animInfo.m_spriteSheetPath = ParseXmlAttribute(*animElement, "spriteSheet", animInfo.m_spriteSheetPath);
+		animInfo.m_cellCount       = ParseXmlAttribute(*animElement, "cellCount", animInfo.m_cellCount);
+		animInfo.m_startFrame      = ParseXmlAttribute(*animElement, "startFrame", animInfo.m_startFrame);
+		animInfo.m_endFrame        = ParseXmlAttribute(*animElement, "endFrame", animInfo.m_endFrame);
+		animInfo.m_secondsPerFrame = ParseXmlAttribute(*animElement, "secondsPerFrame", animInfo.m_secondsPerFrame);
+		m_animationInfos.push_back(animInfo);
 	}
 }
 
@@ -144,7 +173,21 @@ void WeaponDefinition::ParseSound(XmlElement const& soundDefElement)
 
 	m_soundName = ParseXmlAttribute(*soundElement, "sound", m_soundName);
 	m_soundFilePath = ParseXmlAttribute(*soundElement, "name", m_soundFilePath);
-	g_theAudio->CreateOrGetSound(m_soundFilePath);
+}
+
+// Projectile actors are named in XML and may be listed in any actor file
+void WeaponDefinition::ResolveReferences()
+{
+	for (int weaponDefIndex = 0; weaponDefIndex < static_cast<int>(s_weaponDefinitions.size()); ++weaponDefIndex)
+	{
+		WeaponDefinition* weaponDef = s_weaponDefinitions[weaponDefIndex];
+		if (weaponDef->m_projectileActor.empty())
+		{
+			continue;
+		}
+		weaponDef->m_projectileActorDef = ActorDefinition::GetByActorName(weaponDef->m_projectileActor);
+		GUARANTEE_OR_DIE(weaponDef->m_projectileActorDef != nullptr, Stringf("Weapon definition \"%s\" fires unknown actor \"%s\"", weaponDef->m_weaponName.c_str(), weaponDef->m_projectileActor.c_str()));
+	}
 }
 
 WeaponDefinition* WeaponDefinition::GetByWeaponName(std::string const& name)
@@ -5,12 +5,31 @@
 // -----------------------------------------------------------------------------
 class Shader;
 class Texture;
+struct ActorDefinition;
+// -----------------------------------------------------------------------------
+// A HUD animation as parsed, its sprite sheet is made by Initialize
+struct WeaponAnimationInfo
+{
+	std::string m_name = "default";
+	std::string m_shaderName;
+	std::string m_spriteSheetPath;
+	IntVec2     m_cellCount = IntVec2(1, 1);
+	int         m_startFrame = 0;
+	int         m_endFrame = 0;
+	float       m_secondsPerFrame = 1.0f;
+};
+// -----------------------------------------------------------------------------
+// Split into parsing and Initialize the same way as ActorDefinition
 // -----------------------------------------------------------------------------
 struct WeaponDefinition
 {
+	WeaponDefinition();
 	WeaponDefinition(XmlElement const& weaponDefElement);
 	static std::vector<WeaponDefinition*> s_weaponDefinitions;
 	static void InitializeWeaponsDefs();
+	static void ResolveReferences();
+	void ParseXmlElement(XmlElement const& weaponDefElement);
+	void Initialize();
 	void ParseHUD(XmlElement const& hudDefElement);
 	void ParseAnimation(XmlElement const* hudElement);
 	void ParseSound(XmlElement const& soundDefElement);
@@ -27,7 +46,8 @@ struct WeaponDefinition
 	float		m_rayImpulse = 0.0f;
 // -----------------------------------------------------------------------------
 	int			m_projectileCount = 0;
-	std::string m_projectileActor;
+	std::string m_projectileActor;		// As parsed, see m_projectileActorDef
+	ActorDefinition* m_projectileActorDef = nullptr;
 	float		m_projectileCone = 0.0f;
 	float		m_projectileSpeed = 0.0f;
 	float       m_maxRange = 0.0f;
@@ -39,6 +59,9 @@ struct WeaponDefinition
 	FloatRange  m_impMeleeDamage = FloatRange::ZERO;
 	float		m_meleeImpulse = 0.0f;
 // -----------------------------------------------------------------------------
+	std::string m_hudShaderName;
+	std::string m_baseTexturePath;
+	std::string m_reticleTexturePath;
 	Shader*     m_hudShader = nullptr;
 	Texture*    m_baseTexture = nullptr;
 	Texture*    m_reticleTexture = nullptr;
@@ -46,6 +69,7 @@ struct WeaponDefinition
 	Vec2        m_spriteSize = Vec2::ZERO;
 	Vec2        m_spritePivot = Vec2::ZERO;
 // -----------------------------------------------------------------------------
+	std::vector<WeaponAnimationInfo>   m_animationInfos;
 	std::vector<std::string>           m_animationNames;
 	Shader*                            m_animationShader = nullptr;
 	SpriteSheet*                       m_spriteSheet = nullptr;
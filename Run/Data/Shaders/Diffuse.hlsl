@@ -125,13 +125,17 @@ float4 PixelMain(v2p_t input) : SV_Target0
 	//-----------------------------------------POINT LIGHTS---------------------------------------------------//
 	for (int lightIndex = 0; lightIndex < NumPointLights; ++lightIndex)
 	{
-		float4 pixelToLight = PointLights[lightIndex].Position - input.worldPosition;
+		// Position.w holds the light's radius, the same radius the light grid culled against
+		float3 pixelToLight = PointLights[lightIndex].Position.xyz - input.worldPosition.xyz;
+		float lightRadius = max(PointLights[lightIndex].Position.w, 0.0001f);	// A zero radius light lights nothing rather than dividing by zero
 		float distance = length(pixelToLight);
 		pixelToLight = normalize(pixelToLight);
 		float linearfalloff = 0.09f;
 		float quadratic = 0.032f;
 		float attenuation = 1.0f / (1.0f + linearfalloff * distance + quadratic * distance * distance);
-		lightColor += PointLights[lightIndex].Color * attenuation * saturate(dot(normalize(input.worldNormal), pixelToLight));
+		float radiusWindow = saturate(1.0f - distance / lightRadius);
+		attenuation *= radiusWindow * radiusWindow;
+		lightColor += PointLights[lightIndex].Color * attenuation * saturate(dot(normalize(input.worldNormal.xyz), pixelToLight));
 	}
 	//-------------------------------------------------------------------------------------------------------//
 